@@ -1013,6 +1013,12 @@ namespace DuiLib {
 		}
 	}
 
+	bool CActiveXUI::IsPaintThreadSafe() const
+	{
+		// 控件运行在窗口线程的套间中
+		return false;
+	}
+
 	bool CActiveXUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
 		if( m_pControl != NULL && m_pControl->m_bWindowless && m_pControl->m_pViewObject != NULL )
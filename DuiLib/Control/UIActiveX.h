@@ -56,6 +56,7 @@ namespace DuiLib {
 		void SetPos(RECT rc, bool bNeedInvalidate = true);
 		void Move(SIZE szOffset, bool bNeedInvalidate = true);
 		bool DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl);
+		bool IsPaintThreadSafe() const;
 
 		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
 
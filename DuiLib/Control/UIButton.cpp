@@ -421,87 +421,124 @@ namespace DuiLib
 		return m_sBindTabLayoutName;
 	}
 
-	void CButtonUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
-	{
-		if( _tcsicmp(pstrName, _T("normalimage")) == 0 ) SetNormalImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("hotimage")) == 0 ) SetHotImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("pushedimage")) == 0 ) SetPushedImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("focusedimage")) == 0 ) SetFocusedImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("disabledimage")) == 0 ) SetDisabledImage(pstrValue);
-        else if (_tcsicmp(pstrName, _T("hotforeimage")) == 0) SetHotForeImage(pstrValue);
-        else if (_tcsicmp(pstrName, _T("pushedforeimage")) == 0) SetPushedForeImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("stateimage")) == 0 ) SetStateImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("statecount")) == 0 ) SetStateCount(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("bindtabindex")) == 0 ) BindTabIndex(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("bindtablayoutname")) == 0 ) BindTabLayoutName(pstrValue);
-		else if( _tcsicmp(pstrName, _T("hotbkcolor")) == 0 )
-		{
+	bool CButtonUI::CanCopyAttributes() const
+	{
+		return typeid(*this) == typeid(CButtonUI);
+	}
+
+	void CButtonUI::CopyAttributes(const CControlUI* pSource)
+	{
+		CLabelUI::CopyAttributes(pSource);
+		const CButtonUI* pButton = static_cast<const CButtonUI*>(pSource);
+		// 鼠标状态不复制，只保留禁用
+		m_uButtonState = pButton->m_uButtonState & UISTATE_DISABLED;
+		m_iHotFont = pButton->m_iHotFont;
+		m_iPushedFont = pButton->m_iPushedFont;
+		m_iFocusedFont = pButton->m_iFocusedFont;
+		m_dwHotBkColor = pButton->m_dwHotBkColor;
+		m_dwPushedBkColor = pButton->m_dwPushedBkColor;
+		m_dwDisabledBkColor = pButton->m_dwDisabledBkColor;
+		m_dwHotTextColor = pButton->m_dwHotTextColor;
+		m_dwPushedTextColor = pButton->m_dwPushedTextColor;
+		m_dwFocusedTextColor = pButton->m_dwFocusedTextColor;
+		m_dwHotBorderColor = pButton->m_dwHotBorderColor;
+		m_dwPushedBorderColor = pButton->m_dwPushedBorderColor;
+		m_dwDisabledBorderColor = pButton->m_dwDisabledBorderColor;
+		m_sNormalImage = pButton->m_sNormalImage;
+		m_sHotImage = pButton->m_sHotImage;
+		m_sHotForeImage = pButton->m_sHotForeImage;
+		m_sPushedImage = pButton->m_sPushedImage;
+		m_sPushedForeImage = pButton->m_sPushedForeImage;
+		m_sFocusedImage = pButton->m_sFocusedImage;
+		m_sDisabledImage = pButton->m_sDisabledImage;
+		m_nStateCount = pButton->m_nStateCount;
+		m_sStateImage = pButton->m_sStateImage;
+		m_iBindTabIndex = pButton->m_iBindTabIndex;
+		m_sBindTabLayoutName = pButton->m_sBindTabLayoutName;
+	}
+
+	void CButtonUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_NORMALIMAGE: SetNormalImage(pstrValue); break;
+		case DUI_ATTR_HOTIMAGE: SetHotImage(pstrValue); break;
+		case DUI_ATTR_PUSHEDIMAGE: SetPushedImage(pstrValue); break;
+		case DUI_ATTR_FOCUSEDIMAGE: SetFocusedImage(pstrValue); break;
+		case DUI_ATTR_DISABLEDIMAGE: SetDisabledImage(pstrValue); break;
+		case DUI_ATTR_HOTFOREIMAGE: SetHotForeImage(pstrValue); break;
+		case DUI_ATTR_PUSHEDFOREIMAGE: SetPushedForeImage(pstrValue); break;
+		case DUI_ATTR_STATEIMAGE: SetStateImage(pstrValue); break;
+		case DUI_ATTR_STATECOUNT: SetStateCount(_ttoi(pstrValue)); break;
+		case DUI_ATTR_BINDTABINDEX: BindTabIndex(_ttoi(pstrValue)); break;
+		case DUI_ATTR_BINDTABLAYOUTNAME: BindTabLayoutName(pstrValue); break;
+		case DUI_ATTR_HOTBKCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetHotBkColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("pushedbkcolor")) == 0 )
-		{
+		case DUI_ATTR_PUSHEDBKCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetPushedBkColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("disabledbkcolor")) == 0 )
-		{
+		case DUI_ATTR_DISABLEDBKCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetDisabledBkColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("hottextcolor")) == 0 )
-		{
+		case DUI_ATTR_HOTTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetHotTextColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("pushedtextcolor")) == 0 )
-		{
+		case DUI_ATTR_PUSHEDTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetPushedTextColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("focusedtextcolor")) == 0 )
-		{
+		case DUI_ATTR_FOCUSEDTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetFocusedTextColor(clrColor);
+			break;
 		}
-		else if (_tcscmp(pstrName, _T("hotbordercolor")) == 0)
-		{
+		case DUI_ATTR_HOTBORDERCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetHotBorderColor(clrColor);
+			break;
 		}
-		else if (_tcscmp(pstrName, _T("pushedbordercolor")) == 0)
-		{
+		case DUI_ATTR_PUSHEDBORDERCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetPushedBorderColor(clrColor);
+			break;
 		}
-		else if (_tcscmp(pstrName, _T("disabledbordercolor")) == 0)
-		{
+		case DUI_ATTR_DISABLEDBORDERCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetDisabledBorderColor(clrColor);
+			break;
+		}
+		case DUI_ATTR_HOTFONT: SetHotFont(_ttoi(pstrValue)); break;
+		case DUI_ATTR_PUSHEDFONT: SetPushedFont(_ttoi(pstrValue)); break;
+		case DUI_ATTR_FOCUEDFONT: SetFocusedFont(_ttoi(pstrValue)); break;
+		default: CLabelUI::SetAttribute(iId, pstrName, pstrValue); break;
 		}
-		else if( _tcsicmp(pstrName, _T("hotfont")) == 0 ) SetHotFont(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("pushedfont")) == 0 ) SetPushedFont(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("focuedfont")) == 0 ) SetFocusedFont(_ttoi(pstrValue));
-		
-		else CLabelUI::SetAttribute(pstrName, pstrValue);
 	}
 
 	void CButtonUI::PaintText(HDC hDC)
@@ -551,23 +588,31 @@ namespace DuiLib
 			iFont, m_uTextStyle);
 	}
 
+	bool CButtonUI::IsPaintThreadSafe() const
+	{
+		// 首次绘制时把stateimage切分成各状态图，切分前只能在窗口线程绘制；
+		// 绘制中更新的焦点、禁用状态由控件当前的状态得出，各分块写入的值相同
+		if( !m_sStateImage.IsEmpty() && m_nStateCount > 0 && m_sNormalImage.IsEmpty() ) return false;
+		return _tcscmp(GetClass(), _T("ButtonUI")) == 0;
+	}
+
 	void CButtonUI::PaintBkColor(HDC hDC)
 	{
 		if( (m_uButtonState & UISTATE_DISABLED) != 0 ) {
 			if(m_dwDisabledBkColor != 0) {
-				CRenderEngine::DrawColor(hDC, m_rcPaint, GetAdjustColor(m_dwDisabledBkColor));
+				CRenderEngine::DrawColor(hDC, GetPaintRect(), GetAdjustColor(m_dwDisabledBkColor));
 				return;
 			}
 		}
 		else if( (m_uButtonState & UISTATE_PUSHED) != 0 ) {
 			if(m_dwPushedBkColor != 0) {
-				CRenderEngine::DrawColor(hDC, m_rcPaint, GetAdjustColor(m_dwPushedBkColor));
+				CRenderEngine::DrawColor(hDC, GetPaintRect(), GetAdjustColor(m_dwPushedBkColor));
 				return;
 			}
 		}
 		else if( (m_uButtonState & UISTATE_HOT) != 0 ) {
 			if(m_dwHotBkColor != 0) {
-				CRenderEngine::DrawColor(hDC, m_rcPaint, GetAdjustColor(m_dwHotBkColor));
+				CRenderEngine::DrawColor(hDC, GetPaintRect(), GetAdjustColor(m_dwHotBkColor));
 				return;
 			}
 		}
@@ -581,11 +626,11 @@ namespace DuiLib
 		{
 			TDrawInfo info;
 			info.Parse(m_sStateImage, _T(""), m_pManager);
-			const TImageInfo* pImage = m_pManager->GetImageEx(info.sImageName, info.sResType, info.dwMask, info.bHSL, info.bGdiplus);
-			if(m_sNormalImage.IsEmpty() && pImage != NULL)
+			if(m_sNormalImage.IsEmpty())
 			{
-				SIZE szImage = {pImage->nX, pImage->nY};
-				SIZE szStatus = {pImage->nX / m_nStateCount, pImage->nY};
+				// 只需要尺寸来切分状态图，像素在绘制各状态图时才解码
+				SIZE szImage = m_pManager->GetImageSize(info.sImageName, info.sResType, info.dwMask, info.bHSL, info.bGdiplus);
+				SIZE szStatus = {szImage.cx / m_nStateCount, szImage.cy};
 				if( szImage.cx > 0 && szImage.cy > 0 )
 				{
 					RECT rcSrc = {0, 0, szImage.cx, szImage.cy};
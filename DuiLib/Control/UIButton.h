@@ -73,7 +73,10 @@ namespace DuiLib
 		void SetDisabledBorderColor(DWORD dwColor);
 		DWORD GetDisabledBorderColor() const;
 
-		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CLabelUI::SetAttribute;
+		void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
+		bool CanCopyAttributes() const;
+		void CopyAttributes(const CControlUI* pSource);
 
 		void PaintText(HDC hDC);
 
@@ -81,6 +84,7 @@ namespace DuiLib
 		void PaintStatusImage(HDC hDC);
 		void PaintBorder(HDC hDC);
 		void PaintForeImage(HDC hDC);
+		bool IsPaintThreadSafe() const;
 
 		void DrawBorder(HDC hDC, const RECT& rcItem, const DWORD& dwBorderColor, const int& nBorderSize, const RECT& rcBorderSize, const SIZE& cxyBorderRound, const int& nBorderStyle);
 	protected:
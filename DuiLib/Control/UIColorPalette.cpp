@@ -352,13 +352,13 @@ namespace DuiLib {
 		StretchBlt(hDC, m_rcItem.left, m_rcItem.bottom - m_nBarHeight, m_rcItem.right - m_rcItem.left, m_nBarHeight, m_MemDc, 0, 210, 200, m_nBarHeight, SRCCOPY);
 
 		RECT rcCurSorPaint = { m_ptLastPalletMouse.x - 4, m_ptLastPalletMouse.y - 4, m_ptLastPalletMouse.x + 4, m_ptLastPalletMouse.y + 4 };
-		CRenderEngine::DrawImageString(hDC, m_pManager, rcCurSorPaint, m_rcPaint, m_strThumbImage);
+		CRenderEngine::DrawImageString(hDC, m_pManager, rcCurSorPaint, GetPaintRect(), m_strThumbImage);
 
 		rcCurSorPaint.left = m_rcItem.left + m_nCurS * (m_rcItem.right - m_rcItem.left) / 200 - 4;
 		rcCurSorPaint.right = m_rcItem.left + m_nCurS * (m_rcItem.right - m_rcItem.left) / 200 + 4;
 		rcCurSorPaint.top = m_rcItem.bottom - m_nBarHeight / 2 - 4;
 		rcCurSorPaint.bottom = m_rcItem.bottom - m_nBarHeight / 2 + 4;
-		CRenderEngine::DrawImageString(hDC, m_pManager, rcCurSorPaint, m_rcPaint, m_strThumbImage);
+		CRenderEngine::DrawImageString(hDC, m_pManager, rcCurSorPaint, GetPaintRect(), m_strThumbImage);
 		::RestoreDC(hDC, nSaveDC);
 	}
 
@@ -145,7 +145,7 @@ namespace DuiLib {
 			// the items back to the righfull owner/manager when the window closes.
 			m_pLayout = new CVerticalLayoutUI;
 			m_pLayout->SetManager(&m_pm, NULL, true);
-			LPCTSTR pDefaultAttributes = m_pOwner->GetManager()->GetDefaultAttributeList(_T("VerticalLayout"));
+			const CAttributeList* pDefaultAttributes = m_pOwner->GetManager()->GetDefaultAttributes(_T("VerticalLayout"));
 			if( pDefaultAttributes ) {
 				m_pLayout->ApplyAttributeList(pDefaultAttributes);
 			}
@@ -8,8 +8,10 @@ namespace DuiLib
 
 		CGifAnimUI::CGifAnimUI(void)
 	{
-		m_pGifImage			=	NULL;
-		m_pPropertyItem		=	NULL;
+		m_pGifData			=	NULL;
+		m_hGifBitmap		=	NULL;
+		m_pGifBits			=	NULL;
+		m_szGif.cx = m_szGif.cy = 0;
 		m_nFrameCount		=	0;	
 		m_nFramePosition	=	0;	
 		m_bIsAutoPlay		=	true;
@@ -39,13 +41,20 @@ namespace DuiLib
 
 	void CGifAnimUI::DoInit()
 	{
-		InitGifImage();
+		// GIF在首次绘制时才解码，这里只按文件头确定自动大小
+		InitGifSize();
+	}
+
+	bool CGifAnimUI::IsPaintThreadSafe() const
+	{
+		// 首次绘制时解码并启动定时器
+		return false;
 	}
 
 	bool CGifAnimUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
 		if( !::IntersectRect( &m_rcPaint, &rcPaint, &m_rcItem ) ) return true;
-		if ( NULL == m_pGifImage )
+		if ( NULL == m_hGifBitmap )
 		{		
 			InitGifImage();
 		}
@@ -89,6 +98,7 @@ namespace DuiLib
 
 		StopGif();
 		DeleteGif();
+		if( m_pManager != NULL ) InitGifSize();
 
 		Invalidate();
 
@@ -121,12 +131,12 @@ namespace DuiLib
 
 	void CGifAnimUI::PlayGif()
 	{
-		if (m_bIsPlaying || m_pGifImage == NULL || m_nFrameCount <= 1)
+		if (m_bIsPlaying || m_hGifBitmap == NULL || m_nFrameCount <= 1)
 		{
 			return;
 		}
 
-		long lPause = ((long*) m_pPropertyItem->value)[m_nFramePosition] * 10;
+		long lPause = m_GifDecoder.GetFrameDelay(m_nFramePosition);
 		if ( lPause == 0 ) lPause = 100;
 		m_pManager->SetTimer( this, EVENT_TIEM_ID, lPause );
 
@@ -135,7 +145,7 @@ namespace DuiLib
 
 	void CGifAnimUI::PauseGif()
 	{
-		if (!m_bIsPlaying || m_pGifImage == NULL)
+		if (!m_bIsPlaying || m_hGifBitmap == NULL)
 		{
 			return;
 		}
@@ -153,40 +163,58 @@ namespace DuiLib
 		}
 
 		m_pManager->KillTimer(this, EVENT_TIEM_ID);
-		m_nFramePosition = 0;
+		ShowFrame(0, false);
 		this->Invalidate();
 		m_bIsPlaying = false;
 	}
 
-	void CGifAnimUI::InitGifImage()
+	void CGifAnimUI::InitGifSize()
 	{
-		TImageInfo* pImageInfo = CRenderEngine::GdiplusLoadImage(GetBkImage());
-		if(pImageInfo != NULL) {
-			m_pGifImage = pImageInfo->pImage;
+		if( !m_bIsAutoSize || m_sBkImage.IsEmpty() ) return;
+		int x = 0, y = 0;
+		bool bAlpha = false;
+		if( CRenderEngine::ProbeImage(GetBkImage(), NULL, NULL, x, y, bAlpha) ) {
+			SetFixedWidth(x);
+			SetFixedHeight(y);
+		}
+	}
 
-			delete pImageInfo;
-			pImageInfo = NULL;
+	void CGifAnimUI::InitGifImage()
+	{
+		DWORD dwSize = 0;
+		m_pGifData = CRenderEngine::MapImageData(GetBkImage(), NULL, NULL, dwSize);
+		if ( NULL == m_pGifData ) return;
+		if ( m_GifDecoder.Open(m_pGifData, dwSize) )
+		{
+			m_szGif.cx = m_GifDecoder.GetWidth();
+			m_szGif.cy = m_GifDecoder.GetHeight();
+			m_nFrameCount = m_GifDecoder.GetFrameCount();
+			m_hGifBitmap = CRenderEngine::CreateARGB32Bitmap(NULL, m_szGif.cx, -m_szGif.cy, &m_pGifBits);
+			if ( NULL == m_hGifBitmap )
+			{
+				DeleteGif();
+				return;
+			}
+			ShowFrame(0, false);
 		}
-		if ( NULL == m_pGifImage ) return;
-
-		UINT nCount	= 0;
-		nCount	=	m_pGifImage->GetFrameDimensionsCount();
-		GUID* pDimensionIDs	=	new GUID[ nCount ];
-		m_pGifImage->GetFrameDimensionsList( pDimensionIDs, nCount );
-		m_nFrameCount	=	m_pGifImage->GetFrameCount( &pDimensionIDs[0] );
-		if (m_nFrameCount > 1)
+		else
 		{
-			int nSize = m_pGifImage->GetPropertyItemSize(PropertyTagFrameDelay);
-			m_pPropertyItem = (Gdiplus::PropertyItem*) malloc(nSize);
-			m_pGifImage->GetPropertyItem(PropertyTagFrameDelay, nSize, m_pPropertyItem);
+			// 不是GIF时按普通图片显示一帧
+			CRenderEngine::UnmapImageData(m_pGifData);
+			m_pGifData = NULL;
+			TImageInfo* pImageInfo = CRenderEngine::LoadImage(GetBkImage());
+			if ( NULL == pImageInfo ) return;
+			m_hGifBitmap = pImageInfo->hBitmap;
+			m_szGif.cx = pImageInfo->nX;
+			m_szGif.cy = pImageInfo->nY;
+			m_nFrameCount = 1;
+			delete pImageInfo;
 		}
-		delete[]  pDimensionIDs;
-		pDimensionIDs = NULL;
 
 		if (m_bIsAutoSize)
 		{
-			SetFixedWidth(m_pGifImage->GetWidth());
-			SetFixedHeight(m_pGifImage->GetHeight());
+			SetFixedWidth(m_szGif.cx);
+			SetFixedHeight(m_szGif.cy);
 		}
 		if (m_bIsAutoPlay)
 		{
@@ -194,19 +222,59 @@ namespace DuiLib
 		}
 	}
 
-	void CGifAnimUI::DeleteGif()
+	void CGifAnimUI::ShowFrame(UINT nFrame, bool bInvalidate)
 	{
-		if ( m_pGifImage != NULL )
+		m_nFramePosition = nFrame;
+		if ( NULL == m_pGifBits ) return;
+		RECT rcDirty = { 0 };
+		const BYTE* pFrame = m_GifDecoder.GetFrame(nFrame, &rcDirty);
+		if ( NULL == pFrame || ::IsRectEmpty(&rcDirty) ) return;
+
+		// 只复制并刷新与上一帧不同的区域
+		::GdiFlush();
+		int nStride = m_szGif.cx * 4;
+		int cbLine = (rcDirty.right - rcDirty.left) * 4;
+		for ( int y = rcDirty.top; y < rcDirty.bottom; y++ )
 		{
-			delete m_pGifImage;
-			m_pGifImage = NULL;
+			::CopyMemory(m_pGifBits + y * nStride + rcDirty.left * 4, pFrame + y * nStride + rcDirty.left * 4, cbLine);
 		}
+		if ( !bInvalidate || !IsVisible() || m_pManager == NULL ) return;
+
+		// 图片拉伸到整个控件，变化区域按比例换算并向外取整
+		int cx = m_rcItem.right - m_rcItem.left;
+		int cy = m_rcItem.bottom - m_rcItem.top;
+		RECT rcInvalidate = {
+			m_rcItem.left + rcDirty.left * cx / m_szGif.cx,
+			m_rcItem.top + rcDirty.top * cy / m_szGif.cy,
+			m_rcItem.left + (rcDirty.right * cx + m_szGif.cx - 1) / m_szGif.cx,
+			m_rcItem.top + (rcDirty.bottom * cy + m_szGif.cy - 1) / m_szGif.cy
+		};
+		RECT rcTemp;
+		CControlUI* pParent = this;
+		while ( pParent = pParent->GetParent() )
+		{
+			rcTemp = rcInvalidate;
+			RECT rcParent = pParent->GetPos();
+			if ( !::IntersectRect(&rcInvalidate, &rcTemp, &rcParent) ) return;
+		}
+		m_pManager->Invalidate(rcInvalidate);
+	}
 
-		if ( m_pPropertyItem != NULL )
+	void CGifAnimUI::DeleteGif()
+	{
+		m_GifDecoder.Close();
+		if ( m_pGifData != NULL )
 		{
-			free( m_pPropertyItem );
-			m_pPropertyItem = NULL;
+			CRenderEngine::UnmapImageData(m_pGifData);
+			m_pGifData = NULL;
 		}
+		if ( m_hGifBitmap != NULL )
+		{
+			::DeleteObject(m_hGifBitmap);
+			m_hGifBitmap = NULL;
+		}
+		m_pGifBits			=	NULL;
+		m_szGif.cx = m_szGif.cy = 0;
 		m_nFrameCount		=	0;	
 		m_nFramePosition	=	0;	
 	}
@@ -216,21 +284,19 @@ namespace DuiLib
 		if ( idEvent != EVENT_TIEM_ID )
 			return;
 		m_pManager->KillTimer( this, EVENT_TIEM_ID );
-		this->Invalidate();
 
-		m_nFramePosition = (++m_nFramePosition) % m_nFrameCount;
+		ShowFrame( (m_nFramePosition + 1) % m_nFrameCount, true );
 
-		long lPause = ((long*) m_pPropertyItem->value)[m_nFramePosition] * 10;
+		long lPause = m_GifDecoder.GetFrameDelay(m_nFramePosition);
 		if ( lPause == 0 ) lPause = 100;
 		m_pManager->SetTimer( this, EVENT_TIEM_ID, lPause );
 	}
 
 	void CGifAnimUI::DrawFrame( HDC hDC )
 	{
-		if ( NULL == hDC || NULL == m_pGifImage ) return;
-		GUID pageGuid = Gdiplus::FrameDimensionTime;
-		Gdiplus::Graphics graphics( hDC );
-		graphics.DrawImage( m_pGifImage, m_rcItem.left, m_rcItem.top, m_rcItem.right-m_rcItem.left, m_rcItem.bottom-m_rcItem.top );
-		m_pGifImage->SelectActiveFrame( &pageGuid, m_nFramePosition );
+		if ( NULL == hDC || NULL == m_hGifBitmap ) return;
+		RECT rcBmpPart = { 0, 0, m_szGif.cx, m_szGif.cy };
+		RECT rcCorners = { 0 };
+		CRenderEngine::DrawImage( hDC, m_hGifBitmap, m_rcItem, m_rcPaint, rcBmpPart, rcCorners, true );
 	}
 }
@@ -20,6 +20,7 @@ namespace DuiLib
 		LPVOID	GetInterface(LPCTSTR pstrName);
 		void	DoInit();
 		bool	DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl);
+		bool	IsPaintThreadSafe() const;
 		void	DoEvent(TEventUI& event);
 		void	SetVisible(bool bVisible = true );
 		void	SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
@@ -35,16 +36,21 @@ namespace DuiLib
 		void	StopGif();
 
 	private:
+		void	InitGifSize();
 		void	InitGifImage();
+		void	ShowFrame(UINT nFrame, bool bInvalidate);
 		void	DeleteGif();
 		void    OnTimer( UINT_PTR idEvent );
 		void	DrawFrame( HDC hDC );		// 绘制GIF每帧
 
 	private:
-		Gdiplus::Image	*m_pGifImage;
+		CGifDecoder		m_GifDecoder;
+		const BYTE*		m_pGifData;					// 解码器引用的文件数据（MapImageData）
+		HBITMAP			m_hGifBitmap;				// 当前帧，只更新变化的区域
+		LPBYTE			m_pGifBits;
+		SIZE			m_szGif;
 		UINT			m_nFrameCount;				// gif图片总帧数
 		UINT			m_nFramePosition;			// 当前放到第几帧
-		Gdiplus::PropertyItem*	m_pPropertyItem;	// 帧与帧之间间隔时间
 
 		CDuiString		m_sBkImage;
 		bool			m_bIsAutoPlay;				// 是否自动播放gif
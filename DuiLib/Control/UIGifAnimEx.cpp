@@ -165,6 +165,12 @@ namespace DuiLib
 		m_pImp->EventSetVisible(bVisible);
 	}
 
+	bool CGifAnimExUI::IsPaintThreadSafe() const
+	{
+		// CxImage的帧对象不能同时在多个线程绘制
+		return false;
+	}
+
 	bool CGifAnimExUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
 		if( !::IntersectRect( &m_rcPaint, &rcPaint, &m_rcItem ) ) return true;
@@ -26,6 +26,7 @@ namespace DuiLib
 		virtual void SetVisible(bool bVisible = true);
 		virtual void SetInternVisible(bool bVisible = true);
 		virtual bool DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl);
+		virtual bool IsPaintThreadSafe() const;
 		virtual void DoEvent(TEventUI& event);
 	public:
 		void StartAnim();
@@ -185,9 +185,30 @@ namespace DuiLib
 		CControlUI::DoEvent(event);
 	}
 
-	void CLabelUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	bool CLabelUI::CanCopyAttributes() const
 	{
-		if( _tcsicmp(pstrName, _T("align")) == 0 ) {
+		return typeid(*this) == typeid(CLabelUI);
+	}
+
+	void CLabelUI::CopyAttributes(const CControlUI* pSource)
+	{
+		CControlUI::CopyAttributes(pSource);
+		const CLabelUI* pLabel = static_cast<const CLabelUI*>(pSource);
+		m_dwTextColor = pLabel->m_dwTextColor;
+		m_dwDisabledTextColor = pLabel->m_dwDisabledTextColor;
+		m_iFont = pLabel->m_iFont;
+		m_uTextStyle = pLabel->m_uTextStyle;
+		m_rcTextPadding = pLabel->m_rcTextPadding;
+		m_bShowHtml = pLabel->m_bShowHtml;
+		m_bAutoCalcWidth = pLabel->m_bAutoCalcWidth;
+		m_bAutoCalcHeight = pLabel->m_bAutoCalcHeight;
+		m_bNeedEstimateSize = true;
+	}
+
+	void CLabelUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_ALIGN: {
 			if( _tcsstr(pstrValue, _T("left")) != NULL ) {
 				m_uTextStyle &= ~(DT_CENTER | DT_RIGHT);
 				m_uTextStyle |= DT_LEFT;
@@ -200,8 +221,9 @@ namespace DuiLib
 				m_uTextStyle &= ~(DT_LEFT | DT_CENTER);
 				m_uTextStyle |= DT_RIGHT;
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("valign")) == 0 ) {
+		case DUI_ATTR_VALIGN: {
 			if( _tcsstr(pstrValue, _T("top")) != NULL ) {
 				m_uTextStyle &= ~(DT_BOTTOM | DT_VCENTER | DT_WORDBREAK);
 				m_uTextStyle |= (DT_TOP | DT_SINGLELINE);
@@ -214,12 +236,14 @@ namespace DuiLib
 				m_uTextStyle &= ~(DT_TOP | DT_VCENTER | DT_WORDBREAK);
 				m_uTextStyle |= (DT_BOTTOM | DT_SINGLELINE);
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("endellipsis")) == 0 ) {
+		case DUI_ATTR_ENDELLIPSIS: {
 			if( _tcsicmp(pstrValue, _T("true")) == 0 ) m_uTextStyle |= DT_END_ELLIPSIS;
 			else m_uTextStyle &= ~DT_END_ELLIPSIS;
-		}   
-		else if( _tcsicmp(pstrName, _T("wordbreak")) == 0 ) {
+			break;
+		}
+		case DUI_ATTR_WORDBREAK: {
 			if( _tcsicmp(pstrValue, _T("true")) == 0 ) {
 				m_uTextStyle &= ~DT_SINGLELINE;
 				m_uTextStyle |= DT_WORDBREAK | DT_EDITCONTROL;
@@ -228,8 +252,9 @@ namespace DuiLib
 				m_uTextStyle &= ~DT_WORDBREAK & ~DT_EDITCONTROL;
 				m_uTextStyle |= DT_SINGLELINE;
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("noprefix")) == 0 ) {
+		case DUI_ATTR_NOPREFIX: {
 			if( _tcsicmp(pstrValue, _T("true")) == 0)
 			{
 				m_uTextStyle |= DT_NOPREFIX;
@@ -238,21 +263,24 @@ namespace DuiLib
 			{
 				m_uTextStyle = m_uTextStyle & ~DT_NOPREFIX;
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("font")) == 0 ) SetFont(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("textcolor")) == 0 ) {
+		case DUI_ATTR_FONT: SetFont(_ttoi(pstrValue)); break;
+		case DUI_ATTR_TEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetTextColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("disabledtextcolor")) == 0 ) {
+		case DUI_ATTR_DISABLEDTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetDisabledTextColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("textpadding")) == 0 ) {
+		case DUI_ATTR_TEXTPADDING: {
 			RECT rcTextPadding = { 0 };
 			LPTSTR pstr = NULL;
 			rcTextPadding.left = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);    
@@ -260,15 +288,19 @@ namespace DuiLib
 			rcTextPadding.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
 			rcTextPadding.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);    
 			SetTextPadding(rcTextPadding);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("showhtml")) == 0 ) SetShowHtml(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("autocalcwidth")) == 0 ) {
+		case DUI_ATTR_SHOWHTML: SetShowHtml(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_AUTOCALCWIDTH: {
 			SetAutoCalcWidth(_tcsicmp(pstrValue, _T("true")) == 0);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("autocalcheight")) == 0 ) {
+		case DUI_ATTR_AUTOCALCHEIGHT: {
 			SetAutoCalcHeight(_tcsicmp(pstrValue, _T("true")) == 0);
+			break;
+		}
+		default: CControlUI::SetAttribute(iId, pstrName, pstrValue); break;
 		}
-		else CControlUI::SetAttribute(pstrName, pstrValue);
 	}
 
 	void CLabelUI::PaintText(HDC hDC)
@@ -305,6 +337,12 @@ namespace DuiLib
 		}
 	}
 
+	bool CLabelUI::IsPaintThreadSafe() const
+	{
+		// 绘制中只补上默认的文字颜色，各分块写入的值相同
+		return _tcscmp(GetClass(), _T("LabelUI")) == 0;
+	}
+
 	bool CLabelUI::GetAutoCalcWidth() const
 	{
 		return m_bAutoCalcWidth;
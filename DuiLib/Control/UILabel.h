@@ -31,9 +31,13 @@ namespace DuiLib
 
 		SIZE EstimateSize(SIZE szAvailable);
 		void DoEvent(TEventUI& event);
-		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CControlUI::SetAttribute;
+		void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
+		bool CanCopyAttributes() const;
+		void CopyAttributes(const CControlUI* pSource);
 
 		void PaintText(HDC hDC);
+		bool IsPaintThreadSafe() const;
 
 		virtual bool GetAutoCalcWidth() const;
 		virtual void SetAutoCalcWidth(bool bAutoCalcWidth);
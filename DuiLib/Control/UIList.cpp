@@ -989,14 +989,15 @@ namespace DuiLib {
 		m_pList->SetScrollPos(CDuiSize(sz.cx + dx, sz.cy + dy));
 	}
 
-	void CListUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
-	{
-		if (_tcsicmp(pstrName, _T("header")) == 0) GetHeader()->SetVisible(_tcsicmp(pstrValue, _T("hidden")) != 0);
-		else if (_tcsicmp(pstrName, _T("headerbkimage")) == 0) GetHeader()->SetBkImage(pstrValue);
-		else if (_tcsicmp(pstrName, _T("scrollselect")) == 0) SetScrollSelect(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcsicmp(pstrName, _T("multiexpanding")) == 0) SetMultiExpanding(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcsicmp(pstrName, _T("itemfont")) == 0) m_ListInfo.nFont = _ttoi(pstrValue);
-		else if (_tcsicmp(pstrName, _T("itemalign")) == 0) {
+	void CListUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_HEADER: GetHeader()->SetVisible(_tcsicmp(pstrValue, _T("hidden")) != 0); break;
+		case DUI_ATTR_HEADERBKIMAGE: GetHeader()->SetBkImage(pstrValue); break;
+		case DUI_ATTR_SCROLLSELECT: SetScrollSelect(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_MULTIEXPANDING: SetMultiExpanding(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_ITEMFONT: m_ListInfo.nFont = _ttoi(pstrValue); break;
+		case DUI_ATTR_ITEMALIGN: {
 			if (_tcsstr(pstrValue, _T("left")) != NULL) {
 				m_ListInfo.uTextStyle &= ~(DT_CENTER | DT_RIGHT);
 				m_ListInfo.uTextStyle |= DT_LEFT;
@@ -1009,8 +1010,9 @@ namespace DuiLib {
 				m_ListInfo.uTextStyle &= ~(DT_LEFT | DT_CENTER);
 				m_ListInfo.uTextStyle |= DT_RIGHT;
 			}
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemvalign")) == 0) {
+		case DUI_ATTR_ITEMVALIGN: {
 			if (_tcsstr(pstrValue, _T("top")) != NULL) {
 				m_ListInfo.uTextStyle &= ~(DT_VCENTER | DT_BOTTOM);
 				m_ListInfo.uTextStyle |= DT_TOP;
@@ -1023,12 +1025,14 @@ namespace DuiLib {
 				m_ListInfo.uTextStyle &= ~(DT_TOP | DT_VCENTER);
 				m_ListInfo.uTextStyle |= DT_BOTTOM;
 			}
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemendellipsis")) == 0) {
+		case DUI_ATTR_ITEMENDELLIPSIS: {
 			if (_tcsicmp(pstrValue, _T("true")) == 0) m_ListInfo.uTextStyle |= DT_END_ELLIPSIS;
 			else m_ListInfo.uTextStyle &= ~DT_END_ELLIPSIS;
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemtextpadding")) == 0) {
+		case DUI_ATTR_ITEMTEXTPADDING: {
 			RECT rcTextPadding = { 0 };
 			LPTSTR pstr = NULL;
 			rcTextPadding.left = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);
@@ -1036,76 +1040,98 @@ namespace DuiLib {
 			rcTextPadding.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);
 			rcTextPadding.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);
 			SetItemTextPadding(rcTextPadding);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemtextcolor")) == 0) {
+		case DUI_ATTR_ITEMTEXTCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetItemTextColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itembkcolor")) == 0) {
+		case DUI_ATTR_ITEMBKCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetItemBkColor(clrColor);
+			break;
+		}
+		case DUI_ATTR_ITEMBKIMAGE: SetItemBkImage(pstrValue); break;
+		case DUI_ATTR_ITEMALTBK: SetAlternateBk(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_ITEMFOREIMAGE: {
+			m_ListInfo.sForeImage = pstrValue;
+			Invalidate();
+			break;
+		}
+		case DUI_ATTR_ITEMHOTFOREIMAGE: {
+			m_ListInfo.sHotForeImage = pstrValue;
+			Invalidate();
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itembkimage")) == 0) SetItemBkImage(pstrValue);
-		else if (_tcsicmp(pstrName, _T("itemaltbk")) == 0) SetAlternateBk(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("itemforeimage")) == 0 ) {m_ListInfo.sForeImage = pstrValue; Invalidate();}
-		else if( _tcsicmp(pstrName, _T("itemhotforeimage")) == 0 ) {m_ListInfo.sHotForeImage = pstrValue; Invalidate();}
-		else if( _tcsicmp(pstrName, _T("itemselectedforeimage")) == 0 ) {m_ListInfo.sSelectedForeImage = pstrValue; Invalidate();}
-		else if (_tcsicmp(pstrName, _T("itemselectedtextcolor")) == 0) {
+		case DUI_ATTR_ITEMSELECTEDFOREIMAGE: {
+			m_ListInfo.sSelectedForeImage = pstrValue;
+			Invalidate();
+			break;
+		}
+		case DUI_ATTR_ITEMSELECTEDTEXTCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetSelectedItemTextColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemselectedbkcolor")) == 0) {
+		case DUI_ATTR_ITEMSELECTEDBKCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetSelectedItemBkColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemselectedimage")) == 0) SetSelectedItemImage(pstrValue);
-		else if (_tcsicmp(pstrName, _T("itemhottextcolor")) == 0) {
+		case DUI_ATTR_ITEMSELECTEDIMAGE: SetSelectedItemImage(pstrValue); break;
+		case DUI_ATTR_ITEMHOTTEXTCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetHotItemTextColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemhotbkcolor")) == 0) {
+		case DUI_ATTR_ITEMHOTBKCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetHotItemBkColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemhotimage")) == 0) SetHotItemImage(pstrValue);
-		else if (_tcsicmp(pstrName, _T("itemdisabledtextcolor")) == 0) {
+		case DUI_ATTR_ITEMHOTIMAGE: SetHotItemImage(pstrValue); break;
+		case DUI_ATTR_ITEMDISABLEDTEXTCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetDisabledItemTextColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemdisabledbkcolor")) == 0) {
+		case DUI_ATTR_ITEMDISABLEDBKCOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetDisabledItemBkColor(clrColor);
+			break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemdisabledimage")) == 0) SetDisabledItemImage(pstrValue);
-		else if (_tcsicmp(pstrName, _T("itemlinecolor")) == 0) {
+		case DUI_ATTR_ITEMDISABLEDIMAGE: SetDisabledItemImage(pstrValue); break;
+		case DUI_ATTR_ITEMLINECOLOR: {
 			if (*pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetItemLineColor(clrColor);
+			break;
+		}
+		case DUI_ATTR_ITEMSHOWROWLINE: SetItemShowRowLine(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_ITEMSHOWCOLUMNLINE: SetItemShowColumnLine(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_ITEMSHOWHTML: SetItemShowHtml(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_MULTISELECT: SetMultiSelect(_tcscmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_ITEMRSELECTED: SetItemRSelected(_tcscmp(pstrValue, _T("true")) == 0); break;
+		default: CVerticalLayoutUI::SetAttribute(iId, pstrName, pstrValue); break;
 		}
-		else if (_tcsicmp(pstrName, _T("itemshowrowline")) == 0) SetItemShowRowLine(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcsicmp(pstrName, _T("itemshowcolumnline")) == 0) SetItemShowColumnLine(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcsicmp(pstrName, _T("itemshowhtml")) == 0) SetItemShowHtml(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcscmp(pstrName, _T("multiselect")) == 0) SetMultiSelect(_tcscmp(pstrValue, _T("true")) == 0);
-		else if (_tcscmp(pstrName, _T("itemrselected")) == 0) SetItemRSelected(_tcscmp(pstrValue, _T("true")) == 0);
-
-		else CVerticalLayoutUI::SetAttribute(pstrName, pstrValue);
 	}
 
 	IListCallbackUI* CListUI::GetTextCallback() const
@@ -3000,7 +3026,8 @@ namespace DuiLib {
 	{
 		if (_tcsicmp(pstrName, _T("selected")) == 0) Select();
 		//else if( _tcscmp(pstrName, _T("expandable")) == 0 ) SetExpandable(_tcscmp(pstrValue, _T("true")) == 0);
-		else CContainerUI::SetAttribute(pstrName, pstrValue);
+		// 跳过CHorizontalLayoutUI，直接交给CContainerUI
+		else CContainerUI::SetAttribute(CAttributeId::Find(pstrName), pstrName, pstrValue);
 	}
 
 	bool CListContainerElementUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
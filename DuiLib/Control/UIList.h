@@ -203,7 +203,8 @@ namespace DuiLib {
 		void SetPos(RECT rc, bool bNeedInvalidate = true);
 		void Move(SIZE szOffset, bool bNeedInvalidate = true);
 		void DoEvent(TEventUI& event);
-		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CVerticalLayoutUI::SetAttribute;
+		void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
 
 		IListCallbackUI* GetTextCallback() const;
 		void SetTextCallback(IListCallbackUI* pCallback);
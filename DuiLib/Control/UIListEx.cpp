@@ -46,7 +46,7 @@ namespace DuiLib {
 		{
 			m_pEditUI = new CRichEditUI;
 			m_pEditUI->SetName(_T("ListEx_Edit"));
-			LPCTSTR pDefaultAttributes = GetManager()->GetDefaultAttributeList(_T("RichEdit"));
+			const CAttributeList* pDefaultAttributes = GetManager()->GetDefaultAttributes(_T("RichEdit"));
 			if( pDefaultAttributes ) {
 				m_pEditUI->ApplyAttributeList(pDefaultAttributes);
 			}
@@ -79,7 +79,7 @@ namespace DuiLib {
 		{
 			m_pComboBoxUI = new CComboBoxUI;
 			m_pComboBoxUI->SetName(_T("ListEx_Combo"));
-			LPCTSTR pDefaultAttributes = GetManager()->GetDefaultAttributeList(_T("Combo"));
+			const CAttributeList* pDefaultAttributes = GetManager()->GetDefaultAttributes(_T("Combo"));
 			if( pDefaultAttributes ) {
 				m_pComboBoxUI->ApplyAttributeList(pDefaultAttributes);
 			}
@@ -592,7 +592,8 @@ namespace DuiLib {
 		else if( _tcsicmp(pstrName, _T("checkboxselectedimage")) == 0 ) SetCheckBoxSelectedImage(pstrValue);
 		else if( _tcsicmp(pstrName, _T("checkboxforeimage")) == 0 ) SetCheckBoxForeImage(pstrValue);
 
-		else CContainerUI::SetAttribute(pstrName, pstrValue);
+		// 跳过CHorizontalLayoutUI，直接交给CContainerUI
+		else CContainerUI::SetAttribute(CAttributeId::Find(pstrName), pstrName, pstrValue);
 	}
 
 	void CListContainerHeaderItemUI::DoEvent(TEventUI& event)
@@ -941,7 +942,7 @@ Label_ForeImage:
 	{
 		RECT rcCheckBox;
 		GetCheckBoxRect(rcCheckBox);
-		return CRenderEngine::DrawImageString(hDC, m_pManager, rcCheckBox, m_rcPaint, pStrImage, pStrModify);
+		return CRenderEngine::DrawImageString(hDC, m_pManager, rcCheckBox, GetPaintRect(), pStrImage, pStrModify);
 	}
 	LPCTSTR CListContainerHeaderItemUI::GetCheckBoxNormalImage()
 	{
@@ -1391,7 +1392,7 @@ Label_ForeImage:
 	}
 	BOOL CListTextExtElementUI::DrawCheckBoxImage(HDC hDC, LPCTSTR pStrImage, LPCTSTR pStrModify, RECT& rcCheckBox)
 	{
-		return CRenderEngine::DrawImageString(hDC, m_pManager, rcCheckBox, m_rcPaint, pStrImage, pStrModify);
+		return CRenderEngine::DrawImageString(hDC, m_pManager, rcCheckBox, GetPaintRect(), pStrImage, pStrModify);
 	}
 	void CListTextExtElementUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
 	{
@@ -1476,7 +1477,8 @@ Label_ForeImage:
 
 	bool CListTextExtElementUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
-		if( !::IntersectRect(&m_rcPaint, &rcPaint, &m_rcItem) ) return true;
+		RECT rcTemp = { 0 };
+		if( !::IntersectRect(&rcTemp, &rcPaint, &m_rcItem) ) return true;
 		DrawItemBk(hDC, m_rcItem);
 		PaintStatusImage(hDC);
 		DrawItemText(hDC, m_rcItem);
@@ -333,7 +333,7 @@ namespace DuiLib {
 			m_pLayout = new CMenuUI();
 			m_pm.SetForceUseSharedRes(true);
 			m_pLayout->SetManager(&m_pm, NULL, true);
-			LPCTSTR pDefaultAttributes = m_pOwner->GetManager()->GetDefaultAttributeList(_T("Menu"));
+			const CAttributeList* pDefaultAttributes = m_pOwner->GetManager()->GetDefaultAttributes(_T("Menu"));
 			if( pDefaultAttributes ) {
 				m_pLayout->ApplyAttributeList(pDefaultAttributes);
 			}
@@ -785,16 +785,17 @@ namespace DuiLib {
 			SIZE cxyFixed = GetManager()->GetDPIObj()->Scale(m_cxyFixed);
 			int padding = GetManager()->GetDPIObj()->Scale(ITEM_DEFAULT_EXPLAND_ICON_WIDTH) / 3;
 			const TDrawInfo* pDrawInfo = GetManager()->GetDrawInfo((LPCTSTR)strExplandIcon, NULL);
-			const TImageInfo *pImageInfo = GetManager()->GetImageEx(pDrawInfo->sImageName, NULL, 0, false, pDrawInfo->bGdiplus);
-			if (!pImageInfo) {
+			SIZE szImage = GetManager()->GetImageSize(pDrawInfo->sImageName, NULL, 0, false, pDrawInfo->bGdiplus);
+			if (szImage.cx <= 0 || szImage.cy <= 0) {
 				return;
 			}
+			szImage = GetManager()->GetDPIObj()->Scale(szImage);
 			RECT rcDest =
 			{
-				cxyFixed.cx - pImageInfo->nX - padding,
-				(cxyFixed.cy - pImageInfo->nY) / 2,
-				cxyFixed.cx - pImageInfo->nX - padding + pImageInfo->nX,
-				(cxyFixed.cy - pImageInfo->nY) / 2 + pImageInfo->nY
+				cxyFixed.cx - szImage.cx - padding,
+				(cxyFixed.cy - szImage.cy) / 2,
+				cxyFixed.cx - szImage.cx - padding + szImage.cx,
+				(cxyFixed.cy - szImage.cy) / 2 + szImage.cy
 			};
 			GetManager()->GetDPIObj()->ScaleBack(&rcDest);
 			CDuiString pStrImage;
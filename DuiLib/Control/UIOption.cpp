@@ -1,4 +1,4 @@
-#include "StdAfx.h"
+﻿#include "StdAfx.h"
 #include "UIOption.h"
 
 namespace DuiLib
@@ -257,7 +257,7 @@ namespace DuiLib
 	{
 		if(IsSelected()) {
 			if(m_dwSelectedBkColor != 0) {
-				CRenderEngine::DrawColor(hDC, m_rcPaint, GetAdjustColor(m_dwSelectedBkColor));
+				CRenderEngine::DrawColor(hDC, GetPaintRect(), GetAdjustColor(m_dwSelectedBkColor));
 			}
 		}
 		else {
@@ -272,11 +272,10 @@ namespace DuiLib
 			{
 				TDrawInfo info;
 				info.Parse(m_sSelectedStateImage, _T(""), m_pManager);
-				const TImageInfo* pImage = m_pManager->GetImageEx(info.sImageName, info.sResType, info.dwMask, info.bHSL, info.bGdiplus);
-				if(m_sSelectedImage.IsEmpty() && pImage != NULL)
+				if(m_sSelectedImage.IsEmpty())
 				{
-					SIZE szImage = {pImage->nX, pImage->nY};
-					SIZE szStatus = {pImage->nX / m_nSelectedStateCount, pImage->nY};
+					SIZE szImage = m_pManager->GetImageSize(info.sImageName, info.sResType, info.dwMask, info.bHSL, info.bGdiplus);
+					SIZE szStatus = {szImage.cx / m_nSelectedStateCount, szImage.cy};
 					if( szImage.cx > 0 && szImage.cy > 0 )
 					{
 						RECT rcSrc = {0, 0, szImage.cx, szImage.cy};
@@ -324,6 +323,14 @@ namespace DuiLib
 		}
 	}
 
+	bool COptionUI::IsPaintThreadSafe() const
+	{
+		// 与按钮相同，选中状态的stateimage也在首次绘制时切分
+		if( !m_sStateImage.IsEmpty() && m_nStateCount > 0 && m_sNormalImage.IsEmpty() ) return false;
+		if( !m_sSelectedStateImage.IsEmpty() && m_nSelectedStateCount > 0 && m_sSelectedImage.IsEmpty() ) return false;
+		return _tcscmp(GetClass(), _T("OptionUI")) == 0;
+	}
+
 	void COptionUI::PaintForeImage(HDC hDC)
 	{
 		if(IsSelected()) {
@@ -340,11 +347,10 @@ namespace DuiLib
 	{
 		if( (m_uButtonState & UISTATE_SELECTED) != 0 )
 		{
-			DWORD oldTextColor = m_dwTextColor;
-			if( m_dwSelectedTextColor != 0 ) m_dwTextColor = m_dwSelectedTextColor;
-
+			// 选中的文字颜色只在这里使用，不临时替换m_dwTextColor，分块绘制时各线程互不影响
 			if( m_dwTextColor == 0 ) m_dwTextColor = m_pManager->GetDefaultFontColor();
 			if( m_dwDisabledTextColor == 0 ) m_dwDisabledTextColor = m_pManager->GetDefaultDisabledColor();
+			DWORD dwTextColor = m_dwSelectedTextColor != 0 ? m_dwSelectedTextColor : m_dwTextColor;
 
 			int iFont = GetFont();
 			if(GetSelectedFont() != -1) {
@@ -361,13 +367,11 @@ namespace DuiLib
 			rc.bottom -= rcTextPadding.bottom;
 			
 			if( m_bShowHtml )
-				CRenderEngine::DrawHtmlText(hDC, m_pManager, rc, sText, IsEnabled()?m_dwTextColor:m_dwDisabledTextColor, \
+				CRenderEngine::DrawHtmlText(hDC, m_pManager, rc, sText, IsEnabled()?dwTextColor:m_dwDisabledTextColor, \
 				NULL, NULL, nLinks, iFont, m_uTextStyle);
 			else
-				CRenderEngine::DrawText(hDC, m_pManager, rc, sText, IsEnabled()?m_dwTextColor:m_dwDisabledTextColor, \
+				CRenderEngine::DrawText(hDC, m_pManager, rc, sText, IsEnabled()?dwTextColor:m_dwDisabledTextColor, \
 				iFont, m_uTextStyle);
-
-			m_dwTextColor = oldTextColor;
 		}
 		else
 			CButtonUI::PaintText(hDC);
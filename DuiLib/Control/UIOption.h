@@ -59,6 +59,7 @@ namespace DuiLib
 		void PaintStatusImage(HDC hDC);
 		void PaintForeImage(HDC hDC);
 		void PaintText(HDC hDC);
+		bool IsPaintThreadSafe() const;
 
 	protected:
 		bool			m_bSelected;
@@ -2210,6 +2210,12 @@ err:
 		}
 	}
 
+	bool CRichEditUI::IsPaintThreadSafe() const
+	{
+		// 文本服务对象只能在创建它的线程使用
+		return false;
+	}
+
 	bool CRichEditUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
 		RECT rcTemp = { 0 };
@@ -151,6 +151,7 @@ namespace DuiLib {
 		void Move(SIZE szOffset, bool bNeedInvalidate = true);
 		void DoEvent(TEventUI& event);
 		bool DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl);
+		bool IsPaintThreadSafe() const;
 
 		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
 
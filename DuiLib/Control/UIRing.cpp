@@ -41,6 +41,12 @@ namespace DuiLib
 		Invalidate();
 	}
 
+	bool CRingUI::IsPaintThreadSafe() const
+	{
+		// 首次绘制时加载图片并启动定时器，GDI+图片对象也不能同时在多个线程使用
+		return false;
+	}
+
 	void CRingUI::PaintBkImage( HDC hDC )
 	{
 		if(m_pBkimage == NULL) {
@@ -22,6 +22,7 @@ namespace DuiLib
 		void SetBkImage(LPCTSTR pStrImage);	
 		virtual void DoEvent(TEventUI& event);
 		virtual void PaintBkImage(HDC hDC);	
+		virtual bool IsPaintThreadSafe() const;
 
 	private:
 		void InitImage();
@@ -1239,39 +1239,42 @@ namespace DuiLib
 	// 参数信息: LPCTSTR pstrValue
 	// 函数说明: 
 	//************************************
-	void CTreeViewUI::SetAttribute( LPCTSTR pstrName, LPCTSTR pstrValue )
-	{
-		if(_tcsicmp(pstrName,_T("visiblefolderbtn")) == 0)
-			SetVisibleFolderBtn(_tcsicmp(pstrValue,_T("TRUE")) == 0);
-		else if(_tcsicmp(pstrName,_T("visiblecheckbtn")) == 0)
-			SetVisibleCheckBtn(_tcsicmp(pstrValue,_T("TRUE")) == 0);
-		else if(_tcsicmp(pstrName,_T("itemminwidth")) == 0)
-			SetItemMinWidth(_ttoi(pstrValue));
-		else if(_tcsicmp(pstrName, _T("itemtextcolor")) == 0 ){
+	void CTreeViewUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_VISIBLEFOLDERBTN: SetVisibleFolderBtn(_tcsicmp(pstrValue,_T("TRUE")) == 0); break;
+		case DUI_ATTR_VISIBLECHECKBTN: SetVisibleCheckBtn(_tcsicmp(pstrValue,_T("TRUE")) == 0); break;
+		case DUI_ATTR_ITEMMINWIDTH: SetItemMinWidth(_ttoi(pstrValue)); break;
+		case DUI_ATTR_ITEMTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetItemTextColor(clrColor);
+			break;
 		}
-		else if(_tcsicmp(pstrName, _T("itemhottextcolor")) == 0 ){
+		case DUI_ATTR_ITEMHOTTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetItemHotTextColor(clrColor);
+			break;
 		}
-		else if(_tcsicmp(pstrName, _T("selitemtextcolor")) == 0 ){
+		case DUI_ATTR_SELITEMTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetSelItemTextColor(clrColor);
+			break;
 		}
-		else if(_tcsicmp(pstrName, _T("selitemhottextcolor")) == 0 ){
+		case DUI_ATTR_SELITEMHOTTEXTCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetSelItemHotTextColor(clrColor);
+			break;
+		}
+		default: CListUI::SetAttribute(iId, pstrName, pstrValue); break;
 		}
-		else CListUI::SetAttribute(pstrName,pstrValue);
 	}
 
 }
\ No newline at end of file
@@ -131,7 +131,8 @@ namespace DuiLib
 		virtual void SetSelItemTextColor(DWORD _dwSelItemTextColor);
 		virtual void SetSelItemHotTextColor(DWORD _dwSelHotItemTextColor);
 		
-		virtual void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CListUI::SetAttribute;
+		virtual void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
 	private:
 		UINT m_uItemMinWidth;
 		bool m_bVisibleFolderBtn;
@@ -81,6 +81,16 @@ namespace DuiLib
 		}
 	}
 
+	CreateClass CControlFactory::GetCreateClass(CDuiString strClassName)
+	{
+		strClassName.MakeLower();
+		MAP_DUI_CTRATECLASS::iterator iter = m_mapControl.find(strClassName);
+		if ( iter == m_mapControl.end()) {
+			return NULL;
+		}
+		return iter->second;
+	}
+
 	void CControlFactory::RegistControl(CDuiString strClassName, CreateClass pFunc)
 	{
 		strClassName.MakeLower();
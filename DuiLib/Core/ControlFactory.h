@@ -9,6 +9,7 @@ namespace DuiLib
 	{
 	public:
 		CControlUI* CreateControl(CDuiString strClassName);
+		CreateClass GetCreateClass(CDuiString strClassName);
 		void RegistControl(CDuiString strClassName, CreateClass pFunc);
 
 		static CControlFactory* GetInstance();
@@ -0,0 +1,240 @@
+﻿#include "StdAfx.h"
+#include "UIAttributeId.h"
+
+namespace DuiLib
+{
+	static LPCTSTR s_aAttributeNames[DUI_ATTR_COUNT] = {
+		NULL,
+#define DUI_ATTR_NAME(id, name) _T(#name),
+		DUI_ATTRIBUTE_LIST(DUI_ATTR_NAME)
+#undef DUI_ATTR_NAME
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	// 完美哈希: 名字先按哈希分桶，每个桶再找一个位移值，使桶内名字落在互不冲突的空槽里。
+	// 表在DLL加载时生成，查找只需一次哈希和一次字符串比较
+
+	class CAttributeIdTable
+	{
+	public:
+		enum { SLOT_COUNT = 512, BUCKET_COUNT = 128 };
+
+		CAttributeIdTable() : m_bPerfect(false)
+		{
+			::ZeroMemory(m_aSlots, sizeof(m_aSlots));
+			::ZeroMemory(m_aDisplace, sizeof(m_aDisplace));
+			int aBucketSize[BUCKET_COUNT] = { 0 };
+			for( int i = 1; i < DUI_ATTR_COUNT; i++ ) aBucketSize[_Hash(s_aAttributeNames[i]) & (BUCKET_COUNT - 1)]++;
+
+			// 从最大的桶开始放置
+			m_bPerfect = true;
+			for( int nSize = DUI_ATTR_COUNT; nSize > 0 && m_bPerfect; nSize-- ) {
+				for( int iBucket = 0; iBucket < BUCKET_COUNT && m_bPerfect; iBucket++ ) {
+					if( aBucketSize[iBucket] == nSize ) m_bPerfect = _PlaceBucket(iBucket);
+				}
+			}
+			ASSERT(m_bPerfect);
+		}
+
+		int Find(LPCTSTR pstrName) const
+		{
+			if( pstrName == NULL ) return DUI_ATTR_UNKNOWN;
+			if( !m_bPerfect ) {
+				for( int i = 1; i < DUI_ATTR_COUNT; i++ ) {
+					if( _tcsicmp(s_aAttributeNames[i], pstrName) == 0 ) return i;
+				}
+				return DUI_ATTR_UNKNOWN;
+			}
+			UINT nHash = _Hash(pstrName);
+			int iAttr = m_aSlots[_Slot(nHash, m_aDisplace[nHash & (BUCKET_COUNT - 1)])];
+			if( iAttr != DUI_ATTR_UNKNOWN && _tcsicmp(s_aAttributeNames[iAttr], pstrName) == 0 ) return iAttr;
+			return DUI_ATTR_UNKNOWN;
+		}
+
+	private:
+		static UINT _Hash(LPCTSTR pstrName)
+		{
+			// 只折叠ASCII大小写，其它字符原样参与计算，最终由_tcsicmp确认
+			UINT nHash = 2166136261U;
+			for( ; *pstrName != _T('\0'); pstrName++ ) {
+				UINT ch = (UINT)*pstrName;
+				if( ch >= 'A' && ch <= 'Z' ) ch += 'a' - 'A';
+				nHash = (nHash ^ ch) * 16777619U;
+			}
+			return nHash;
+		}
+
+		static UINT _Slot(UINT nHash, UINT nDisplace)
+		{
+			UINT nMix = nHash ^ (nDisplace * 0x9E3779B1U);
+			nMix ^= nMix >> 16;
+			nMix *= 0x85EBCA6BU;
+			nMix ^= nMix >> 13;
+			return nMix & (SLOT_COUNT - 1);
+		}
+
+		bool _PlaceBucket(int iBucket)
+		{
+			int aSlots[DUI_ATTR_COUNT];
+			for( UINT nDisplace = 1; nDisplace < 0x10000; nDisplace++ ) {
+				int nPlaced = 0;
+				bool bFit = true;
+				for( int i = 1; i < DUI_ATTR_COUNT && bFit; i++ ) {
+					UINT nHash = _Hash(s_aAttributeNames[i]);
+					if( (int)(nHash & (BUCKET_COUNT - 1)) != iBucket ) continue;
+					int iSlot = _Slot(nHash, nDisplace);
+					if( m_aSlots[iSlot] != DUI_ATTR_UNKNOWN ) bFit = false;
+					for( int j = 0; j < nPlaced && bFit; j++ ) {
+						if( aSlots[j] == iSlot ) bFit = false;
+					}
+					aSlots[nPlaced++] = iSlot;
+				}
+				if( !bFit ) continue;
+				nPlaced = 0;
+				for( int i = 1; i < DUI_ATTR_COUNT; i++ ) {
+					if( (int)(_Hash(s_aAttributeNames[i]) & (BUCKET_COUNT - 1)) == iBucket ) m_aSlots[aSlots[nPlaced++]] = (WORD)i;
+				}
+				m_aDisplace[iBucket] = (WORD)nDisplace;
+				return true;
+			}
+			return false;
+		}
+
+	private:
+		WORD m_aSlots[SLOT_COUNT];
+		WORD m_aDisplace[BUCKET_COUNT];
+		bool m_bPerfect;
+	};
+
+	static_assert(DUI_ATTR_COUNT * 2 <= CAttributeIdTable::SLOT_COUNT, "Attribute name table needs more slots");
+
+	static CAttributeIdTable s_attributeIdTable;
+
+	int CAttributeId::Find(LPCTSTR pstrName)
+	{
+		return s_attributeIdTable.Find(pstrName);
+	}
+
+	LPCTSTR CAttributeId::GetName(int iAttr)
+	{
+		if( iAttr <= DUI_ATTR_UNKNOWN || iAttr >= DUI_ATTR_COUNT ) return NULL;
+		return s_aAttributeNames[iAttr];
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	// 解析规则与原来的ApplyAttributeList一致: name="value"，以空格或逗号分隔，
+	// 出错时保留出错之前的属性
+
+	CAttributeList::CAttributeList(LPCTSTR pstrList) : m_pstrBuffer(NULL), m_pItems(NULL), m_nItems(0)
+	{
+		if( pstrList == NULL ) return;
+		m_sData = pstrList;
+
+		CDuiString sXmlData = pstrList;
+		sXmlData.Replace(_T("&quot;"), _T("\""));
+		sXmlData.Replace(_T("\r"), _T(" "));
+		sXmlData.Replace(_T("\n"), _T(" "));
+		sXmlData.Replace(_T("\t"), _T(" "));
+		sXmlData.Trim();
+		if( sXmlData.IsEmpty() ) return;
+
+		// 名字和值就地截断，一个属性至少占三个字符: =""
+		int cchBuffer = sXmlData.GetLength() + 1;
+		m_pstrBuffer = static_cast<LPTSTR>(malloc(cchBuffer * sizeof(TCHAR)));
+		m_pItems = static_cast<TAttributeItem*>(malloc((cchBuffer / 3 + 1) * sizeof(TAttributeItem)));
+		if( m_pstrBuffer == NULL || m_pItems == NULL ) return;
+		memcpy(m_pstrBuffer, sXmlData.GetData(), cchBuffer * sizeof(TCHAR));
+
+		LPTSTR pstrText = m_pstrBuffer;
+		while( *pstrText != _T('\0') ) {
+			while( *pstrText == _T(' ') ) pstrText++;
+			LPTSTR pstrName = pstrText;
+			while( *pstrText != _T('\0') && *pstrText != _T('=') ) pstrText = ::CharNext(pstrText);
+			ASSERT( *pstrText == _T('=') );
+			if( *pstrText != _T('=') ) return;
+			*pstrText++ = _T('\0');
+			ASSERT( *pstrText == _T('\"') );
+			if( *pstrText++ != _T('\"') ) return;
+			LPTSTR pstrValue = pstrText;
+			while( *pstrText != _T('\0') && *pstrText != _T('\"') ) pstrText = ::CharNext(pstrText);
+			ASSERT( *pstrText == _T('\"') );
+			if( *pstrText != _T('\"') ) return;
+			*pstrText++ = _T('\0');
+
+			_SetItem(m_nItems++, pstrName, pstrValue);
+			if( *pstrText != _T(' ') && *pstrText != _T(',') ) return;
+			pstrText++;
+		}
+	}
+
+	CAttributeList::CAttributeList(CMarkupNode& node) : m_pstrBuffer(NULL), m_pItems(NULL), m_nItems(0)
+	{
+		int nAttributes = node.GetAttributeCount();
+		if( nAttributes <= 0 ) return;
+
+		// 名字和值连续复制到一块内存里
+		int cchBuffer = 0;
+		for( int i = 0; i < nAttributes; i++ ) {
+			cchBuffer += (int)_tcslen(node.GetAttributeName(i)) + (int)_tcslen(node.GetAttributeValue(i)) + 2;
+		}
+		m_pstrBuffer = static_cast<LPTSTR>(malloc(cchBuffer * sizeof(TCHAR)));
+		m_pItems = static_cast<TAttributeItem*>(malloc(nAttributes * sizeof(TAttributeItem)));
+		if( m_pstrBuffer == NULL || m_pItems == NULL ) return;
+
+		LPTSTR pstrText = m_pstrBuffer;
+		for( int i = 0; i < nAttributes; i++ ) {
+			LPTSTR pstrName = pstrText;
+			_tcscpy(pstrText, node.GetAttributeName(i));
+			pstrText += _tcslen(pstrText) + 1;
+			LPTSTR pstrValue = pstrText;
+			_tcscpy(pstrText, node.GetAttributeValue(i));
+			pstrText += _tcslen(pstrText) + 1;
+			_SetItem(m_nItems++, pstrName, pstrValue);
+		}
+	}
+
+	CAttributeList::~CAttributeList()
+	{
+		if( m_pstrBuffer != NULL ) free(m_pstrBuffer);
+		if( m_pItems != NULL ) free(m_pItems);
+	}
+
+	LPCTSTR CAttributeList::GetData() const
+	{
+		return m_sData.GetData();
+	}
+
+	int CAttributeList::GetCount() const
+	{
+		return m_nItems;
+	}
+
+	int CAttributeList::GetId(int iIndex) const
+	{
+		if( iIndex < 0 || iIndex >= m_nItems ) return DUI_ATTR_UNKNOWN;
+		return m_pItems[iIndex].iId;
+	}
+
+	LPCTSTR CAttributeList::GetName(int iIndex) const
+	{
+		if( iIndex < 0 || iIndex >= m_nItems ) return NULL;
+		return m_pItems[iIndex].pstrName;
+	}
+
+	LPCTSTR CAttributeList::GetValue(int iIndex) const
+	{
+		if( iIndex < 0 || iIndex >= m_nItems ) return NULL;
+		return m_pItems[iIndex].pstrValue;
+	}
+
+	void CAttributeList::_SetItem(int iIndex, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		TAttributeItem& item = m_pItems[iIndex];
+		item.iId = CAttributeId::Find(pstrName);
+		item.pstrName = pstrName;
+		item.pstrValue = pstrValue;
+	}
+
+} // namespace DuiLib
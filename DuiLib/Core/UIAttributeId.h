@@ -0,0 +1,201 @@
+﻿#pragma once
+
+namespace DuiLib
+{
+	// SetAttribute按编号分派的属性名，X(编号, 名字)，名字是皮肤文件中的小写写法
+#define DUI_ATTRIBUTE_LIST(X) \
+	/* CControlUI */ \
+	X(STYLE, style) \
+	X(INNERSTYLE, innerstyle) \
+	X(POS, pos) \
+	X(FLOAT, float) \
+	X(FLOATALIGN, floatalign) \
+	X(PADDING, padding) \
+	X(GRADIENT, gradient) \
+	X(BKCOLOR, bkcolor) \
+	X(BKCOLOR1, bkcolor1) \
+	X(BKCOLOR2, bkcolor2) \
+	X(BKCOLOR3, bkcolor3) \
+	X(FORECOLOR, forecolor) \
+	X(BORDERCOLOR, bordercolor) \
+	X(FOCUSBORDERCOLOR, focusbordercolor) \
+	X(COLORHSL, colorhsl) \
+	X(BORDERSIZE, bordersize) \
+	X(LEFTBORDERSIZE, leftbordersize) \
+	X(TOPBORDERSIZE, topbordersize) \
+	X(RIGHTBORDERSIZE, rightbordersize) \
+	X(BOTTOMBORDERSIZE, bottombordersize) \
+	X(BORDERSTYLE, borderstyle) \
+	X(BORDERROUND, borderround) \
+	X(BKIMAGE, bkimage) \
+	X(FOREIMAGE, foreimage) \
+	X(WIDTH, width) \
+	X(HEIGHT, height) \
+	X(MINWIDTH, minwidth) \
+	X(MINHEIGHT, minheight) \
+	X(MAXWIDTH, maxwidth) \
+	X(MAXHEIGHT, maxheight) \
+	X(NAME, name) \
+	X(DRAG, drag) \
+	X(DROP, drop) \
+	X(RESOURCETEXT, resourcetext) \
+	X(RICHEVENT, richevent) \
+	X(TEXT, text) \
+	X(TOOLTIP, tooltip) \
+	X(USERDATA, userdata) \
+	X(ENABLED, enabled) \
+	X(MOUSE, mouse) \
+	X(KEYBOARD, keyboard) \
+	X(VISIBLE, visible) \
+	X(SHORTCUT, shortcut) \
+	X(MENU, menu) \
+	X(CURSOR, cursor) \
+	X(VIRTUALWND, virtualwnd) \
+	/* CContainerUI */ \
+	X(INSET, inset) \
+	X(MOUSECHILD, mousechild) \
+	X(VSCROLLBAR, vscrollbar) \
+	X(VSCROLLBARSTYLE, vscrollbarstyle) \
+	X(HSCROLLBAR, hscrollbar) \
+	X(HSCROLLBARSTYLE, hscrollbarstyle) \
+	X(CHILDPADDING, childpadding) \
+	X(CHILDALIGN, childalign) \
+	X(CHILDVALIGN, childvalign) \
+	X(SCROLLSTEPSIZE, scrollstepsize) \
+	X(FIXEDSCROLLBAR, fixedscrollbar) \
+	X(SHOWSCROLLBAR, showscrollbar) \
+	X(CACHE, cache) \
+	/* CVerticalLayoutUI */ \
+	X(SEPHEIGHT, sepheight) \
+	X(SEPIMM, sepimm) \
+	/* CHorizontalLayoutUI */ \
+	X(SEPWIDTH, sepwidth) \
+	/* CLabelUI */ \
+	X(ALIGN, align) \
+	X(VALIGN, valign) \
+	X(ENDELLIPSIS, endellipsis) \
+	X(WORDBREAK, wordbreak) \
+	X(NOPREFIX, noprefix) \
+	X(FONT, font) \
+	X(TEXTCOLOR, textcolor) \
+	X(DISABLEDTEXTCOLOR, disabledtextcolor) \
+	X(TEXTPADDING, textpadding) \
+	X(SHOWHTML, showhtml) \
+	X(AUTOCALCWIDTH, autocalcwidth) \
+	X(AUTOCALCHEIGHT, autocalcheight) \
+	/* CButtonUI */ \
+	X(NORMALIMAGE, normalimage) \
+	X(HOTIMAGE, hotimage) \
+	X(PUSHEDIMAGE, pushedimage) \
+	X(FOCUSEDIMAGE, focusedimage) \
+	X(DISABLEDIMAGE, disabledimage) \
+	X(HOTFOREIMAGE, hotforeimage) \
+	X(PUSHEDFOREIMAGE, pushedforeimage) \
+	X(STATEIMAGE, stateimage) \
+	X(STATECOUNT, statecount) \
+	X(BINDTABINDEX, bindtabindex) \
+	X(BINDTABLAYOUTNAME, bindtablayoutname) \
+	X(HOTBKCOLOR, hotbkcolor) \
+	X(PUSHEDBKCOLOR, pushedbkcolor) \
+	X(DISABLEDBKCOLOR, disabledbkcolor) \
+	X(HOTTEXTCOLOR, hottextcolor) \
+	X(PUSHEDTEXTCOLOR, pushedtextcolor) \
+	X(FOCUSEDTEXTCOLOR, focusedtextcolor) \
+	X(HOTBORDERCOLOR, hotbordercolor) \
+	X(PUSHEDBORDERCOLOR, pushedbordercolor) \
+	X(DISABLEDBORDERCOLOR, disabledbordercolor) \
+	X(HOTFONT, hotfont) \
+	X(PUSHEDFONT, pushedfont) \
+	X(FOCUEDFONT, focuedfont) \
+	/* CListUI */ \
+	X(HEADER, header) \
+	X(HEADERBKIMAGE, headerbkimage) \
+	X(SCROLLSELECT, scrollselect) \
+	X(MULTIEXPANDING, multiexpanding) \
+	X(ITEMFONT, itemfont) \
+	X(ITEMALIGN, itemalign) \
+	X(ITEMVALIGN, itemvalign) \
+	X(ITEMENDELLIPSIS, itemendellipsis) \
+	X(ITEMTEXTPADDING, itemtextpadding) \
+	X(ITEMTEXTCOLOR, itemtextcolor) \
+	X(ITEMBKCOLOR, itembkcolor) \
+	X(ITEMBKIMAGE, itembkimage) \
+	X(ITEMALTBK, itemaltbk) \
+	X(ITEMFOREIMAGE, itemforeimage) \
+	X(ITEMHOTFOREIMAGE, itemhotforeimage) \
+	X(ITEMSELECTEDFOREIMAGE, itemselectedforeimage) \
+	X(ITEMSELECTEDTEXTCOLOR, itemselectedtextcolor) \
+	X(ITEMSELECTEDBKCOLOR, itemselectedbkcolor) \
+	X(ITEMSELECTEDIMAGE, itemselectedimage) \
+	X(ITEMHOTTEXTCOLOR, itemhottextcolor) \
+	X(ITEMHOTBKCOLOR, itemhotbkcolor) \
+	X(ITEMHOTIMAGE, itemhotimage) \
+	X(ITEMDISABLEDTEXTCOLOR, itemdisabledtextcolor) \
+	X(ITEMDISABLEDBKCOLOR, itemdisabledbkcolor) \
+	X(ITEMDISABLEDIMAGE, itemdisabledimage) \
+	X(ITEMLINECOLOR, itemlinecolor) \
+	X(ITEMSHOWROWLINE, itemshowrowline) \
+	X(ITEMSHOWCOLUMNLINE, itemshowcolumnline) \
+	X(ITEMSHOWHTML, itemshowhtml) \
+	X(MULTISELECT, multiselect) \
+	X(ITEMRSELECTED, itemrselected) \
+	/* CTreeViewUI */ \
+	X(VISIBLEFOLDERBTN, visiblefolderbtn) \
+	X(VISIBLECHECKBTN, visiblecheckbtn) \
+	X(ITEMMINWIDTH, itemminwidth) \
+	X(SELITEMTEXTCOLOR, selitemtextcolor) \
+	X(SELITEMHOTTEXTCOLOR, selitemhottextcolor)
+
+	enum DuiAttributeId
+	{
+		DUI_ATTR_UNKNOWN = 0,
+#define DUI_ATTR_ENUM(id, name) DUI_ATTR_##id,
+		DUI_ATTRIBUTE_LIST(DUI_ATTR_ENUM)
+#undef DUI_ATTR_ENUM
+		DUI_ATTR_COUNT
+	};
+
+	class UILIB_API CAttributeId
+	{
+	public:
+		// 与_tcsicmp一样不区分大小写，不在表中的名字返回DUI_ATTR_UNKNOWN
+		static int Find(LPCTSTR pstrName);
+		static LPCTSTR GetName(int iAttr);
+	};
+
+	// 样式或默认属性表，构造时一次拆成(编号, 名字, 值)，之后不再修改；
+	// CPaintManagerUI拥有它保存的实例，控件只在应用时借用
+	class UILIB_API CAttributeList
+	{
+	public:
+		CAttributeList(LPCTSTR pstrList);
+		// 复制一个XML节点的属性，这种表的GetData()为空
+		CAttributeList(CMarkupNode& node);
+		~CAttributeList();
+
+		// 构造时传入的原始文本
+		LPCTSTR GetData() const;
+		int GetCount() const;
+		int GetId(int iIndex) const;
+		LPCTSTR GetName(int iIndex) const;
+		LPCTSTR GetValue(int iIndex) const;
+
+	private:
+		CAttributeList(const CAttributeList&);
+		CAttributeList& operator=(const CAttributeList&);
+		void _SetItem(int iIndex, LPCTSTR pstrName, LPCTSTR pstrValue);
+
+		typedef struct tagTAttributeItem
+		{
+			int iId;
+			LPCTSTR pstrName;
+			LPCTSTR pstrValue;
+		} TAttributeItem;
+
+		CDuiString m_sData;
+		LPTSTR m_pstrBuffer;
+		TAttributeItem* m_pItems;
+		int m_nItems;
+	};
+
+} // namespace DuiLib
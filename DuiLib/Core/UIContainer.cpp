@@ -19,9 +19,15 @@ namespace DuiLib
 		m_pHorizontalScrollBar(NULL),
 		m_nScrollStepSize(0),
 		m_bFixedScrollbar(false),
-		m_bShowScrollbar(true)
+		m_bShowScrollbar(true),
+		m_bLayerCache(false),
+		m_bLayerPainting(false),
+		m_hLayerBitmap(NULL),
+		m_pLayerBits(NULL)
 	{
 		::ZeroMemory(&m_rcInset, sizeof(m_rcInset));
+		m_szLayer.cx = m_szLayer.cy = 0;
+		::ZeroMemory(&m_rcLayerDirty, sizeof(m_rcLayerDirty));
 	}
 
 	CContainerUI::~CContainerUI()
@@ -36,6 +42,8 @@ namespace DuiLib
 			delete m_pHorizontalScrollBar;
 			m_pHorizontalScrollBar = NULL;
 		}
+		if( m_bLayerCache && m_pManager != NULL ) m_pManager->RemoveLayerCache(this);
+		ReleaseLayer();
 	}
 
 	LPCTSTR CContainerUI::GetClass() const
@@ -236,6 +244,48 @@ namespace DuiLib
 		Invalidate();
 	}
 
+	bool CContainerUI::IsLayerCache() const
+	{
+		return m_bLayerCache;
+	}
+
+	bool CContainerUI::IsPaintThreadSafe() const
+	{
+		if( m_bLayerCache ) return false;
+		LPCTSTR pstrClass = GetClass();
+		return _tcscmp(pstrClass, _T("ContainerUI")) == 0 || _tcscmp(pstrClass, _T("VerticalLayoutUI")) == 0 ||
+			_tcscmp(pstrClass, _T("HorizontalLayoutUI")) == 0 || _tcscmp(pstrClass, _T("TileLayoutUI")) == 0 ||
+			_tcscmp(pstrClass, _T("TabLayoutUI")) == 0 || _tcscmp(pstrClass, _T("ChildLayoutUI")) == 0;
+	}
+
+	void CContainerUI::SetLayerCache(bool bCache)
+	{
+		if( m_bLayerCache == bCache ) return;
+		m_bLayerCache = bCache;
+		if( m_pManager != NULL ) {
+			if( bCache ) m_pManager->AddLayerCache(this);
+			else m_pManager->RemoveLayerCache(this);
+		}
+		if( !bCache ) ReleaseLayer();
+		Invalidate();
+	}
+
+	void CContainerUI::InvalidateLayer(const RECT& rcDirty)
+	{
+		if( m_hLayerBitmap == NULL ) return;
+		RECT rcTemp = { 0 };
+		if( ::IntersectRect(&rcTemp, &rcDirty, &m_rcItem) ) ::UnionRect(&m_rcLayerDirty, &m_rcLayerDirty, &rcTemp);
+	}
+
+	void CContainerUI::ReleaseLayer()
+	{
+		if( m_hLayerBitmap != NULL ) ::DeleteObject(m_hLayerBitmap);
+		m_hLayerBitmap = NULL;
+		m_pLayerBits = NULL;
+		m_szLayer.cx = m_szLayer.cy = 0;
+		::ZeroMemory(&m_rcLayerDirty, sizeof(m_rcLayerDirty));
+	}
+
 	bool CContainerUI::IsShowScrollbar()
 	{
 		return m_bShowScrollbar;
@@ -585,7 +635,7 @@ namespace DuiLib
 			m_pVerticalScrollBar->SetOwner(this);
 			m_pVerticalScrollBar->SetManager(m_pManager, NULL, false);
 			if ( m_pManager ) {
-				LPCTSTR pDefaultAttributes = m_pManager->GetDefaultAttributeList(_T("VScrollBar"));
+				const CAttributeList* pDefaultAttributes = m_pManager->GetDefaultAttributes(_T("VScrollBar"));
 				if( pDefaultAttributes ) {
 					m_pVerticalScrollBar->ApplyAttributeList(pDefaultAttributes);
 				}
@@ -605,7 +655,7 @@ namespace DuiLib
 			m_pHorizontalScrollBar->SetManager(m_pManager, NULL, false);
 
 			if ( m_pManager ) {
-				LPCTSTR pDefaultAttributes = m_pManager->GetDefaultAttributeList(_T("HScrollBar"));
+				const CAttributeList* pDefaultAttributes = m_pManager->GetDefaultAttributes(_T("HScrollBar"));
 				if( pDefaultAttributes ) {
 					m_pHorizontalScrollBar->ApplyAttributeList(pDefaultAttributes);
 				}
@@ -734,9 +784,36 @@ namespace DuiLib
 		}
 	}
 
-	void CContainerUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	bool CContainerUI::CanCopyAttributes() const
 	{
-		if( _tcsicmp(pstrName, _T("inset")) == 0 ) {
+		// 滚动条的属性来自管理器的默认属性和样式，带滚动条的容器按属性表重新设置
+		return typeid(*this) == typeid(CContainerUI) && m_pVerticalScrollBar == NULL && m_pHorizontalScrollBar == NULL;
+	}
+
+	void CContainerUI::CopyAttributes(const CControlUI* pSource)
+	{
+		CControlUI::CopyAttributes(pSource);
+		const CContainerUI* pContainer = static_cast<const CContainerUI*>(pSource);
+		m_rcInset = pContainer->m_rcInset;
+		m_iChildPadding = pContainer->m_iChildPadding;
+		m_iChildAlign = pContainer->m_iChildAlign;
+		m_iChildVAlign = pContainer->m_iChildVAlign;
+		m_bAutoDestroy = pContainer->m_bAutoDestroy;
+		m_bDelayedDestroy = pContainer->m_bDelayedDestroy;
+		m_bMouseChildEnabled = pContainer->m_bMouseChildEnabled;
+		m_nScrollStepSize = pContainer->m_nScrollStepSize;
+		m_bFixedScrollbar = pContainer->m_bFixedScrollbar;
+		m_bShowScrollbar = pContainer->m_bShowScrollbar;
+		m_sVerticalScrollBarStyle = pContainer->m_sVerticalScrollBarStyle;
+		m_sHorizontalScrollBarStyle = pContainer->m_sHorizontalScrollBarStyle;
+		// 还没有管理器，SetManager时再登记缓存层
+		m_bLayerCache = pContainer->m_bLayerCache;
+	}
+
+	void CContainerUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_INSET: {
 			RECT rcInset = { 0 };
 			LPTSTR pstr = NULL;
 			rcInset.left = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);    
@@ -744,16 +821,18 @@ namespace DuiLib
 			rcInset.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
 			rcInset.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);    
 			SetInset(rcInset);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("mousechild")) == 0 ) SetMouseChildEnabled(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("vscrollbar")) == 0 ) {
+		case DUI_ATTR_MOUSECHILD: SetMouseChildEnabled(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_VSCROLLBAR: {
 			EnableScrollBar(_tcsicmp(pstrValue, _T("true")) == 0, GetHorizontalScrollBar() != NULL);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("vscrollbarstyle")) == 0 ) {
+		case DUI_ATTR_VSCROLLBARSTYLE: {
 			m_sVerticalScrollBarStyle = pstrValue;
 			EnableScrollBar(TRUE, GetHorizontalScrollBar() != NULL);
 			if( GetVerticalScrollBar() ) {
-				LPCTSTR pStyle = m_pManager->GetStyle(m_sVerticalScrollBarStyle);
+				const CAttributeList* pStyle = m_pManager->GetStyleAttributes(m_sVerticalScrollBarStyle);
 				if( pStyle ) {
 					GetVerticalScrollBar()->ApplyAttributeList(pStyle);
 				}
@@ -761,15 +840,17 @@ namespace DuiLib
 					GetVerticalScrollBar()->ApplyAttributeList(pstrValue);
 				}
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("hscrollbar")) == 0 ) {
+		case DUI_ATTR_HSCROLLBAR: {
 			EnableScrollBar(GetVerticalScrollBar() != NULL, _tcsicmp(pstrValue, _T("true")) == 0);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("hscrollbarstyle")) == 0 ) {
+		case DUI_ATTR_HSCROLLBARSTYLE: {
 			m_sHorizontalScrollBarStyle = pstrValue;
 			EnableScrollBar(TRUE, GetHorizontalScrollBar() != NULL);
 			if( GetHorizontalScrollBar() ) {
-				LPCTSTR pStyle = m_pManager->GetStyle(m_sHorizontalScrollBarStyle);
+				const CAttributeList* pStyle = m_pManager->GetStyleAttributes(m_sHorizontalScrollBarStyle);
 				if( pStyle ) {
 					GetHorizontalScrollBar()->ApplyAttributeList(pStyle);
 				}
@@ -777,26 +858,36 @@ namespace DuiLib
 					GetHorizontalScrollBar()->ApplyAttributeList(pstrValue);
 				}
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("childpadding")) == 0 ) SetChildPadding(_ttoi(pstrValue));
-		else if( _tcscmp(pstrName, _T("childalign")) == 0 ) {
+		case DUI_ATTR_CHILDPADDING: SetChildPadding(_ttoi(pstrValue)); break;
+		case DUI_ATTR_CHILDALIGN: {
 			if( _tcscmp(pstrValue, _T("left")) == 0 ) m_iChildAlign = DT_LEFT;
 			else if( _tcscmp(pstrValue, _T("center")) == 0 ) m_iChildAlign = DT_CENTER;
 			else if( _tcscmp(pstrValue, _T("right")) == 0 ) m_iChildAlign = DT_RIGHT;
+			break;
 		}
-		else if( _tcscmp(pstrName, _T("childvalign")) == 0 ) {
+		case DUI_ATTR_CHILDVALIGN: {
 			if( _tcscmp(pstrValue, _T("top")) == 0 ) m_iChildVAlign = DT_TOP;
 			else if( _tcscmp(pstrValue, _T("vcenter")) == 0 ) m_iChildVAlign = DT_VCENTER;
 			else if( _tcscmp(pstrValue, _T("bottom")) == 0 ) m_iChildVAlign = DT_BOTTOM;
+			break;
+		}
+		case DUI_ATTR_SCROLLSTEPSIZE: SetScrollStepSize(_ttoi(pstrValue)); break;
+		case DUI_ATTR_FIXEDSCROLLBAR: SetFixedScrollbar(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_SHOWSCROLLBAR: SetShowScrollbar(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_CACHE: SetLayerCache(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		default: CControlUI::SetAttribute(iId, pstrName, pstrValue); break;
 		}
-		else if( _tcsicmp(pstrName, _T("scrollstepsize")) == 0 ) SetScrollStepSize(_ttoi(pstrValue));
-		else if (_tcsicmp(pstrName, _T("fixedscrollbar")) == 0) SetFixedScrollbar(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if (_tcsicmp(pstrName, _T("showscrollbar")) == 0) SetShowScrollbar(_tcsicmp(pstrValue, _T("true")) == 0);
-		else CControlUI::SetAttribute(pstrName, pstrValue);
 	}
 
 	void CContainerUI::SetManager(CPaintManagerUI* pManager, CControlUI* pParent, bool bInit)
 	{
+		if( m_bLayerCache && m_pManager != pManager ) {
+			if( m_pManager != NULL ) m_pManager->RemoveLayerCache(this);
+			if( pManager != NULL ) pManager->AddLayerCache(this);
+			ReleaseLayer();
+		}
 		for( int it = 0; it < m_items.GetSize(); it++ ) {
 			static_cast<CControlUI*>(m_items[it])->SetManager(pManager, this, bInit);
 		}
@@ -871,6 +962,8 @@ namespace DuiLib
 	{
 		RECT rcTemp = { 0 };
 		if( !::IntersectRect(&rcTemp, &rcPaint, &m_rcItem) ) return true;
+		// 缓存层包含全部子控件，需要停在某个控件（截取背景）时仍逐个绘制
+		if( m_bLayerCache && !m_bLayerPainting && pStopControl == NULL && CanPaintLayer() && PaintLayer(hDC, rcTemp) ) return true;
 
 		CRenderClip clip;
 		CRenderClip::GenerateClip(hDC, rcTemp, clip);
@@ -936,6 +1029,70 @@ namespace DuiLib
 		return true;
 	}
 
+	bool CContainerUI::CanPaintLayer()
+	{
+		// 分层窗口本身就是在透明位图上绘制再修复alpha，缓存与直接绘制的结果相同
+		if( m_pManager == NULL ) return false;
+		if( m_pManager->IsLayered() ) return true;
+		// 缓存清为透明黑，子控件的GDI文字会与黑色混合；背景色铺满整个区域且不透明时才与直接绘制一致
+		if( m_dwBackColor < 0xFF000000 ) return false;
+		if( m_dwBackColor2 != 0 && m_dwBackColor2 < 0xFF000000 ) return false;
+		if( m_dwBackColor2 != 0 && m_dwBackColor3 != 0 && m_dwBackColor3 < 0xFF000000 ) return false;
+		return true;
+	}
+
+	bool CContainerUI::PaintLayer(HDC hDC, const RECT& rcPaint)
+	{
+		int cx = m_rcItem.right - m_rcItem.left;
+		int cy = m_rcItem.bottom - m_rcItem.top;
+		if( cx <= 0 || cy <= 0 || m_pManager == NULL ) return false;
+		if( m_hLayerBitmap == NULL || m_szLayer.cx != cx || m_szLayer.cy != cy ) {
+			ReleaseLayer();
+			m_hLayerBitmap = CRenderEngine::CreateARGB32Bitmap(hDC, cx, cy, &m_pLayerBits);
+			if( m_hLayerBitmap == NULL ) return false;
+			m_szLayer.cx = cx;
+			m_szLayer.cy = cy;
+			m_rcLayerDirty = m_rcItem;
+		}
+
+		RECT rcUpdate = { 0 };
+		if( ::IntersectRect(&rcUpdate, &m_rcLayerDirty, &m_rcItem) ) {
+			// 先清空，绘制过程中产生的刷新留到下一次
+			::ZeroMemory(&m_rcLayerDirty, sizeof(m_rcLayerDirty));
+			// 位图是自下而上的DIB，按相对m_rcItem左上角的坐标处理
+			CRasterizer layer;
+			layer.Attach(m_pLayerBits + (cy - 1) * cx * 4, cx, cy, -cx * 4);
+			RECT rcLayerUpdate = rcUpdate;
+			::OffsetRect(&rcLayerUpdate, -m_rcItem.left, -m_rcItem.top);
+			layer.Clear(rcLayerUpdate);
+
+			HDC hLayerDC = ::CreateCompatibleDC(hDC);
+			HBITMAP hOldBitmap = (HBITMAP) ::SelectObject(hLayerDC, m_hLayerBitmap);
+			// 控件仍按窗口坐标绘制，位图左上角对应m_rcItem的左上角
+			::SetWindowOrgEx(hLayerDC, m_rcItem.left, m_rcItem.top, NULL);
+			CSoftRenderTarget* pSoftTarget = m_pManager->IsSoftwareRender() ? new CSoftRenderTarget(hLayerDC) : NULL;
+			RECT rcOldPaint = m_rcPaint;
+			m_rcPaint = rcUpdate;
+			m_bLayerPainting = true;
+			CContainerUI::DoPaint(hLayerDC, rcUpdate, NULL);
+			m_bLayerPainting = false;
+			m_rcPaint = rcOldPaint;
+			if( pSoftTarget != NULL ) delete pSoftTarget;
+			::SelectObject(hLayerDC, hOldBitmap);
+			::DeleteDC(hLayerDC);
+			::GdiFlush();
+
+			// GDI绘制的像素（主要是文字）alpha为0，与分层窗口的处理相同，当作不透明
+			layer.RepairAlpha(rcLayerUpdate);
+		}
+
+		RECT rcBmpPart = rcPaint;
+		::OffsetRect(&rcBmpPart, -m_rcItem.left, -m_rcItem.top);
+		RECT rcCorners = { 0 };
+		CRenderEngine::DrawImage(hDC, m_hLayerBitmap, rcPaint, rcPaint, rcBmpPart, rcCorners, true);
+		return true;
+	}
+
 	void CContainerUI::SetFloatPos(int iIndex)
 	{
 		// 因为CControlUI::SetPos对float的操作影响，这里不能对float组件添加滚动条的影响
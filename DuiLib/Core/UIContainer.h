@@ -75,6 +75,17 @@ namespace DuiLib {
 		bool IsShowScrollbar();
 		void SetShowScrollbar(bool bShow);
 
+		// 缓存层：把整个子树绘制到一张预乘alpha的位图上，之后的绘制只贴这张图；
+		// 区域内有刷新（包括子孙控件的Invalidate/NeedUpdate）时只重绘缓存中变化的部分，大小变化时整个重绘
+		// 用于内容很少变化的布局容器；GDI文字要画在不透明的底色上才有正确的抗锯齿，
+		// 因此普通窗口中只有设置了不透明背景色的容器才使用缓存，否则仍直接绘制
+		bool IsLayerCache() const;
+		void SetLayerCache(bool bCache);
+		// 由CPaintManagerUI::Invalidate调用
+		void InvalidateLayer(const RECT& rcDirty);
+		// 容器和基本布局（垂直、水平、平铺、选项卡、子布局）；缓存层的位图在绘制时创建和更新，只能在窗口线程绘制
+		bool IsPaintThreadSafe() const;
+
 		virtual int FindSelectable(int iIndex, bool bForward = true) const;
 
 		RECT GetClientPos() const;
@@ -82,7 +93,10 @@ namespace DuiLib {
 		void Move(SIZE szOffset, bool bNeedInvalidate = true);
 		bool DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl);
 
-		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CControlUI::SetAttribute;
+		void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
+		bool CanCopyAttributes() const;
+		void CopyAttributes(const CControlUI* pSource);
 
 		void SetManager(CPaintManagerUI* pManager, CControlUI* pParent, bool bInit = true);
 		CControlUI* FindControl(FINDCONTROLPROC Proc, LPVOID pData, UINT uFlags);
@@ -122,6 +136,9 @@ namespace DuiLib {
 	protected:
 		virtual void SetFloatPos(int iIndex);
 		virtual void ProcessScrollBar(RECT rc, int cxRequired, int cyRequired);
+		bool CanPaintLayer();
+		bool PaintLayer(HDC hDC, const RECT& rcPaint);
+		void ReleaseLayer();
 
 	protected:
 		CStdPtrArray m_items;
@@ -140,6 +157,13 @@ namespace DuiLib {
 		CScrollBarUI* m_pHorizontalScrollBar;
 		CDuiString	m_sVerticalScrollBarStyle;
 		CDuiString	m_sHorizontalScrollBarStyle;
+
+		bool m_bLayerCache;
+		bool m_bLayerPainting;
+		HBITMAP m_hLayerBitmap;
+		LPBYTE m_pLayerBits;
+		SIZE m_szLayer;
+		RECT m_rcLayerDirty;
 	};
 
 } // namespace DuiLib
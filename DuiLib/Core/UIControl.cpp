@@ -1,6 +1,17 @@
 #include "StdAfx.h"
 
 namespace DuiLib {
+	// 分块绘制的线程中正在绘制的控件及其绘制范围，由内向外链接，都在栈上
+	typedef struct tagPAINTFRAME
+	{
+		const CControlUI* pControl;
+		RECT rcPaint;
+		tagPAINTFRAME* pOuter;
+	} PAINTFRAME;
+
+	static __declspec(thread) bool g_bPaintTileThread = false;
+	static __declspec(thread) PAINTFRAME* g_pPaintFrame = NULL;
+
 	IMPLEMENT_DUICONTROL(CControlUI)
 
 		CControlUI::CControlUI()
@@ -34,7 +45,8 @@ namespace DuiLib {
 		m_nBorderStyle(PS_SOLID),
 		m_nTooltipWidth(300),
 		m_wCursor(0),
-		m_instance(NULL)
+		m_instance(NULL),
+		m_pPrototype(NULL)
 	{
 		m_cXY.cx = m_cXY.cy = 0;
 		m_cxyFixed.cx = m_cxyFixed.cy = 0;
@@ -54,6 +66,7 @@ namespace DuiLib {
 		if( OnDestroy ) OnDestroy(this);
 		RemoveAllCustomAttribute();	
 		if( m_pManager != NULL ) m_pManager->ReapObjects(this);
+		if( m_pPrototype != NULL ) m_pPrototype->Release();
 	}
 
 	CDuiString CControlUI::GetName() const
@@ -351,7 +364,7 @@ namespace DuiLib {
 
 	bool CControlUI::DrawImage(HDC hDC, LPCTSTR pStrImage, LPCTSTR pStrModify)
 	{
-		return CRenderEngine::DrawImageString(hDC, m_pManager, m_rcItem, m_rcPaint, pStrImage, pStrModify, m_instance);
+		return CRenderEngine::DrawImageString(hDC, m_pManager, m_rcItem, GetPaintRect(), pStrImage, pStrModify, m_instance);
 	}
 
 	const RECT& CControlUI::GetPos() const
@@ -938,20 +951,28 @@ namespace DuiLib {
 	}
 
 	void CControlUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		// 属性名只在这里查一次编号，派生类各自switch，未处理的交给基类
+		SetAttribute(CAttributeId::Find(pstrName), pstrName, pstrValue);
+	}
+
+	void CControlUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
 	{
 		// 样式表
-		if(m_pManager != NULL &&  _tcsicmp(pstrName, _T("style")) == 0) {
-			LPCTSTR pStyle = m_pManager->GetStyle(pstrValue);
+		if(m_pManager != NULL && iId == DUI_ATTR_STYLE) {
+			const CAttributeList* pStyle = m_pManager->GetStyleAttributes(pstrValue);
 			if( pStyle != NULL) {
 				ApplyAttributeList(pStyle);
 				return;
 			}
 		}
 		// 属性
-		if( _tcsicmp(pstrName, _T("innerstyle")) == 0 ) {
+		switch( iId ) {
+		case DUI_ATTR_INNERSTYLE: {
 			ApplyAttributeList(pstrValue);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("pos")) == 0 ) {
+		case DUI_ATTR_POS: {
 			RECT rcPos = { 0 };
 			LPTSTR pstr = NULL;
 			rcPos.left = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);    
@@ -962,8 +983,9 @@ namespace DuiLib {
 			SetFixedXY(szXY);
 			SetFixedWidth(abs(rcPos.right - rcPos.left));
 			SetFixedHeight(abs(rcPos.bottom - rcPos.top));
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("float")) == 0 ) {
+		case DUI_ATTR_FLOAT: {
 			CDuiString nValue = pstrValue;
 			// 动态计算相对比例
 			if(nValue.Find(',') < 0) {
@@ -979,8 +1001,9 @@ namespace DuiLib {
 				SetFloatPercent(piFloatPercent);
 				SetFloat(true);
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("floatalign")) == 0) {
+		case DUI_ATTR_FLOATALIGN: {
 			UINT uAlign = GetFloatAlign();
 			// 解析文字属性
 			while( *pstrValue != _T('\0') ) {
@@ -1022,8 +1045,9 @@ namespace DuiLib {
 				}
 			}
 			SetFloatAlign(uAlign);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("padding")) == 0 ) {
+		case DUI_ATTR_PADDING: {
 			RECT rcPadding = { 0 };
 			LPTSTR pstr = NULL;
 			rcPadding.left = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);    
@@ -1031,50 +1055,57 @@ namespace DuiLib {
 			rcPadding.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
 			rcPadding.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);    
 			SetPadding(rcPadding);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("gradient")) == 0 ) SetGradient(pstrValue);
-		else if( _tcsicmp(pstrName, _T("bkcolor")) == 0 || _tcsicmp(pstrName, _T("bkcolor1")) == 0 ) {
+		case DUI_ATTR_GRADIENT: SetGradient(pstrValue); break;
+		case DUI_ATTR_BKCOLOR: case DUI_ATTR_BKCOLOR1: {
 			while( *pstrValue > _T('\0') && *pstrValue <= _T(' ') ) pstrValue = ::CharNext(pstrValue);
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetBkColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("bkcolor2")) == 0 ) {
+		case DUI_ATTR_BKCOLOR2: {
 			while( *pstrValue > _T('\0') && *pstrValue <= _T(' ') ) pstrValue = ::CharNext(pstrValue);
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetBkColor2(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("bkcolor3")) == 0 ) {
+		case DUI_ATTR_BKCOLOR3: {
 			while( *pstrValue > _T('\0') && *pstrValue <= _T(' ') ) pstrValue = ::CharNext(pstrValue);
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetBkColor3(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("forecolor")) == 0 ) {
+		case DUI_ATTR_FORECOLOR: {
 			while( *pstrValue > _T('\0') && *pstrValue <= _T(' ') ) pstrValue = ::CharNext(pstrValue);
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetForeColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("bordercolor")) == 0 ) {
+		case DUI_ATTR_BORDERCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetBorderColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("focusbordercolor")) == 0 ) {
+		case DUI_ATTR_FOCUSBORDERCOLOR: {
 			if( *pstrValue == _T('#')) pstrValue = ::CharNext(pstrValue);
 			LPTSTR pstr = NULL;
 			DWORD clrColor = _tcstoul(pstrValue, &pstr, 16);
 			SetFocusBorderColor(clrColor);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("colorhsl")) == 0 ) SetColorHSL(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("bordersize")) == 0 ) {
+		case DUI_ATTR_COLORHSL: SetColorHSL(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_BORDERSIZE: {
 			CDuiString nValue = pstrValue;
 			if(nValue.Find(',') < 0) {
 				SetBorderSize(_ttoi(pstrValue));
@@ -1090,43 +1121,48 @@ namespace DuiLib {
 				rcPadding.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);
 				SetBorderSize(rcPadding);
 			}
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("leftbordersize")) == 0 ) SetLeftBorderSize(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("topbordersize")) == 0 ) SetTopBorderSize(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("rightbordersize")) == 0 ) SetRightBorderSize(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("bottombordersize")) == 0 ) SetBottomBorderSize(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("borderstyle")) == 0 ) SetBorderStyle(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("borderround")) == 0 ) {
+		case DUI_ATTR_LEFTBORDERSIZE: SetLeftBorderSize(_ttoi(pstrValue)); break;
+		case DUI_ATTR_TOPBORDERSIZE: SetTopBorderSize(_ttoi(pstrValue)); break;
+		case DUI_ATTR_RIGHTBORDERSIZE: SetRightBorderSize(_ttoi(pstrValue)); break;
+		case DUI_ATTR_BOTTOMBORDERSIZE: SetBottomBorderSize(_ttoi(pstrValue)); break;
+		case DUI_ATTR_BORDERSTYLE: SetBorderStyle(_ttoi(pstrValue)); break;
+		case DUI_ATTR_BORDERROUND: {
 			SIZE cxyRound = { 0 };
 			LPTSTR pstr = NULL;
 			cxyRound.cx = _tcstol(pstrValue, &pstr, 10);  ASSERT(pstr);    
 			cxyRound.cy = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);
 			SetBorderRound(cxyRound);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("bkimage")) == 0 ) SetBkImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("foreimage")) == 0 ) SetForeImage(pstrValue);
-		else if( _tcsicmp(pstrName, _T("width")) == 0 ) SetFixedWidth(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("height")) == 0 ) SetFixedHeight(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("minwidth")) == 0 ) SetMinWidth(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("minheight")) == 0 ) SetMinHeight(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("maxwidth")) == 0 ) SetMaxWidth(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("maxheight")) == 0 ) SetMaxHeight(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("name")) == 0 ) SetName(pstrValue);
-		else if( _tcsicmp(pstrName, _T("drag")) == 0 ) SetDragEnable(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("drop")) == 0 ) SetDropEnable(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("resourcetext")) == 0 ) SetResourceText(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("richevent")) == 0 ) SetRichEvent(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("text")) == 0 ) SetText(pstrValue);
-		else if( _tcsicmp(pstrName, _T("tooltip")) == 0 ) SetToolTip(pstrValue);
-		else if( _tcsicmp(pstrName, _T("userdata")) == 0 ) SetUserData(pstrValue);
-		else if( _tcsicmp(pstrName, _T("enabled")) == 0 ) SetEnabled(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("mouse")) == 0 ) SetMouseEnabled(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("keyboard")) == 0 ) SetKeyboardEnabled(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("visible")) == 0 ) SetVisible(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("float")) == 0 ) SetFloat(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("shortcut")) == 0 ) SetShortcut(pstrValue[0]);
-		else if( _tcsicmp(pstrName, _T("menu")) == 0 ) SetContextMenuUsed(_tcsicmp(pstrValue, _T("true")) == 0);
-		else if( _tcsicmp(pstrName, _T("cursor")) == 0 && pstrValue) {
+		case DUI_ATTR_BKIMAGE: SetBkImage(pstrValue); break;
+		case DUI_ATTR_FOREIMAGE: SetForeImage(pstrValue); break;
+		case DUI_ATTR_WIDTH: SetFixedWidth(_ttoi(pstrValue)); break;
+		case DUI_ATTR_HEIGHT: SetFixedHeight(_ttoi(pstrValue)); break;
+		case DUI_ATTR_MINWIDTH: SetMinWidth(_ttoi(pstrValue)); break;
+		case DUI_ATTR_MINHEIGHT: SetMinHeight(_ttoi(pstrValue)); break;
+		case DUI_ATTR_MAXWIDTH: SetMaxWidth(_ttoi(pstrValue)); break;
+		case DUI_ATTR_MAXHEIGHT: SetMaxHeight(_ttoi(pstrValue)); break;
+		case DUI_ATTR_NAME: SetName(pstrValue); break;
+		case DUI_ATTR_DRAG: SetDragEnable(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_DROP: SetDropEnable(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_RESOURCETEXT: SetResourceText(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_RICHEVENT: SetRichEvent(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_TEXT: SetText(pstrValue); break;
+		case DUI_ATTR_TOOLTIP: SetToolTip(pstrValue); break;
+		case DUI_ATTR_USERDATA: SetUserData(pstrValue); break;
+		case DUI_ATTR_ENABLED: SetEnabled(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_MOUSE: SetMouseEnabled(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_KEYBOARD: SetKeyboardEnabled(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_VISIBLE: SetVisible(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_SHORTCUT: SetShortcut(pstrValue[0]); break;
+		case DUI_ATTR_MENU: SetContextMenuUsed(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		case DUI_ATTR_CURSOR: {
+			if( pstrValue == NULL ) {
+				AddCustomAttribute(pstrName, pstrValue);
+				break;
+			}
 			if( _tcsicmp(pstrValue, _T("arrow")) == 0 )			SetCursor(DUI_ARROW);
 			else if( _tcsicmp(pstrValue, _T("ibeam")) == 0 )	SetCursor(DUI_IBEAM);
 			else if( _tcsicmp(pstrValue, _T("wait")) == 0 )		SetCursor(DUI_WAIT);
@@ -1141,10 +1177,10 @@ namespace DuiLib {
 			else if( _tcsicmp(pstrValue, _T("sizeall")) == 0 )	SetCursor(DUI_SIZEALL);
 			else if( _tcsicmp(pstrValue, _T("no")) == 0 )		SetCursor(DUI_NO);
 			else if( _tcsicmp(pstrValue, _T("hand")) == 0 )		SetCursor(DUI_HAND);
+			break;
 		}
-		else if( _tcsicmp(pstrName, _T("virtualwnd")) == 0 ) SetVirtualWnd(pstrValue);
-		else {
-			AddCustomAttribute(pstrName, pstrValue);
+		case DUI_ATTR_VIRTUALWND: SetVirtualWnd(pstrValue); break;
+		default: AddCustomAttribute(pstrName, pstrValue); break;
 		}
 	}
 
@@ -1152,59 +1188,99 @@ namespace DuiLib {
 	{
 		// 解析样式表
 		if(m_pManager != NULL) {
-			LPCTSTR pStyle = m_pManager->GetStyle(pstrValue);
+			const CAttributeList* pStyle = m_pManager->GetStyleAttributes(pstrValue);
 			if( pStyle != NULL) {
 				return ApplyAttributeList(pStyle);
 			}
 		}
-		CDuiString sXmlData = pstrValue;
-        sXmlData.Replace(_T("&quot;"), _T("\""));
-        sXmlData.Replace(_T("\r"), _T(" "));
-        sXmlData.Replace(_T("\n"), _T(" "));
-        sXmlData.Replace(_T("\t"), _T(" "));
-        sXmlData.Trim();
-
-		LPCTSTR pstrList = sXmlData.GetData();
 		// 解析样式属性
-		CDuiString sItem;
-		CDuiString sValue;
-		while( *pstrList != _T('\0') ) {
-			sItem.Empty();
-			sValue.Empty();
-            while (*pstrList != _T('\0')  && (*pstrList == _T(' ')) )
-            {
-				pstrList++;
-            }
-			while( *pstrList != _T('\0') && *pstrList != _T('=') ) {
-				LPTSTR pstrTemp = ::CharNext(pstrList);
-				while( pstrList < pstrTemp) {
-					sItem += *pstrList++;
-				}
-			}			
-			ASSERT( *pstrList == _T('=') );
-			if( *pstrList++ != _T('=') ) return this;
-			ASSERT( *pstrList == _T('\"') );
-			if( *pstrList++ != _T('\"') ) return this;
-			while( *pstrList != _T('\0') && *pstrList != _T('\"') ) {
-				LPTSTR pstrTemp = ::CharNext(pstrList);
-				while( pstrList < pstrTemp) {
-					sValue += *pstrList++;
-				}
-			}
-			ASSERT( *pstrList == _T('\"') );
-			if( *pstrList++ != _T('\"') ) return this;
-			SetAttribute(sItem, sValue);
-			if( *pstrList != _T(' ') && *pstrList != _T(',') )
-			{
-				return this;
-			}else
-			{
-                ++pstrList;
-			}
+		CAttributeList attrList(pstrValue);
+		return ApplyAttributeList(&attrList);
+	}
+
+	CControlUI* CControlUI::ApplyAttributeList(const CAttributeList* pList)
+	{
+		if( pList == NULL ) return this;
+		for( int i = 0; i < pList->GetCount(); i++ ) {
+			SetAttribute(pList->GetName(i), pList->GetValue(i));
 		}
 		return this;
 	}
 
+	CControlUI* CControlUI::Clone()
+	{
+		if( m_pPrototype == NULL ) return NULL;
+		return m_pPrototype->Instantiate(m_pManager);
+	}
+
+	bool CControlUI::CanCopyAttributes() const
+	{
+		return typeid(*this) == typeid(CControlUI);
+	}
+
+	void CControlUI::CopyAttributes(const CControlUI* pSource)
+	{
+		m_sVirtualWnd = pSource->m_sVirtualWnd;
+		m_sName = pSource->m_sName;
+		m_bMenuUsed = pSource->m_bMenuUsed;
+		m_rcPadding = pSource->m_rcPadding;
+		m_cXY = pSource->m_cXY;
+		m_cxyFixed = pSource->m_cxyFixed;
+		m_cxyMin = pSource->m_cxyMin;
+		m_cxyMax = pSource->m_cxyMax;
+		m_bVisible = pSource->m_bVisible;
+		m_bEnabled = pSource->m_bEnabled;
+		m_bMouseEnabled = pSource->m_bMouseEnabled;
+		m_bKeyboardEnabled = pSource->m_bKeyboardEnabled;
+		m_bFloat = pSource->m_bFloat;
+		m_piFloatPercent = pSource->m_piFloatPercent;
+		m_uFloatAlign = pSource->m_uFloatAlign;
+		m_bRichEvent = pSource->m_bRichEvent;
+		m_bDragEnabled = pSource->m_bDragEnabled;
+		m_bDropEnabled = pSource->m_bDropEnabled;
+		m_bResourceText = pSource->m_bResourceText;
+		m_sText = pSource->m_sText;
+		m_sToolTip = pSource->m_sToolTip;
+		m_chShortcut = pSource->m_chShortcut;
+		m_sUserData = pSource->m_sUserData;
+		m_sGradient = pSource->m_sGradient;
+		m_dwBackColor = pSource->m_dwBackColor;
+		m_dwBackColor2 = pSource->m_dwBackColor2;
+		m_dwBackColor3 = pSource->m_dwBackColor3;
+		m_dwForeColor = pSource->m_dwForeColor;
+		m_sBkImage = pSource->m_sBkImage;
+		m_sForeImage = pSource->m_sForeImage;
+		m_dwBorderColor = pSource->m_dwBorderColor;
+		m_dwFocusBorderColor = pSource->m_dwFocusBorderColor;
+		m_bColorHSL = pSource->m_bColorHSL;
+		m_nBorderSize = pSource->m_nBorderSize;
+		m_nBorderStyle = pSource->m_nBorderStyle;
+		m_nTooltipWidth = pSource->m_nTooltipWidth;
+		m_wCursor = pSource->m_wCursor;
+		m_cxyBorderRound = pSource->m_cxyBorderRound;
+		m_rcBorderSize = pSource->m_rcBorderSize;
+		m_instance = pSource->m_instance;
+		for( int i = 0; i < pSource->m_mCustomAttrHash.GetSize(); i++ ) {
+			if( LPCTSTR key = pSource->m_mCustomAttrHash.GetAt(i) ) {
+				const CDuiString* pValue = static_cast<const CDuiString*>(pSource->m_mCustomAttrHash.Find(key));
+				if( pValue != NULL ) AddCustomAttribute(key, *pValue);
+			}
+		}
+		m_bUpdateNeeded = true;
+	}
+
+	CControlPrototype* CControlUI::GetPrototype() const
+	{
+		return m_pPrototype;
+	}
+
+	void CControlUI::SetPrototype(CControlPrototype* pPrototype)
+	{
+		if( pPrototype != NULL ) pPrototype->AddRef();
+		if( m_pPrototype != NULL ) m_pPrototype->Release();
+		m_pPrototype = pPrototype;
+	}
+
 	SIZE CControlUI::EstimateSize(SIZE szAvailable)
 	{
 		if(m_pManager != NULL)
@@ -1215,9 +1291,31 @@ namespace DuiLib {
 	bool CControlUI::Paint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
 	{
 		if (pStopControl == this) return false;
-		if( !::IntersectRect(&m_rcPaint, &rcPaint, &m_rcItem) ) return true;
-		if (!DoPaint(hDC, m_rcPaint, pStopControl)) return false;
-		return true;
+		if( !g_bPaintTileThread ) {
+			if( !::IntersectRect(&m_rcPaint, &rcPaint, &m_rcItem) ) return true;
+			if (!DoPaint(hDC, m_rcPaint, pStopControl)) return false;
+			return true;
+		}
+		PAINTFRAME frame = { this, { 0 }, g_pPaintFrame };
+		if( !::IntersectRect(&frame.rcPaint, &rcPaint, &m_rcItem) ) return true;
+		g_pPaintFrame = &frame;
+		bool bContinue = DoPaint(hDC, frame.rcPaint, pStopControl);
+		g_pPaintFrame = frame.pOuter;
+		return bContinue;
+	}
+
+	const RECT& CControlUI::GetPaintRect() const
+	{
+		for( const PAINTFRAME* pFrame = g_pPaintFrame; pFrame != NULL; pFrame = pFrame->pOuter ) {
+			if( pFrame->pControl == this ) return pFrame->rcPaint;
+		}
+		return m_rcPaint;
+	}
+
+	void CControlUI::SetPaintTileThread(bool bTileThread)
+	{
+		g_bPaintTileThread = bTileThread;
+		g_pPaintFrame = NULL;
 	}
 
 	bool CControlUI::DoPaint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl)
@@ -1228,7 +1326,7 @@ namespace DuiLib {
 
 		if( cxyBorderRound.cx > 0 || cxyBorderRound.cy > 0 ) {
 			CRenderClip roundClip;
-			CRenderClip::GenerateRoundClip(hDC, m_rcPaint,  m_rcItem, cxyBorderRound.cx, cxyBorderRound.cy, roundClip);
+			CRenderClip::GenerateRoundClip(hDC, GetPaintRect(),  m_rcItem, cxyBorderRound.cx, cxyBorderRound.cy, roundClip);
 			PaintBkColor(hDC);
 			PaintBkImage(hDC);
 			PaintStatusImage(hDC);
@@ -1266,7 +1364,7 @@ namespace DuiLib {
 					CRenderEngine::DrawGradient(hDC, m_rcItem, GetAdjustColor(m_dwBackColor), GetAdjustColor(m_dwBackColor2), bVer, 16);
 				}
 			}
-			else if( m_dwBackColor >= 0xFF000000 ) CRenderEngine::DrawColor(hDC, m_rcPaint, GetAdjustColor(m_dwBackColor));
+			else if( m_dwBackColor >= 0xFF000000 ) CRenderEngine::DrawColor(hDC, GetPaintRect(), GetAdjustColor(m_dwBackColor));
 			else CRenderEngine::DrawColor(hDC, m_rcItem, GetAdjustColor(m_dwBackColor));
 		}
 	}
@@ -1354,6 +1452,11 @@ namespace DuiLib {
 		return;
 	}
 
+	bool CControlUI::IsPaintThreadSafe() const
+	{
+		return _tcscmp(GetClass(), _T("ControlUI")) == 0;
+	}
+
 	int CControlUI::GetLeftBorderSize() const
 	{
 		RECT rcBorderSize = m_rcBorderSize;
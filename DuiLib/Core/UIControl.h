@@ -10,6 +10,8 @@ namespace DuiLib {
 
 	typedef CControlUI* (CALLBACK* FINDCONTROLPROC)(CControlUI*, LPVOID);
 
+	class CControlPrototype;
+
 	class UILIB_API CControlUI
 	{
 		DECLARE_DUICONTROL(CControlUI)
@@ -181,8 +183,21 @@ namespace DuiLib {
 		bool RemoveCustomAttribute(LPCTSTR pstrName);
 		void RemoveAllCustomAttribute();
 
+		// 属性名在这里换成编号（CAttributeId），再沿派生类的SetAttribute(iId, ...)传到基类；
+		// 按名字比较的派生类重写前一个，未处理的属性交给基类的同名函数
 		virtual void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		virtual void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
 		CControlUI* ApplyAttributeList(LPCTSTR pstrList);
+		CControlUI* ApplyAttributeList(const CAttributeList* pList);
+
+		// 由CDialogBuilder::CreatePrototype生成的控件可以直接复制，其它控件返回NULL
+		virtual CControlUI* Clone();
+		// 原型用来按值复制控件：CopyAttributes复制属性设置的值，不复制父控件、管理器、子控件、位置和鼠标等运行状态。
+		// 只有对象的类型正好是重写了这两个函数的类时CanCopyAttributes才返回true，其它控件按属性表重新设置
+		virtual bool CanCopyAttributes() const;
+		virtual void CopyAttributes(const CControlUI* pSource);
+		CControlPrototype* GetPrototype() const;
+		void SetPrototype(CControlPrototype* pPrototype);
 
 		virtual SIZE EstimateSize(SIZE szAvailable);
 		virtual bool Paint(HDC hDC, const RECT& rcPaint, CControlUI* pStopControl = NULL); // 返回要不要继续绘制
@@ -196,6 +211,15 @@ namespace DuiLib {
 		virtual void PaintBorder(HDC hDC);
 
 		virtual void DoPostPaint(HDC hDC, const RECT& rcPaint);
+		// 分块并行绘制时DoPaint可能在线程池中执行，脏区域内有返回false的控件时整块在窗口线程绘制
+		// 只有审查过绘制过程的类返回true（控件、标签、按钮、选项、容器和基本布局），并且只认本类：
+		// 按GetClass判断，派生类默认返回false，确认绘制中不使用定时器、原生窗口、COM对象，
+		// 也不修改绘制之外的状态后再重载；可以在线程池中绘制的控件用GetPaintRect()取得绘制范围，不直接读写m_rcPaint
+		virtual bool IsPaintThreadSafe() const;
+		// 当前线程中本控件的绘制范围，即Paint传入的范围与m_rcItem的交集
+		const RECT& GetPaintRect() const;
+		// 分块绘制的线程在绘制本块前后调用：期间Paint把绘制范围记在线程中，不写入控件共享的m_rcPaint
+		static void SetPaintTileThread(bool bTileThread);
 
 		//虚拟窗口参数
 		void SetVirtualWnd(LPCTSTR pstrValue);
@@ -261,6 +285,7 @@ namespace DuiLib {
 		RECT m_rcPaint;
 		RECT m_rcBorderSize;
 	    HINSTANCE m_instance;
+		CControlPrototype* m_pPrototype;
 
 		CStdStringPtrMap m_mCustomAttrHash;
 	};
@@ -0,0 +1,191 @@
+﻿#include "UIDirtyRegion.h"
+#include <assert.h>
+
+namespace DuiLib {
+
+	static inline LONGLONG RectArea(const RECT& rc)
+	{
+		return (LONGLONG)(rc.right - rc.left) * (rc.bottom - rc.top);
+	}
+
+	static inline bool IsDirtyRectEmpty(const RECT& rc)
+	{
+		return rc.left >= rc.right || rc.top >= rc.bottom;
+	}
+
+	static inline void SetDirtyRect(RECT& rc, LONG left, LONG top, LONG right, LONG bottom)
+	{
+		rc.left = left;
+		rc.top = top;
+		rc.right = right;
+		rc.bottom = bottom;
+	}
+
+	// 与IntersectRect、UnionRect相同：不相交时为空矩形并返回false，空矩形不参与合并；rc可以是参数之一
+	static bool IntersectDirtyRect(RECT& rc, const RECT& rc1, const RECT& rc2)
+	{
+		SetDirtyRect(rc, rc1.left > rc2.left ? rc1.left : rc2.left, rc1.top > rc2.top ? rc1.top : rc2.top,
+			rc1.right < rc2.right ? rc1.right : rc2.right, rc1.bottom < rc2.bottom ? rc1.bottom : rc2.bottom);
+		if( !IsDirtyRectEmpty(rc) ) return true;
+		SetDirtyRect(rc, 0, 0, 0, 0);
+		return false;
+	}
+
+	static void UnionDirtyRect(RECT& rc, const RECT& rc1, const RECT& rc2)
+	{
+		if( IsDirtyRectEmpty(rc1) ) {
+			if( IsDirtyRectEmpty(rc2) ) SetDirtyRect(rc, 0, 0, 0, 0);
+			else rc = rc2;
+			return;
+		}
+		if( IsDirtyRectEmpty(rc2) ) {
+			rc = rc1;
+			return;
+		}
+		SetDirtyRect(rc, rc1.left < rc2.left ? rc1.left : rc2.left, rc1.top < rc2.top ? rc1.top : rc2.top,
+			rc1.right > rc2.right ? rc1.right : rc2.right, rc1.bottom > rc2.bottom ? rc1.bottom : rc2.bottom);
+	}
+
+	CDirtyRegion::CDirtyRegion() : m_nCount(0)
+	{
+	}
+
+	void CDirtyRegion::Empty()
+	{
+		m_nCount = 0;
+	}
+
+	bool CDirtyRegion::IsEmpty() const
+	{
+		return m_nCount == 0;
+	}
+
+	void CDirtyRegion::Add(const RECT& rc)
+	{
+		if( rc.right <= rc.left || rc.bottom <= rc.top ) return;
+
+		RECT rcNew = rc;
+		for( ;; ) {
+			int iBest = -1;
+			LONGLONG llBestWaste = 0;
+			bool bMerged = false;
+			for( int i = 0; i < m_nCount; i++ ) {
+				const RECT& rcOld = m_aRects[i];
+				if( rcOld.left <= rcNew.left && rcOld.top <= rcNew.top && rcOld.right >= rcNew.right && rcOld.bottom >= rcNew.bottom ) return;
+
+				RECT rcUnion = { 0 };
+				UnionDirtyRect(rcUnion, rcOld, rcNew);
+				LONGLONG llWaste = RectArea(rcUnion) - RectArea(rcOld) - RectArea(rcNew);
+				RECT rcInter = { 0 };
+				// 相交的必须合并，保证矩形互不相交；多出的面积少于一遍遍历的开销也合并
+				if( IntersectDirtyRect(rcInter, rcOld, rcNew) || llWaste <= DIRTY_MERGE_AREA ) {
+					rcNew = rcUnion;
+					_Remove(i);
+					bMerged = true;
+					break;
+				}
+				if( iBest < 0 || llWaste < llBestWaste ) {
+					iBest = i;
+					llBestWaste = llWaste;
+				}
+			}
+			// 合并后变大的矩形可能与其它矩形相交，重新检查一遍
+			if( bMerged ) continue;
+			if( m_nCount < DIRTY_RECT_MAX ) {
+				m_aRects[m_nCount++] = rcNew;
+				return;
+			}
+			// 已满：已有的两个矩形合并更省时先合并它们，腾出位置；否则新矩形并入最合适的一个
+			int iPair = -1, jPair = -1;
+			for( int i = 0; i < m_nCount; i++ ) {
+				for( int j = i + 1; j < m_nCount; j++ ) {
+					RECT rcUnion = { 0 };
+					UnionDirtyRect(rcUnion, m_aRects[i], m_aRects[j]);
+					LONGLONG llWaste = RectArea(rcUnion) - RectArea(m_aRects[i]) - RectArea(m_aRects[j]);
+					if( llWaste < llBestWaste ) {
+						iPair = i;
+						jPair = j;
+						llBestWaste = llWaste;
+					}
+				}
+			}
+			if( iPair >= 0 ) {
+				RECT rcUnion = { 0 };
+				UnionDirtyRect(rcUnion, m_aRects[iPair], m_aRects[jPair]);
+				// jPair > iPair，先去掉后面的，不影响前面的位置
+				_Remove(jPair);
+				_Remove(iPair);
+				Add(rcUnion);
+				continue;
+			}
+			UnionDirtyRect(rcNew, rcNew, m_aRects[iBest]);
+			_Remove(iBest);
+		}
+	}
+
+	void CDirtyRegion::Add(const CDirtyRegion& region)
+	{
+		for( int i = 0; i < region.m_nCount; i++ ) Add(region.m_aRects[i]);
+	}
+
+#ifdef _WIN32
+	void CDirtyRegion::Add(HRGN hRgn)
+	{
+		if( hRgn == NULL ) return;
+		DWORD dwSize = ::GetRegionData(hRgn, 0, NULL);
+		if( dwSize == 0 ) return;
+		// 常见的更新区域只有几个矩形，先用栈上的缓冲区
+		BYTE aBuffer[sizeof(RGNDATAHEADER) + 16 * sizeof(RECT)];
+		LPBYTE pBuffer = dwSize <= sizeof(aBuffer) ? aBuffer : new BYTE[dwSize];
+		LPRGNDATA pRgnData = (LPRGNDATA)pBuffer;
+		if( ::GetRegionData(hRgn, dwSize, pRgnData) != 0 ) {
+			const RECT* pRects = (const RECT*)pRgnData->Buffer;
+			for( DWORD i = 0; i < pRgnData->rdh.nCount; i++ ) Add(pRects[i]);
+		}
+		if( pBuffer != aBuffer ) delete[] pBuffer;
+	}
+#endif
+
+	void CDirtyRegion::Clip(const RECT& rcClip)
+	{
+		for( int i = 0; i < m_nCount; ) {
+			if( !IntersectDirtyRect(m_aRects[i], m_aRects[i], rcClip) ) {
+				_Remove(i);
+				continue;
+			}
+			++i;
+		}
+	}
+
+	int CDirtyRegion::GetCount() const
+	{
+		return m_nCount;
+	}
+
+	const RECT& CDirtyRegion::GetAt(int iIndex) const
+	{
+		assert(iIndex >= 0 && iIndex < m_nCount);
+		return m_aRects[iIndex];
+	}
+
+	RECT CDirtyRegion::GetBounds() const
+	{
+		RECT rcBounds = { 0 };
+		for( int i = 0; i < m_nCount; i++ ) UnionDirtyRect(rcBounds, rcBounds, m_aRects[i]);
+		return rcBounds;
+	}
+
+	DWORD CDirtyRegion::GetArea() const
+	{
+		LONGLONG llArea = 0;
+		for( int i = 0; i < m_nCount; i++ ) llArea += RectArea(m_aRects[i]);
+		return (DWORD)llArea;
+	}
+
+	void CDirtyRegion::_Remove(int iIndex)
+	{
+		// 顺序无关，用最后一个填补
+		m_aRects[iIndex] = m_aRects[--m_nCount];
+	}
+
+} // namespace DuiLib
@@ -0,0 +1,54 @@
+﻿#ifndef __UIDIRTYREGION_H__
+#define __UIDIRTYREGION_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// 脏区域：最多保存DIRTY_RECT_MAX个互不相交的矩形
+	// 加入的矩形与已有矩形相交时合并；不相交时合并多出的面积小于DIRTY_MERGE_AREA也合并，否则单独保存；
+	// 矩形已满时在所有两两组合中合并多出面积最小的一对
+	// 每个矩形对应控件树的一遍绘制，矩形互不相交，同一像素不会重绘两次
+	// 除了Add(HRGN)只使用RECT和C运行库，不依赖窗口
+	class UILIB_API CDirtyRegion
+	{
+	public:
+		enum
+		{
+			DIRTY_RECT_MAX = 8,
+			// 一遍控件树遍历的固定开销，折算成像素数
+			DIRTY_MERGE_AREA = 64 * 64,
+		};
+
+		CDirtyRegion();
+
+		void Empty();
+		bool IsEmpty() const;
+		void Add(const RECT& rc);
+		void Add(const CDirtyRegion& region);
+#ifdef _WIN32
+		// 逐个加入区域分解出的矩形
+		void Add(HRGN hRgn);
+#endif
+		// 所有矩形与rcClip求交，空矩形被去掉
+		void Clip(const RECT& rcClip);
+
+		int GetCount() const;
+		const RECT& GetAt(int iIndex) const;
+		RECT GetBounds() const;
+		// 像素数
+		DWORD GetArea() const;
+
+	private:
+		void _Remove(int iIndex);
+
+	private:
+		RECT m_aRects[DIRTY_RECT_MAX];
+		int m_nCount;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIDIRTYREGION_H__
@@ -2,6 +2,184 @@
 
 namespace DuiLib {
 
+	enum { ATTACH_OK, ATTACH_DELETED, ATTACH_FAILED };
+
+	// 挂到父控件上。因为某些属性和父窗口相关，比如selected，必须先Add到父窗口
+	static int AttachControl(CControlUI* pControl, CControlUI* pParent, IContainerUI*& pContainer, CTreeViewUI*& pTreeView)
+	{
+		pTreeView = NULL;
+		if( pParent == NULL || pControl == NULL ) return ATTACH_OK;
+
+		CTreeNodeUI* pParentTreeNode = static_cast<CTreeNodeUI*>(pParent->GetInterface(_T("TreeNode")));
+		CTreeNodeUI* pTreeNode = static_cast<CTreeNodeUI*>(pControl->GetInterface(_T("TreeNode")));
+		pTreeView = static_cast<CTreeViewUI*>(pParent->GetInterface(_T("TreeView")));
+		// TreeNode子节点
+		if(pTreeNode != NULL) {
+			if(pParentTreeNode) {
+				pTreeView = pParentTreeNode->GetTreeView();
+				if(!pParentTreeNode->Add(pTreeNode)) {
+					delete pTreeNode;
+					return ATTACH_DELETED;
+				}
+			}
+			else {
+				if(pTreeView != NULL) {
+					if(!pTreeView->Add(pTreeNode)) {
+						delete pTreeNode;
+						return ATTACH_DELETED;
+					}
+				}
+			}
+		}
+		// TreeNode子控件
+		else if(pParentTreeNode != NULL) {
+			pParentTreeNode->GetTreeNodeHoriznotal()->Add(pControl);
+		}
+		// 普通控件
+		else {
+			if( pContainer == NULL ) pContainer = static_cast<IContainerUI*>(pParent->GetInterface(_T("IContainer")));
+			ASSERT(pContainer);
+			if( pContainer == NULL ) return ATTACH_FAILED;
+			if( !pContainer->Add(pControl) ) {
+				delete pControl;
+				return ATTACH_DELETED;
+			}
+		}
+		return ATTACH_OK;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	CControlPrototype::CControlPrototype() : m_pfnCreate(NULL), m_pCallback(NULL), m_pAttributes(NULL), m_nRepeat(1), m_nRef(1),
+		m_pTemplate(NULL), m_pTemplateManager(NULL)
+	{
+	}
+
+	CControlPrototype::~CControlPrototype()
+	{
+		for( int i = 0; i < m_aChildren.GetSize(); i++ ) static_cast<CControlPrototype*>(m_aChildren[i])->Release();
+		if( m_pAttributes != NULL ) delete m_pAttributes;
+		if( m_pTemplate != NULL ) delete m_pTemplate;
+	}
+
+	void CControlPrototype::AddRef()
+	{
+		::InterlockedIncrement(&m_nRef);
+	}
+
+	void CControlPrototype::Release()
+	{
+		if( ::InterlockedDecrement(&m_nRef) == 0 ) delete this;
+	}
+
+	CControlUI* CControlPrototype::Instantiate(CPaintManagerUI* pManager, CControlUI* pParent)
+	{
+		if( m_sClass.IsEmpty() ) {
+			return _Instantiate(reinterpret_cast<CControlPrototype**>(m_aChildren.GetData()), m_aChildren.GetSize(), pManager, pParent);
+		}
+		CControlPrototype* pThis = this;
+		return _Instantiate(&pThis, 1, pManager, pParent);
+	}
+
+	CControlUI* CControlPrototype::_Instantiate(CControlPrototype** ppNodes, int nNodes, CPaintManagerUI* pManager, CControlUI* pParent)
+	{
+		// 与CDialogBuilder::_Parse的流程一致，只是类名和属性都已经解析好了
+		IContainerUI* pContainer = NULL;
+		CControlUI* pReturn = NULL;
+		for( int i = 0; i < nNodes; i++ ) {
+			CControlPrototype* pNode = ppNodes[i];
+			if( pNode->m_sClass.IsEmpty() ) {
+				for( int j = 0; j < pNode->m_nRepeat; j++ ) {
+					_Instantiate(reinterpret_cast<CControlPrototype**>(pNode->m_aChildren.GetData()), pNode->m_aChildren.GetSize(), pManager, pParent);
+				}
+				continue;
+			}
+
+			CControlUI* pControl = pNode->_CreateControl();
+			if( pControl == NULL ) {
+				DUITRACE(_T("未知控件:%s"), pNode->m_sClass.GetData());
+				continue;
+			}
+
+			// Add children
+			if( !pNode->m_aChildren.IsEmpty() ) {
+				_Instantiate(reinterpret_cast<CControlPrototype**>(pNode->m_aChildren.GetData()), pNode->m_aChildren.GetSize(), pManager, pControl);
+			}
+			// Attach to parent
+			CTreeViewUI* pTreeView = NULL;
+			int nAttach = AttachControl(pControl, pParent, pContainer, pTreeView);
+			if( nAttach == ATTACH_FAILED ) return NULL;
+			if( nAttach == ATTACH_DELETED ) continue;
+
+			// 同一个管理器下第二次以后直接复制第一次设置好的属性值。树节点在设置属性时要用到管理器，仍按属性表设置
+			if( pNode->m_pTemplate != NULL && pNode->m_pTemplateManager == pManager && pTreeView == NULL ) {
+				pControl->CopyAttributes(pNode->m_pTemplate);
+				pControl->SetPrototype(pNode);
+				if( pReturn == NULL ) pReturn = pControl;
+				continue;
+			}
+			// Init default attributes
+			if( pManager ) {
+				if(pTreeView != NULL) {
+					pControl->SetManager(pManager, pTreeView, true);
+				}
+				else {
+					pControl->SetManager(pManager, NULL, false);
+				}
+				const CAttributeList* pDefaultAttributes = pManager->GetDefaultAttributes(pNode->m_sClass);
+				if( pDefaultAttributes ) {
+					pControl->ApplyAttributeList(pDefaultAttributes);
+				}
+			}
+			// Process attributes
+			pControl->ApplyAttributeList(pNode->m_pAttributes);
+			if( pManager ) {
+				if(pTreeView == NULL) {
+					pControl->SetManager(NULL, NULL, false);
+				}
+			}
+			// 默认属性和样式取自管理器，所以模板只对创建它时的管理器有效
+			if( pNode->m_pTemplate == NULL && pTreeView == NULL && pControl->CanCopyAttributes() ) {
+				pNode->m_pTemplate = pNode->_CreateControl();
+				if( pNode->m_pTemplate != NULL ) {
+					pNode->m_pTemplate->CopyAttributes(pControl);
+					pNode->m_pTemplateManager = pManager;
+				}
+			}
+			pControl->SetPrototype(pNode);
+			// Return first item
+			if( pReturn == NULL ) pReturn = pControl;
+		}
+		return pReturn;
+	}
+
+	CControlUI* CControlPrototype::_CreateControl() const
+	{
+		if( m_pfnCreate != NULL ) return m_pfnCreate();
+
+		// 插件和回调创建的控件不缓存创建函数
+		CControlUI* pControl = NULL;
+		CStdPtrArray* pPlugins = CPaintManagerUI::GetPlugins();
+		LPCREATECONTROL lpCreateControl = NULL;
+		for( int i = 0; i < pPlugins->GetSize(); ++i ) {
+			lpCreateControl = (LPCREATECONTROL)pPlugins->GetAt(i);
+			if( lpCreateControl != NULL ) {
+				pControl = lpCreateControl(m_sClass);
+				if( pControl != NULL ) return pControl;
+			}
+		}
+		if( m_pCallback != NULL ) {
+			pControl = m_pCallback->CreateControl(m_sClass);
+		}
+		return pControl;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	//
+
 	CDialogBuilder::CDialogBuilder() : m_pCallback(NULL), m_pstrtype(NULL)
 	{
 		m_instance = NULL;
@@ -9,6 +187,26 @@ namespace DuiLib {
 
 	CControlUI* CDialogBuilder::Create(STRINGorID xml, LPCTSTR type, IDialogBuilderCallback* pCallback, 
 		CPaintManagerUI* pManager, CControlUI* pParent)
+	{
+		if( !_Load(xml, type) ) return NULL;
+		return Create(pCallback, pManager, pParent);
+	}
+
+	CControlPrototype* CDialogBuilder::CreatePrototype(STRINGorID xml, LPCTSTR type, IDialogBuilderCallback* pCallback, CPaintManagerUI* pManager)
+	{
+		m_pCallback = pCallback;
+		if( !_Load(xml, type) ) return NULL;
+		CMarkupNode root = m_xml.GetRoot();
+		if( !root.IsValid() ) return NULL;
+		_LoadResources(root, pManager);
+
+		CControlPrototype* pPrototype = new CControlPrototype;
+		pPrototype->m_pCallback = pCallback;
+		_Compile(&root, pPrototype, pManager);
+		return pPrototype;
+	}
+
+	bool CDialogBuilder::_Load(STRINGorID xml, LPCTSTR type)
 	{
 		//资源ID为0-65535，两个字节；字符串指针为4个字节
 		//字符串以<开头认为是XML字符串，否则认为是XML文件
@@ -21,10 +219,10 @@ namespace DuiLib {
 
 		if( HIWORD(xml.m_lpstr) != NULL ) {
 			if( *(xml.m_lpstr) == _T('<') ) {
-				if( !m_xml.Load(xml.m_lpstr) ) return NULL;
+				if( !m_xml.Load(xml.m_lpstr) ) return false;
 			}
 			else {
-				if( !m_xml.LoadFromFile(xml.m_lpstr) ) return NULL;
+				if( !m_xml.LoadFromFile(xml.m_lpstr) ) return false;
 			}
 		}
 		else {
@@ -38,20 +236,19 @@ namespace DuiLib {
 				dll_instence = CPaintManagerUI::GetResourceDll();
 			}
 			HRSRC hResource = ::FindResource(dll_instence, xml.m_lpstr, type);
-			if( hResource == NULL ) return NULL;
+			if( hResource == NULL ) return false;
 			HGLOBAL hGlobal = ::LoadResource(dll_instence, hResource);
 			if( hGlobal == NULL ) {
 				FreeResource(hResource);
-				return NULL;
+				return false;
 			}
 
-			m_pCallback = pCallback;
-			if( !m_xml.LoadFromMem((BYTE*)::LockResource(hGlobal), ::SizeofResource(dll_instence, hResource) )) return NULL;
+			if( !m_xml.LoadFromMem((BYTE*)::LockResource(hGlobal), ::SizeofResource(dll_instence, hResource) )) return false;
 			::FreeResource(hGlobal);
 			m_pstrtype = type;
 		}
 
-		return Create(pCallback, pManager, pParent);
+		return true;
 	}
 
 	CControlUI* CDialogBuilder::Create(IDialogBuilderCallback* pCallback, CPaintManagerUI* pManager, CControlUI* pParent)
@@ -60,6 +257,12 @@ namespace DuiLib {
 		CMarkupNode root = m_xml.GetRoot();
 		if( !root.IsValid() ) return NULL;
 
+		_LoadResources(root, pManager);
+		return _Parse(&root, pParent, pManager);
+	}
+
+	void CDialogBuilder::_LoadResources(CMarkupNode& root, CPaintManagerUI* pManager)
+	{
 		if( pManager ) {
 			LPCTSTR pstrClass = NULL;
 			int nAttributes = 0;
@@ -91,7 +294,11 @@ namespace DuiLib {
 							shared = (_tcsicmp(pstrValue, _T("true")) == 0);
 						}
 					}
-					if( pImageName ) pManager->AddImage(pImageName, pImageResType, mask, false, shared);
+					if( pImageName ) {
+						// 并行解码时只提交任务，绘制用到时才等待对应的图片
+						if( CPaintManagerUI::IsParallelImageDecode() ) pManager->PreloadImage(pImageName, pImageResType, mask, false, shared);
+						else pManager->AddImage(pImageName, pImageResType, mask, false, shared);
+					}
 				}
 				else if( _tcsicmp(pstrClass, _T("Font")) == 0 ) {
 					nAttributes = node.GetAttributeCount();
@@ -252,6 +459,12 @@ namespace DuiLib {
 						else if( _tcsicmp(pstrName, _T("showdirty")) == 0 ) {
 							pManager->SetShowUpdateRect(_tcsicmp(pstrValue, _T("true")) == 0);
 						} 
+						else if( _tcsicmp(pstrName, _T("asyncimage")) == 0 ) {
+							pManager->SetAsyncImageLoad(_tcsicmp(pstrValue, _T("true")) == 0);
+						} 
+						else if( _tcsicmp(pstrName, _T("imageplaceholder")) == 0 ) {
+							pManager->SetImagePlaceholder(pstrValue);
+						} 
 						else if( _tcsicmp(pstrName, _T("opacity")) == 0 || _tcsicmp(pstrName, _T("alpha")) == 0 ) {
 							pManager->SetOpacity(_ttoi(pstrValue));
 						} 
@@ -340,6 +553,12 @@ namespace DuiLib {
 						else if( _tcsicmp(pstrName, _T("textrenderinghint")) == 0 ) {
 							pManager->SetGdiplusTextRenderingHint(_ttoi(pstrValue));
 						} 
+						else if( _tcsicmp(pstrName, _T("softwarerender")) == 0 ) {
+							pManager->SetSoftwareRender(_tcsicmp(pstrValue, _T("true")) == 0);
+						} 
+						else if( _tcsicmp(pstrName, _T("paintthreads")) == 0 ) {
+							pManager->SetPaintThreads(_ttoi(pstrValue));
+						} 
 						else if( _tcsicmp(pstrName, _T("tooltiphovertime")) == 0 ) {
 							pManager->SetHoverTime(_ttoi(pstrValue));
 						} 
@@ -347,7 +566,6 @@ namespace DuiLib {
 				}
 			}
 		}
-		return _Parse(&root, pParent, pManager);
 	}
 
 	CMarkup* CDialogBuilder::GetMarkup()
@@ -434,47 +652,10 @@ namespace DuiLib {
 				_Parse(&node, pControl, pManager);
 			}
 			// Attach to parent
-			// 因为某些属性和父窗口相关，比如selected，必须先Add到父窗口
 			CTreeViewUI* pTreeView = NULL;
-			if( pParent != NULL && pControl != NULL ) {
-				CTreeNodeUI* pParentTreeNode = static_cast<CTreeNodeUI*>(pParent->GetInterface(_T("TreeNode")));
-				CTreeNodeUI* pTreeNode = static_cast<CTreeNodeUI*>(pControl->GetInterface(_T("TreeNode")));
-				pTreeView = static_cast<CTreeViewUI*>(pParent->GetInterface(_T("TreeView")));
-				// TreeNode子节点
-				if(pTreeNode != NULL) {
-					if(pParentTreeNode) {
-						pTreeView = pParentTreeNode->GetTreeView();
-						if(!pParentTreeNode->Add(pTreeNode)) {
-							delete pTreeNode;
-							pTreeNode = NULL;
-							continue;
-						}
-					}
-					else {
-						if(pTreeView != NULL) {
-							if(!pTreeView->Add(pTreeNode)) {
-								delete pTreeNode;
-								pTreeNode = NULL;
-								continue;
-							}
-						}
-					}
-				}
-				// TreeNode子控件
-				else if(pParentTreeNode != NULL) {
-					pParentTreeNode->GetTreeNodeHoriznotal()->Add(pControl);
-				}
-				// 普通控件
-				else {
-					if( pContainer == NULL ) pContainer = static_cast<IContainerUI*>(pParent->GetInterface(_T("IContainer")));
-					ASSERT(pContainer);
-					if( pContainer == NULL ) return NULL;
-					if( !pContainer->Add(pControl) ) {
-						delete pControl;
-						continue;
-					}
-				}
-			}
+			int nAttach = AttachControl(pControl, pParent, pContainer, pTreeView);
+			if( nAttach == ATTACH_FAILED ) return NULL;
+			if( nAttach == ATTACH_DELETED ) continue;
 			if( pControl == NULL ) continue;
 
 			// Init default attributes
@@ -485,7 +666,7 @@ namespace DuiLib {
 				else {
 					pControl->SetManager(pManager, NULL, false);
 				}
-				LPCTSTR pDefaultAttributes = pManager->GetDefaultAttributeList(pstrClass);
+				const CAttributeList* pDefaultAttributes = pManager->GetDefaultAttributes(pstrClass);
 				if( pDefaultAttributes ) {
 					pControl->ApplyAttributeList(pDefaultAttributes);
 				}
@@ -509,4 +690,63 @@ namespace DuiLib {
 		return pReturn;
 	}
 
+	void CDialogBuilder::_Compile(CMarkupNode* pRoot, CControlPrototype* pTarget, CPaintManagerUI* pManager)
+	{
+		for( CMarkupNode node = pRoot->GetChild() ; node.IsValid(); node = node.GetSibling() ) {
+			LPCTSTR pstrClass = node.GetName();
+			if( _tcsicmp(pstrClass, _T("Image")) == 0 || _tcsicmp(pstrClass, _T("Font")) == 0 \
+				|| _tcsicmp(pstrClass, _T("Default")) == 0 || _tcsicmp(pstrClass, _T("Style")) == 0 ) continue;
+			if (_tcsicmp(pstrClass, _T("Import")) == 0) continue;
+
+			// Include在编译时就读入，实例化时按count重复
+			if( _tcsicmp(pstrClass, _T("Include")) == 0 ) {
+				if( !node.HasAttributes() ) continue;
+				int count = 1;
+				LPTSTR pstr = NULL;
+				TCHAR szValue[500] = { 0 };
+				SIZE_T cchLen = lengthof(szValue) - 1;
+				if ( node.GetAttributeValue(_T("count"), szValue, cchLen) )
+					count = _tcstol(szValue, &pstr, 10);
+				cchLen = lengthof(szValue) - 1;
+				if ( !node.GetAttributeValue(_T("source"), szValue, cchLen) ) continue;
+
+				CDialogBuilder builder;
+				builder.m_pCallback = m_pCallback;
+				bool bLoaded = false;
+				if( m_pstrtype != NULL ) { // 使用资源dll，从资源中读取
+					WORD id = (WORD)_tcstol(szValue, &pstr, 10); 
+					bLoaded = builder._Load((UINT)id, m_pstrtype);
+				}
+				else {
+					bLoaded = builder._Load((LPCTSTR)szValue, NULL);
+				}
+				if( !bLoaded ) continue;
+				CMarkupNode root = builder.m_xml.GetRoot();
+				if( !root.IsValid() ) continue;
+				builder._LoadResources(root, pManager);
+
+				CControlPrototype* pInclude = new CControlPrototype;
+				pInclude->m_pCallback = m_pCallback;
+				pInclude->m_nRepeat = count;
+				builder._Compile(&root, pInclude, pManager);
+				pTarget->m_aChildren.Add(pInclude);
+				continue;
+			}
+
+			CControlPrototype* pNode = new CControlPrototype;
+			pNode->m_sClass = pstrClass;
+			pNode->m_pCallback = m_pCallback;
+			CDuiString strClass;
+			strClass.Format(_T("C%sUI"), pstrClass);
+			pNode->m_pfnCreate = CControlFactory::GetInstance()->GetCreateClass(strClass);
+			if( node.HasAttributes() ) {
+				pNode->m_pAttributes = new CAttributeList(node);
+			}
+			if( node.HasChildren() ) {
+				_Compile(&node, pNode, pManager);
+			}
+			pTarget->m_aChildren.Add(pNode);
+		}
+	}
+
 } // namespace DuiLib
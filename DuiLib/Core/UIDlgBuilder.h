@@ -11,6 +11,42 @@ namespace DuiLib {
 		virtual CControlUI* CreateControl(LPCTSTR pstrClass) = 0;
 	};
 
+	// A parsed skin snippet: class creators and pre-split attributes per node.
+	// Created by CDialogBuilder::CreatePrototype and shared by reference with
+	// every control instantiated from it.
+	class UILIB_API CControlPrototype
+	{
+		friend class CDialogBuilder;
+	public:
+		void AddRef();
+		void Release();
+
+		// Creates the controls under pParent like CDialogBuilder::Create and returns the first one
+		CControlUI* Instantiate(CPaintManagerUI* pManager = NULL, CControlUI* pParent = NULL);
+
+	private:
+		CControlPrototype();
+		~CControlPrototype();
+		CControlPrototype(const CControlPrototype&);
+		CControlPrototype& operator=(const CControlPrototype&);
+
+		static CControlUI* _Instantiate(CControlPrototype** ppNodes, int nNodes, CPaintManagerUI* pManager, CControlUI* pParent);
+		CControlUI* _CreateControl() const;
+
+		// An empty class marks a list of nodes: the document root or an Include repeated m_nRepeat times
+		CDuiString m_sClass;
+		CreateClass m_pfnCreate;
+		IDialogBuilderCallback* m_pCallback;
+		CAttributeList* m_pAttributes;
+		int m_nRepeat;
+		CStdPtrArray m_aChildren;
+		LONG m_nRef;
+		// Attribute values of the first instance created for m_pTemplateManager; later instances
+		// for the same manager copy them instead of replaying the default attributes and m_pAttributes
+		CControlUI* m_pTemplate;
+		CPaintManagerUI* m_pTemplateManager;
+	};
+
 
 	class UILIB_API CDialogBuilder
 	{
@@ -21,13 +57,21 @@ namespace DuiLib {
 		CControlUI* Create(IDialogBuilderCallback* pCallback = NULL, CPaintManagerUI* pManager = NULL,
 			CControlUI* pParent = NULL);
 
+		// Parses the xml and loads its resources once; Instantiate or CControlUI::Clone
+		// then create the controls without touching the xml again
+		CControlPrototype* CreatePrototype(STRINGorID xml, LPCTSTR type = NULL, IDialogBuilderCallback* pCallback = NULL,
+			CPaintManagerUI* pManager = NULL);
+
 		CMarkup* GetMarkup();
 
 		void GetLastErrorMessage(LPTSTR pstrMessage, SIZE_T cchMax) const;
 		void GetLastErrorLocation(LPTSTR pstrSource, SIZE_T cchMax) const;
 	    void SetInstance(HINSTANCE instance){ m_instance = instance;};
 	private:
+		bool _Load(STRINGorID xml, LPCTSTR type);
+		void _LoadResources(CMarkupNode& root, CPaintManagerUI* pManager);
 		CControlUI* _Parse(CMarkupNode* parent, CControlUI* pParent = NULL, CPaintManagerUI* pManager = NULL);
+		void _Compile(CMarkupNode* pRoot, CControlPrototype* pTarget, CPaintManagerUI* pManager);
 
 		CMarkup m_xml;
 		IDialogBuilderCallback* m_pCallback;
@@ -0,0 +1,430 @@
+﻿#include "UIGifDecoder.h"
+#include <string.h>
+
+namespace DuiLib {
+
+	#define GIF_MAX_CODE_BITS	12
+	#define GIF_MAX_CODES		(1 << GIF_MAX_CODE_BITS)
+
+	static inline int ReadGifWord(const BYTE* p)
+	{
+		return p[0] | (p[1] << 8);
+	}
+
+	static inline bool IsGifRectEmpty(const RECT& rc)
+	{
+		return rc.left >= rc.right || rc.top >= rc.bottom;
+	}
+
+	static inline void SetGifRect(RECT& rc, int left, int top, int right, int bottom)
+	{
+		rc.left = left;
+		rc.top = top;
+		rc.right = right;
+		rc.bottom = bottom;
+	}
+
+	// 与IntersectRect、UnionRect相同：不相交时为空矩形，空矩形不参与合并
+	static void IntersectGifRect(RECT& rc, const RECT& rc1, const RECT& rc2)
+	{
+		SetGifRect(rc, rc1.left > rc2.left ? rc1.left : rc2.left, rc1.top > rc2.top ? rc1.top : rc2.top,
+			rc1.right < rc2.right ? rc1.right : rc2.right, rc1.bottom < rc2.bottom ? rc1.bottom : rc2.bottom);
+		if( IsGifRectEmpty(rc) ) SetGifRect(rc, 0, 0, 0, 0);
+	}
+
+	static void UnionGifRect(RECT& rc, const RECT& rc1, const RECT& rc2)
+	{
+		if( IsGifRectEmpty(rc1) ) {
+			if( IsGifRectEmpty(rc2) ) SetGifRect(rc, 0, 0, 0, 0);
+			else rc = rc2;
+			return;
+		}
+		if( IsGifRectEmpty(rc2) ) {
+			rc = rc1;
+			return;
+		}
+		SetGifRect(rc, rc1.left < rc2.left ? rc1.left : rc2.left, rc1.top < rc2.top ? rc1.top : rc2.top,
+			rc1.right > rc2.right ? rc1.right : rc2.right, rc1.bottom > rc2.bottom ? rc1.bottom : rc2.bottom);
+	}
+
+	// 跳过以长度0结束的数据子块序列
+	static DWORD SkipGifBlocks(const BYTE* pData, DWORD dwSize, DWORD dwPos)
+	{
+		while( dwPos < dwSize ) {
+			BYTE cLen = pData[dwPos++];
+			if( cLen == 0 ) break;
+			dwPos += cLen;
+		}
+		return dwPos;
+	}
+
+	CGifDecoder::CGifDecoder() :
+		m_pData(NULL),
+		m_dwSize(0),
+		m_nWidth(0),
+		m_nHeight(0),
+		m_bGlobalPalette(false),
+		m_pFrames(NULL),
+		m_nFrames(0),
+		m_nFramesAlloc(0),
+		m_pCanvas(NULL),
+		m_pRestore(NULL),
+		m_iCanvasFrame(-1),
+		m_iLastFrame(-1),
+		m_nCacheFrames(GIF_CACHE_FRAMES),
+		m_ppCache(NULL)
+	{
+	}
+
+	CGifDecoder::~CGifDecoder()
+	{
+		Close();
+	}
+
+	bool CGifDecoder::Open(const BYTE* pData, DWORD dwSize)
+	{
+		Close();
+		if( pData == NULL || dwSize < 13 ) return false;
+		if( memcmp(pData, "GIF87a", 6) != 0 && memcmp(pData, "GIF89a", 6) != 0 ) return false;
+		m_pData = pData;
+		m_dwSize = dwSize;
+		m_nWidth = ReadGifWord(pData + 6);
+		m_nHeight = ReadGifWord(pData + 8);
+		if( m_nWidth <= 0 || m_nHeight <= 0 || !_Index() ) {
+			Close();
+			return false;
+		}
+		m_pCanvas = new DWORD[m_nWidth * m_nHeight];
+		return true;
+	}
+
+	void CGifDecoder::Close()
+	{
+		if( m_ppCache != NULL ) {
+			for( int i = 0; i < m_nFrames; i++ ) delete[] m_ppCache[i];
+			delete[] m_ppCache;
+			m_ppCache = NULL;
+		}
+		delete[] m_pCanvas;
+		m_pCanvas = NULL;
+		delete[] m_pRestore;
+		m_pRestore = NULL;
+		delete[] m_pFrames;
+		m_pFrames = NULL;
+		m_nFrames = m_nFramesAlloc = 0;
+		m_pData = NULL;
+		m_dwSize = 0;
+		m_nWidth = m_nHeight = 0;
+		m_bGlobalPalette = false;
+		m_iCanvasFrame = -1;
+		m_iLastFrame = -1;
+	}
+
+	bool CGifDecoder::IsOpen() const
+	{
+		return m_pCanvas != NULL;
+	}
+
+	int CGifDecoder::GetWidth() const
+	{
+		return m_nWidth;
+	}
+
+	int CGifDecoder::GetHeight() const
+	{
+		return m_nHeight;
+	}
+
+	int CGifDecoder::GetFrameCount() const
+	{
+		return m_nFrames;
+	}
+
+	UINT CGifDecoder::GetFrameDelay(int iFrame) const
+	{
+		if( iFrame < 0 || iFrame >= m_nFrames ) return 0;
+		return m_pFrames[iFrame].uDelay;
+	}
+
+	void CGifDecoder::SetCacheFrames(int nFrames)
+	{
+		m_nCacheFrames = nFrames < 0 ? 0 : nFrames;
+	}
+
+	const BYTE* CGifDecoder::GetFrame(int iFrame, RECT* prcDirty)
+	{
+		if( !IsOpen() || iFrame < 0 || iFrame >= m_nFrames ) return NULL;
+
+		if( prcDirty != NULL ) {
+			if( iFrame == m_iLastFrame + 1 ) *prcDirty = m_pFrames[iFrame].rcDirty;
+			else if( iFrame == m_iLastFrame ) SetGifRect(*prcDirty, 0, 0, 0, 0);
+			else SetGifRect(*prcDirty, 0, 0, m_nWidth, m_nHeight);
+		}
+		m_iLastFrame = iFrame;
+
+		if( m_ppCache == NULL && m_nFrames > 1 && m_nFrames <= m_nCacheFrames ) {
+			m_ppCache = new DWORD*[m_nFrames];
+			memset(m_ppCache, 0, m_nFrames * sizeof(DWORD*));
+		}
+		if( m_ppCache != NULL && m_ppCache[iFrame] != NULL ) return (const BYTE*)m_ppCache[iFrame];
+
+		// 往回取帧时从第一帧重新合成
+		if( iFrame < m_iCanvasFrame ) m_iCanvasFrame = -1;
+		while( m_iCanvasFrame < iFrame ) _DecodeNext();
+
+		if( m_ppCache != NULL ) {
+			m_ppCache[iFrame] = new DWORD[m_nWidth * m_nHeight];
+			memcpy(m_ppCache[iFrame], m_pCanvas, m_nWidth * m_nHeight * sizeof(DWORD));
+			return (const BYTE*)m_ppCache[iFrame];
+		}
+		return (const BYTE*)m_pCanvas;
+	}
+
+	bool CGifDecoder::_Index()
+	{
+		const BYTE* pData = m_pData;
+		DWORD dwSize = m_dwSize;
+		BYTE cFlags = pData[10];
+		DWORD dwPos = 13;
+		if( cFlags & 0x80 ) {
+			int nColors = 2 << (cFlags & 0x07);
+			if( dwPos + nColors * 3 > dwSize ) return false;
+			_ReadPalette(pData + dwPos, nColors, m_aGlobalPalette);
+			m_bGlobalPalette = true;
+			dwPos += nColors * 3;
+		}
+
+		// 图形控制扩展作用于紧随其后的一幅图像
+		UINT uDelay = 0;
+		int nTransparent = -1;
+		BYTE cDisposal = 0;
+		RECT rcCanvas = { 0, 0, m_nWidth, m_nHeight };
+		RECT rcPrevDispose = rcCanvas;
+		while( dwPos < dwSize ) {
+			BYTE cTag = pData[dwPos++];
+			if( cTag == 0x21 ) {
+				if( dwPos >= dwSize ) break;
+				BYTE cLabel = pData[dwPos++];
+				if( cLabel == 0xF9 && dwPos + 5 <= dwSize && pData[dwPos] >= 4 ) {
+					BYTE cExtFlags = pData[dwPos + 1];
+					uDelay = ReadGifWord(pData + dwPos + 2) * 10;
+					nTransparent = (cExtFlags & 0x01) ? pData[dwPos + 4] : -1;
+					cDisposal = (cExtFlags >> 2) & 0x07;
+				}
+				dwPos = SkipGifBlocks(pData, dwSize, dwPos);
+			}
+			else if( cTag == 0x2C ) {
+				if( dwPos + 10 > dwSize ) break;
+				GIFFRAME frame;
+				frame.dwOffset = dwPos;
+				int x = ReadGifWord(pData + dwPos);
+				int y = ReadGifWord(pData + dwPos + 2);
+				RECT rcFrame = { x, y, x + ReadGifWord(pData + dwPos + 4), y + ReadGifWord(pData + dwPos + 6) };
+				IntersectGifRect(frame.rcFrame, rcFrame, rcCanvas);
+				if( m_nFrames == 0 ) frame.rcDirty = rcCanvas;
+				else UnionGifRect(frame.rcDirty, frame.rcFrame, rcPrevDispose);
+				frame.uDelay = uDelay;
+				frame.nTransparent = nTransparent;
+				frame.cDisposal = cDisposal;
+				_AddFrame(frame);
+
+				// 处置方式2、3在下一帧之前清除或恢复本帧区域
+				if( cDisposal == 2 || cDisposal == 3 ) rcPrevDispose = frame.rcFrame;
+				else SetGifRect(rcPrevDispose, 0, 0, 0, 0);
+
+				BYTE cLocalFlags = pData[dwPos + 8];
+				dwPos += 9;
+				if( cLocalFlags & 0x80 ) dwPos += 3 * (2 << (cLocalFlags & 0x07));
+				// LZW最小码长
+				dwPos++;
+				dwPos = SkipGifBlocks(pData, dwSize, dwPos);
+
+				uDelay = 0;
+				nTransparent = -1;
+				cDisposal = 0;
+			}
+			else break;
+		}
+		return m_nFrames > 0;
+	}
+
+	void CGifDecoder::_AddFrame(const GIFFRAME& frame)
+	{
+		if( m_nFrames == m_nFramesAlloc ) {
+			int nAlloc = m_nFramesAlloc < 8 ? 8 : m_nFramesAlloc * 2;
+			GIFFRAME* pFrames = new GIFFRAME[nAlloc];
+			if( m_nFrames > 0 ) memcpy(pFrames, m_pFrames, m_nFrames * sizeof(GIFFRAME));
+			delete[] m_pFrames;
+			m_pFrames = pFrames;
+			m_nFramesAlloc = nAlloc;
+		}
+		m_pFrames[m_nFrames++] = frame;
+	}
+
+	void CGifDecoder::_DecodeNext()
+	{
+		int iFrame = m_iCanvasFrame + 1;
+		const GIFFRAME* pFrame = &m_pFrames[iFrame];
+		if( iFrame == 0 ) {
+			memset(m_pCanvas, 0, m_nWidth * m_nHeight * sizeof(DWORD));
+		}
+		else {
+			const GIFFRAME* pPrev = &m_pFrames[iFrame - 1];
+			if( pPrev->cDisposal == 2 ) _FillRect(m_pCanvas, pPrev->rcFrame, NULL);
+			else if( pPrev->cDisposal == 3 && m_pRestore != NULL ) _FillRect(m_pCanvas, pPrev->rcFrame, m_pRestore);
+		}
+		if( pFrame->cDisposal == 3 ) {
+			if( m_pRestore == NULL ) m_pRestore = new DWORD[m_nWidth * m_nHeight];
+			_FillRect(m_pRestore, pFrame->rcFrame, m_pCanvas);
+		}
+		_DecodeRaster(pFrame);
+		m_iCanvasFrame = iFrame;
+	}
+
+	void CGifDecoder::_FillRect(DWORD* pDest, const RECT& rc, const DWORD* pSrc)
+	{
+		int cx = rc.right - rc.left;
+		for( int y = rc.top; y < rc.bottom; y++ ) {
+			DWORD* pLine = pDest + y * m_nWidth + rc.left;
+			if( pSrc != NULL ) memcpy(pLine, pSrc + y * m_nWidth + rc.left, cx * sizeof(DWORD));
+			else memset(pLine, 0, cx * sizeof(DWORD));
+		}
+	}
+
+	void CGifDecoder::_ReadPalette(const BYTE* pData, int nColors, DWORD* pPalette)
+	{
+		// 不透明颜色的预乘值与原值相同
+		for( int i = 0; i < nColors; i++, pData += 3 ) {
+			pPalette[i] = 0xFF000000 | (pData[0] << 16) | (pData[1] << 8) | pData[2];
+		}
+		for( int i = nColors; i < 256; i++ ) pPalette[i] = 0xFF000000;
+	}
+
+	void CGifDecoder::_DecodeRaster(const GIFFRAME* pFrame)
+	{
+		const BYTE* pData = m_pData;
+		DWORD dwSize = m_dwSize;
+		DWORD dwPos = pFrame->dwOffset;
+		int nFrameX = ReadGifWord(pData + dwPos);
+		int nFrameY = ReadGifWord(pData + dwPos + 2);
+		int nFrameWidth = ReadGifWord(pData + dwPos + 4);
+		int nFrameHeight = ReadGifWord(pData + dwPos + 6);
+		BYTE cLocalFlags = pData[dwPos + 8];
+		dwPos += 9;
+
+		DWORD aLocalPalette[256];
+		const DWORD* pPalette = m_aGlobalPalette;
+		if( cLocalFlags & 0x80 ) {
+			int nColors = 2 << (cLocalFlags & 0x07);
+			if( dwPos + nColors * 3 > dwSize ) return;
+			_ReadPalette(pData + dwPos, nColors, aLocalPalette);
+			pPalette = aLocalPalette;
+			dwPos += nColors * 3;
+		}
+		else if( !m_bGlobalPalette ) return;
+		if( nFrameWidth == 0 || nFrameHeight == 0 || dwPos >= dwSize ) return;
+
+		int nMinCodeSize = pData[dwPos++];
+		if( nMinCodeSize < 1 || nMinCodeSize > GIF_MAX_CODE_BITS - 1 ) return;
+
+		// 隔行扫描的四遍起始行和行距
+		static const int aPassStart[] = { 0, 4, 2, 1 };
+		static const int aPassStep[] = { 8, 8, 4, 2 };
+		bool bInterlaced = (cLocalFlags & 0x40) != 0;
+		int nPass = 0;
+		int nStep = bInterlaced ? aPassStep[0] : 1;
+		int x = 0, y = 0;
+		int nTransparent = pFrame->nTransparent;
+
+		WORD aPrefix[GIF_MAX_CODES];
+		BYTE aSuffix[GIF_MAX_CODES];
+		BYTE aStack[GIF_MAX_CODES + 1];
+		int nClear = 1 << nMinCodeSize;
+		int nEnd = nClear + 1;
+		for( int i = 0; i < nClear; i++ ) {
+			aPrefix[i] = 0;
+			aSuffix[i] = (BYTE)i;
+		}
+		int nCodeSize = nMinCodeSize + 1;
+		int nAvail = nClear + 2;
+		int nOldCode = -1;
+		BYTE cFirst = 0;
+
+		DWORD dwBits = 0;
+		int nBits = 0;
+		DWORD dwBlockEnd = dwPos;
+		for( ;; ) {
+			// 从数据子块中补足一个码字
+			while( nBits < nCodeSize ) {
+				if( dwPos >= dwBlockEnd ) {
+					if( dwPos >= dwSize || pData[dwPos] == 0 ) return;
+					dwBlockEnd = dwPos + 1 + pData[dwPos];
+					dwPos++;
+					if( dwBlockEnd > dwSize ) dwBlockEnd = dwSize;
+					continue;
+				}
+				dwBits |= (DWORD)pData[dwPos++] << nBits;
+				nBits += 8;
+			}
+			int nCode = (int)(dwBits & ((1 << nCodeSize) - 1));
+			dwBits >>= nCodeSize;
+			nBits -= nCodeSize;
+
+			if( nCode == nClear ) {
+				nCodeSize = nMinCodeSize + 1;
+				nAvail = nClear + 2;
+				nOldCode = -1;
+				continue;
+			}
+			if( nCode == nEnd ) return;
+
+			int nStack = 0;
+			if( nOldCode == -1 ) {
+				if( nCode >= nClear ) return;
+				cFirst = (BYTE)nCode;
+				aStack[nStack++] = cFirst;
+			}
+			else {
+				int nInCode = nCode;
+				if( nCode > nAvail ) return;
+				if( nCode == nAvail ) {
+					aStack[nStack++] = cFirst;
+					nCode = nOldCode;
+				}
+				while( nCode >= nClear ) {
+					aStack[nStack++] = aSuffix[nCode];
+					nCode = aPrefix[nCode];
+				}
+				cFirst = aSuffix[nCode];
+				aStack[nStack++] = cFirst;
+				if( nAvail < GIF_MAX_CODES ) {
+					aPrefix[nAvail] = (WORD)nOldCode;
+					aSuffix[nAvail] = cFirst;
+					nAvail++;
+					if( nAvail == (1 << nCodeSize) && nCodeSize < GIF_MAX_CODE_BITS ) nCodeSize++;
+				}
+				nCode = nInCode;
+			}
+			nOldCode = nCode;
+
+			// 码字展开的像素是逆序压栈的
+			while( nStack > 0 ) {
+				BYTE cIndex = aStack[--nStack];
+				int xCanvas = nFrameX + x;
+				int yCanvas = nFrameY + y;
+				if( cIndex != nTransparent && xCanvas < m_nWidth && yCanvas < m_nHeight ) {
+					m_pCanvas[yCanvas * m_nWidth + xCanvas] = pPalette[cIndex];
+				}
+				if( ++x < nFrameWidth ) continue;
+				x = 0;
+				y += nStep;
+				while( y >= nFrameHeight ) {
+					if( !bInterlaced || ++nPass >= 4 ) return;
+					y = aPassStart[nPass];
+					nStep = aPassStep[nPass];
+				}
+			}
+		}
+	}
+
+} // namespace DuiLib
@@ -0,0 +1,84 @@
+﻿#ifndef __UIGIFDECODER_H__
+#define __UIGIFDECODER_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// GIF逐帧解码器：Open只扫描一遍数据块建立帧索引，不解码像素；GetFrame按播放顺序在一张画布上增量合成，
+	// 每帧只解码并覆盖它自己的区域，按上一帧的处置方式清除或恢复上一帧的区域
+	// 输出为预乘alpha的BGRA，可直接复制到32位DIB；只依赖内存数据和C运行库，不使用Win32 API
+	// 帧数不超过缓存帧数的小动画合成一遍后保存全部帧，之后循环播放不再解码；
+	// 较长的动画只保留画布，回到第一帧时从头解码，内存占用与帧数无关
+	class UILIB_API CGifDecoder
+	{
+	public:
+		enum
+		{
+			GIF_CACHE_FRAMES = 8,
+		};
+
+		CGifDecoder();
+		~CGifDecoder();
+
+		// pData在Close之前必须有效，解码器不复制数据
+		bool Open(const BYTE* pData, DWORD dwSize);
+		void Close();
+		bool IsOpen() const;
+
+		int GetWidth() const;
+		int GetHeight() const;
+		int GetFrameCount() const;
+		// 帧显示时间（毫秒），文件未指定时为0
+		UINT GetFrameDelay(int iFrame) const;
+		// 缓存帧数上限，0表示不缓存；在第一次GetFrame之前设置
+		void SetCacheFrames(int nFrames);
+
+		// 返回第iFrame帧的合成结果（宽*高*4字节），下次调用GetFrame或Close之前有效，失败返回NULL
+		// prcDirty返回与上一次返回的帧相比发生变化的区域，不连续取帧时为整幅图片
+		const BYTE* GetFrame(int iFrame, RECT* prcDirty = NULL);
+
+	private:
+		CGifDecoder(const CGifDecoder&);
+		CGifDecoder& operator=(const CGifDecoder&);
+
+		typedef struct tagGIFFRAME
+		{
+			DWORD dwOffset;		// 图像描述符（0x2C之后）在数据中的位置
+			RECT rcFrame;		// 已裁剪到画布内
+			RECT rcDirty;		// 相对上一帧变化的区域
+			UINT uDelay;
+			int nTransparent;
+			BYTE cDisposal;
+		} GIFFRAME;
+
+		bool _Index();
+		void _AddFrame(const GIFFRAME& frame);
+		void _DecodeNext();
+		void _DecodeRaster(const GIFFRAME* pFrame);
+		void _FillRect(DWORD* pDest, const RECT& rc, const DWORD* pSrc);
+		static void _ReadPalette(const BYTE* pData, int nColors, DWORD* pPalette);
+
+	private:
+		const BYTE* m_pData;
+		DWORD m_dwSize;
+		int m_nWidth;
+		int m_nHeight;
+		DWORD m_aGlobalPalette[256];
+		bool m_bGlobalPalette;
+		GIFFRAME* m_pFrames;
+		int m_nFrames;
+		int m_nFramesAlloc;
+		DWORD* m_pCanvas;
+		DWORD* m_pRestore;
+		int m_iCanvasFrame;
+		int m_iLastFrame;
+		int m_nCacheFrames;
+		DWORD** m_ppCache;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIGIFDECODER_H__
@@ -0,0 +1,101 @@
+﻿#include "StdAfx.h"
+#include "UIImageAtlas.h"
+
+namespace DuiLib {
+
+	CStdPtrArray CImageAtlas::m_aAtlases;
+
+	CImageAtlas::CImageAtlas() :
+		m_hBitmap(NULL),
+		m_pBits(NULL),
+		m_nImages(0)
+	{
+	}
+
+	CImageAtlas::~CImageAtlas()
+	{
+		if( m_hBitmap ) ::DeleteObject(m_hBitmap);
+	}
+
+	bool CImageAtlas::Pack(TImageInfo* pImageInfo)
+	{
+		// GDI+图片和HSL图片需要完整独立的位图
+		if( pImageInfo == NULL || pImageInfo->pAtlas != NULL || pImageInfo->hBitmap == NULL || pImageInfo->pBits == NULL ) return false;
+		if( pImageInfo->pImage != NULL || pImageInfo->bUseHSL ) return false;
+		int nX = pImageInfo->nX;
+		int nY = pImageInfo->nY;
+		if( nX <= 0 || nY <= 0 || nX > ATLAS_MAX_IMAGE || nY > ATLAS_MAX_IMAGE ) return false;
+
+		POINT pt = { 0 };
+		CImageAtlas* pAtlas = NULL;
+		// 较早的页通常已经放满，从最新的页开始找
+		for( int i = m_aAtlases.GetSize() - 1; i >= 0; i-- ) {
+			CImageAtlas* pPage = static_cast<CImageAtlas*>(m_aAtlases[i]);
+			if( pPage->m_packer.Allocate(nX + 2, nY + 2, pt) ) {
+				pAtlas = pPage;
+				break;
+			}
+		}
+		if( pAtlas == NULL ) {
+			pAtlas = new CImageAtlas;
+			if( !pAtlas->_Create() || !pAtlas->m_packer.Allocate(nX + 2, nY + 2, pt) ) {
+				delete pAtlas;
+				return false;
+			}
+			m_aAtlases.Add(pAtlas);
+		}
+
+		// 直接写入DIB内存前先完成未执行的GDI操作
+		::GdiFlush();
+		const DWORD* pSrc = (const DWORD*)pImageInfo->pBits;
+		DWORD* pDest = (DWORD*)pAtlas->m_pBits;
+		for( int y = -1; y <= nY; y++ ) {
+			int ySrc = y < 0 ? 0 : (y >= nY ? nY - 1 : y);
+			const DWORD* pLine = pSrc + ySrc * nX;
+			DWORD* pOut = pDest + (pt.y + 1 + y) * ATLAS_SIZE + pt.x + 1;
+			pOut[-1] = pLine[0];
+			::CopyMemory(pOut, pLine, nX * 4);
+			pOut[nX] = pLine[nX - 1];
+		}
+
+		::DeleteObject(pImageInfo->hBitmap);
+		pImageInfo->hBitmap = pAtlas->m_hBitmap;
+		pImageInfo->pBits = NULL;
+		pImageInfo->pAtlas = pAtlas;
+		pImageInfo->nAtlasX = pt.x + 1;
+		pImageInfo->nAtlasY = pt.y + 1;
+		pAtlas->m_nImages++;
+		return true;
+	}
+
+	void CImageAtlas::Release(TImageInfo* pImageInfo)
+	{
+		if( pImageInfo == NULL || pImageInfo->pAtlas == NULL ) return;
+		CImageAtlas* pAtlas = pImageInfo->pAtlas;
+		pImageInfo->pAtlas = NULL;
+		pImageInfo->nAtlasX = 0;
+		pImageInfo->nAtlasY = 0;
+		if( --pAtlas->m_nImages > 0 ) return;
+		m_aAtlases.Remove(m_aAtlases.Find(pAtlas));
+		delete pAtlas;
+	}
+
+	bool CImageAtlas::_Create()
+	{
+		BITMAPINFO bmi;
+		::ZeroMemory(&bmi, sizeof(BITMAPINFO));
+		bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		bmi.bmiHeader.biWidth = ATLAS_SIZE;
+		bmi.bmiHeader.biHeight = -ATLAS_SIZE;
+		bmi.bmiHeader.biPlanes = 1;
+		bmi.bmiHeader.biBitCount = 32;
+		bmi.bmiHeader.biCompression = BI_RGB;
+		bmi.bmiHeader.biSizeImage = ATLAS_SIZE * ATLAS_SIZE * 4;
+		m_hBitmap = ::CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, (void**)&m_pBits, NULL, 0);
+		if( m_hBitmap == NULL ) return false;
+
+		m_packer.Reset(ATLAS_SIZE, ATLAS_SIZE);
+		return true;
+	}
+
+} // namespace DuiLib
@@ -0,0 +1,44 @@
+﻿#ifndef __UIIMAGEATLAS_H__
+#define __UIIMAGEATLAS_H__
+
+#pragma once
+
+namespace DuiLib {
+
+	// 图集：把小图片合并到共享的大位图中，减少GDI对象数量和内存碎片
+	// 每页是ATLAS_SIZE见方的预乘alpha DIB，用CSkylinePacker分配区域；
+	// 图片四周各复制一圈边缘像素，拉伸绘制时不会采样到相邻的图片
+	// 页中的图片全部释放后删除整页，单张图片释放的区域不再复用
+	class UILIB_API CImageAtlas
+	{
+	public:
+		enum
+		{
+			ATLAS_SIZE = 1024,
+			ATLAS_MAX_IMAGE = 256,
+		};
+
+		// 把图片复制到图集并释放原来的位图，之后pImageInfo->hBitmap为整页位图，
+		// 图片位于(nAtlasX, nAtlasY)；不适合放入图集时返回false，图片保持不变
+		static bool Pack(TImageInfo* pImageInfo);
+		// 由CRenderEngine::FreeImage调用
+		static void Release(TImageInfo* pImageInfo);
+
+	private:
+		CImageAtlas();
+		~CImageAtlas();
+
+		bool _Create();
+
+	private:
+		HBITMAP m_hBitmap;
+		LPBYTE m_pBits;
+		int m_nImages;
+		CSkylinePacker m_packer;
+
+		static CStdPtrArray m_aAtlases;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIIMAGEATLAS_H__
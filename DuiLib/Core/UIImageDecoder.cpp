@@ -0,0 +1,222 @@
+﻿#include "StdAfx.h"
+#include "UIImageDecoder.h"
+
+namespace DuiLib {
+
+	// 正在运行的解码任务数，归零时置位事件，WaitAll等待该事件而不是轮询
+	class CDecodeJobCounter
+	{
+	public:
+		CDecodeJobCounter() : m_nRunning(0)
+		{
+			::InitializeCriticalSection(&m_cs);
+			m_hIdle = ::CreateEvent(NULL, TRUE, TRUE, NULL);
+		}
+
+		~CDecodeJobCounter()
+		{
+			if( m_hIdle ) ::CloseHandle(m_hIdle);
+			::DeleteCriticalSection(&m_cs);
+		}
+
+		bool IsValid() const
+		{
+			return m_hIdle != NULL;
+		}
+
+		void Start()
+		{
+			::EnterCriticalSection(&m_cs);
+			if( m_nRunning++ == 0 ) ::ResetEvent(m_hIdle);
+			::LeaveCriticalSection(&m_cs);
+		}
+
+		void Finish()
+		{
+			::EnterCriticalSection(&m_cs);
+			if( --m_nRunning == 0 ) ::SetEvent(m_hIdle);
+			::LeaveCriticalSection(&m_cs);
+		}
+
+		void WaitIdle()
+		{
+			if( m_hIdle ) ::WaitForSingleObject(m_hIdle, INFINITE);
+		}
+
+	private:
+		CRITICAL_SECTION m_cs;
+		HANDLE m_hIdle;
+		LONG m_nRunning;
+	};
+
+	static CDecodeJobCounter s_jobCounter;
+
+	CImageDecodeJob::CImageDecodeJob() :
+		m_nID(0),
+		m_dwMask(0),
+		m_hInstance(NULL),
+		m_pData(NULL),
+		m_dwSize(0),
+		m_bPrefetched(false),
+		m_bFallbackTried(false),
+		m_bFinished(false),
+		m_nScale(100),
+		m_pImageInfo(NULL),
+		m_hWndNotify(NULL),
+		m_uMsgNotify(0),
+		m_nRef(1)
+	{
+		m_hDone = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+	}
+
+	CImageDecodeJob::~CImageDecodeJob()
+	{
+		CRenderEngine::UnmapImageData(m_pData);
+		CRenderEngine::FreeImage(m_pImageInfo);
+		if( m_hDone ) ::CloseHandle(m_hDone);
+	}
+
+	CImageDecodeJob* CImageDecodeJob::Submit(LPCTSTR bitmap, LPCTSTR type, DWORD mask, HINSTANCE instance)
+	{
+		if( bitmap == NULL || bitmap[0] == _T('\0') || !s_jobCounter.IsValid() ) return NULL;
+
+		CImageDecodeJob* pJob = new CImageDecodeJob;
+		if( pJob->m_hDone == NULL ) {
+			delete pJob;
+			return NULL;
+		}
+		pJob->m_dwMask = mask;
+		pJob->m_hInstance = instance;
+		if( type != NULL && lstrlen(type) > 0 ) {
+			// 资源dll中的图片只支持数字ID，与AddImage一致
+			if( !isdigit(*bitmap) ) {
+				delete pJob;
+				return NULL;
+			}
+			LPTSTR pstr = NULL;
+			pJob->m_nID = _tcstol(bitmap, &pstr, 10);
+			pJob->m_sType = type;
+		}
+		else {
+			// 路径映射在UI线程完成，工作线程只访问自己的副本
+			pJob->m_sBitmap = CResourceManager::GetInstance()->GetImagePath(bitmap);
+			if( pJob->m_sBitmap.IsEmpty() ) pJob->m_sBitmap = bitmap;
+			pJob->m_nScale = CRenderEngine::GetImageScale(bitmap);
+			CDuiString sImageName = bitmap;
+			int iAtIdx = sImageName.ReverseFind(_T('@'));
+			int iDotIdx = sImageName.ReverseFind(_T('.'));
+			if( iAtIdx != -1 && iDotIdx != -1 ) {
+				sImageName = sImageName.Left(iAtIdx) + sImageName.Mid(iDotIdx);
+				pJob->m_sFallback = CResourceManager::GetInstance()->GetImagePath(sImageName);
+				if( pJob->m_sFallback.IsEmpty() ) pJob->m_sFallback = sImageName;
+			}
+			if( !CPaintManagerUI::GetResourceZip().IsEmpty() ) {
+				pJob->m_pData = CRenderEngine::MapImageData(pJob->_GetBitmap(), NULL, instance, pJob->m_dwSize);
+				pJob->m_bPrefetched = true;
+			}
+		}
+
+		pJob->AddRef();
+		s_jobCounter.Start();
+		if( !::QueueUserWorkItem(_Run, pJob, WT_EXECUTEDEFAULT) ) _Run(pJob);
+		return pJob;
+	}
+
+	void CImageDecodeJob::WaitAll()
+	{
+		s_jobCounter.WaitIdle();
+	}
+
+	void CImageDecodeJob::AddRef()
+	{
+		::InterlockedIncrement(&m_nRef);
+	}
+
+	void CImageDecodeJob::Release()
+	{
+		if( ::InterlockedDecrement(&m_nRef) == 0 ) delete this;
+	}
+
+	bool CImageDecodeJob::IsDone() const
+	{
+		return ::WaitForSingleObject(m_hDone, 0) == WAIT_OBJECT_0;
+	}
+
+	bool CImageDecodeJob::Wait(DWORD dwMilliseconds)
+	{
+		return ::WaitForSingleObject(m_hDone, dwMilliseconds) == WAIT_OBJECT_0;
+	}
+
+	void CImageDecodeJob::SetNotify(HWND hWnd, UINT uMsg)
+	{
+		m_uMsgNotify = uMsg;
+		::InterlockedExchangePointer((PVOID volatile*)&m_hWndNotify, hWnd);
+		// 工作线程可能在设置前已经结束，重复投递由接收方忽略
+		if( hWnd != NULL && IsDone() ) ::PostMessage(hWnd, uMsg, 0, 0L);
+	}
+
+	TImageInfo* CImageDecodeJob::Finish()
+	{
+		if( m_bFinished ) return NULL;
+		m_bFinished = true;
+		Wait();
+
+		TImageInfo* data = m_pImageInfo;
+		m_pImageInfo = NULL;
+		// 工作线程尝试过备用图片说明得到的是原图
+		bool bOriginal = m_bFallbackTried;
+		if( data == NULL && !m_bFallbackTried && !m_sFallback.IsEmpty() ) {
+			data = CRenderEngine::LoadImage(STRINGorID(m_sFallback.GetData()), NULL, m_dwMask, m_hInstance);
+			bOriginal = true;
+		}
+		return CRenderEngine::ApplyImageScale(data, m_nScale, bOriginal);
+	}
+
+	STRINGorID CImageDecodeJob::_GetBitmap() const
+	{
+		if( m_sType.IsEmpty() ) return STRINGorID(m_sBitmap.GetData());
+		return STRINGorID(m_nID);
+	}
+
+	void CImageDecodeJob::_Decode(const BYTE* pData, DWORD dwSize)
+	{
+		if( pData == NULL ) return;
+		bool bDiskCache = !CPaintManagerUI::GetDecodedImageCachePath().IsEmpty();
+		ULONGLONG ullHash = 0;
+		if( bDiskCache ) {
+			ullHash = CRenderEngine::HashImageData(pData, dwSize);
+			m_pImageInfo = CRenderEngine::LoadCachedImage(ullHash, m_dwMask);
+			if( m_pImageInfo ) return;
+		}
+		m_pImageInfo = CRenderEngine::DecodeImageInfo(pData, dwSize, m_dwMask);
+		if( bDiskCache && m_pImageInfo ) CRenderEngine::SaveCachedImage(ullHash, m_dwMask, m_pImageInfo);
+	}
+
+	DWORD WINAPI CImageDecodeJob::_Run(LPVOID pParam)
+	{
+		CImageDecodeJob* pJob = static_cast<CImageDecodeJob*>(pParam);
+		if( !pJob->m_bPrefetched ) {
+			pJob->m_pData = CRenderEngine::MapImageData(pJob->_GetBitmap(), pJob->m_sType.IsEmpty() ? NULL : pJob->m_sType.GetData(), pJob->m_hInstance, pJob->m_dwSize);
+		}
+		pJob->_Decode(pJob->m_pData, pJob->m_dwSize);
+		CRenderEngine::UnmapImageData(pJob->m_pData);
+		pJob->m_pData = NULL;
+
+		// 带@的DPI图片不存在时使用原图，zip中的备用图片留给Finish在UI线程读取
+		if( pJob->m_pImageInfo == NULL && !pJob->m_bPrefetched && !pJob->m_sFallback.IsEmpty() ) {
+			DWORD dwSize = 0;
+			const BYTE* pData = CRenderEngine::MapImageData(STRINGorID(pJob->m_sFallback.GetData()), NULL, pJob->m_hInstance, dwSize);
+			pJob->_Decode(pData, dwSize);
+			CRenderEngine::UnmapImageData(pData);
+			pJob->m_bFallbackTried = true;
+		}
+
+		::SetEvent(pJob->m_hDone);
+		HWND hWndNotify = (HWND)::InterlockedCompareExchangePointer((PVOID volatile*)&pJob->m_hWndNotify, NULL, NULL);
+		if( hWndNotify != NULL ) ::PostMessage(hWndNotify, pJob->m_uMsgNotify, 0, 0L);
+		pJob->Release();
+		s_jobCounter.Finish();
+		return 0;
+	}
+
+} // namespace DuiLib
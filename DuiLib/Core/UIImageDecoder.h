@@ -0,0 +1,61 @@
+﻿#ifndef __UIIMAGEDECODER_H__
+#define __UIIMAGEDECODER_H__
+
+#pragma once
+
+namespace DuiLib {
+
+	// 图片后台解码任务：在系统线程池中读取并解码图片，UI线程调用Finish创建位图
+	// 使用资源zip时文件数据在提交时由UI线程读取（zip句柄不是线程安全的），只把解码交给工作线程
+	// 位图在工作线程创建，stb解码出的RGBA在工作线程转换写入位图，Finish只做DPI缩放
+	class UILIB_API CImageDecodeJob
+	{
+	public:
+		// 参数含义同CPaintManagerUI::AddImage，返回的任务由调用方Release；无法异步加载时返回NULL
+		static CImageDecodeJob* Submit(LPCTSTR bitmap, LPCTSTR type = NULL, DWORD mask = 0, HINSTANCE instance = NULL);
+		// 等待所有已提交的任务结束，退出前调用
+		static void WaitAll();
+
+		void AddRef();
+		void Release();
+
+		bool IsDone() const;
+		bool Wait(DWORD dwMilliseconds = INFINITE);
+		// 解码结束后向hWnd投递uMsg，已经结束时立即投递；同一任务只保留最后一个接收窗口
+		void SetNotify(HWND hWnd, UINT uMsg);
+		// 等待解码完成并创建位图，失败返回NULL；只能调用一次
+		TImageInfo* Finish();
+
+	private:
+		CImageDecodeJob();
+		~CImageDecodeJob();
+		CImageDecodeJob(const CImageDecodeJob&);
+		CImageDecodeJob& operator=(const CImageDecodeJob&);
+
+		static DWORD WINAPI _Run(LPVOID pParam);
+		void _Decode(const BYTE* pData, DWORD dwSize);
+		STRINGorID _GetBitmap() const;
+
+	private:
+		CDuiString m_sBitmap;
+		CDuiString m_sFallback;
+		CDuiString m_sType;
+		UINT m_nID;
+		DWORD m_dwMask;
+		HINSTANCE m_hInstance;
+		const BYTE* m_pData;
+		DWORD m_dwSize;
+		bool m_bPrefetched;
+		bool m_bFallbackTried;
+		bool m_bFinished;
+		int m_nScale;
+		TImageInfo* m_pImageInfo;
+		HANDLE m_hDone;
+		HWND volatile m_hWndNotify;
+		UINT m_uMsgNotify;
+		LONG m_nRef;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIIMAGEDECODER_H__
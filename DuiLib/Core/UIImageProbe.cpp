@@ -0,0 +1,95 @@
+﻿#include "UIImageProbe.h"
+#include <string.h>
+
+namespace DuiLib {
+
+	static inline DWORD ReadBE16(const BYTE* p) { return ((DWORD)p[0] << 8) | p[1]; }
+	static inline DWORD ReadBE32(const BYTE* p) { return ((DWORD)p[0] << 24) | ((DWORD)p[1] << 16) | ((DWORD)p[2] << 8) | p[3]; }
+	static inline DWORD ReadLE16(const BYTE* p) { return p[0] | ((DWORD)p[1] << 8); }
+	static inline DWORD ReadLE32(const BYTE* p) { return p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24); }
+
+	bool CImageProbe::Probe(const BYTE* pData, DWORD dwSize, int& x, int& y, bool& bAlpha)
+	{
+		x = y = 0;
+		bAlpha = false;
+		if( pData == NULL || dwSize < 26 ) return false;
+
+		// PNG：IHDR固定为第一个数据块；颜色类型4、6带alpha，其它类型在IDAT之前出现tRNS时也有透明
+		if( memcmp(pData, "\x89PNG\r\n\x1a\n", 8) == 0 ) {
+			if( memcmp(pData + 12, "IHDR", 4) != 0 ) return false;
+			x = (int)ReadBE32(pData + 16);
+			y = (int)ReadBE32(pData + 20);
+			BYTE cColorType = pData[25];
+			bAlpha = cColorType == 4 || cColorType == 6;
+			for( DWORD dwPos = 8; !bAlpha && dwPos + 8 <= dwSize; ) {
+				DWORD dwLen = ReadBE32(pData + dwPos);
+				if( memcmp(pData + dwPos + 4, "IDAT", 4) == 0 ) break;
+				if( memcmp(pData + dwPos + 4, "tRNS", 4) == 0 ) bAlpha = true;
+				if( dwLen > dwSize - dwPos - 8 ) break;
+				dwPos += dwLen + 12;
+			}
+		}
+		// GIF：逻辑屏幕尺寸，第一幅图像之前的图形控制扩展标记了透明色时视为带透明
+		else if( memcmp(pData, "GIF87a", 6) == 0 || memcmp(pData, "GIF89a", 6) == 0 ) {
+			x = (int)ReadLE16(pData + 6);
+			y = (int)ReadLE16(pData + 8);
+			DWORD dwPos = 13;
+			if( pData[10] & 0x80 ) dwPos += 3 << ((pData[10] & 0x07) + 1);
+			while( dwPos + 2 < dwSize && pData[dwPos] == 0x21 ) {
+				if( pData[dwPos + 1] == 0xF9 && dwPos + 3 < dwSize ) {
+					bAlpha = (pData[dwPos + 3] & 0x01) != 0;
+					break;
+				}
+				dwPos += 2;
+				while( dwPos < dwSize && pData[dwPos] != 0 ) dwPos += pData[dwPos] + 1;
+				dwPos++;
+			}
+		}
+		// JPEG：逐段跳过，直到帧头SOFn（DHT、JPG、DAC也使用0xC4、0xC8、0xCC）
+		else if( pData[0] == 0xFF && pData[1] == 0xD8 ) {
+			DWORD dwPos = 2;
+			for( ; ; ) {
+				if( dwPos + 9 > dwSize ) return false;
+				if( pData[dwPos] != 0xFF ) return false;
+				BYTE cMarker = pData[dwPos + 1];
+				// 填充字节，以及没有长度字段的RSTn、TEM
+				if( cMarker == 0xFF ) {
+					dwPos++;
+					continue;
+				}
+				if( (cMarker >= 0xD0 && cMarker <= 0xD7) || cMarker == 0x01 ) {
+					dwPos += 2;
+					continue;
+				}
+				if( cMarker >= 0xC0 && cMarker <= 0xCF && cMarker != 0xC4 && cMarker != 0xC8 && cMarker != 0xCC ) {
+					y = (int)ReadBE16(pData + dwPos + 5);
+					x = (int)ReadBE16(pData + dwPos + 7);
+					break;
+				}
+				if( cMarker == 0xD9 || cMarker == 0xDA ) return false;
+				dwPos += ReadBE16(pData + dwPos + 2) + 2;
+			}
+		}
+		// BMP：BITMAPCOREHEADER使用16位尺寸，其它信息头使用32位，高度为负表示自上而下
+		else if( pData[0] == 'B' && pData[1] == 'M' ) {
+			DWORD dwHeaderSize = ReadLE32(pData + 14);
+			if( dwHeaderSize == 12 ) {
+				x = (int)ReadLE16(pData + 18);
+				y = (int)ReadLE16(pData + 20);
+				bAlpha = ReadLE16(pData + 24) == 32;
+			}
+			else if( dwHeaderSize >= 40 && dwSize >= 30 ) {
+				x = (int)ReadLE32(pData + 18);
+				// 取绝对值时按无符号数取反，0x80000000仍为负数，不会溢出
+				DWORD dwHeight = ReadLE32(pData + 22);
+				y = (int)((dwHeight & 0x80000000) ? 0 - dwHeight : dwHeight);
+				bAlpha = ReadLE16(pData + 28) == 32;
+			}
+		}
+		if( x > 0 && y > 0 ) return true;
+		x = y = 0;
+		bAlpha = false;
+		return false;
+	}
+
+} // namespace DuiLib
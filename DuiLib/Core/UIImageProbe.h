@@ -0,0 +1,21 @@
+﻿#ifndef __UIIMAGEPROBE_H__
+#define __UIIMAGEPROBE_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// 只解析PNG/JPEG/GIF/BMP文件头，取得尺寸和是否可能带透明，不解码像素
+	// 只读取[pData, pData + dwSize)，数据被截断时返回false；只使用C运行库，不依赖窗口
+	class UILIB_API CImageProbe
+	{
+	public:
+		// 无法识别的格式或文件头不完整时返回false
+		static bool Probe(const BYTE* pData, DWORD dwSize, int& x, int& y, bool& bAlpha);
+	};
+
+} // namespace DuiLib
+
+#endif // __UIIMAGEPROBE_H__
@@ -65,6 +65,25 @@ namespace DuiLib {
 		bool bKilled;
 	} TIMERINFO;
 
+	typedef struct tagPENDINGIMAGE
+	{
+		CImageDecodeJob* pJob;
+		CDuiString sResType;
+		DWORD dwMask;
+		bool bUseHSL;
+		bool bEvictable;
+	} PENDINGIMAGE;
+
+	// 按最近一次取用的时钟排序，越久未用越靠前
+	static int __cdecl CompareImageLastUse(const void* p1, const void* p2)
+	{
+		const TImageInfo* pImage1 = *static_cast<TImageInfo* const*>(p1);
+		const TImageInfo* pImage2 = *static_cast<TImageInfo* const*>(p2);
+		if( pImage1->dwLastUse < pImage2->dwLastUse ) return -1;
+		if( pImage1->dwLastUse > pImage2->dwLastUse ) return 1;
+		return 0;
+	}
+
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///
@@ -72,6 +91,13 @@ namespace DuiLib {
 	{
 		pImage = NULL;
 		hBitmap = NULL;
+		dwHSLVersion = 0;
+		nScale = 100;
+		pAtlas = NULL;
+		nAtlasX = 0;
+		nAtlasY = 0;
+		dwLastUse = 0;
+		bEvictable = false;
 	}
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,6 +107,31 @@ namespace DuiLib {
 		Clear();
 	}
 
+	// 键按长度比较，pstrKey不以'\0'结尾
+	static bool IsDrawKey(LPCTSTR pstrKey, int cchKey, LPCTSTR pstrName)
+	{
+		return _tcsncmp(pstrKey, pstrName, cchKey) == 0 && pstrName[cchKey] == _T('\0');
+	}
+
+	static bool IsDrawValueTrue(LPCTSTR pstrValue, LPCTSTR pstrEnd)
+	{
+		return pstrEnd - pstrValue == 4 && _tcsnicmp(pstrValue, _T("true"), 4) == 0;
+	}
+
+	// 逗号分隔的整数，缺少的项为0，不会越过值的结束引号
+	static void ParseDrawLongs(LPCTSTR pstrValue, LPCTSTR pstrEnd, LONG* pValues, int nCount)
+	{
+		LPTSTR pstr = NULL;
+		for( int i = 0; i < nCount; i++ ) {
+			if( pstrValue >= pstrEnd ) {
+				pValues[i] = 0;
+				continue;
+			}
+			pValues[i] = _tcstol(pstrValue, &pstr, 10); ASSERT(pstr);
+			pstrValue = pstr + 1;
+		}
+	}
+
 	void tagTDrawInfo::Parse(LPCTSTR pStrImage, LPCTSTR pStrModify,CPaintManagerUI *pManager)
 	{
 		// 1、aaa.jpg
@@ -90,99 +141,80 @@ namespace DuiLib {
 		sDrawModify = pStrModify;
 		sImageName = pStrImage;
 
-		CDuiString sItem;
-		CDuiString sValue;
+		// 键和值都直接指向原字符串，只有需要保存的字符串才复制
 		LPTSTR pstr = NULL;
 		for( int i = 0; i < 2; ++i ) {
 			if( i == 1) pStrImage = pStrModify;
 			if( !pStrImage ) continue;
 			while( *pStrImage != _T('\0') ) {
-				sItem.Empty();
-				sValue.Empty();
 				while( *pStrImage > _T('\0') && *pStrImage <= _T(' ') ) pStrImage = ::CharNext(pStrImage);
-				while( *pStrImage != _T('\0') && *pStrImage != _T('=') && *pStrImage > _T(' ') ) {
-					LPTSTR pstrTemp = ::CharNext(pStrImage);
-					while( pStrImage < pstrTemp) {
-						sItem += *pStrImage++;
-					}
-				}
+				LPCTSTR pstrKey = pStrImage;
+				while( *pStrImage != _T('\0') && *pStrImage != _T('=') && *pStrImage > _T(' ') ) pStrImage = ::CharNext(pStrImage);
+				int cchKey = (int)(pStrImage - pstrKey);
 				while( *pStrImage > _T('\0') && *pStrImage <= _T(' ') ) pStrImage = ::CharNext(pStrImage);
 				if( *pStrImage++ != _T('=') ) break;
 				while( *pStrImage > _T('\0') && *pStrImage <= _T(' ') ) pStrImage = ::CharNext(pStrImage);
 				if( *pStrImage++ != _T('\'') ) break;
-				while( *pStrImage != _T('\0') && *pStrImage != _T('\'') ) {
-					LPTSTR pstrTemp = ::CharNext(pStrImage);
-					while( pStrImage < pstrTemp) {
-						sValue += *pStrImage++;
-					}
-				}
+				LPCTSTR pstrValue = pStrImage;
+				while( *pStrImage != _T('\0') && *pStrImage != _T('\'') ) pStrImage = ::CharNext(pStrImage);
+				LPCTSTR pstrValueEnd = pStrImage;
 				if( *pStrImage++ != _T('\'') ) break;
-				if( !sValue.IsEmpty() ) {
-					if( sItem == _T("file") || sItem == _T("res") ) {
-						sImageName = sValue;
+				if( pstrValueEnd > pstrValue ) {
+					if( IsDrawKey(pstrKey, cchKey, _T("file")) || IsDrawKey(pstrKey, cchKey, _T("res")) ) {
+						sImageName.Assign(pstrValue, (int)(pstrValueEnd - pstrValue));
 					}
-					else if( sItem == _T("restype") ) {
-						sResType = sValue;
+					else if( IsDrawKey(pstrKey, cchKey, _T("restype")) ) {
+						sResType.Assign(pstrValue, (int)(pstrValueEnd - pstrValue));
 					}
-					else if( sItem == _T("dest") ) {
-						rcDest.left = _tcstol(sValue.GetData(), &pstr, 10);  ASSERT(pstr);    
-						rcDest.top = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);    
-						rcDest.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
-						rcDest.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);  
+					else if( IsDrawKey(pstrKey, cchKey, _T("dest")) ) {
+						ParseDrawLongs(pstrValue, pstrValueEnd, &rcDest.left, 4);
 						//if(pManager != NULL) pManager->GetDPIObj()->Scale(&rcDest);
 					}
-					else if( sItem == _T("source") ) {
-						rcSource.left = _tcstol(sValue.GetData(), &pstr, 10);  ASSERT(pstr);    
-						rcSource.top = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);    
-						rcSource.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
-						rcSource.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);
+					else if( IsDrawKey(pstrKey, cchKey, _T("source")) ) {
+						ParseDrawLongs(pstrValue, pstrValueEnd, &rcSource.left, 4);
 						//if(pManager != NULL) pManager->GetDPIObj()->Scale(&rcSource);
 					}
-					else if( sItem == _T("corner") ) {
-						rcCorner.left = _tcstol(sValue.GetData(), &pstr, 10);  ASSERT(pstr);    
-						rcCorner.top = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);    
-						rcCorner.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
-						rcCorner.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);
+					else if( IsDrawKey(pstrKey, cchKey, _T("corner")) ) {
+						ParseDrawLongs(pstrValue, pstrValueEnd, &rcCorner.left, 4);
 						//if(pManager != NULL) pManager->GetDPIObj()->Scale(&rcCorner);
 					}
-					else if( sItem == _T("mask") ) {
-						if( sValue[0] == _T('#')) dwMask = _tcstoul(sValue.GetData() + 1, &pstr, 16);
-						else dwMask = _tcstoul(sValue.GetData(), &pstr, 16);
+					else if( IsDrawKey(pstrKey, cchKey, _T("mask")) ) {
+						if( *pstrValue == _T('#')) dwMask = _tcstoul(pstrValue + 1, &pstr, 16);
+						else dwMask = _tcstoul(pstrValue, &pstr, 16);
 					}
-					else if( sItem == _T("fade") ) {
-						uFade = (UINT)_tcstoul(sValue.GetData(), &pstr, 10);
+					else if( IsDrawKey(pstrKey, cchKey, _T("fade")) ) {
+						uFade = (UINT)_tcstoul(pstrValue, &pstr, 10);
 					}
-					else if( sItem == _T("rotate") ) {
-						uRotate = (UINT)_tcstoul(sValue.GetData(), &pstr, 10);
+					else if( IsDrawKey(pstrKey, cchKey, _T("rotate")) ) {
+						uRotate = (UINT)_tcstoul(pstrValue, &pstr, 10);
 						bGdiplus = true;
 					}
-					else if( sItem == _T("gdiplus") ) {
-						bGdiplus = (_tcsicmp(sValue.GetData(), _T("true")) == 0);
+					else if( IsDrawKey(pstrKey, cchKey, _T("gdiplus")) ) {
+						bGdiplus = IsDrawValueTrue(pstrValue, pstrValueEnd);
 					}
-					else if( sItem == _T("hole") ) {
-						bHole = (_tcsicmp(sValue.GetData(), _T("true")) == 0);
+					else if( IsDrawKey(pstrKey, cchKey, _T("hole")) ) {
+						bHole = IsDrawValueTrue(pstrValue, pstrValueEnd);
 					}
-					else if( sItem == _T("xtiled") ) {
-						bTiledX = (_tcsicmp(sValue.GetData(), _T("true")) == 0);
+					else if( IsDrawKey(pstrKey, cchKey, _T("xtiled")) ) {
+						bTiledX = IsDrawValueTrue(pstrValue, pstrValueEnd);
 					}
-					else if( sItem == _T("ytiled") ) {
-						bTiledY = (_tcsicmp(sValue.GetData(), _T("true")) == 0);
+					else if( IsDrawKey(pstrKey, cchKey, _T("ytiled")) ) {
+						bTiledY = IsDrawValueTrue(pstrValue, pstrValueEnd);
 					}
-					else if( sItem == _T("hsl") ) {
-						bHSL = (_tcsicmp(sValue.GetData(), _T("true")) == 0);
+					else if( IsDrawKey(pstrKey, cchKey, _T("hsl")) ) {
+						bHSL = IsDrawValueTrue(pstrValue, pstrValueEnd);
 					}
-					else if( sItem == _T("size") ) {
-						szImage.cx = _tcstol(sValue.GetData(), &pstr, 10);  ASSERT(pstr);
-						szImage.cy = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);
+					else if( IsDrawKey(pstrKey, cchKey, _T("size")) ) {
+						LONG aSize[2];
+						ParseDrawLongs(pstrValue, pstrValueEnd, aSize, 2);
+						szImage.cx = aSize[0];
+						szImage.cy = aSize[1];
 					}
-					else if( sItem == _T("align") ) {
-						sAlign = sValue;
+					else if( IsDrawKey(pstrKey, cchKey, _T("align")) ) {
+						sAlign.Assign(pstrValue, (int)(pstrValueEnd - pstrValue));
 					}
-					else if( sItem == _T("padding") ) {
-						rcPadding.left = _tcstol(sValue.GetData(), &pstr, 10);  ASSERT(pstr);    
-						rcPadding.top = _tcstol(pstr + 1, &pstr, 10);    ASSERT(pstr);    
-						rcPadding.right = _tcstol(pstr + 1, &pstr, 10);  ASSERT(pstr);    
-						rcPadding.bottom = _tcstol(pstr + 1, &pstr, 10); ASSERT(pstr);  
+					else if( IsDrawKey(pstrKey, cchKey, _T("padding")) ) {
+						ParseDrawLongs(pstrValue, pstrValueEnd, &rcPadding.left, 4);
 						//if(pManager != NULL) pManager->GetDPIObj()->Scale(&rcPadding);
 					}
 				}
@@ -220,6 +252,256 @@ namespace DuiLib {
 		memset(&rcPadding, 0, sizeof(RECT));
 	}
 
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	///
+	// 在作用域内持有窗口的绘制资源锁，分块绘制的线程通过它互斥地查找和加载图片、字体
+	class CPaintResourceLock
+	{
+	public:
+		explicit CPaintResourceLock(CPaintManagerUI* pManager) : m_pManager(pManager) { m_pManager->LockPaintResource(); }
+		~CPaintResourceLock() { m_pManager->UnlockPaintResource(); }
+
+	private:
+		CPaintResourceLock(const CPaintResourceLock&);
+		CPaintResourceLock& operator=(const CPaintResourceLock&);
+
+	private:
+		CPaintManagerUI* m_pManager;
+	};
+
+	// 所有CPaintManagerUI共用的TDrawInfo表，同样的图片字符串在同一DPI下只解析一次。
+	// 每个条目记录引用它的窗口，最后一个窗口释放后删除。
+	// 不同窗口（各自的分块绘制线程或UI线程）会同时访问，表由自己的临界区保护
+	class CDrawInfoPool
+	{
+	public:
+		CDrawInfoPool() : m_pBuckets(NULL), m_nBuckets(0), m_nCount(0)
+		{
+			::InitializeCriticalSection(&m_cs);
+		}
+
+		~CDrawInfoPool()
+		{
+			for( int i = 0; i < m_nBuckets; i++ ) {
+				TEntry* pEntry = m_pBuckets[i];
+				while( pEntry != NULL ) {
+					TEntry* pNext = pEntry->pNext;
+					delete pEntry;
+					pEntry = pNext;
+				}
+			}
+			if( m_pBuckets != NULL ) free(m_pBuckets);
+			m_pBuckets = NULL;
+			m_nBuckets = m_nCount = 0;
+			::DeleteCriticalSection(&m_cs);
+		}
+
+		const TDrawInfo* Acquire(LPCTSTR pStrImage, LPCTSTR pStrModify, CPaintManagerUI* pManager)
+		{
+			int nScale = pManager->GetDPIObj()->GetScale();
+			UINT nHash = _Hash(pStrImage, pStrModify, nScale);
+			::EnterCriticalSection(&m_cs);
+			TEntry* pEntry = _Find(nHash, pStrImage, pStrModify, nScale);
+			if( pEntry == NULL ) {
+				if( m_nCount >= m_nBuckets * 2 && !_Grow() ) {
+					::LeaveCriticalSection(&m_cs);
+					return NULL;
+				}
+				pEntry = new TEntry;
+				pEntry->nHash = nHash;
+				pEntry->nScale = nScale;
+				pEntry->info.Parse(pStrImage, pStrModify, pManager);
+				TEntry*& pHead = m_pBuckets[nHash & (m_nBuckets - 1)];
+				pEntry->pNext = pHead;
+				pHead = pEntry;
+				m_nCount++;
+			}
+			if( pEntry->aOwners.Find(pManager) < 0 ) pEntry->aOwners.Add(pManager);
+			// 条目在pManager释放它之前不会被删除，出临界区后仍可使用
+			::LeaveCriticalSection(&m_cs);
+			return &pEntry->info;
+		}
+
+		void Release(LPCTSTR pStrImage, LPCTSTR pStrModify, CPaintManagerUI* pManager)
+		{
+			int nScale = pManager->GetDPIObj()->GetScale();
+			UINT nHash = _Hash(pStrImage, pStrModify, nScale);
+			::EnterCriticalSection(&m_cs);
+			TEntry* pEntry = _Find(nHash, pStrImage, pStrModify, nScale);
+			if( pEntry != NULL ) {
+				int iOwner = pEntry->aOwners.Find(pManager);
+				if( iOwner >= 0 ) pEntry->aOwners.Remove(iOwner);
+				if( pEntry->aOwners.IsEmpty() ) _Delete(pEntry);
+			}
+			::LeaveCriticalSection(&m_cs);
+		}
+
+		void ReleaseAll(CPaintManagerUI* pManager)
+		{
+			::EnterCriticalSection(&m_cs);
+			for( int i = 0; i < m_nBuckets; i++ ) {
+				TEntry* pEntry = m_pBuckets[i];
+				while( pEntry != NULL ) {
+					TEntry* pNext = pEntry->pNext;
+					int iOwner = pEntry->aOwners.Find(pManager);
+					if( iOwner >= 0 ) {
+						pEntry->aOwners.Remove(iOwner);
+						if( pEntry->aOwners.IsEmpty() ) _Delete(pEntry);
+					}
+					pEntry = pNext;
+				}
+			}
+			::LeaveCriticalSection(&m_cs);
+		}
+
+	private:
+		typedef struct tagTEntry
+		{
+			UINT nHash;
+			int nScale;
+			TDrawInfo info;
+			CStdPtrArray aOwners;
+			tagTEntry* pNext;
+		} TEntry;
+
+		static UINT _Hash(LPCTSTR pStrImage, LPCTSTR pStrModify, int nScale)
+		{
+			// 两段之间加一个分隔值，"ab"+""和"a"+"b"不会算成同一个键
+			UINT nHash = 2166136261U ^ (UINT)nScale;
+			if( pStrImage != NULL ) {
+				for( ; *pStrImage != _T('\0'); pStrImage++ ) nHash = (nHash ^ (UINT)*pStrImage) * 16777619U;
+			}
+			nHash = (nHash ^ 0xFFFFU) * 16777619U;
+			if( pStrModify != NULL ) {
+				for( ; *pStrModify != _T('\0'); pStrModify++ ) nHash = (nHash ^ (UINT)*pStrModify) * 16777619U;
+			}
+			return nHash;
+		}
+
+		TEntry* _Find(UINT nHash, LPCTSTR pStrImage, LPCTSTR pStrModify, int nScale) const
+		{
+			if( m_nBuckets == 0 ) return NULL;
+			if( pStrImage == NULL ) pStrImage = _T("");
+			if( pStrModify == NULL ) pStrModify = _T("");
+			for( TEntry* pEntry = m_pBuckets[nHash & (m_nBuckets - 1)]; pEntry != NULL; pEntry = pEntry->pNext ) {
+				if( pEntry->nHash == nHash && pEntry->nScale == nScale && pEntry->info.sDrawString == pStrImage && pEntry->info.sDrawModify == pStrModify ) {
+					return pEntry;
+				}
+			}
+			return NULL;
+		}
+
+		bool _Grow()
+		{
+			int nBuckets = m_nBuckets == 0 ? 64 : m_nBuckets * 2;
+			TEntry** pBuckets = static_cast<TEntry**>(calloc(nBuckets, sizeof(TEntry*)));
+			if( pBuckets == NULL ) return m_nBuckets > 0;
+			for( int i = 0; i < m_nBuckets; i++ ) {
+				TEntry* pEntry = m_pBuckets[i];
+				while( pEntry != NULL ) {
+					TEntry* pNext = pEntry->pNext;
+					TEntry*& pHead = pBuckets[pEntry->nHash & (nBuckets - 1)];
+					pEntry->pNext = pHead;
+					pHead = pEntry;
+					pEntry = pNext;
+				}
+			}
+			if( m_pBuckets != NULL ) free(m_pBuckets);
+			m_pBuckets = pBuckets;
+			m_nBuckets = nBuckets;
+			return true;
+		}
+
+		void _Delete(TEntry* pEntry)
+		{
+			TEntry** ppLink = &m_pBuckets[pEntry->nHash & (m_nBuckets - 1)];
+			while( *ppLink != pEntry ) ppLink = &(*ppLink)->pNext;
+			*ppLink = pEntry->pNext;
+			delete pEntry;
+			m_nCount--;
+		}
+
+	private:
+		TEntry** m_pBuckets;
+		int m_nBuckets;
+		int m_nCount;
+		CRITICAL_SECTION m_cs;
+	};
+
+	static CDrawInfoPool s_drawInfoPool;
+
+	// 分块绘制：每块至少PAINT_TILE_MIN_ROWS行，小于PAINT_TILE_MIN_PIXELS的脏矩形不分块
+	#define PAINT_TILE_MIN_ROWS 64
+	#define PAINT_TILE_MIN_PIXELS (256 * 256)
+
+	typedef struct tagPAINTTILE
+	{
+		CControlUI* pRoot;
+		RECT rcTile;
+		LPBYTE pOffscreenBits;
+		int nOffscreenWidth;
+		int nOffscreenHeight;
+		HDC hDC;
+		HBITMAP hBitmap;
+		HBITMAP hOldBitmap;
+		LPBYTE pBits;
+		bool bPainted;
+		volatile LONG* pnPending;
+		HANDLE hDone;
+	} PAINTTILE;
+
+	// 离屏位图是自下而上的DIB，取客户区第y行的地址
+	static inline LPBYTE GetOffscreenRow(const PAINTTILE* pTile, int y)
+	{
+		return pTile->pOffscreenBits + (pTile->nOffscreenHeight - 1 - y) * pTile->nOffscreenWidth * 4;
+	}
+
+	// 离屏位图中的一块复制到单独的DIB上软件渲染，绘制范围和裁剪区域都是本块，由窗口线程在全部完成后复制回去
+	// 控件的绘制范围记在本线程中，不写入共享的m_rcPaint；有需要交给GDI的绘制时bPainted为false
+	static void PaintTile(PAINTTILE* pTile)
+	{
+		const RECT& rc = pTile->rcTile;
+		int cx = rc.right - rc.left;
+		int cy = rc.bottom - rc.top;
+		pTile->bPainted = false;
+		pTile->hDC = ::CreateCompatibleDC(NULL);
+		if( pTile->hDC == NULL ) return;
+		pTile->hBitmap = CRenderEngine::CreateARGB32Bitmap(pTile->hDC, cx, cy, &pTile->pBits);
+		if( pTile->hBitmap == NULL ) return;
+		for( int y = 0; y < cy; y++ ) {
+			::CopyMemory(pTile->pBits + (cy - 1 - y) * cx * 4, GetOffscreenRow(pTile, rc.top + y) + rc.left * 4, cx * 4);
+		}
+		pTile->hOldBitmap = (HBITMAP)::SelectObject(pTile->hDC, pTile->hBitmap);
+		::SetWindowOrgEx(pTile->hDC, rc.left, rc.top, NULL);
+		::IntersectClipRect(pTile->hDC, rc.left, rc.top, rc.right, rc.bottom);
+		{
+			CSoftRenderTarget target(pTile->hDC);
+			if( target.IsValid() ) {
+				target.SetGdiFallback(false);
+				CControlUI::SetPaintTileThread(true);
+				pTile->pRoot->Paint(pTile->hDC, rc, NULL);
+				CControlUI::SetPaintTileThread(false);
+				pTile->bPainted = !target.HasSkippedDraw();
+			}
+		}
+		::GdiFlush();
+	}
+
+	static void FreePaintTile(PAINTTILE* pTile)
+	{
+		if( pTile->hOldBitmap != NULL ) ::SelectObject(pTile->hDC, pTile->hOldBitmap);
+		if( pTile->hBitmap != NULL ) ::DeleteObject(pTile->hBitmap);
+		if( pTile->hDC != NULL ) ::DeleteDC(pTile->hDC);
+	}
+
+	static DWORD WINAPI PaintTileTask(LPVOID pParam)
+	{
+		PAINTTILE* pTile = static_cast<PAINTTILE*>(pParam);
+		PaintTile(pTile);
+		if( ::InterlockedDecrement(pTile->pnPending) == 0 ) ::SetEvent(pTile->hDone);
+		return 0;
+	}
+
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///
 	typedef BOOL (__stdcall *PFUNCUPDATELAYEREDWINDOW)(HWND, HDC, POINT*, SIZE*, HDC, POINT*, COLORREF, BLENDFUNCTION*, DWORD);
@@ -230,14 +512,22 @@ namespace DuiLib {
 	HINSTANCE CPaintManagerUI::m_hResourceInstance = NULL;
 	CDuiString CPaintManagerUI::m_pStrResourcePath;
 	CDuiString CPaintManagerUI::m_pStrResourceZip;
+	CDuiString CPaintManagerUI::m_pStrDecodedImageCachePath;
 	CDuiString CPaintManagerUI::m_pStrResourceZipPwd;  //Garfield 20160325 带密码zip包解密
 	HANDLE CPaintManagerUI::m_hResourceZip = NULL;
 	bool CPaintManagerUI::m_bCachedResourceZip = true;
+	bool CPaintManagerUI::m_bParallelImageDecode = false;
+	bool CPaintManagerUI::m_bImageAtlas = false;
 	BYTE* CPaintManagerUI::m_cbZipBuf = nullptr;
 	int CPaintManagerUI::m_nResType = UILIB_FILE;
 	TResInfo CPaintManagerUI::m_SharedResInfo;
 	HINSTANCE CPaintManagerUI::m_hInstance = NULL;
 	bool CPaintManagerUI::m_bUseHSL = false;
+	DWORD CPaintManagerUI::m_dwHSLVersion = 0;
+	SIZE_T CPaintManagerUI::m_nImageCacheBudget = 0;
+	TImageCacheStats CPaintManagerUI::m_ImageCacheStats = { 0 };
+	DWORD CPaintManagerUI::m_dwImageClock = 0;
+	CStdStringPtrMap CPaintManagerUI::m_ImageSizeHash;
 	short CPaintManagerUI::m_H = 180;
 	short CPaintManagerUI::m_S = 100;
 	short CPaintManagerUI::m_L = 100;
@@ -274,8 +564,12 @@ namespace DuiLib {
 		m_bLayered(false),
 		m_bLayeredChanged(false),
 		m_bShowUpdateRect(false),
+		m_bAsyncImageLoad(false),
+		m_dwImagePaintClock(0),
 		m_bUseGdiplusText(false),
 		m_trh(0),
+		m_bSoftwareRender(false),
+		m_nPaintThreads(0),
 		m_bDragDrop(false),
 		m_bDragMode(false),
 		m_hDragBitmap(NULL),
@@ -326,8 +620,8 @@ namespace DuiLib {
 		::ZeroMemory(&m_rcSizeBox, sizeof(m_rcSizeBox));
 		::ZeroMemory(&m_rcCaption, sizeof(m_rcCaption));
 		::ZeroMemory(&m_rcLayeredInset, sizeof(m_rcLayeredInset));
-		::ZeroMemory(&m_rcLayeredUpdate, sizeof(m_rcLayeredUpdate));
 		m_ptLastMousePos.x = m_ptLastMousePos.y = -1;
+		::InitializeCriticalSection(&m_csPaintResource);
 
 		m_pGdiplusStartupInput = new Gdiplus::GdiplusStartupInput;
 		Gdiplus::GdiplusStartup( &m_gdiplusToken, m_pGdiplusStartupInput, NULL); // 加载GDI接口
@@ -375,6 +669,7 @@ namespace DuiLib {
 		if( m_hbmpBackground != NULL ) ::DeleteObject(m_hbmpBackground);
 		if( m_hDcPaint != NULL ) ::ReleaseDC(m_hWndPaint, m_hDcPaint);
 		m_aPreMessages.Remove(m_aPreMessages.Find(this));
+		RemoveAllImageWaiters();
 		// 销毁拖拽图片
 		if( m_hDragBitmap != NULL ) ::DeleteObject(m_hDragBitmap);
 		//卸载GDIPlus
@@ -385,6 +680,7 @@ namespace DuiLib {
 			delete m_pDPI;
 			m_pDPI = NULL;
 		}
+		::DeleteCriticalSection(&m_csPaintResource);
 	}
 
 	void CPaintManagerUI::Init(HWND hWnd, LPCTSTR pstrName)
@@ -488,11 +784,25 @@ namespace DuiLib {
 	void CPaintManagerUI::SetResourcePath(LPCTSTR pStrPath)
 	{
 		m_pStrResourcePath = pStrPath;
+		RemoveAllImageSizes();
 		if( m_pStrResourcePath.IsEmpty() ) return;
 		TCHAR cEnd = m_pStrResourcePath.GetAt(m_pStrResourcePath.GetLength() - 1);
 		if( cEnd != _T('\\') && cEnd != _T('/') ) m_pStrResourcePath += _T('\\');
 	}
 
+	const CDuiString& CPaintManagerUI::GetDecodedImageCachePath()
+	{
+		return m_pStrDecodedImageCachePath;
+	}
+
+	void CPaintManagerUI::SetDecodedImageCachePath(LPCTSTR pStrPath)
+	{
+		m_pStrDecodedImageCachePath = pStrPath;
+		if( m_pStrDecodedImageCachePath.IsEmpty() ) return;
+		TCHAR cEnd = m_pStrDecodedImageCachePath.GetAt(m_pStrDecodedImageCachePath.GetLength() - 1);
+		if( cEnd != _T('\\') && cEnd != _T('/') ) m_pStrDecodedImageCachePath += _T('\\');
+	}
+
 	void CPaintManagerUI::SetResourceZip(LPVOID pVoid, unsigned int len, LPCTSTR password)
 	{
 		if( m_pStrResourceZip == _T("membuffer") ) return;
@@ -501,6 +811,7 @@ namespace DuiLib {
 			m_hResourceZip = NULL;
 		}
 		m_pStrResourceZip = _T("membuffer");
+		RemoveAllImageSizes();
         if (m_cbZipBuf)
         {
             delete[] m_cbZipBuf;
@@ -538,6 +849,7 @@ namespace DuiLib {
 		}
 		m_pStrResourceZip = pStrPath;
 		m_bCachedResourceZip = bCachedResourceZip;
+		RemoveAllImageSizes();
 		m_pStrResourceZipPwd = password;
 		if( m_bCachedResourceZip ) {
 			CDuiString sFile = CPaintManagerUI::GetResourcePath();
@@ -565,6 +877,50 @@ namespace DuiLib {
 		return m_nResType;
 	}
 
+	bool CPaintManagerUI::IsParallelImageDecode()
+	{
+		return m_bParallelImageDecode;
+	}
+
+	void CPaintManagerUI::SetParallelImageDecode(bool bParallel)
+	{
+		m_bParallelImageDecode = bParallel;
+	}
+
+	bool CPaintManagerUI::IsImageAtlas()
+	{
+		return m_bImageAtlas;
+	}
+
+	void CPaintManagerUI::SetImageAtlas(bool bAtlas)
+	{
+		m_bImageAtlas = bAtlas;
+	}
+
+	SIZE_T CPaintManagerUI::GetImageCacheBudget()
+	{
+		return m_nImageCacheBudget;
+	}
+
+	void CPaintManagerUI::SetImageCacheBudget(SIZE_T nBytes)
+	{
+		m_nImageCacheBudget = nBytes;
+		TrimImageCache();
+	}
+
+	void CPaintManagerUI::GetImageCacheStats(TImageCacheStats& stats)
+	{
+		stats = m_ImageCacheStats;
+		stats.nBudgetBytes = m_nImageCacheBudget;
+	}
+
+	void CPaintManagerUI::ResetImageCacheStats()
+	{
+		m_ImageCacheStats.dwHits = 0;
+		m_ImageCacheStats.dwMisses = 0;
+		m_ImageCacheStats.dwEvictions = 0;
+	}
+
 	bool CPaintManagerUI::GetHSL(short* H, short* S, short* L)
 	{
 		*H = m_H;
@@ -581,10 +937,10 @@ namespace DuiLib {
 			m_H = CLAMP(H, 0, 360);
 			m_S = CLAMP(S, 0, 200);
 			m_L = CLAMP(L, 0, 200);
-			AdjustSharedImagesHSL();
+			m_dwHSLVersion++;
 			for( int i = 0; i < m_aPreMessages.GetSize(); i++ ) {
 				CPaintManagerUI* pManager = static_cast<CPaintManagerUI*>(m_aPreMessages[i]);
-				if( pManager != NULL ) pManager->AdjustImagesHSL();
+				if( pManager != NULL ) pManager->Invalidate();
 			}
 		}
 	}
@@ -882,6 +1238,108 @@ namespace DuiLib {
 		return m_trh;
 	}
 
+	void CPaintManagerUI::SetSoftwareRender(bool bSoftware)
+	{
+		if( m_bSoftwareRender == bSoftware ) return;
+		m_bSoftwareRender = bSoftware;
+		if( m_pRoot != NULL ) m_pRoot->Invalidate();
+	}
+
+	bool CPaintManagerUI::IsSoftwareRender() const
+	{
+		return m_bSoftwareRender;
+	}
+
+	void CPaintManagerUI::SetPaintThreads(int nThreads)
+	{
+		if( nThreads < 0 ) nThreads = 0;
+		m_nPaintThreads = nThreads;
+	}
+
+	int CPaintManagerUI::GetPaintThreads() const
+	{
+		return m_nPaintThreads;
+	}
+
+	void CPaintManagerUI::LockPaintResource()
+	{
+		::EnterCriticalSection(&m_csPaintResource);
+	}
+
+	void CPaintManagerUI::UnlockPaintResource()
+	{
+		::LeaveCriticalSection(&m_csPaintResource);
+	}
+
+	bool CPaintManagerUI::PaintTiles(const RECT& rcDirty)
+	{
+		if( m_nPaintThreads < 2 || m_pRoot == NULL || m_hbmpOffscreen == NULL || m_pOffscreenBits == NULL ) return false;
+		int cx = rcDirty.right - rcDirty.left;
+		int cy = rcDirty.bottom - rcDirty.top;
+		if( cx * cy < PAINT_TILE_MIN_PIXELS ) return false;
+		SYSTEM_INFO si;
+		::GetSystemInfo(&si);
+		int nTiles = min(min(m_nPaintThreads, (int)si.dwNumberOfProcessors), cy / PAINT_TILE_MIN_ROWS);
+		if( nTiles < 2 ) return false;
+		// 脏矩形内有只能在窗口线程绘制的控件时不分块
+		RECT rcFind = rcDirty;
+		if( m_pRoot->FindControl(__FindControlFromPaintUnsafe, &rcFind, UIFIND_VISIBLE | UIFIND_ME_FIRST) != NULL ) return false;
+		BITMAP bm = { 0 };
+		if( ::GetObject(m_hbmpOffscreen, sizeof(BITMAP), &bm) != sizeof(BITMAP) ) return false;
+		HANDLE hDone = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+		if( hDone == NULL ) return false;
+
+		// 各块直接读写离屏位图的内存，先完成窗口线程未执行的GDI操作
+		::GdiFlush();
+
+		// 按行分块交给线程池，当前线程绘制第一块
+		volatile LONG nPending = nTiles - 1;
+		PAINTTILE* pTiles = new PAINTTILE[nTiles];
+		int nRows = (cy + nTiles - 1) / nTiles;
+		for( int i = 0; i < nTiles; i++ ) {
+			pTiles[i].pRoot = m_pRoot;
+			pTiles[i].rcTile = rcDirty;
+			pTiles[i].rcTile.top = min(rcDirty.top + i * nRows, rcDirty.bottom);
+			pTiles[i].rcTile.bottom = min(pTiles[i].rcTile.top + nRows, rcDirty.bottom);
+			pTiles[i].pOffscreenBits = m_pOffscreenBits;
+			pTiles[i].nOffscreenWidth = bm.bmWidth;
+			pTiles[i].nOffscreenHeight = bm.bmHeight;
+			pTiles[i].hDC = NULL;
+			pTiles[i].hBitmap = NULL;
+			pTiles[i].hOldBitmap = NULL;
+			pTiles[i].pBits = NULL;
+			pTiles[i].bPainted = false;
+			pTiles[i].pnPending = &nPending;
+			pTiles[i].hDone = hDone;
+		}
+		for( int i = 1; i < nTiles; i++ ) {
+			if( !::QueueUserWorkItem(PaintTileTask, &pTiles[i], WT_EXECUTEDEFAULT) ) PaintTileTask(&pTiles[i]);
+		}
+		PaintTile(&pTiles[0]);
+		::WaitForSingleObject(hDone, INFINITE);
+		::CloseHandle(hDone);
+
+		// 每块都画完才写回离屏位图；有一块失败或需要GDI时全部丢弃，由调用者整个脏矩形串行绘制，
+		// 避免半透明的内容在已写回的块上混合两次
+		bool bPainted = true;
+		for( int i = 0; i < nTiles; i++ ) {
+			if( !pTiles[i].bPainted ) bPainted = false;
+		}
+		for( int i = 0; i < nTiles; i++ ) {
+			if( bPainted ) {
+				const RECT& rc = pTiles[i].rcTile;
+				int cxTile = rc.right - rc.left;
+				int cyTile = rc.bottom - rc.top;
+				for( int y = 0; y < cyTile; y++ ) {
+					::CopyMemory(GetOffscreenRow(&pTiles[i], rc.top + y) + rc.left * 4, pTiles[i].pBits + (cyTile - 1 - y) * cxTile * 4, cxTile * 4);
+				}
+			}
+			FreePaintTile(&pTiles[i]);
+		}
+		delete[] pTiles;
+		return bPainted;
+	}
+
 	bool CPaintManagerUI::PreMessageHandler(UINT uMsg, WPARAM wParam, LPARAM lParam, LRESULT& lRes)
 	{
 		for( int i = 0; i < m_aPreMessageFilters.GetSize(); i++ ) 
@@ -988,6 +1446,13 @@ namespace DuiLib {
 		}
 		// Custom handling of events
 		switch( uMsg ) {
+		case WM_APP + 2:
+			{
+				// 后台解码的图片已就绪，创建位图并刷新等待它们的区域
+				FinishReadyImages(m_ResInfo);
+				FinishReadyImages(m_SharedResInfo);
+			}
+			break;
 		case WM_APP + 1:
 			{
 				for( int i = 0; i < m_aDelayedCleanup.GetSize(); i++ ) 
@@ -1085,6 +1550,9 @@ namespace DuiLib {
 				//	if( !::GetUpdateRect(m_hWndPaint, &rcPaint, FALSE) ) return true;
 				//}
 
+				// 本次绘制取用的图片不会被缓存淘汰
+				m_dwImagePaintClock = ++m_dwImageClock;
+
 				// Set focus to first control?
 				if( m_bFocusNeeded ) {
 					SetNextTabControl();
@@ -1157,16 +1625,22 @@ namespace DuiLib {
 					m_pRoot->SetPos(rcRoot, true);
 				}
 
+				// 脏区域取系统的更新区域（已包含布局过程中的刷新），分层窗口再加上自己记录的区域
+				// 之后按矩形逐个绘制，rcPaint只是它们的外接矩形
+				m_PaintRegion.Empty();
+				HRGN hUpdateRgn = ::CreateRectRgn(0, 0, 0, 0);
+				if( ::GetUpdateRgn(m_hWndPaint, hUpdateRgn, FALSE) > NULLREGION ) m_PaintRegion.Add(hUpdateRgn);
+				::DeleteObject(hUpdateRgn);
 				if( m_bLayered ) {
 					DWORD dwExStyle = ::GetWindowLong(m_hWndPaint, GWL_EXSTYLE);
 					DWORD dwNewExStyle = dwExStyle | WS_EX_LAYERED;
 					if(dwExStyle != dwNewExStyle) ::SetWindowLong(m_hWndPaint, GWL_EXSTYLE, dwNewExStyle);
 					m_bOffscreenPaint = true;
-					UnionRect(&rcPaint, &rcPaint, &m_rcLayeredUpdate);
-					if( rcPaint.right > rcClient.right ) rcPaint.right = rcClient.right;
-					if( rcPaint.bottom > rcClient.bottom ) rcPaint.bottom = rcClient.bottom;
-					::ZeroMemory(&m_rcLayeredUpdate, sizeof(m_rcLayeredUpdate));
+					m_PaintRegion.Add(m_LayeredUpdate);
+					m_LayeredUpdate.Empty();
 				}
+				m_PaintRegion.Clip(rcClient);
+				rcPaint = m_PaintRegion.GetBounds();
 
 				//
 				// Render screen
@@ -1184,15 +1658,17 @@ namespace DuiLib {
 				if( m_bOffscreenPaint ) {
 					HBITMAP hOldBitmap = (HBITMAP) ::SelectObject(m_hDcOffscreen, m_hbmpOffscreen);
 					int iSaveDC = ::SaveDC(m_hDcOffscreen);
-					if (m_bLayered) {
-						for( LONG y = rcClient.bottom - rcPaint.bottom; y < rcClient.bottom - rcPaint.top; ++y ) {
-							for( LONG x = rcPaint.left; x < rcPaint.right; ++x ) {
-								int i = (y * dwWidth + x) * 4;
-								*(DWORD*)(&m_pOffscreenBits[i]) = 0;
-							}
-						}
+					// 软件渲染时图元直接写入离屏位图，文字仍由GDI绘制
+					CSoftRenderTarget* pSoftTarget = m_bSoftwareRender ? new CSoftRenderTarget(m_hDcOffscreen) : NULL;
+					// 分层窗口的逐像素处理按客户区坐标进行，离屏位图是自下而上的DIB
+					CRasterizer offscreen;
+					if( m_bLayered && m_pOffscreenBits != NULL ) offscreen.Attach(m_pOffscreenBits + (dwHeight - 1) * dwWidth * 4, dwWidth, dwHeight, -(int)(dwWidth * 4));
+					for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+						const RECT& rcDirty = m_PaintRegion.GetAt(iRect);
+						if( m_bLayered ) offscreen.Clear(rcDirty);
+						// 软件渲染时较大的脏矩形分块并行绘制
+						if( pSoftTarget == NULL || !pSoftTarget->IsValid() || !PaintTiles(rcDirty) ) m_pRoot->Paint(m_hDcOffscreen, rcDirty, NULL);
 					}
-					m_pRoot->Paint(m_hDcOffscreen, rcPaint, NULL);
 
 					if( m_bLayered ) {
 						for( int i = 0; i < m_aNativeWindow.GetSize(); ) {
@@ -1214,13 +1690,11 @@ namespace DuiLib {
 							::ZeroMemory(pChildBitmapBits, (rcChildWnd.right - rcChildWnd.left)*(rcChildWnd.bottom - rcChildWnd.top)*4);
 							HBITMAP hOldChildBitmap = (HBITMAP) ::SelectObject(hChildMemDC, hChildBitmap);
 							::SendMessage(hChildWnd, WM_PRINT, (WPARAM)hChildMemDC,(LPARAM)(PRF_CHECKVISIBLE|PRF_CHILDREN|PRF_CLIENT|PRF_OWNED));
-							COLORREF* pChildBitmapBit;
-							for( LONG y = 0; y < rcChildWnd.bottom-rcChildWnd.top; y++ ) {
-								for( LONG x = 0; x < rcChildWnd.right-rcChildWnd.left; x++ ) {
-									pChildBitmapBit = pChildBitmapBits+y*(rcChildWnd.right-rcChildWnd.left) + x;
-									if (*pChildBitmapBit != 0x00000000) *pChildBitmapBit |= 0xff000000;
-								}
-							}
+							::GdiFlush();
+							CRasterizer child;
+							child.Attach((LPBYTE)pChildBitmapBits, rcChildWnd.right - rcChildWnd.left, rcChildWnd.bottom - rcChildWnd.top, (rcChildWnd.right - rcChildWnd.left) * 4);
+							RECT rcChild = { 0, 0, rcChildWnd.right - rcChildWnd.left, rcChildWnd.bottom - rcChildWnd.top };
+							child.ForceOpaque(rcChild);
 							::BitBlt(m_hDcOffscreen, rcChildWnd.left, rcChildWnd.top, rcChildWnd.right - rcChildWnd.left,
 								rcChildWnd.bottom - rcChildWnd.top, hChildMemDC, 0, 0, SRCCOPY);
 							::SelectObject(hChildMemDC, hOldChildBitmap);
@@ -1229,14 +1703,19 @@ namespace DuiLib {
 						}
 					}
 
-					for( int i = 0; i < m_aPostPaintControls.GetSize(); i++ ) {
-						CControlUI* pPostPaintControl = static_cast<CControlUI*>(m_aPostPaintControls[i]);
-						pPostPaintControl->DoPostPaint(m_hDcOffscreen, rcPaint);
+					for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+						for( int i = 0; i < m_aPostPaintControls.GetSize(); i++ ) {
+							CControlUI* pPostPaintControl = static_cast<CControlUI*>(m_aPostPaintControls[i]);
+							pPostPaintControl->DoPostPaint(m_hDcOffscreen, m_PaintRegion.GetAt(iRect));
+						}
 					}
 
+					if( pSoftTarget != NULL ) delete pSoftTarget;
 					::RestoreDC(m_hDcOffscreen, iSaveDC);
 
 					if( m_bLayered ) {
+						// 之后直接读写位图内存，先让GDI完成批量提交的绘制
+						::GdiFlush();
 						RECT rcWnd = { 0 };
 						::GetWindowRect(m_hWndPaint, &rcWnd);
 						if(!m_diLayered.sDrawString.IsEmpty()) {
@@ -1248,12 +1727,6 @@ namespace DuiLib {
 							rcLayeredClient.right -= m_rcLayeredInset.right;
 							rcLayeredClient.bottom -= m_rcLayeredInset.bottom;
 
-							COLORREF* pOffscreenBits = (COLORREF*)m_pOffscreenBits;
-							COLORREF* pBackgroundBits = m_pBackgroundBits;
-							BYTE A = 0;
-							BYTE R = 0;
-							BYTE G = 0;
-							BYTE B = 0;
 							if (!m_diLayered.sDrawString.IsEmpty()) {
 								if( m_hbmpBackground == NULL) {
 									m_hDcBackground = ::CreateCompatibleDC(m_hDcPaint);
@@ -1270,26 +1743,17 @@ namespace DuiLib {
 									CRenderClip::GenerateClip(m_hDcBackground, rcLayeredClient, clip);
 									CRenderEngine::DrawImageInfo(m_hDcBackground, this, rcLayeredClient, rcLayeredClient, &m_diLayered);
 								}
-								for( LONG y = rcClient.bottom - rcPaint.bottom; y < rcClient.bottom - rcPaint.top; ++y ) {
-									for( LONG x = rcPaint.left; x < rcPaint.right; ++x ) {
-										pOffscreenBits = (COLORREF*)(m_pOffscreenBits + y * dwWidth + x);
-										pBackgroundBits = m_pBackgroundBits + y * dwWidth + x;
-										A = (BYTE)((*pBackgroundBits) >> 24);
-										R = (BYTE)((*pOffscreenBits) >> 16) * A / 255;
-										G = (BYTE)((*pOffscreenBits) >> 8) * A / 255;
-										B = (BYTE)(*pOffscreenBits) * A / 255;
-										*pOffscreenBits = RGB(B, G, R) + ((DWORD)A << 24);
-									}
+								::GdiFlush();
+								// 背景图的alpha作为遮罩
+								const BYTE* pMask = (const BYTE*)(m_pBackgroundBits + (dwHeight - 1) * dwWidth);
+								for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+									offscreen.MultiplyAlpha(m_PaintRegion.GetAt(iRect), pMask, -(int)(dwWidth * 4));
 								}
 							}
 						}
 						else {
-							for( LONG y = rcClient.bottom - rcPaint.bottom; y < rcClient.bottom - rcPaint.top; ++y ) {
-								for( LONG x = rcPaint.left; x < rcPaint.right; ++x ) {
-									int i = (y * dwWidth + x) * 4;
-									if((m_pOffscreenBits[i + 3] == 0)&& (m_pOffscreenBits[i + 0] != 0 || m_pOffscreenBits[i + 1] != 0|| m_pOffscreenBits[i + 2] != 0))
-										m_pOffscreenBits[i + 3] = 255;
-								}
+							for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+								offscreen.RepairAlpha(m_PaintRegion.GetAt(iRect));
 							}
 						}
 
@@ -1300,24 +1764,33 @@ namespace DuiLib {
 						g_fUpdateLayeredWindow(m_hWndPaint, m_hDcPaint, &ptPos, &sizeWnd, m_hDcOffscreen, &ptSrc, 0, &bf, ULW_ALPHA);
 					}
 					else {
-						::BitBlt(m_hDcPaint, rcPaint.left, rcPaint.top, rcPaint.right - rcPaint.left, rcPaint.bottom - rcPaint.top, m_hDcOffscreen, rcPaint.left, rcPaint.top, SRCCOPY);
+						for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+							const RECT& rcDirty = m_PaintRegion.GetAt(iRect);
+							::BitBlt(m_hDcPaint, rcDirty.left, rcDirty.top, rcDirty.right - rcDirty.left, rcDirty.bottom - rcDirty.top, m_hDcOffscreen, rcDirty.left, rcDirty.top, SRCCOPY);
+						}
 					}
 					::SelectObject(m_hDcOffscreen, hOldBitmap);
 
 					if( m_bShowUpdateRect && !m_bLayered ) {
 						HPEN hOldPen = (HPEN)::SelectObject(m_hDcPaint, m_hUpdateRectPen);
 						::SelectObject(m_hDcPaint, ::GetStockObject(HOLLOW_BRUSH));
-						::Rectangle(m_hDcPaint, rcPaint.left, rcPaint.top, rcPaint.right, rcPaint.bottom);
+						for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+							const RECT& rcDirty = m_PaintRegion.GetAt(iRect);
+							::Rectangle(m_hDcPaint, rcDirty.left, rcDirty.top, rcDirty.right, rcDirty.bottom);
+						}
 						::SelectObject(m_hDcPaint, hOldPen);
 					}
 				}
 				else {
 					// A standard paint job
 					int iSaveDC = ::SaveDC(m_hDcPaint);
-					m_pRoot->Paint(m_hDcPaint, rcPaint, NULL);
-					for( int i = 0; i < m_aPostPaintControls.GetSize(); i++ ) {
-						CControlUI* pPostPaintControl = static_cast<CControlUI*>(m_aPostPaintControls[i]);
-						pPostPaintControl->DoPostPaint(m_hDcPaint, rcPaint);
+					for( int iRect = 0; iRect < m_PaintRegion.GetCount(); iRect++ ) {
+						const RECT& rcDirty = m_PaintRegion.GetAt(iRect);
+						m_pRoot->Paint(m_hDcPaint, rcDirty, NULL);
+						for( int i = 0; i < m_aPostPaintControls.GetSize(); i++ ) {
+							CControlUI* pPostPaintControl = static_cast<CControlUI*>(m_aPostPaintControls[i]);
+							pPostPaintControl->DoPostPaint(m_hDcPaint, rcDirty);
+						}
 					}
 					::RestoreDC(m_hDcPaint, iSaveDC);
 				}
@@ -1952,7 +2425,10 @@ namespace DuiLib {
 	{
 		RECT rcClient = { 0 };
 		::GetClientRect(m_hWndPaint, &rcClient);
-		::UnionRect(&m_rcLayeredUpdate, &m_rcLayeredUpdate, &rcClient);
+		m_LayeredUpdate.Add(rcClient);
+		for( int i = 0; i < m_aLayerCacheControls.GetSize(); i++ ) {
+			static_cast<CContainerUI*>(m_aLayerCacheControls[i])->InvalidateLayer(rcClient);
+		}
 		::InvalidateRect(m_hWndPaint, NULL, FALSE);
 	}
 
@@ -1962,10 +2438,18 @@ namespace DuiLib {
 		if( rcItem .top < 0 ) rcItem.top = 0;
 		if( rcItem.right < rcItem.left ) rcItem.right = rcItem.left;
 		if( rcItem.bottom < rcItem.top ) rcItem.bottom = rcItem.top;
-		::UnionRect(&m_rcLayeredUpdate, &m_rcLayeredUpdate, &rcItem);
+		m_LayeredUpdate.Add(rcItem);
+		for( int i = 0; i < m_aLayerCacheControls.GetSize(); i++ ) {
+			static_cast<CContainerUI*>(m_aLayerCacheControls[i])->InvalidateLayer(rcItem);
+		}
 		::InvalidateRect(m_hWndPaint, &rcItem, FALSE);
 	}
 
+	const CDirtyRegion& CPaintManagerUI::GetPaintRegion() const
+	{
+		return m_PaintRegion;
+	}
+
 	bool CPaintManagerUI::IsValid()
 	{
 		return m_hWndPaint != NULL && m_pRoot != NULL;
@@ -1988,6 +2472,7 @@ namespace DuiLib {
 		// pull the internal memory of the calling code. We'll delay the cleanup.
 		if( m_pRoot != NULL ) {
 			m_aPostPaintControls.Empty();
+			m_aLayerCacheControls.Empty();
 			AddDelayedCleanup(m_pRoot);
 		}
 		// Set the dialog root element
@@ -2111,17 +2596,20 @@ namespace DuiLib {
 
 		// 清理共享资源
 		// 图片
+		CancelAllPendingImages(m_SharedResInfo);
+		CImageDecodeJob::WaitAll();
 		TImageInfo* data;
 		for( int i = 0; i< m_SharedResInfo.m_ImageHash.GetSize(); i++ ) {
 			if(LPCTSTR key = m_SharedResInfo.m_ImageHash.GetAt(i)) {
 				data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(key, false));
 				if (data) {
-					CRenderEngine::FreeImage(data);
+					FreeImageInfo(data);
 					data = NULL;
 				}
 			}
 		}
 		m_SharedResInfo.m_ImageHash.RemoveAll();
+		RemoveAllImageSizes();
 		// 字体
 		TFontInfo* pFontInfo;
 		for( int i = 0; i< m_SharedResInfo.m_CustomFonts.GetSize(); i++ ) {
@@ -2140,10 +2628,10 @@ namespace DuiLib {
 			::DeleteObject(m_SharedResInfo.m_DefaultFontInfo.hFont);
 		}
 		// 样式
-		CDuiString* pStyle;
+		CAttributeList* pStyle;
 		for( int i = 0; i< m_SharedResInfo.m_StyleHash.GetSize(); i++ ) {
 			if(LPCTSTR key = m_SharedResInfo.m_StyleHash.GetAt(i)) {
-				pStyle = static_cast<CDuiString*>(m_SharedResInfo.m_StyleHash.Find(key, false));
+				pStyle = static_cast<CAttributeList*>(m_SharedResInfo.m_StyleHash.Find(key, false));
 				if (pStyle) {
 					delete pStyle;
 					pStyle = NULL;
@@ -2153,10 +2641,10 @@ namespace DuiLib {
 		m_SharedResInfo.m_StyleHash.RemoveAll();
 
 		// 样式
-		CDuiString* pAttr;
+		CAttributeList* pAttr;
 		for( int i = 0; i< m_SharedResInfo.m_AttrHash.GetSize(); i++ ) {
 			if(LPCTSTR key = m_SharedResInfo.m_AttrHash.GetAt(i)) {
-				pAttr = static_cast<CDuiString*>(m_SharedResInfo.m_AttrHash.Find(key, false));
+				pAttr = static_cast<CAttributeList*>(m_SharedResInfo.m_AttrHash.Find(key, false));
 				if (pAttr) {
 					delete pAttr;
 					pAttr = NULL;
@@ -2537,6 +3025,19 @@ namespace DuiLib {
 		return false;
 	}
 
+	bool CPaintManagerUI::AddLayerCache(CContainerUI* pContainer)
+	{
+		if( m_aLayerCacheControls.Find(pContainer) >= 0 ) return false;
+		return m_aLayerCacheControls.Add(pContainer);
+	}
+
+	bool CPaintManagerUI::RemoveLayerCache(CContainerUI* pContainer)
+	{
+		int iIndex = m_aLayerCacheControls.Find(pContainer);
+		if( iIndex < 0 ) return false;
+		return m_aLayerCacheControls.Remove(iIndex);
+	}
+
 	bool CPaintManagerUI::SetPostPaintIndex(CControlUI* pControl, int iIndex)
 	{
 		RemovePostPaint(pControl);
@@ -2766,6 +3267,7 @@ namespace DuiLib {
 
 	TFontInfo* CPaintManagerUI::GetDefaultFontInfo()
 	{
+		CPaintResourceLock lock(this);
 		if (m_ResInfo.m_DefaultFontInfo.sFontName.IsEmpty())
 		{
 			if( m_SharedResInfo.m_DefaultFontInfo.tm.tmHeight == 0 ) 
@@ -2853,6 +3355,7 @@ namespace DuiLib {
 
 	HFONT CPaintManagerUI::AddFont(int id, LPCTSTR pStrFontName, int nSize, bool bBold, bool bUnderline, bool bItalic, bool bStrikeout, bool bShared)
 	{
+		CPaintResourceLock lock(this);
 		LOGFONT lf = { 0 };
 		::GetObject(::GetStockObject(DEFAULT_GUI_FONT), sizeof(LOGFONT), &lf);
 		if(lstrlen(pStrFontName) > 0) {
@@ -3011,6 +3514,7 @@ namespace DuiLib {
 	}
 	HFONT CPaintManagerUI::GetFont(int id)
 	{
+		CPaintResourceLock lock(this);
 		if (id < 0) return GetDefaultFontInfo()->hFont;
 
 		TCHAR idBuffer[16];
@@ -3024,6 +3528,7 @@ namespace DuiLib {
 
 	HFONT CPaintManagerUI::GetFont(LPCTSTR pStrFontName, int nSize, bool bBold, bool bUnderline, bool bItalic, bool bStrikeout)
 	{
+		CPaintResourceLock lock(this);
 		TFontInfo* pFontInfo = NULL;
 		for( int i = 0; i< m_ResInfo.m_CustomFonts.GetSize(); i++ ) {
 			if(LPCTSTR key = m_ResInfo.m_CustomFonts.GetAt(i)) {
@@ -3204,6 +3709,7 @@ namespace DuiLib {
 
 	TFontInfo* CPaintManagerUI::GetFontInfo(int id)
 	{
+		CPaintResourceLock lock(this);
 		if (id < 0) return GetDefaultFontInfo();
 
 		TCHAR idBuffer[16];
@@ -3223,6 +3729,7 @@ namespace DuiLib {
 
 	TFontInfo* CPaintManagerUI::GetFontInfo(HFONT hFont)
 	{
+		CPaintResourceLock lock(this);
 		TFontInfo* pFontInfo = NULL;
 		for( int i = 0; i< m_ResInfo.m_CustomFonts.GetSize(); i++ ) 
 		{
@@ -3254,13 +3761,17 @@ namespace DuiLib {
 
 	const TImageInfo* CPaintManagerUI::GetImage(LPCTSTR bitmap)
 	{
-		TImageInfo* data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(bitmap));
-		if( !data ) data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(bitmap));
+		CPaintResourceLock lock(this);
+		const TImageInfo* data = FindImage(m_ResInfo, bitmap);
+		if( !data && m_ResInfo.m_PendingImageHash.GetSize() > 0 ) data = FinishPendingImage(m_ResInfo, bitmap);
+		if( !data ) data = FindImage(m_SharedResInfo, bitmap);
+		if( !data && m_SharedResInfo.m_PendingImageHash.GetSize() > 0 ) data = FinishPendingImage(m_SharedResInfo, bitmap);
 		return data;
 	}
 
 	const TImageInfo* CPaintManagerUI::GetImageEx(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bGdiplus, HINSTANCE instance)
 	{
+		CPaintResourceLock lock(this);
 		const TImageInfo* data = GetImage(bitmap);
 		if( !data ) {
 			if( AddImage(bitmap, type, mask, bUseHSL, bGdiplus, false, instance) ) {
@@ -3272,10 +3783,91 @@ namespace DuiLib {
 		return data;
 	}
 
+	SIZE CPaintManagerUI::GetImageSize(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bGdiplus, HINSTANCE instance)
+	{
+		CPaintResourceLock lock(this);
+		SIZE szImage = { 0 };
+		if( bitmap == NULL || bitmap[0] == _T('\0') ) return szImage;
+		if( type != NULL && type[0] == _T('\0') ) type = NULL;
+
+		// 已加载的图片直接取尺寸，被缓存淘汰的图片也保留了尺寸
+		const TImageInfo* data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(bitmap));
+		if( data == NULL ) data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(bitmap));
+		if( data == NULL || data->nX <= 0 || data->nY <= 0 ) {
+			CDuiString sKey = type;
+			sKey += _T('|');
+			sKey += bitmap;
+			SIZE* pSize = static_cast<SIZE*>(m_ImageSizeHash.Find(sKey));
+			if( pSize == NULL ) {
+				pSize = new SIZE;
+				pSize->cx = pSize->cy = 0;
+				int x = 0, y = 0;
+				bool bAlpha = false;
+				if( type != NULL ) {
+					if( isdigit(*bitmap) && CRenderEngine::ProbeImage(_ttoi(bitmap), type, instance, x, y, bAlpha) ) {
+						pSize->cx = x;
+						pSize->cy = y;
+					}
+				}
+				else if( CRenderEngine::ProbeImage(bitmap, NULL, instance, x, y, bAlpha) ) {
+					int nScale = CRenderEngine::GetImageScale(bitmap);
+					pSize->cx = MulDiv(x, 100, nScale);
+					pSize->cy = MulDiv(y, 100, nScale);
+				}
+				else {
+					// 与LoadImageSource相同，DPI图片变体不存在时使用原图
+					CDuiString sImageName = bitmap;
+					int iAtIdx = sImageName.ReverseFind(_T('@'));
+					int iDotIdx = sImageName.ReverseFind(_T('.'));
+					if( iAtIdx != -1 && iDotIdx != -1 ) {
+						sImageName = sImageName.Left(iAtIdx) + sImageName.Mid(iDotIdx);
+						if( CRenderEngine::ProbeImage(sImageName.GetData(), NULL, instance, x, y, bAlpha) ) {
+							pSize->cx = x;
+							pSize->cy = y;
+						}
+					}
+				}
+				m_ImageSizeHash.Insert(sKey, pSize);
+			}
+			if( pSize->cx > 0 && pSize->cy > 0 ) return *pSize;
+
+			data = GetImageEx(bitmap, type, mask, bUseHSL, bGdiplus, instance);
+			if( data == NULL || data->nX <= 0 || data->nY <= 0 ) return szImage;
+		}
+		szImage.cx = MulDiv(data->nX, 100, data->nScale);
+		szImage.cy = MulDiv(data->nY, 100, data->nScale);
+		return szImage;
+	}
+
+	void CPaintManagerUI::RemoveAllImageSizes()
+	{
+		SIZE* pSize;
+		for( int i = 0; i< m_ImageSizeHash.GetSize(); i++ ) {
+			if(LPCTSTR key = m_ImageSizeHash.GetAt(i)) {
+				pSize = static_cast<SIZE*>(m_ImageSizeHash.Find(key, false));
+				if (pSize) {
+					delete pSize;
+				}
+			}
+		}
+		m_ImageSizeHash.RemoveAll();
+	}
+
 	const TImageInfo* CPaintManagerUI::AddImage(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bGdiplus, bool bShared, HINSTANCE instance)
 	{
 		if( bitmap == NULL || bitmap[0] == _T('\0') ) return NULL;
 
+		TImageInfo* data = LoadImageSource(bitmap, type, mask, bGdiplus, instance);
+		if( data == NULL ) {
+			return NULL;
+		}
+		// 指定资源模块或GDI+加载的图片无法按缓存记录的信息重新加载，不参与淘汰
+		data->bEvictable = !bGdiplus && instance == NULL;
+		return InsertImage((bShared || m_bForceUseSharedRes) ? m_SharedResInfo : m_ResInfo, bitmap, data, type, mask, bUseHSL);
+	}
+
+	TImageInfo* CPaintManagerUI::LoadImageSource(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bGdiplus, HINSTANCE instance)
+	{
 		TImageInfo* data = NULL;
 		if( type != NULL && lstrlen(type) > 0) {
 			if( isdigit(*bitmap) ) {
@@ -3287,7 +3879,8 @@ namespace DuiLib {
 		}
 		else {
 			data = bGdiplus ? CRenderEngine::GdiplusLoadImage(bitmap, NULL, mask, instance) : CRenderEngine::LoadImage(bitmap, NULL, mask, instance);
-			if(!data) {
+			if( data ) data = CRenderEngine::ApplyImageScale(data, CRenderEngine::GetImageScale(bitmap), false);
+			else {
 				CDuiString sImageName = bitmap;
 				int iAtIdx = sImageName.ReverseFind(_T('@'));
 				int iDotIdx = sImageName.ReverseFind(_T('.'));
@@ -3295,14 +3888,18 @@ namespace DuiLib {
 					CDuiString sExe = sImageName.Mid(iDotIdx);
 					sImageName = sImageName.Left(iAtIdx) + sExe;
 					data = bGdiplus ? CRenderEngine::GdiplusLoadImage(sImageName.GetData(), NULL, mask, instance) : CRenderEngine::LoadImage(sImageName.GetData(), NULL, mask, instance);
+					// 没有对应DPI的图片时把原图高质量缩放一次，之后绘制不再拉伸
+					data = CRenderEngine::ApplyImageScale(data, CRenderEngine::GetImageScale(bitmap), true);
 				}
 			}
 
 		}
 
-		if( data == NULL ) {
-			return NULL;
-		}
+		return data;
+	}
+
+	const TImageInfo* CPaintManagerUI::InsertImage(TResInfo& resInfo, LPCTSTR bitmap, TImageInfo* data, LPCTSTR type, DWORD mask, bool bUseHSL)
+	{
 		data->bUseHSL = bUseHSL;
 		if( type != NULL ) data->sResType = type;
 		data->dwMask = mask;
@@ -3312,35 +3909,29 @@ namespace DuiLib {
 		}
 		else data->pSrcBits = NULL;
 		if( m_bUseHSL ) CRenderEngine::AdjustImage(true, data, m_H, m_S, m_L);
+		data->dwHSLVersion = m_dwHSLVersion;
+		data->dwLastUse = m_dwImageClock;
+		// 图集释放的区域不能复用，图集中的图片不参与缓存淘汰
+		if( m_bImageAtlas && CImageAtlas::Pack(data) ) data->bEvictable = false;
 		if (data)
 		{
-			if (bShared || m_bForceUseSharedRes)
+			// 同名图片以最后一次加载为准，丢弃还在后台解码的旧请求
+			CancelPendingImage(resInfo, bitmap);
+			TImageInfo* pOldImageInfo = static_cast<TImageInfo*>(resInfo.m_ImageHash.Find(bitmap));
+			if (pOldImageInfo)
 			{
-				TImageInfo* pOldImageInfo = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(bitmap));
-				if (pOldImageInfo)
-				{
-					CRenderEngine::FreeImage(pOldImageInfo);
-					m_SharedResInfo.m_ImageHash.Remove(bitmap);
-				}
-
-				if( !m_SharedResInfo.m_ImageHash.Insert(bitmap, data) ) {
-					CRenderEngine::FreeImage(data);
-					data = NULL;
-				}
+				FreeImageInfo(pOldImageInfo);
+				resInfo.m_ImageHash.Remove(bitmap);
 			}
-			else
-			{
-				TImageInfo* pOldImageInfo = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(bitmap));
-				if (pOldImageInfo)
-				{
-					CRenderEngine::FreeImage(pOldImageInfo);
-					m_ResInfo.m_ImageHash.Remove(bitmap);
-				}
 
-				if( !m_ResInfo.m_ImageHash.Insert(bitmap, data) ) {
-					CRenderEngine::FreeImage(data);
-					data = NULL;
-				}
+			if( !resInfo.m_ImageHash.Insert(bitmap, data) ) {
+				CRenderEngine::FreeImage(data);
+				data = NULL;
+			}
+			else {
+				m_ImageCacheStats.nResidentBytes += GetImageBytes(data);
+				m_ImageCacheStats.dwMisses++;
+				TrimImageCache();
 			}
 		}
 
@@ -3379,28 +3970,229 @@ namespace DuiLib {
 				data = NULL;
 			}
 		}
+		if( data ) m_ImageCacheStats.nResidentBytes += GetImageBytes(data);
 
 		return data;
 	}
 
+	bool CPaintManagerUI::PreloadImage(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bShared, HINSTANCE instance)
+	{
+		if( bitmap == NULL || bitmap[0] == _T('\0') ) return false;
+
+		TResInfo& resInfo = (bShared || m_bForceUseSharedRes) ? m_SharedResInfo : m_ResInfo;
+		CImageDecodeJob* pJob = CImageDecodeJob::Submit(bitmap, type, mask, instance);
+		if( pJob == NULL ) return AddImage(bitmap, type, mask, bUseHSL, false, bShared, instance) != NULL;
+
+		// 与AddImage一致，重复声明的图片替换旧图片
+		CancelPendingImage(resInfo, bitmap);
+		TImageInfo* pOldImageInfo = static_cast<TImageInfo*>(resInfo.m_ImageHash.Find(bitmap));
+		if( pOldImageInfo ) {
+			FreeImageInfo(pOldImageInfo);
+			resInfo.m_ImageHash.Remove(bitmap);
+		}
+
+		InsertPendingImage(resInfo, bitmap, pJob, type, mask, bUseHSL, instance);
+		return true;
+	}
+
+	const TImageInfo* CPaintManagerUI::GetImageAsync(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bGdiplus, const RECT& rcInvalidate, HINSTANCE instance)
+	{
+		CPaintResourceLock lock(this);
+		if( !m_bAsyncImageLoad || bGdiplus || m_hWndPaint == NULL ) return GetImageEx(bitmap, type, mask, bUseHSL, bGdiplus, instance);
+
+		const TImageInfo* data = FindImage(m_ResInfo, bitmap);
+		if( data ) return data;
+		TResInfo* pResInfo = &m_ResInfo;
+		PENDINGIMAGE* pPending = static_cast<PENDINGIMAGE*>(m_ResInfo.m_PendingImageHash.Find(bitmap));
+		if( pPending == NULL ) {
+			data = FindImage(m_SharedResInfo, bitmap);
+			if( data ) return data;
+			pResInfo = &m_SharedResInfo;
+			pPending = static_cast<PENDINGIMAGE*>(m_SharedResInfo.m_PendingImageHash.Find(bitmap));
+		}
+
+		CImageDecodeJob* pJob = NULL;
+		if( pPending != NULL ) {
+			if( pPending->pJob->IsDone() ) return FinishPendingImage(*pResInfo, bitmap);
+			pJob = pPending->pJob;
+		}
+		else {
+			pJob = CImageDecodeJob::Submit(bitmap, type, mask, instance);
+			if( pJob == NULL ) return GetImageEx(bitmap, type, mask, bUseHSL, bGdiplus, instance);
+			InsertPendingImage(m_bForceUseSharedRes ? m_SharedResInfo : m_ResInfo, bitmap, pJob, type, mask, bUseHSL, instance);
+		}
+
+		// 多个控件等待同一图片时只解码一次，各自登记需要刷新的区域
+		CStdValArray* pRects = static_cast<CStdValArray*>(m_mImageWaiters.Find(bitmap));
+		if( pRects == NULL ) {
+			pRects = new CStdValArray(sizeof(RECT));
+			m_mImageWaiters.Insert(bitmap, pRects);
+		}
+		bool bFound = false;
+		for( int i = 0; i < pRects->GetSize(); i++ ) {
+			if( ::EqualRect(static_cast<LPRECT>(pRects->GetAt(i)), &rcInvalidate) ) {
+				bFound = true;
+				break;
+			}
+		}
+		if( !bFound ) pRects->Add(&rcInvalidate);
+		pJob->SetNotify(m_hWndPaint, WM_APP + 2);
+		return NULL;
+	}
+
+	const TImageInfo* CPaintManagerUI::GetImagePlaceholderInfo()
+	{
+		if( m_sImagePlaceholder.IsEmpty() ) return NULL;
+		return GetImageEx(m_sImagePlaceholder);
+	}
+
+	void CPaintManagerUI::InsertPendingImage(TResInfo& resInfo, LPCTSTR bitmap, CImageDecodeJob* pJob, LPCTSTR type, DWORD mask, bool bUseHSL, HINSTANCE instance)
+	{
+		PENDINGIMAGE* pPending = new PENDINGIMAGE;
+		pPending->pJob = pJob;
+		if( type != NULL ) pPending->sResType = type;
+		pPending->dwMask = mask;
+		pPending->bUseHSL = bUseHSL;
+		pPending->bEvictable = instance == NULL;
+		resInfo.m_PendingImageHash.Insert(bitmap, pPending);
+	}
+
+	void CPaintManagerUI::FinishReadyImages(TResInfo& resInfo)
+	{
+		CStdPtrArray aReady;
+		for( int i = 0; i< resInfo.m_PendingImageHash.GetSize(); i++ ) {
+			if(LPCTSTR key = resInfo.m_PendingImageHash.GetAt(i)) {
+				PENDINGIMAGE* pPending = static_cast<PENDINGIMAGE*>(resInfo.m_PendingImageHash.Find(key, false));
+				if( pPending && pPending->pJob->IsDone() ) aReady.Add(new CDuiString(key));
+			}
+		}
+
+		for( int i = 0; i < aReady.GetSize(); i++ ) {
+			CDuiString* pBitmap = static_cast<CDuiString*>(aReady[i]);
+			FinishPendingImage(resInfo, *pBitmap);
+			delete pBitmap;
+		}
+	}
+
+	void CPaintManagerUI::InvalidateImageWaiters(LPCTSTR bitmap, bool bInvalidate)
+	{
+		CStdValArray* pRects = static_cast<CStdValArray*>(m_mImageWaiters.Find(bitmap));
+		if( pRects == NULL ) return;
+		m_mImageWaiters.Remove(bitmap);
+		if( bInvalidate ) {
+			for( int i = 0; i < pRects->GetSize(); i++ ) {
+				RECT rcItem = *static_cast<LPRECT>(pRects->GetAt(i));
+				Invalidate(rcItem);
+			}
+		}
+		delete pRects;
+	}
+
+	void CPaintManagerUI::RemoveAllImageWaiters()
+	{
+		for( int i = 0; i< m_mImageWaiters.GetSize(); i++ ) {
+			if(LPCTSTR key = m_mImageWaiters.GetAt(i)) {
+				delete static_cast<CStdValArray*>(m_mImageWaiters.Find(key, false));
+			}
+		}
+		m_mImageWaiters.RemoveAll();
+	}
+
+	bool CPaintManagerUI::IsAsyncImageLoad() const
+	{
+		return m_bAsyncImageLoad;
+	}
+
+	void CPaintManagerUI::SetAsyncImageLoad(bool bAsync)
+	{
+		m_bAsyncImageLoad = bAsync;
+	}
+
+	LPCTSTR CPaintManagerUI::GetImagePlaceholder() const
+	{
+		return m_sImagePlaceholder;
+	}
+
+	void CPaintManagerUI::SetImagePlaceholder(LPCTSTR pStrImage)
+	{
+		m_sImagePlaceholder = pStrImage;
+	}
+
+	const TImageInfo* CPaintManagerUI::FinishPendingImage(TResInfo& resInfo, LPCTSTR bitmap)
+	{
+		PENDINGIMAGE* pPending = static_cast<PENDINGIMAGE*>(resInfo.m_PendingImageHash.Find(bitmap));
+		if( pPending == NULL ) return NULL;
+		resInfo.m_PendingImageHash.Remove(bitmap);
+
+		const TImageInfo* data = NULL;
+		TImageInfo* pNewData = pPending->pJob->Finish();
+		if( pNewData ) {
+			pNewData->bEvictable = pPending->bEvictable;
+			data = InsertImage(resInfo, bitmap, pNewData, pPending->sResType.IsEmpty() ? NULL : pPending->sResType.GetData(), pPending->dwMask, pPending->bUseHSL);
+		}
+		pPending->pJob->Release();
+		delete pPending;
+
+		// 刷新异步加载时等待该图片的区域，共享图片可能被多个窗口等待
+		for( int i = 0; i < m_aPreMessages.GetSize(); i++ ) {
+			static_cast<CPaintManagerUI*>(m_aPreMessages[i])->InvalidateImageWaiters(bitmap, data != NULL);
+		}
+		return data;
+	}
+
+	void CPaintManagerUI::FinishAllPendingImages(TResInfo& resInfo)
+	{
+		while( resInfo.m_PendingImageHash.GetSize() > 0 ) {
+			CDuiString sBitmap = resInfo.m_PendingImageHash.GetAt(0);
+			FinishPendingImage(resInfo, sBitmap);
+		}
+	}
+
+	void CPaintManagerUI::CancelPendingImage(TResInfo& resInfo, LPCTSTR bitmap)
+	{
+		PENDINGIMAGE* pPending = static_cast<PENDINGIMAGE*>(resInfo.m_PendingImageHash.Find(bitmap));
+		if( pPending == NULL ) return;
+		resInfo.m_PendingImageHash.Remove(bitmap);
+		// 工作线程持有自己的引用，不必等待解码结束
+		pPending->pJob->Release();
+		delete pPending;
+	}
+
+	void CPaintManagerUI::CancelAllPendingImages(TResInfo& resInfo)
+	{
+		PENDINGIMAGE* pPending;
+		for( int i = 0; i< resInfo.m_PendingImageHash.GetSize(); i++ ) {
+			if(LPCTSTR key = resInfo.m_PendingImageHash.GetAt(i)) {
+				pPending = static_cast<PENDINGIMAGE*>(resInfo.m_PendingImageHash.Find(key, false));
+				if (pPending) {
+					pPending->pJob->Release();
+					delete pPending;
+				}
+			}
+		}
+		resInfo.m_PendingImageHash.RemoveAll();
+	}
+
 	void CPaintManagerUI::RemoveImage(LPCTSTR bitmap, bool bShared)
 	{
 		TImageInfo* data = NULL;
 		if (bShared) 
 		{
+			CancelPendingImage(m_SharedResInfo, bitmap);
 			data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(bitmap));
 			if (data)
 			{
-				CRenderEngine::FreeImage(data) ;
+				FreeImageInfo(data);
 				m_SharedResInfo.m_ImageHash.Remove(bitmap);
 			}
 		}
 		else
 		{
+			CancelPendingImage(m_ResInfo, bitmap);
 			data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(bitmap));
 			if (data)
 			{
-				CRenderEngine::FreeImage(data) ;
+				FreeImageInfo(data);
 				m_ResInfo.m_ImageHash.Remove(bitmap);
 			}
 		}
@@ -3410,12 +4202,13 @@ namespace DuiLib {
 	{
 		if (bShared)
 		{
+			CancelAllPendingImages(m_SharedResInfo);
 			TImageInfo* data;
 			for( int i = 0; i< m_SharedResInfo.m_ImageHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_SharedResInfo.m_ImageHash.GetAt(i)) {
 					data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(key, false));
 					if (data) {
-						CRenderEngine::FreeImage(data);
+						FreeImageInfo(data);
 					}
 				}
 			}
@@ -3423,12 +4216,13 @@ namespace DuiLib {
 		}
 		else
 		{
+			CancelAllPendingImages(m_ResInfo);
 			TImageInfo* data;
 			for( int i = 0; i< m_ResInfo.m_ImageHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_ResInfo.m_ImageHash.GetAt(i)) {
 					data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(key, false));
 					if (data) {
-						CRenderEngine::FreeImage(data);
+						FreeImageInfo(data);
 					}
 				}
 			}
@@ -3436,31 +4230,106 @@ namespace DuiLib {
 		}
 	}
 
-	void CPaintManagerUI::AdjustSharedImagesHSL()
+	TImageInfo* CPaintManagerUI::FindImage(TResInfo& resInfo, LPCTSTR bitmap)
 	{
-		TImageInfo* data;
-		for( int i = 0; i< m_SharedResInfo.m_ImageHash.GetSize(); i++ ) {
-			if(LPCTSTR key = m_SharedResInfo.m_ImageHash.GetAt(i)) {
-				data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(key));
-				if( data && data->bUseHSL ) {
-					CRenderEngine::AdjustImage(m_bUseHSL, data, m_H, m_S, m_L);
-				}
-			}
+		TImageInfo* data = static_cast<TImageInfo*>(resInfo.m_ImageHash.Find(bitmap));
+		if( data == NULL ) return NULL;
+		data->dwLastUse = m_dwImageClock;
+		// 位图已被缓存淘汰，按原来的参数重新加载
+		if( data->hBitmap == NULL && data->pImage == NULL ) {
+			if( !data->bEvictable || !ReloadEvictedImage(bitmap, data) ) return NULL;
+			TrimImageCache();
+			return data;
+		}
+		m_ImageCacheStats.dwHits++;
+		// SetHSL只更新版本号，图片在被取用时才重新调色，看不到的图片不必处理
+		if( data->bUseHSL && data->dwHSLVersion != m_dwHSLVersion ) {
+			CRenderEngine::AdjustImage(m_bUseHSL, data, m_H, m_S, m_L);
+			data->dwHSLVersion = m_dwHSLVersion;
 		}
+		return data;
+	}
+
+	bool CPaintManagerUI::ReloadEvictedImage(LPCTSTR bitmap, TImageInfo* data)
+	{
+		TImageInfo* pNewData = LoadImageSource(bitmap, data->sResType.IsEmpty() ? NULL : data->sResType.GetData(), data->dwMask, false, NULL);
+		if( pNewData == NULL ) return false;
+
+		data->hBitmap = pNewData->hBitmap;
+		data->pBits = pNewData->pBits;
+		data->nX = pNewData->nX;
+		data->nY = pNewData->nY;
+		data->bAlpha = pNewData->bAlpha;
+		data->nScale = pNewData->nScale;
+		if( data->bUseHSL ) {
+			data->pSrcBits = new BYTE[data->nX * data->nY * 4];
+			::CopyMemory(data->pSrcBits, data->pBits, data->nX * data->nY * 4);
+		}
+		else data->pSrcBits = NULL;
+		if( m_bUseHSL ) CRenderEngine::AdjustImage(true, data, m_H, m_S, m_L);
+		data->dwHSLVersion = m_dwHSLVersion;
+		delete pNewData;
+
+		m_ImageCacheStats.nResidentBytes += GetImageBytes(data);
+		m_ImageCacheStats.dwMisses++;
+		return true;
+	}
+
+	SIZE_T CPaintManagerUI::GetImageBytes(const TImageInfo* data)
+	{
+		SIZE_T nPixelBytes = (SIZE_T)data->nX * data->nY * 4;
+		SIZE_T nBytes = 0;
+		if( data->hBitmap != NULL ) nBytes += nPixelBytes;
+		if( data->pImage != NULL ) nBytes += nPixelBytes;
+		if( data->pSrcBits != NULL ) nBytes += nPixelBytes;
+		return nBytes;
+	}
+
+	void CPaintManagerUI::FreeImageInfo(TImageInfo* data, bool bDelete)
+	{
+		m_ImageCacheStats.nResidentBytes -= GetImageBytes(data);
+		CRenderEngine::FreeImage(data, bDelete);
 	}
 
-	void CPaintManagerUI::AdjustImagesHSL()
+	void CPaintManagerUI::CollectEvictableImages(TResInfo& resInfo, DWORD dwPinned, CStdPtrArray& aImages)
 	{
 		TImageInfo* data;
-		for( int i = 0; i< m_ResInfo.m_ImageHash.GetSize(); i++ ) {
-			if(LPCTSTR key = m_ResInfo.m_ImageHash.GetAt(i)) {
-				data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(key));
-				if( data && data->bUseHSL ) {
-					CRenderEngine::AdjustImage(m_bUseHSL, data, m_H, m_S, m_L);
-				}
+		for( int i = 0; i< resInfo.m_ImageHash.GetSize(); i++ ) {
+			if(LPCTSTR key = resInfo.m_ImageHash.GetAt(i)) {
+				data = static_cast<TImageInfo*>(resInfo.m_ImageHash.Find(key, false));
+				if( data && data->bEvictable && data->hBitmap != NULL && data->dwLastUse < dwPinned ) aImages.Add(data);
 			}
 		}
-		Invalidate();
+	}
+
+	void CPaintManagerUI::TrimImageCache()
+	{
+		if( m_nImageCacheBudget == 0 || m_ImageCacheStats.nResidentBytes <= m_nImageCacheBudget ) return;
+
+		// 可见窗口最近一次绘制中用到的图片视为正在显示，不能淘汰
+		DWORD dwPinned = m_dwImageClock;
+		for( int i = 0; i < m_aPreMessages.GetSize(); i++ ) {
+			CPaintManagerUI* pManager = static_cast<CPaintManagerUI*>(m_aPreMessages[i]);
+			HWND hWnd = pManager->GetPaintWindow();
+			if( hWnd == NULL || !::IsWindowVisible(hWnd) || ::IsIconic(hWnd) ) continue;
+			if( pManager->m_dwImagePaintClock < dwPinned ) dwPinned = pManager->m_dwImagePaintClock;
+		}
+
+		CStdPtrArray aImages;
+		CollectEvictableImages(m_SharedResInfo, dwPinned, aImages);
+		for( int i = 0; i < m_aPreMessages.GetSize(); i++ ) {
+			CollectEvictableImages(static_cast<CPaintManagerUI*>(m_aPreMessages[i])->m_ResInfo, dwPinned, aImages);
+		}
+		if( aImages.IsEmpty() ) return;
+		::qsort(aImages.GetData(), aImages.GetSize(), sizeof(LPVOID), CompareImageLastUse);
+
+		// 多淘汰一些，避免每加载一张图片都要重新扫描
+		SIZE_T nTarget = m_nImageCacheBudget - m_nImageCacheBudget / 8;
+		for( int i = 0; i < aImages.GetSize() && m_ImageCacheStats.nResidentBytes > nTarget; i++ ) {
+			// 只释放位图，保留图片记录以便按原来的类型、掩码和HSL设置重新加载
+			FreeImageInfo(static_cast<TImageInfo*>(aImages[i]), false);
+			m_ImageCacheStats.dwEvictions++;
+		}
 	}
 
 	void CPaintManagerUI::PostAsyncNotify()
@@ -3472,31 +4341,28 @@ namespace DuiLib {
 	}
 	void CPaintManagerUI::ReloadSharedImages()
 	{
+		FinishAllPendingImages(m_SharedResInfo);
+
 		TImageInfo* data = NULL;
 		TImageInfo* pNewData = NULL;
 		for( int i = 0; i< m_SharedResInfo.m_ImageHash.GetSize(); i++ ) {
 			if(LPCTSTR bitmap = m_SharedResInfo.m_ImageHash.GetAt(i)) {
 				data = static_cast<TImageInfo*>(m_SharedResInfo.m_ImageHash.Find(bitmap));
 				if( data != NULL ) {
-					if( !data->sResType.IsEmpty() ) {
-						if( isdigit(*bitmap) ) {
-							LPTSTR pstr = NULL;
-							int iIndex = _tcstol(bitmap, &pstr, 10);
-							pNewData = CRenderEngine::LoadImage(iIndex, data->sResType.GetData(), data->dwMask);
-						}
-					}
-					else {
-						pNewData = CRenderEngine::LoadImage(bitmap, NULL, data->dwMask);
-					}
+					// 已被缓存淘汰的图片下次取用时再加载
+					if( data->bEvictable && data->hBitmap == NULL ) continue;
+					// 与AddImage一致，DPI图片变体不存在时使用缩放后的原图
+					pNewData = LoadImageSource(bitmap, data->sResType.IsEmpty() ? NULL : data->sResType.GetData(), data->dwMask, false, NULL);
 					if( pNewData == NULL ) continue;
 
-					CRenderEngine::FreeImage(data, false);
+					FreeImageInfo(data, false);
 					data->hBitmap = pNewData->hBitmap;
 					data->pImage = pNewData->pImage;
 					data->pBits = pNewData->pBits;
 					data->nX = pNewData->nX;
 					data->nY = pNewData->nY;
 					data->bAlpha = pNewData->bAlpha;
+					data->nScale = pNewData->nScale;
 					data->pSrcBits = NULL;
 					if( data->bUseHSL ) {
 						data->pSrcBits = new BYTE[data->nX * data->nY * 4];
@@ -3504,16 +4370,19 @@ namespace DuiLib {
 					}
 					else data->pSrcBits = NULL;
 					if( m_bUseHSL ) CRenderEngine::AdjustImage(true, data, m_H, m_S, m_L);
+					m_ImageCacheStats.nResidentBytes += GetImageBytes(data);
 
 					delete pNewData;
 				}
 			}
 		}
+		TrimImageCache();
 	}
 
 	void CPaintManagerUI::ReloadImages()
 	{
 		RemoveAllDrawInfos();
+		FinishAllPendingImages(m_ResInfo);
 
 		TImageInfo* data = NULL;
 		TImageInfo* pNewData = NULL;
@@ -3521,18 +4390,10 @@ namespace DuiLib {
 			if(LPCTSTR bitmap = m_ResInfo.m_ImageHash.GetAt(i)) {
 				data = static_cast<TImageInfo*>(m_ResInfo.m_ImageHash.Find(bitmap));
 				if( data != NULL ) {
-					if( !data->sResType.IsEmpty() ) {
-						if( isdigit(*bitmap) ) {
-							LPTSTR pstr = NULL;
-							int iIndex = _tcstol(bitmap, &pstr, 10);
-							pNewData = CRenderEngine::LoadImage(iIndex, data->sResType.GetData(), data->dwMask);
-						}
-					}
-					else {
-						pNewData = CRenderEngine::LoadImage(bitmap, NULL, data->dwMask);
-					}
+					if( data->bEvictable && data->hBitmap == NULL ) continue;
+					pNewData = LoadImageSource(bitmap, data->sResType.IsEmpty() ? NULL : data->sResType.GetData(), data->dwMask, false, NULL);
 
-					CRenderEngine::FreeImage(data, false);
+					FreeImageInfo(data, false);
 					if( pNewData == NULL ) {
 						m_ResInfo.m_ImageHash.Remove(bitmap);
 						continue;
@@ -3542,6 +4403,7 @@ namespace DuiLib {
 					data->nX = pNewData->nX;
 					data->nY = pNewData->nY;
 					data->bAlpha = pNewData->bAlpha;
+					data->nScale = pNewData->nScale;
 					data->pSrcBits = NULL;
 					if( data->bUseHSL ) {
 						data->pSrcBits = new BYTE[data->nX * data->nY * 4];
@@ -3549,73 +4411,52 @@ namespace DuiLib {
 					}
 					else data->pSrcBits = NULL;
 					if( m_bUseHSL ) CRenderEngine::AdjustImage(true, data, m_H, m_S, m_L);
+					m_ImageCacheStats.nResidentBytes += GetImageBytes(data);
 
 					delete pNewData;
 				}
 			}
 		}
 
+		TrimImageCache();
 		if( m_pRoot ) m_pRoot->Invalidate();
 	}
 
 	const TDrawInfo* CPaintManagerUI::GetDrawInfo(LPCTSTR pStrImage, LPCTSTR pStrModify)
 	{
-		CDuiString sKey;
-		sKey.Format(_T("%s%s"), pStrImage == NULL ? _T("") : pStrImage, pStrModify == NULL ? _T("") : pStrModify);
-		TDrawInfo* pDrawInfo = static_cast<TDrawInfo*>(m_ResInfo.m_DrawInfoHash.Find(sKey));
-		if(pDrawInfo == NULL && !sKey.IsEmpty()) {
-			pDrawInfo = new TDrawInfo();
-			pDrawInfo->Parse(pStrImage, pStrModify,this);
-			m_ResInfo.m_DrawInfoHash.Insert(sKey, pDrawInfo);
-		}
-		return pDrawInfo;
+		CPaintResourceLock lock(this);
+		if( (pStrImage == NULL || *pStrImage == _T('\0')) && (pStrModify == NULL || *pStrModify == _T('\0')) ) return NULL;
+		return s_drawInfoPool.Acquire(pStrImage, pStrModify, this);
 	}
 
 	void CPaintManagerUI::RemoveDrawInfo(LPCTSTR pStrImage, LPCTSTR pStrModify)
 	{
-		CDuiString sKey;
-		sKey.Format(_T("%s%s"), pStrImage == NULL ? _T("") : pStrImage, pStrModify == NULL ? _T("") : pStrModify);
-		TDrawInfo* pDrawInfo = static_cast<TDrawInfo*>(m_ResInfo.m_DrawInfoHash.Find(sKey));
-		if(pDrawInfo != NULL) {
-			m_ResInfo.m_DrawInfoHash.Remove(sKey);
-			delete pDrawInfo;
-			pDrawInfo = NULL;
-		}
+		s_drawInfoPool.Release(pStrImage, pStrModify, this);
 	}
 
 	void CPaintManagerUI::RemoveAllDrawInfos()
 	{
-		TDrawInfo* pDrawInfo = NULL;
-		for( int i = 0; i< m_ResInfo.m_DrawInfoHash.GetSize(); i++ ) {
-			LPCTSTR key = m_ResInfo.m_DrawInfoHash.GetAt(i);
-			if(key != NULL) {
-				pDrawInfo = static_cast<TDrawInfo*>(m_ResInfo.m_DrawInfoHash.Find(key, false));
-				if (pDrawInfo) {
-					delete pDrawInfo;
-					pDrawInfo = NULL;
-				}
-			}
-		}
-		m_ResInfo.m_DrawInfoHash.RemoveAll();
+		s_drawInfoPool.ReleaseAll(this);
 	}
 
 	void CPaintManagerUI::AddDefaultAttributeList(LPCTSTR pStrControlName, LPCTSTR pStrControlAttrList, bool bShared)
 	{
+		// 加入时就拆分好，控件使用时直接逐项设置
 		if (bShared || m_bForceUseSharedRes)
 		{
-			CDuiString* pDefaultAttr = new CDuiString(pStrControlAttrList);
+			CAttributeList* pDefaultAttr = new CAttributeList(pStrControlAttrList);
 			if (pDefaultAttr != NULL)
 			{
-				CDuiString* pOldDefaultAttr = static_cast<CDuiString*>(m_SharedResInfo.m_AttrHash.Set(pStrControlName, (LPVOID)pDefaultAttr));
+				CAttributeList* pOldDefaultAttr = static_cast<CAttributeList*>(m_SharedResInfo.m_AttrHash.Set(pStrControlName, (LPVOID)pDefaultAttr));
 				if (pOldDefaultAttr) delete pOldDefaultAttr;
 			}
 		}
 		else
 		{
-			CDuiString* pDefaultAttr = new CDuiString(pStrControlAttrList);
+			CAttributeList* pDefaultAttr = new CAttributeList(pStrControlAttrList);
 			if (pDefaultAttr != NULL)
 			{
-				CDuiString* pOldDefaultAttr = static_cast<CDuiString*>(m_ResInfo.m_AttrHash.Set(pStrControlName, (LPVOID)pDefaultAttr));
+				CAttributeList* pOldDefaultAttr = static_cast<CAttributeList*>(m_ResInfo.m_AttrHash.Set(pStrControlName, (LPVOID)pDefaultAttr));
 				if (pOldDefaultAttr) delete pOldDefaultAttr;
 			}
 		}
@@ -3623,17 +4464,23 @@ namespace DuiLib {
 
 	LPCTSTR CPaintManagerUI::GetDefaultAttributeList(LPCTSTR pStrControlName) const
 	{
-		CDuiString* pDefaultAttr = static_cast<CDuiString*>(m_ResInfo.m_AttrHash.Find(pStrControlName));
-		if( !pDefaultAttr ) pDefaultAttr = static_cast<CDuiString*>(m_SharedResInfo.m_AttrHash.Find(pStrControlName));
+		const CAttributeList* pDefaultAttr = GetDefaultAttributes(pStrControlName);
 		if (pDefaultAttr) return pDefaultAttr->GetData();
 		return NULL;
 	}
 
+	const CAttributeList* CPaintManagerUI::GetDefaultAttributes(LPCTSTR pStrControlName) const
+	{
+		CAttributeList* pDefaultAttr = static_cast<CAttributeList*>(m_ResInfo.m_AttrHash.Find(pStrControlName));
+		if( !pDefaultAttr ) pDefaultAttr = static_cast<CAttributeList*>(m_SharedResInfo.m_AttrHash.Find(pStrControlName));
+		return pDefaultAttr;
+	}
+
 	bool CPaintManagerUI::RemoveDefaultAttributeList(LPCTSTR pStrControlName, bool bShared)
 	{
 		if (bShared)
 		{
-			CDuiString* pDefaultAttr = static_cast<CDuiString*>(m_SharedResInfo.m_AttrHash.Find(pStrControlName));
+			CAttributeList* pDefaultAttr = static_cast<CAttributeList*>(m_SharedResInfo.m_AttrHash.Find(pStrControlName));
 			if( !pDefaultAttr ) return false;
 
 			delete pDefaultAttr;
@@ -3641,7 +4488,7 @@ namespace DuiLib {
 		}
 		else
 		{
-			CDuiString* pDefaultAttr = static_cast<CDuiString*>(m_ResInfo.m_AttrHash.Find(pStrControlName));
+			CAttributeList* pDefaultAttr = static_cast<CAttributeList*>(m_ResInfo.m_AttrHash.Find(pStrControlName));
 			if( !pDefaultAttr ) return false;
 
 			delete pDefaultAttr;
@@ -3653,10 +4500,10 @@ namespace DuiLib {
 	{
 		if (bShared)
 		{
-			CDuiString* pDefaultAttr;
+			CAttributeList* pDefaultAttr;
 			for( int i = 0; i< m_SharedResInfo.m_AttrHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_SharedResInfo.m_AttrHash.GetAt(i)) {
-					pDefaultAttr = static_cast<CDuiString*>(m_SharedResInfo.m_AttrHash.Find(key));
+					pDefaultAttr = static_cast<CAttributeList*>(m_SharedResInfo.m_AttrHash.Find(key));
 					if (pDefaultAttr) delete pDefaultAttr;
 				}
 			}
@@ -3664,10 +4511,10 @@ namespace DuiLib {
 		}
 		else
 		{
-			CDuiString* pDefaultAttr;
+			CAttributeList* pDefaultAttr;
 			for( int i = 0; i< m_ResInfo.m_AttrHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_ResInfo.m_AttrHash.GetAt(i)) {
-					pDefaultAttr = static_cast<CDuiString*>(m_ResInfo.m_AttrHash.Find(key));
+					pDefaultAttr = static_cast<CAttributeList*>(m_ResInfo.m_AttrHash.Find(key));
 					if (pDefaultAttr) delete pDefaultAttr;
 				}
 			}
@@ -3857,6 +4704,14 @@ namespace DuiLib {
 		return NULL;
 	}
 
+	CControlUI* CALLBACK CPaintManagerUI::__FindControlFromPaintUnsafe(CControlUI* pThis, LPVOID pData)
+	{
+		if( pThis->IsPaintThreadSafe() ) return NULL;
+		LPRECT prcPaint = static_cast<LPRECT>(pData);
+		RECT rcTemp = { 0 };
+		return ::IntersectRect(&rcTemp, prcPaint, &pThis->GetPos()) ? pThis : NULL;
+	}
+
 	bool CPaintManagerUI::TranslateAccelerator(LPMSG pMsg)
 	{
 		for (int i = 0; i < m_aTranslateAccelerator.GetSize(); i++)
@@ -3942,7 +4797,7 @@ namespace DuiLib {
 	// 样式管理
 	void CPaintManagerUI::AddStyle(LPCTSTR pName, LPCTSTR pDeclarationList, bool bShared)
 	{
-		CDuiString* pStyle = new CDuiString(pDeclarationList);
+		CAttributeList* pStyle = new CAttributeList(pDeclarationList);
 
 		if(bShared || m_bForceUseSharedRes){
 			if( !m_SharedResInfo.m_StyleHash.Insert(pName, pStyle) ) {
@@ -3959,18 +4814,24 @@ namespace DuiLib {
 
 	LPCTSTR CPaintManagerUI::GetStyle(LPCTSTR pName) const
 	{
-		CDuiString* pStyle = static_cast<CDuiString*>(m_ResInfo.m_StyleHash.Find(pName));
-		if( !pStyle ) pStyle = static_cast<CDuiString*>(m_SharedResInfo.m_StyleHash.Find(pName));
+		const CAttributeList* pStyle = GetStyleAttributes(pName);
 		if( pStyle ) return pStyle->GetData();
 		else return NULL;
 	}
 
+	const CAttributeList* CPaintManagerUI::GetStyleAttributes(LPCTSTR pName) const
+	{
+		CAttributeList* pStyle = static_cast<CAttributeList*>(m_ResInfo.m_StyleHash.Find(pName));
+		if( !pStyle ) pStyle = static_cast<CAttributeList*>(m_SharedResInfo.m_StyleHash.Find(pName));
+		return pStyle;
+	}
+
 	BOOL CPaintManagerUI::RemoveStyle(LPCTSTR pName, bool bShared)
 	{
-		CDuiString* pStyle = NULL;
+		CAttributeList* pStyle = NULL;
 		if (bShared) 
 		{
-			pStyle = static_cast<CDuiString*>(m_SharedResInfo.m_StyleHash.Find(pName));
+			pStyle = static_cast<CAttributeList*>(m_SharedResInfo.m_StyleHash.Find(pName));
 			if (pStyle)
 			{
 				delete pStyle;
@@ -3979,7 +4840,7 @@ namespace DuiLib {
 		}
 		else
 		{
-			pStyle = static_cast<CDuiString*>(m_ResInfo.m_StyleHash.Find(pName));
+			pStyle = static_cast<CAttributeList*>(m_ResInfo.m_StyleHash.Find(pName));
 			if (pStyle)
 			{
 				delete pStyle;
@@ -3989,7 +4850,7 @@ namespace DuiLib {
 		return true;
 	}
 
-	const CStdStringPtrMap& CPaintManagerUI::GetStyles(bool bShared) const
+	const CStdStringPtrMap& CPaintManagerUI::GetStyleAttributeMap(bool bShared) const
 	{
 		if(bShared) return m_SharedResInfo.m_StyleHash;
 		else return m_ResInfo.m_StyleHash;
@@ -3999,10 +4860,10 @@ namespace DuiLib {
 	{
 		if (bShared)
 		{
-			CDuiString* pStyle;
+			CAttributeList* pStyle;
 			for( int i = 0; i< m_SharedResInfo.m_StyleHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_SharedResInfo.m_StyleHash.GetAt(i)) {
-					pStyle = static_cast<CDuiString*>(m_SharedResInfo.m_StyleHash.Find(key));
+					pStyle = static_cast<CAttributeList*>(m_SharedResInfo.m_StyleHash.Find(key));
 					delete pStyle;
 				}
 			}
@@ -4010,10 +4871,10 @@ namespace DuiLib {
 		}
 		else
 		{
-			CDuiString* pStyle;
+			CAttributeList* pStyle;
 			for( int i = 0; i< m_ResInfo.m_StyleHash.GetSize(); i++ ) {
 				if(LPCTSTR key = m_ResInfo.m_StyleHash.GetAt(i)) {
-					pStyle = static_cast<CDuiString*>(m_ResInfo.m_StyleHash.Find(key));
+					pStyle = static_cast<CAttributeList*>(m_ResInfo.m_StyleHash.Find(key));
 					delete pStyle;
 				}
 			}
@@ -7,8 +7,11 @@ namespace DuiLib {
 	//
 
 	class CControlUI;
+	class CContainerUI;
 	class CRichEditUI;
 	class CIDropTarget;
+	class CImageDecodeJob;
+	class CImageAtlas;
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	//
@@ -120,9 +123,31 @@ namespace DuiLib {
 		bool bUseHSL;
 		CDuiString sResType;
 		DWORD dwMask;
+		// 上次调色时的CPaintManagerUI HSL版本
+		DWORD dwHSLVersion;
+		// 位图相对皮肤坐标的缩放百分比，DPI图片变体不为100
+		int nScale;
+		// 放入图集时hBitmap为整页位图，图片位于(nAtlasX, nAtlasY)，pBits为NULL
+		CImageAtlas* pAtlas;
+		int nAtlasX;
+		int nAtlasY;
+		// 最近一次取用时的绘制时钟
+		DWORD dwLastUse;
+		// 可以从源文件重新加载，超出图片缓存预算时允许释放位图
+		bool bEvictable;
 
 	} TImageInfo;
 
+	// 图片缓存统计，见CPaintManagerUI::GetImageCacheStats
+	typedef struct UILIB_API tagTImageCacheStats
+	{
+		DWORD dwHits;		// 取用时位图已在内存中
+		DWORD dwMisses;		// 从源数据解码（首次加载或释放后重新加载）
+		DWORD dwEvictions;	// 因超出预算释放的图片数
+		SIZE_T nResidentBytes;
+		SIZE_T nBudgetBytes;
+	} TImageCacheStats;
+
 	typedef struct UILIB_API tagTDrawInfo
 	{
 		tagTDrawInfo();
@@ -168,9 +193,10 @@ namespace DuiLib {
 		TFontInfo m_DefaultFontInfo;
 		CStdStringPtrMap m_CustomFonts;
 		CStdStringPtrMap m_ImageHash;
+		// 后台解码中的图片，GetImage取用时完成并移入m_ImageHash
+		CStdStringPtrMap m_PendingImageHash;
 		CStdStringPtrMap m_AttrHash;
 		CStdStringPtrMap m_StyleHash;
-		CStdStringPtrMap m_DrawInfoHash;
 	} TResInfo;
 
 	// Structure for notifications from the system
@@ -236,6 +262,8 @@ namespace DuiLib {
 		void NeedUpdate();
 		void Invalidate();
 		void Invalidate(RECT& rcItem);
+		// 上一次WM_PAINT实际重绘的矩形，GetArea()为重绘的像素数
+		const CDirtyRegion& GetPaintRegion() const;
 
 		LPCTSTR GetName() const;
 		HDC GetPaintDC() const;
@@ -260,6 +288,11 @@ namespace DuiLib {
 		void SetMaxInfo(int cx, int cy);
 		bool IsShowUpdateRect();
 		void SetShowUpdateRect(bool show);
+		// 异步加载时绘制用到的图片在后台解码，完成前绘制占位图，完成后只刷新用到它的区域
+		bool IsAsyncImageLoad() const;
+		void SetAsyncImageLoad(bool bAsync);
+		LPCTSTR GetImagePlaceholder() const;
+		void SetImagePlaceholder(LPCTSTR pStrImage);
 		bool IsNoActivate();
 		void SetNoActivate(bool bNoActivate);
 
@@ -281,6 +314,16 @@ namespace DuiLib {
 		bool IsUseGdiplusText() const;
 		void SetGdiplusTextRenderingHint(int trh);
 		int GetGdiplusTextRenderingHint() const;
+		// 离屏绘制时用CSoftRenderTarget软件光栅化图元，默认使用GDI
+		void SetSoftwareRender(bool bSoftware);
+		bool IsSoftwareRender() const;
+		// 软件渲染时较大的脏矩形按水平分块，由最多nThreads个线程同时绘制，0或1为在窗口线程绘制
+		// 有一块需要交给GDI绘制时整个脏矩形改在窗口线程绘制
+		void SetPaintThreads(int nThreads);
+		int GetPaintThreads() const;
+		// 分块绘制时多个线程同时查找和加载图片、字体，由这对函数互斥，可以嵌套
+		void LockPaintResource();
+		void UnlockPaintResource();
 
 		static HINSTANCE GetInstance();
 		static CDuiString GetInstancePath();
@@ -298,7 +341,21 @@ namespace DuiLib {
 		static void SetResourceZip(LPVOID pVoid, unsigned int len, LPCTSTR password = NULL);
 		static void SetResourceZip(LPCTSTR pstrZip, bool bCachedResourceZip = false, LPCTSTR password = NULL);
 		static void SetResourceType(int nType);
+		// 解码缓存目录，为空时不使用。保存解码后的位图，之后启动时直接映射读取，跳过PNG解码；应在加载皮肤前设置
+		static const CDuiString& GetDecodedImageCachePath();
+		static void SetDecodedImageCachePath(LPCTSTR pStrPath);
 		static int GetResourceType();
+		// 开启后皮肤中的<Image>交给线程池并行解码，首次使用时才在UI线程创建位图
+		static bool IsParallelImageDecode();
+		static void SetParallelImageDecode(bool bParallel);
+		// 开启后之后加载的小图片合并到共享的图集位图中，HSL图片和GDI+图片除外
+		static bool IsImageAtlas();
+		static void SetImageAtlas(bool bAtlas);
+		// 图片缓存预算（字节），0表示不限制；超出时释放最久未绘制的图片，下次取用时自动重新加载
+		static SIZE_T GetImageCacheBudget();
+		static void SetImageCacheBudget(SIZE_T nBytes);
+		static void GetImageCacheStats(TImageCacheStats& stats);
+		static void ResetImageCacheStats();
 		static bool GetHSL(short* H, short* S, short* L);
 		static void SetHSL(bool bUseHSL, short H, short S, short L); // H:0~360, S:0~200, L:0~200 
 		static void ReloadSkin();
@@ -339,8 +396,16 @@ namespace DuiLib {
 
 		const TImageInfo* GetImage(LPCTSTR bitmap);
 		const TImageInfo* GetImageEx(LPCTSTR bitmap, LPCTSTR type = NULL, DWORD mask = 0, bool bUseHSL = false, bool bGdiplus = false, HINSTANCE instance = NULL);
+		// 布局用：返回图片在皮肤坐标下的尺寸（DPI图片变体已换算回原图尺寸），未加载的图片只读取文件头，
+		// 像素在绘制时才解码；文件头无法识别时按参数同GetImageEx加载图片，失败返回{0, 0}
+		SIZE GetImageSize(LPCTSTR bitmap, LPCTSTR type = NULL, DWORD mask = 0, bool bUseHSL = false, bool bGdiplus = false, HINSTANCE instance = NULL);
 		const TImageInfo* AddImage(LPCTSTR bitmap, LPCTSTR type = NULL, DWORD mask = 0, bool bUseHSL = false, bool bGdiplus = false, bool bShared = false, HINSTANCE instance = NULL);
 		const TImageInfo* AddImage(LPCTSTR bitmap, HBITMAP hBitmap, int iWidth, int iHeight, bool bAlpha, bool bShared = false);
+		// 参数同AddImage，图片在后台解码，GetImage首次取用时才等待该图片；无法后台解码时同步加载
+		bool PreloadImage(LPCTSTR bitmap, LPCTSTR type = NULL, DWORD mask = 0, bool bUseHSL = false, bool bShared = false, HINSTANCE instance = NULL);
+		// 绘制用：异步加载模式下未就绪的图片返回NULL，解码完成后刷新rcInvalidate；其它情况同GetImageEx
+		const TImageInfo* GetImageAsync(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bUseHSL, bool bGdiplus, const RECT& rcInvalidate, HINSTANCE instance = NULL);
+		const TImageInfo* GetImagePlaceholderInfo();
 		void RemoveImage(LPCTSTR bitmap, bool bShared = false);
 		void RemoveAllImages(bool bShared = false);
 		static void ReloadSharedImages();
@@ -352,6 +417,7 @@ namespace DuiLib {
 
 		void AddDefaultAttributeList(LPCTSTR pStrControlName, LPCTSTR pStrControlAttrList, bool bShared = false);
 		LPCTSTR GetDefaultAttributeList(LPCTSTR pStrControlName) const;
+		const CAttributeList* GetDefaultAttributes(LPCTSTR pStrControlName) const;
 		bool RemoveDefaultAttributeList(LPCTSTR pStrControlName, bool bShared = false);
 		void RemoveAllDefaultAttributeList(bool bShared = false);
 
@@ -363,8 +429,10 @@ namespace DuiLib {
 		// 样式管理
 		void AddStyle(LPCTSTR pName, LPCTSTR pStyle, bool bShared = false);
 		LPCTSTR GetStyle(LPCTSTR pName) const;
+		const CAttributeList* GetStyleAttributes(LPCTSTR pName) const;
 		BOOL RemoveStyle(LPCTSTR pName, bool bShared = false);
-		const CStdStringPtrMap& GetStyles(bool bShared = false) const;
+		// 值是CAttributeList*，样式原文用GetData()取得；值为CDuiString*的GetStyles已去掉
+		const CStdStringPtrMap& GetStyleAttributeMap(bool bShared = false) const;
 		void RemoveAllStyle(bool bShared = false);
 
 		const TImageInfo* GetImageString(LPCTSTR pStrImage, LPCTSTR pStrModify = NULL);
@@ -419,6 +487,10 @@ namespace DuiLib {
 		bool RemovePostPaint(CControlUI* pControl);
 		bool SetPostPaintIndex(CControlUI* pControl, int iIndex);
 
+		// 开启了缓存层的容器，Invalidate时通知它们重绘缓存中对应的部分
+		bool AddLayerCache(CContainerUI* pContainer);
+		bool RemoveLayerCache(CContainerUI* pContainer);
+
 		int GetNativeWindowCount() const;
 		RECT GetNativeWindowRect(HWND hChildWnd);
 		bool AddNativeWindow(CControlUI* pControl, HWND hChildWnd);
@@ -465,9 +537,26 @@ namespace DuiLib {
 		static CControlUI* CALLBACK __FindControlFromClass(CControlUI* pThis, LPVOID pData);
 		static CControlUI* CALLBACK __FindControlsFromClass(CControlUI* pThis, LPVOID pData);
 		static CControlUI* CALLBACK __FindControlsFromUpdate(CControlUI* pThis, LPVOID pData);
-
-		static void AdjustSharedImagesHSL();
-		void AdjustImagesHSL();
+		static CControlUI* CALLBACK __FindControlFromPaintUnsafe(CControlUI* pThis, LPVOID pData);
+		bool PaintTiles(const RECT& rcDirty);
+
+		static TImageInfo* FindImage(TResInfo& resInfo, LPCTSTR bitmap);
+		static const TImageInfo* InsertImage(TResInfo& resInfo, LPCTSTR bitmap, TImageInfo* data, LPCTSTR type, DWORD mask, bool bUseHSL);
+		static const TImageInfo* FinishPendingImage(TResInfo& resInfo, LPCTSTR bitmap);
+		static void FinishAllPendingImages(TResInfo& resInfo);
+		static void CancelPendingImage(TResInfo& resInfo, LPCTSTR bitmap);
+		static void CancelAllPendingImages(TResInfo& resInfo);
+		static void InsertPendingImage(TResInfo& resInfo, LPCTSTR bitmap, CImageDecodeJob* pJob, LPCTSTR type, DWORD mask, bool bUseHSL, HINSTANCE instance);
+		static void FinishReadyImages(TResInfo& resInfo);
+		static TImageInfo* LoadImageSource(LPCTSTR bitmap, LPCTSTR type, DWORD mask, bool bGdiplus, HINSTANCE instance);
+		static bool ReloadEvictedImage(LPCTSTR bitmap, TImageInfo* data);
+		static SIZE_T GetImageBytes(const TImageInfo* data);
+		static void FreeImageInfo(TImageInfo* data, bool bDelete = true);
+		static void CollectEvictableImages(TResInfo& resInfo, DWORD dwPinned, CStdPtrArray& aImages);
+		static void TrimImageCache();
+		static void RemoveAllImageSizes();
+		void InvalidateImageWaiters(LPCTSTR bitmap, bool bInvalidate);
+		void RemoveAllImageWaiters();
 		void PostAsyncNotify();
 
 	private:
@@ -488,6 +577,13 @@ namespace DuiLib {
 		bool m_bNoActivate;
 		bool m_bShowUpdateRect;
 
+		// 异步加载图片
+		bool m_bAsyncImageLoad;
+		CDuiString m_sImagePlaceholder;
+		CStdStringPtrMap m_mImageWaiters;
+		// 最近一次WM_PAINT开始时的图片时钟
+		DWORD m_dwImagePaintClock;
+
 		//
 		CControlUI* m_pRoot;
 		CControlUI* m_pFocus;
@@ -514,7 +610,8 @@ namespace DuiLib {
 		bool m_bLayered;
 		RECT m_rcLayeredInset;
 		bool m_bLayeredChanged;
-		RECT m_rcLayeredUpdate;
+		CDirtyRegion m_LayeredUpdate;
+		CDirtyRegion m_PaintRegion;
 		TDrawInfo m_diLayered;
 
 		bool m_bMouseTracking;
@@ -530,6 +627,7 @@ namespace DuiLib {
 		CStdPtrArray m_aPreMessageFilters;
 		CStdPtrArray m_aMessageFilters;
 		CStdPtrArray m_aPostPaintControls;
+		CStdPtrArray m_aLayerCacheControls;
 		CStdPtrArray m_aNativeWindow;
 		CStdPtrArray m_aNativeWindowControl;
 		CStdPtrArray m_aDelayedCleanup;
@@ -552,6 +650,10 @@ namespace DuiLib {
 		// 是否开启Gdiplus
 		bool m_bUseGdiplusText;
 		int m_trh;
+		// 软件渲染后端
+		bool m_bSoftwareRender;
+		int m_nPaintThreads;
+		CRITICAL_SECTION m_csPaintResource;
 		ULONG_PTR m_gdiplusToken;
 		Gdiplus::GdiplusStartupInput *m_pGdiplusStartupInput;
 
@@ -564,15 +666,24 @@ namespace DuiLib {
 		static HINSTANCE m_hInstance;
 		static HINSTANCE m_hResourceInstance;
 		static CDuiString m_pStrResourcePath;
+		static CDuiString m_pStrDecodedImageCachePath;
 		static CDuiString m_pStrResourceZip;
 		static CDuiString m_pStrResourceZipPwd;
 		static HANDLE m_hResourceZip;
         static BYTE* m_cbZipBuf;
 
 		static bool m_bCachedResourceZip;
+		static bool m_bParallelImageDecode;
+		static bool m_bImageAtlas;
 		static int m_nResType;
 		static TResInfo m_SharedResInfo;
 		static bool m_bUseHSL;
+		static DWORD m_dwHSLVersion;
+		static SIZE_T m_nImageCacheBudget;
+		static TImageCacheStats m_ImageCacheStats;
+		static DWORD m_dwImageClock;
+		// GetImageSize读取文件头得到的尺寸，键为restype|name
+		static CStdStringPtrMap m_ImageSizeHash;
 		static short m_H;
 		static short m_S;
 		static short m_L;
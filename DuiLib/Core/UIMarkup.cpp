@@ -4,16 +4,326 @@
 #define TRACE
 #endif
 
+// Unicode版本下用SSE2/AVX2批量扫描分隔符，ANSI版本有DBCS尾字节问题，保持逐字符处理
+#if defined(_UNICODE) && (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__))
+#define UIMARKUP_SIMD
+// 对齐读取会读到结尾'\0'之后同一内存页中的数据，这是有意的，AddressSanitizer不检查这些函数
+#ifdef _MSC_VER
+#include <intrin.h>
+#ifdef __SANITIZE_ADDRESS__
+#define UIMARKUP_TARGET(isa) __declspec(no_sanitize_address)
+#else
+#define UIMARKUP_TARGET(isa)
+#endif
+#else
+#include <cpuid.h>
+// GCC要求用到SSE2/AVX2指令的函数声明目标指令集，调用前已按cpuid检查
+#define UIMARKUP_TARGET(isa) __attribute__((target(isa), no_sanitize_address))
+#endif
+#include <emmintrin.h>
+#if !defined(_MSC_VER) || _MSC_VER >= 1700
+#define UIMARKUP_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 namespace DuiLib {
 ///////////////////////////////////////////////////////////////////////////////////////
 //
 //
 //
-CMarkupNode::CMarkupNode() : m_pOwner(NULL)
+static inline bool _IsScanStop(TCHAR ch, TCHAR c1, TCHAR c2, TCHAR c3)
+{
+    return ch == _T('\0') || ch == c1 || ch == c2 || ch == c3;
+}
+
+static inline bool _IsSpaceChar(TCHAR ch)
+{
+    return ch > _T('\0') && ch <= _T(' ');
+}
+
+static int s_iSimdLimit = MARKUP_SIMD_AVX2;
+
+#ifdef UIMARKUP_SIMD
+enum { SIMD_NONE = MARKUP_SIMD_NONE, SIMD_SSE2 = MARKUP_SIMD_SSE2, SIMD_AVX2 = MARKUP_SIMD_AVX2 };
+
+static int _GetCpuSimdLevel()
+{
+    int iLevel = SIMD_NONE;
+#ifdef _MSC_VER
+    int info[4] = { 0 };
+    __cpuid(info, 0);
+    int nIds = info[0];
+    __cpuid(info, 1);
+    if( (info[3] & (1 << 26)) != 0 ) iLevel = SIMD_SSE2;
+#ifdef UIMARKUP_AVX2
+    bool bOSXSave = (info[2] & (1 << 27)) != 0;
+    bool bAVX = (info[2] & (1 << 28)) != 0;
+    if( iLevel == SIMD_SSE2 && nIds >= 7 && bOSXSave && bAVX && (_xgetbv(0) & 6) == 6 ) {
+        __cpuidex(info, 7, 0);
+        if( (info[1] & (1 << 5)) != 0 ) iLevel = SIMD_AVX2;
+    }
+#endif
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ) return SIMD_NONE;
+    if( (edx & (1 << 26)) != 0 ) iLevel = SIMD_SSE2;
+    bool bOSXSave = (ecx & (1 << 27)) != 0;
+    bool bAVX = (ecx & (1 << 28)) != 0;
+    if( iLevel == SIMD_SSE2 && bOSXSave && bAVX ) {
+        unsigned int xcr0 = 0, xcr0High = 0;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        if( (xcr0 & 6) == 6 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 5)) != 0 ) iLevel = SIMD_AVX2;
+    }
+#endif
+    return iLevel;
+}
+
+static int _GetSimdLevel()
+{
+    static int s_iLevel = -1;
+    if( s_iLevel < 0 ) s_iLevel = _GetCpuSimdLevel();
+    return s_iLevel < s_iSimdLimit ? s_iLevel : s_iSimdLimit;
+}
+
+static inline unsigned long _FirstBit(unsigned long nMask)
+{
+#ifdef _MSC_VER
+    unsigned long iBit = 0;
+    _BitScanForward(&iBit, nMask);
+    return iBit;
+#else
+    return (unsigned long)__builtin_ctzl(nMask);
+#endif
+}
+
+// 只使用对齐读取，一次读取不会跨越内存页，可以安全地读到结尾'\0'之后
+UIMARKUP_TARGET("sse2") static LPCTSTR _ScanUntilSSE2(LPCTSTR pstr, TCHAR c1, TCHAR c2, TCHAR c3)
+{
+    while( ((UINT_PTR)pstr & 15) != 0 ) {
+        if( _IsScanStop(*pstr, c1, c2, c3) ) return pstr;
+        ++pstr;
+    }
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i v1 = _mm_set1_epi16((short)c1);
+    const __m128i v2 = _mm_set1_epi16((short)c2);
+    const __m128i v3 = _mm_set1_epi16((short)c3);
+    for( ; ; ) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(pstr));
+        __m128i vHit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, vZero), _mm_cmpeq_epi16(v, v1)),
+            _mm_or_si128(_mm_cmpeq_epi16(v, v2), _mm_cmpeq_epi16(v, v3)));
+        unsigned long nMask = (unsigned long)_mm_movemask_epi8(vHit);
+        if( nMask != 0 ) {
+            return pstr + (_FirstBit(nMask) >> 1);
+        }
+        pstr += 16 / sizeof(TCHAR);
+    }
+}
+
+// 空白字符为 1 <= ch <= ' '，即 (ch - 1) 无符号不大于 0x1F
+UIMARKUP_TARGET("sse2") static LPCTSTR _SkipSpaceSSE2(LPCTSTR pstr)
+{
+    while( ((UINT_PTR)pstr & 15) != 0 ) {
+        if( !_IsSpaceChar(*pstr) ) return pstr;
+        ++pstr;
+    }
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vOne = _mm_set1_epi16(1);
+    const __m128i vMax = _mm_set1_epi16(0x1F);
+    for( ; ; ) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(pstr));
+        __m128i vSpace = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(v, vOne), vMax), vZero);
+        unsigned long nMask = (unsigned long)_mm_movemask_epi8(vSpace) ^ 0xFFFF;
+        if( nMask != 0 ) {
+            return pstr + (_FirstBit(nMask) >> 1);
+        }
+        pstr += 16 / sizeof(TCHAR);
+    }
+}
+
+// UTF-8原位解析用的单字节版本，多字节序列的各字节都 >= 0x80，不会与分隔符混淆
+UIMARKUP_TARGET("sse2") static LPCSTR _ScanUntilSSE2(LPCSTR pstr, char c1, char c2, char c3)
+{
+    while( ((UINT_PTR)pstr & 15) != 0 ) {
+        if( *pstr == '\0' || *pstr == c1 || *pstr == c2 || *pstr == c3 ) return pstr;
+        ++pstr;
+    }
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i v1 = _mm_set1_epi8(c1);
+    const __m128i v2 = _mm_set1_epi8(c2);
+    const __m128i v3 = _mm_set1_epi8(c3);
+    for( ; ; ) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(pstr));
+        __m128i vHit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vZero), _mm_cmpeq_epi8(v, v1)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, v2), _mm_cmpeq_epi8(v, v3)));
+        unsigned long nMask = (unsigned long)_mm_movemask_epi8(vHit);
+        if( nMask != 0 ) {
+            return pstr + _FirstBit(nMask);
+        }
+        pstr += 16;
+    }
+}
+
+#ifdef UIMARKUP_AVX2
+UIMARKUP_TARGET("avx2") static LPCTSTR _ScanUntilAVX2(LPCTSTR pstr, TCHAR c1, TCHAR c2, TCHAR c3)
+{
+    while( ((UINT_PTR)pstr & 31) != 0 ) {
+        if( _IsScanStop(*pstr, c1, c2, c3) ) return pstr;
+        ++pstr;
+    }
+    const __m256i vZero = _mm256_setzero_si256();
+    const __m256i v1 = _mm256_set1_epi16((short)c1);
+    const __m256i v2 = _mm256_set1_epi16((short)c2);
+    const __m256i v3 = _mm256_set1_epi16((short)c3);
+    for( ; ; ) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(pstr));
+        __m256i vHit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(v, vZero), _mm256_cmpeq_epi16(v, v1)),
+            _mm256_or_si256(_mm256_cmpeq_epi16(v, v2), _mm256_cmpeq_epi16(v, v3)));
+        unsigned long nMask = (unsigned int)_mm256_movemask_epi8(vHit);
+        if( nMask != 0 ) {
+            return pstr + (_FirstBit(nMask) >> 1);
+        }
+        pstr += 32 / sizeof(TCHAR);
+    }
+}
+
+UIMARKUP_TARGET("avx2") static LPCTSTR _SkipSpaceAVX2(LPCTSTR pstr)
+{
+    while( ((UINT_PTR)pstr & 31) != 0 ) {
+        if( !_IsSpaceChar(*pstr) ) return pstr;
+        ++pstr;
+    }
+    const __m256i vZero = _mm256_setzero_si256();
+    const __m256i vOne = _mm256_set1_epi16(1);
+    const __m256i vMax = _mm256_set1_epi16(0x1F);
+    for( ; ; ) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(pstr));
+        __m256i vSpace = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_sub_epi16(v, vOne), vMax), vZero);
+        unsigned long nMask = ~(unsigned int)_mm256_movemask_epi8(vSpace);
+        if( nMask != 0 ) {
+            return pstr + (_FirstBit(nMask) >> 1);
+        }
+        pstr += 32 / sizeof(TCHAR);
+    }
+}
+#endif // UIMARKUP_AVX2
+#endif // UIMARKUP_SIMD
+
+// 大部分属性值、名字和文本都很短，先逐字符检查SCAN_PROBE个字符，找不到再用SIMD扫描剩下的部分
+enum { SCAN_PROBE = 16 };
+
+// 返回第一个 '\0'、c1、c2 或 c3 的位置
+static LPCTSTR _ScanUntil(LPCTSTR pstr, TCHAR c1, TCHAR c2, TCHAR c3)
+{
+#ifdef UIMARKUP_SIMD
+    int iLevel = _GetSimdLevel();
+    if( iLevel != SIMD_NONE ) {
+        for( int i = 0; i < SCAN_PROBE; i++, pstr++ ) {
+            if( _IsScanStop(*pstr, c1, c2, c3) ) return pstr;
+        }
+#ifdef UIMARKUP_AVX2
+        if( iLevel >= SIMD_AVX2 ) return _ScanUntilAVX2(pstr, c1, c2, c3);
+#endif
+        return _ScanUntilSSE2(pstr, c1, c2, c3);
+    }
+#endif
+    while( *pstr != _T('\0') && *pstr != c1 && *pstr != c2 && *pstr != c3 ) ++pstr;
+    return pstr;
+}
+
+static inline LPTSTR _ScanUntil(LPTSTR pstr, TCHAR c1, TCHAR c2, TCHAR c3)
+{
+    return const_cast<LPTSTR>(_ScanUntil(static_cast<LPCTSTR>(pstr), c1, c2, c3));
+}
+
+// 跳过一段空白，结果与逐个CharNext一致
+static LPCTSTR _SkipSpaceRun(LPCTSTR pstr)
+{
+#ifdef UIMARKUP_SIMD
+    int iLevel = _GetSimdLevel();
+    if( iLevel != SIMD_NONE && _IsSpaceChar(pstr[0]) && _IsSpaceChar(pstr[1]) ) {
+        LPCTSTR pstrStart = pstr;
+#ifdef UIMARKUP_AVX2
+        if( iLevel >= SIMD_AVX2 ) pstr = _SkipSpaceAVX2(pstr);
+        else
+#endif
+        pstr = _SkipSpaceSSE2(pstr);
+        // CharNext会把空白后的组合字符一并跳过，交给下面的逐字符处理
+        if( pstr > pstrStart && *pstr >= 0x0300 ) --pstr;
+    }
+#endif
+    while( _IsSpaceChar(*pstr) ) pstr = ::CharNext(pstr);
+    return pstr;
+}
+
+static inline SIZE_T _CharLength(LPCTSTR pstr)
+{
+    return ::CharNext(pstr) - pstr;
+}
+
+static inline bool _IsNameChar(TCHAR ch)
+{
+    // 属性只能用英文，所以这样处理没有问题
+    return ch != _T('\0') && (ch == _T('_') || ch == _T(':') || _istalnum(ch));
+}
+
+static inline int _CompareName(LPCTSTR pstr1, LPCTSTR pstr2, SIZE_T cchName)
+{
+    return _tcsncmp(pstr1, pstr2, cchName);
+}
+
+#ifdef _UNICODE
+static LPCSTR _ScanUntil(LPCSTR pstr, char c1, char c2, char c3)
+{
+#ifdef UIMARKUP_SIMD
+    if( _GetSimdLevel() != SIMD_NONE ) {
+        for( int i = 0; i < SCAN_PROBE; i++, pstr++ ) {
+            if( *pstr == '\0' || *pstr == c1 || *pstr == c2 || *pstr == c3 ) return pstr;
+        }
+        return _ScanUntilSSE2(pstr, c1, c2, c3);
+    }
+#endif
+    while( *pstr != '\0' && *pstr != c1 && *pstr != c2 && *pstr != c3 ) ++pstr;
+    return pstr;
+}
+
+static inline LPSTR _ScanUntil(LPSTR pstr, char c1, char c2, char c3)
+{
+    return const_cast<LPSTR>(_ScanUntil(static_cast<LPCSTR>(pstr), c1, c2, c3));
+}
+
+static inline LPCSTR _SkipSpaceRun(LPCSTR pstr)
+{
+    while( *pstr > '\0' && *pstr <= ' ' ) ++pstr;
+    return pstr;
+}
+
+static inline SIZE_T _CharLength(LPCSTR pstr)
+{
+    return *pstr != '\0' ? 1 : 0;
+}
+
+static inline bool _IsNameChar(char ch)
+{
+    // 非ASCII字节按宽字符版本的_istalnum处理，当作名字的一部分
+    return ch == '_' || ch == ':' || (ch > '\0' && isalnum(ch)) || (BYTE)ch >= 0x80;
+}
+
+static inline int _CompareName(LPCSTR pstr1, LPCSTR pstr2, SIZE_T cchName)
+{
+    return strncmp(pstr1, pstr2, cchName);
+}
+#endif // _UNICODE
+
+///////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+CMarkupNode::CMarkupNode() : m_iPos(0), m_pOwner(NULL)
 {
 }
 
-CMarkupNode::CMarkupNode(CMarkup* pOwner, int iPos) : m_pOwner(pOwner), m_iPos(iPos), m_nAttributes(0)
+CMarkupNode::CMarkupNode(CMarkup* pOwner, int iPos) : m_iPos(iPos), m_pOwner(pOwner)
 {
 }
 
@@ -45,7 +355,7 @@ CMarkupNode CMarkupNode::GetChild(LPCTSTR pstrName)
     if( m_pOwner == NULL ) return CMarkupNode();
     ULONG iPos = m_pOwner->m_pElements[m_iPos].iChild;
     while( iPos != 0 ) {
-        if( _tcsicmp(m_pOwner->m_pstrXML + m_pOwner->m_pElements[iPos].iStart, pstrName) == 0 ) {
+        if( _tcsicmp(m_pOwner->_GetString(m_pOwner->m_pElements[iPos].iStart), pstrName) == 0 ) {
             return CMarkupNode(m_pOwner, iPos);
         }
         iPos = m_pOwner->m_pElements[iPos].iNext;
@@ -75,104 +385,70 @@ bool CMarkupNode::IsValid() const
 LPCTSTR CMarkupNode::GetName() const
 {
     if( m_pOwner == NULL ) return NULL;
-    return m_pOwner->m_pstrXML + m_pOwner->m_pElements[m_iPos].iStart;
+    return m_pOwner->_GetString(m_pOwner->m_pElements[m_iPos].iStart);
 }
 
 LPCTSTR CMarkupNode::GetValue() const
 {
     if( m_pOwner == NULL ) return NULL;
-    return m_pOwner->m_pstrXML + m_pOwner->m_pElements[m_iPos].iData;
+    return m_pOwner->_GetString(m_pOwner->m_pElements[m_iPos].iData);
 }
 
 LPCTSTR CMarkupNode::GetAttributeName(int iIndex)
 {
     if( m_pOwner == NULL ) return NULL;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    if( iIndex < 0 || iIndex >= m_nAttributes ) return _T("");
-    return m_pOwner->m_pstrXML + m_aAttributes[iIndex].iName;
+    if( iIndex < 0 || iIndex >= GetAttributeCount() ) return _T("");
+    return m_pOwner->_GetString(m_pOwner->m_pAttributes[m_pOwner->m_pAttributeIndex[m_iPos] + iIndex].iName);
 }
 
 LPCTSTR CMarkupNode::GetAttributeValue(int iIndex)
 {
     if( m_pOwner == NULL ) return NULL;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    if( iIndex < 0 || iIndex >= m_nAttributes ) return _T("");
-    return m_pOwner->m_pstrXML + m_aAttributes[iIndex].iValue;
+    if( iIndex < 0 || iIndex >= GetAttributeCount() ) return _T("");
+    return m_pOwner->_GetString(m_pOwner->m_pAttributes[m_pOwner->m_pAttributeIndex[m_iPos] + iIndex].iValue);
 }
 
 LPCTSTR CMarkupNode::GetAttributeValue(LPCTSTR pstrName)
 {
     if( m_pOwner == NULL ) return NULL;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    for( int i = 0; i < m_nAttributes; i++ ) {
-        if( _tcsicmp(m_pOwner->m_pstrXML + m_aAttributes[i].iName, pstrName) == 0 ) return m_pOwner->m_pstrXML + m_aAttributes[i].iValue;
-    }
-    return _T("");
+    const CMarkup::XMLATTRIBUTE* pAttr = m_pOwner->_FindAttribute(m_iPos, pstrName);
+    if( pAttr == NULL ) return _T("");
+    return m_pOwner->_GetString(pAttr->iValue);
 }
 
 bool CMarkupNode::GetAttributeValue(int iIndex, LPTSTR pstrValue, SIZE_T cchMax)
 {
     if( m_pOwner == NULL ) return false;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    if( iIndex < 0 || iIndex >= m_nAttributes ) return false;
-    _tcsncpy(pstrValue, m_pOwner->m_pstrXML + m_aAttributes[iIndex].iValue, cchMax);
+    if( iIndex < 0 || iIndex >= GetAttributeCount() ) return false;
+    _tcsncpy(pstrValue, m_pOwner->_GetString(m_pOwner->m_pAttributes[m_pOwner->m_pAttributeIndex[m_iPos] + iIndex].iValue), cchMax);
     return true;
 }
 
 bool CMarkupNode::GetAttributeValue(LPCTSTR pstrName, LPTSTR pstrValue, SIZE_T cchMax)
 {
     if( m_pOwner == NULL ) return false;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    for( int i = 0; i < m_nAttributes; i++ ) {
-        if( _tcsicmp(m_pOwner->m_pstrXML + m_aAttributes[i].iName, pstrName) == 0 ) {
-            _tcsncpy(pstrValue, m_pOwner->m_pstrXML + m_aAttributes[i].iValue, cchMax);
-            return true;
-        }
-    }
-    return false;
+    const CMarkup::XMLATTRIBUTE* pAttr = m_pOwner->_FindAttribute(m_iPos, pstrName);
+    if( pAttr == NULL ) return false;
+    _tcsncpy(pstrValue, m_pOwner->_GetString(pAttr->iValue), cchMax);
+    return true;
 }
 
 int CMarkupNode::GetAttributeCount()
 {
     if( m_pOwner == NULL ) return 0;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    return m_nAttributes;
+    return (int)(m_pOwner->m_pAttributeIndex[m_iPos + 1] - m_pOwner->m_pAttributeIndex[m_iPos]);
 }
 
 bool CMarkupNode::HasAttributes()
 {
     if( m_pOwner == NULL ) return false;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    return m_nAttributes > 0;
+    return m_pOwner->m_pAttributeIndex[m_iPos + 1] > m_pOwner->m_pAttributeIndex[m_iPos];
 }
 
 bool CMarkupNode::HasAttribute(LPCTSTR pstrName)
 {
     if( m_pOwner == NULL ) return false;
-    if( m_nAttributes == 0 ) _MapAttributes();
-    for( int i = 0; i < m_nAttributes; i++ ) {
-        if( _tcsicmp(m_pOwner->m_pstrXML + m_aAttributes[i].iName, pstrName) == 0 ) return true;
-    }
-    return false;
-}
-
-void CMarkupNode::_MapAttributes()
-{
-    m_nAttributes = 0;
-    LPCTSTR pstr = m_pOwner->m_pstrXML + m_pOwner->m_pElements[m_iPos].iStart;
-    LPCTSTR pstrEnd = m_pOwner->m_pstrXML + m_pOwner->m_pElements[m_iPos].iData;
-    pstr += _tcslen(pstr) + 1;
-    while( pstr < pstrEnd ) {
-        m_pOwner->_SkipWhitespace(pstr);
-        m_aAttributes[m_nAttributes].iName = pstr - m_pOwner->m_pstrXML;
-        pstr += _tcslen(pstr) + 1;
-        m_pOwner->_SkipWhitespace(pstr);
-        if( *pstr++ != _T('\"') ) return; // if( *pstr != _T('\"') ) { pstr = ::CharNext(pstr); return; }
-        
-        m_aAttributes[m_nAttributes++].iValue = pstr - m_pOwner->m_pstrXML;
-        if( m_nAttributes >= MAX_XML_ATTRIBUTES ) return;
-        pstr += _tcslen(pstr) + 1;
-    }
+    return m_pOwner->_FindAttribute(m_iPos, pstrName) != NULL;
 }
 
 
@@ -184,8 +460,18 @@ void CMarkupNode::_MapAttributes()
 CMarkup::CMarkup(LPCTSTR pstrXML)
 {
     m_pstrXML = NULL;
+    m_pstrUtf8 = NULL;
+    m_pstrUtf8Wide = NULL;
+    m_pUtf8WidePages = NULL;
     m_pElements = NULL;
     m_nElements = 0;
+    m_pAttributeIndex = NULL;
+    m_pAttributes = NULL;
+    m_nAttributes = 0;
+    m_pAttributeHash = NULL;
+    m_nAttributeHashMask = 0;
+    m_pBinary = NULL;
+    m_hBinaryMap = NULL;
     m_bPreserveWhitespace = true;
     if( pstrXML != NULL ) Load(pstrXML);
 }
@@ -200,11 +486,21 @@ bool CMarkup::IsValid() const
     return m_pElements != NULL;
 }
 
+bool CMarkup::IsBinary() const
+{
+    return m_pBinary != NULL;
+}
+
 void CMarkup::SetPreserveWhitespace(bool bPreserve)
 {
     m_bPreserveWhitespace = bPreserve;
 }
 
+void CMarkup::SetSimdLevel(int iLevel)
+{
+    s_iSimdLimit = iLevel;
+}
+
 bool CMarkup::Load(LPCTSTR pstrXML)
 {
     Release();
@@ -218,18 +514,22 @@ bool CMarkup::Load(LPCTSTR pstrXML)
 
 bool CMarkup::LoadFromMem(BYTE* pByte, DWORD dwSize, int encoding)
 {
+    Release();
+    if( _IsBinary(pByte, dwSize) ) {
+        m_pBinary = static_cast<LPBYTE>(malloc(dwSize));
+        ::CopyMemory(m_pBinary, pByte, dwSize);
+        bool bRes = _LoadBinary(m_pBinary, dwSize);
+        if( !bRes ) Release();
+        return bRes;
+    }
+
 #ifdef _UNICODE
     if (encoding == XMLFILE_ENCODING_UTF8)
     {
-        if( dwSize >= 3 && pByte[0] == 0xEF && pByte[1] == 0xBB && pByte[2] == 0xBF ) 
-        {
-            pByte += 3; dwSize -= 3;
-        }
-        DWORD nWide = ::MultiByteToWideChar( CP_UTF8, 0, (LPCSTR)pByte, dwSize, NULL, 0 );
-
-        m_pstrXML = static_cast<LPTSTR>(malloc((nWide + 1)*sizeof(TCHAR)));
-        ::MultiByteToWideChar( CP_UTF8, 0, (LPCSTR)pByte, dwSize, m_pstrXML, nWide );
-        m_pstrXML[nWide] = _T('\0');
+        // 复制一份可写的UTF-8文本原位解析，字符串在访问时才转换
+        LPBYTE pText = static_cast<LPBYTE>(malloc(dwSize + 1));
+        ::CopyMemory(pText, pByte, dwSize);
+        return _LoadUtf8(pText, dwSize);
     }
     else if (encoding == XMLFILE_ENCODING_ASNI)
     {
@@ -345,18 +645,40 @@ bool CMarkup::LoadFromFile(LPCTSTR pstrFilename, int encoding)
         if ( dwSize > 4096*1024 ) return _Failed(_T("File too large"));
 
         DWORD dwRead = 0;
-        BYTE* pByte = new BYTE[ dwSize ];
+        XMLBINARYHEADER header = { 0 };
+        if( dwSize >= sizeof(header) && ::ReadFile(hFile, &header, sizeof(header), &dwRead, NULL) && _IsBinary((BYTE*)&header, dwRead) ) {
+            // 编译过的皮肤直接映射文件，不再读取和解析
+            m_hBinaryMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            ::CloseHandle( hFile );
+            if( m_hBinaryMap == NULL ) return _Failed(_T("Error mapping file"));
+            m_pBinary = static_cast<LPBYTE>(::MapViewOfFile(m_hBinaryMap, FILE_MAP_READ, 0, 0, 0));
+            if( m_pBinary == NULL ) {
+                Release();
+                return _Failed(_T("Error mapping file"));
+            }
+            bool bRes = _LoadBinary(m_pBinary, dwSize);
+            if( !bRes ) Release();
+            return bRes;
+        }
+        ::SetFilePointer( hFile, 0, NULL, FILE_BEGIN );
+
+        dwRead = 0;
+        BYTE* pByte = static_cast<BYTE*>(malloc(dwSize + 1));
         ::ReadFile( hFile, pByte, dwSize, &dwRead, NULL );
         ::CloseHandle( hFile );
         if( dwRead != dwSize ) {
-            delete[] pByte;
+            free(pByte);
 			pByte = NULL;
             Release();
             return _Failed(_T("Could not read file"));
         }
+#ifdef _UNICODE
+        // UTF-8直接在读入的缓冲区中解析，不再复制
+        if( encoding == XMLFILE_ENCODING_UTF8 && !_IsBinary(pByte, dwSize) ) return _LoadUtf8(pByte, dwSize);
+#endif
 
         bool ret = LoadFromMem(pByte, dwSize, encoding);
-        delete[] pByte;
+        free(pByte);
 		pByte = NULL;
 
         return ret;
@@ -384,30 +706,570 @@ bool CMarkup::LoadFromFile(LPCTSTR pstrFilename, int encoding)
         DWORD dwSize = ze.unc_size;
         if( dwSize == 0 ) return _Failed(_T("File is empty"));
         if ( dwSize > 4096*1024 ) return _Failed(_T("File too large"));
-        BYTE* pByte = new BYTE[ dwSize ];
+        BYTE* pByte = static_cast<BYTE*>(malloc(dwSize + 1));
         int res = UnzipItem(hz, i, pByte, dwSize);
         if( res != 0x00000000 && res != 0x00000600) {
-            delete[] pByte;
+            free(pByte);
             if( !CPaintManagerUI::IsCachedResourceZip() ) CloseZip(hz);
             return _Failed(_T("Could not unzip file"));
         }
         if( !CPaintManagerUI::IsCachedResourceZip() ) CloseZip(hz);
+#ifdef _UNICODE
+        if( encoding == XMLFILE_ENCODING_UTF8 && !_IsBinary(pByte, dwSize) ) return _LoadUtf8(pByte, dwSize);
+#endif
         bool ret = LoadFromMem(pByte, dwSize, encoding);
-        delete[] pByte;
+        free(pByte);
 		pByte = NULL;
         return ret;
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////
+//
+// 流式解析: 按块读取文件或zip项并转换为TCHAR，内存只与最大的单个标签有关
+//
+
+class CMarkupStreamReader
+{
+public:
+    enum { CHUNK_SIZE = 64 * 1024 };
+
+    CMarkupStreamReader() : m_hFile(INVALID_HANDLE_VALUE), m_hZip(NULL), m_bCloseZip(false), m_iZipItem(-1),
+        m_dwZipLeft(0), m_encoding(XMLFILE_ENCODING_UTF8), m_bFirst(true), m_bBigEndian(false), m_cbCarry(0)
+    {
+    }
+
+    ~CMarkupStreamReader()
+    {
+        if( m_hFile != INVALID_HANDLE_VALUE ) ::CloseHandle(m_hFile);
+        if( m_hZip != NULL && m_bCloseZip ) CloseZip(m_hZip);
+    }
+
+    LPCTSTR Open(LPCTSTR pstrFilename, int encoding)
+    {
+        m_encoding = encoding;
+        CDuiString sFile = CPaintManagerUI::GetResourcePath();
+        if( CPaintManagerUI::GetResourceZip().IsEmpty() ) {
+            sFile += pstrFilename;
+            m_hFile = ::CreateFile(sFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if( m_hFile == INVALID_HANDLE_VALUE ) return _T("Error opening file");
+            return NULL;
+        }
+        sFile += CPaintManagerUI::GetResourceZip();
+        if( CPaintManagerUI::IsCachedResourceZip() ) m_hZip = (HZIP)CPaintManagerUI::GetResourceZipHandle();
+        else {
+            CDuiString sFilePwd = CPaintManagerUI::GetResourceZipPwd();
+#ifdef UNICODE
+            char* pwd = w2a((wchar_t*)sFilePwd.GetData());
+            m_hZip = OpenZip(sFile.GetData(), pwd);
+            if(pwd) delete[] pwd;
+#else
+            m_hZip = OpenZip(sFile.GetData(), sFilePwd.GetData());
+#endif
+            m_bCloseZip = true;
+        }
+        if( m_hZip == NULL ) return _T("Error opening zip file");
+        ZIPENTRY ze;
+        CDuiString key = pstrFilename;
+        key.Replace(_T("\\"), _T("/"));
+        if( FindZipItem(m_hZip, key, true, &m_iZipItem, &ze) != 0 ) return _T("Could not find ziped file");
+        m_dwZipLeft = ze.unc_size;
+        return NULL;
+    }
+
+    // 读取下一块，pstrDest至少能容纳CHUNK_SIZE个字符，返回0表示结束
+    int Read(LPTSTR pstrDest)
+    {
+        for( ; ; ) {
+            DWORD cbRead = _ReadRaw(m_aRaw + m_cbCarry, CHUNK_SIZE - m_cbCarry);
+            DWORD cbData = m_cbCarry + cbRead;
+            if( cbData == 0 ) return 0;
+            bool bLast = (cbRead == 0);
+            BYTE* pByte = m_aRaw;
+            if( m_bFirst ) {
+                m_bFirst = false;
+                if( m_encoding == XMLFILE_ENCODING_UTF8 && cbData >= 3 && pByte[0] == 0xEF && pByte[1] == 0xBB && pByte[2] == 0xBF ) {
+                    pByte += 3; cbData -= 3;
+                }
+                else if( m_encoding == XMLFILE_ENCODING_UNICODE && cbData >= 2 && pByte[0] == 0xFE && pByte[1] == 0xFF ) {
+                    pByte += 2; cbData -= 2; m_bBigEndian = true;
+                }
+                else if( m_encoding == XMLFILE_ENCODING_UNICODE && cbData >= 2 && pByte[0] == 0xFF && pByte[1] == 0xFE ) {
+                    pByte += 2; cbData -= 2; m_bBigEndian = false;
+                }
+            }
+            DWORD cbUse = bLast ? cbData : _CompleteBytes(pByte, cbData);
+            int cch = _Convert(pByte, cbUse, pstrDest);
+            m_cbCarry = cbData - cbUse;
+            ::MoveMemory(m_aRaw, pByte + cbUse, m_cbCarry);
+            if( cch > 0 || bLast ) return cch;
+        }
+    }
+
+private:
+    DWORD _ReadRaw(BYTE* pByte, DWORD cbSize)
+    {
+        DWORD dwRead = 0;
+        if( m_hFile != INVALID_HANDLE_VALUE ) {
+            if( !::ReadFile(m_hFile, pByte, cbSize, &dwRead, NULL) ) return 0;
+            return dwRead;
+        }
+        if( m_hZip == NULL || m_dwZipLeft == 0 ) return 0;
+        // 反复调用UnzipItem，返回ZR_MORE说明缓冲区已填满
+        ZRESULT res = UnzipItem(m_hZip, m_iZipItem, pByte, cbSize);
+        if( res == ZR_MORE ) dwRead = cbSize;
+        else if( res == ZR_OK ) dwRead = m_dwZipLeft;
+        else return 0;
+        if( dwRead > m_dwZipLeft ) dwRead = m_dwZipLeft;
+        m_dwZipLeft -= dwRead;
+        return dwRead;
+    }
+
+    // 不把被块边界截断的多字节字符交给转换函数
+    DWORD _CompleteBytes(const BYTE* pByte, DWORD cbData) const
+    {
+        if( m_encoding == XMLFILE_ENCODING_UNICODE ) return cbData & ~1;
+        if( m_encoding == XMLFILE_ENCODING_UTF8 ) {
+            DWORD i = cbData;
+            while( i > 0 && cbData - i < 3 && (pByte[i - 1] & 0xC0) == 0x80 ) i--;
+            if( i == 0 || pByte[i - 1] < 0xC0 ) return cbData;
+            DWORD cbNeed = pByte[i - 1] >= 0xF0 ? 4 : (pByte[i - 1] >= 0xE0 ? 3 : 2);
+            return (cbData - (i - 1) < cbNeed) ? i - 1 : cbData;
+        }
+        DWORD j = 0;
+        while( j < cbData ) {
+            if( ::IsDBCSLeadByte(pByte[j]) ) {
+                if( j + 1 >= cbData ) return j;
+                j += 2;
+            }
+            else j++;
+        }
+        return cbData;
+    }
+
+    int _Convert(BYTE* pByte, DWORD cbSize, LPTSTR pstrDest)
+    {
+        if( cbSize == 0 ) return 0;
+        LPCWSTR pwstr = NULL;
+        int cchWide = 0;
+        if( m_encoding == XMLFILE_ENCODING_UNICODE ) {
+            if( m_bBigEndian ) {
+                for( DWORD i = 0; i + 1 < cbSize; i += 2 ) {
+                    BYTE nTemp = pByte[i];
+                    pByte[i] = pByte[i + 1];
+                    pByte[i + 1] = nTemp;
+                }
+            }
+            pwstr = (LPCWSTR)pByte;
+            cchWide = cbSize / 2;
+        }
+        else {
+#ifdef _UNICODE
+            return ::MultiByteToWideChar(m_encoding == XMLFILE_ENCODING_UTF8 ? CP_UTF8 : CP_ACP, 0, (LPCSTR)pByte, cbSize, pstrDest, CHUNK_SIZE);
+#else
+            if( m_encoding == XMLFILE_ENCODING_ASNI ) {
+                ::CopyMemory(pstrDest, pByte, cbSize);
+                return cbSize;
+            }
+            cchWide = ::MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)pByte, cbSize, m_aWide, CHUNK_SIZE);
+            pwstr = m_aWide;
+#endif
+        }
+#ifdef _UNICODE
+        ::CopyMemory(pstrDest, pwstr, cchWide * sizeof(WCHAR));
+        return cchWide;
+#else
+        return ::WideCharToMultiByte(CP_ACP, 0, pwstr, cchWide, pstrDest, CHUNK_SIZE, NULL, NULL);
+#endif
+    }
+
+    HANDLE m_hFile;
+    HZIP m_hZip;
+    bool m_bCloseZip;
+    int m_iZipItem;
+    DWORD m_dwZipLeft;
+    int m_encoding;
+    bool m_bFirst;
+    bool m_bBigEndian;
+    DWORD m_cbCarry;
+    BYTE m_aRaw[CHUNK_SIZE];
+#ifndef _UNICODE
+    WCHAR m_aWide[CHUNK_SIZE];
+#endif
+};
+
+bool CMarkup::ParseStream(LPCTSTR pstrFilename, IMarkupHandler* pHandler, int encoding)
+{
+    ::ZeroMemory(m_szErrorMsg, sizeof(m_szErrorMsg));
+    ::ZeroMemory(m_szErrorXML, sizeof(m_szErrorXML));
+    if( pHandler == NULL ) return _Failed(_T("No markup handler"));
+    CMarkupStreamReader* pReader = new CMarkupStreamReader;
+    LPCTSTR pstrError = pReader->Open(pstrFilename, encoding);
+    if( pstrError != NULL ) {
+        delete pReader;
+        return _Failed(pstrError);
+    }
+
+    int cchAlloc = CMarkupStreamReader::CHUNK_SIZE * 2;
+    LPTSTR pstrBuffer = static_cast<LPTSTR>(malloc((cchAlloc + 1) * sizeof(TCHAR)));
+    int cchData = 0;
+    int iPos = 0;
+    int iScan = 0;
+    bool bQuote = false;
+    bool bEof = false;
+    bool bRes = true;
+    CStdPtrArray aNames;
+    pstrBuffer[0] = _T('\0');
+
+    for( ; ; ) {
+        // 在[iPos, cchData)中找一个完整的单元: 文本、标签、注释或处理指令
+        LPTSTR pstrText = pstrBuffer + iPos;
+        LPTSTR pstrEnd = NULL;
+        LPTSTR pstr = pstrBuffer + iScan;
+        if( *pstrText != _T('<') ) {
+            pstrEnd = _ScanUntil(pstr, _T('<'), _T('<'), _T('<'));
+            if( *pstrEnd == _T('\0') && !bEof ) pstrEnd = NULL;
+        }
+        else if( pstrText[1] == _T('!') || pstrText[1] == _T('?') ) {
+            TCHAR ch = (pstrText[1] == _T('!')) ? _T('-') : _T('?');
+            if( pstr < pstrText + 2 ) pstr = pstrText + 2;
+            for( ; ; ) {
+                pstr = _ScanUntil(pstr, ch, ch, ch);
+                if( *pstr == _T('\0') ) break;
+                if( pstr[1] == _T('>') ) { pstrEnd = pstr + 2; break; }
+                if( pstr[1] == _T('\0') ) break;
+                pstr++;
+            }
+        }
+        else if( pstrText[1] != _T('\0') ) {
+            // 引号内的'>'不结束标签；续读时从上次扫描到的位置和引号状态接着扫描
+            if( pstr < pstrText + 1 ) pstr = pstrText + 1;
+            for( ; ; ) {
+                pstr = _ScanUntil(pstr, _T('>'), _T('\"'), _T('\"'));
+                if( *pstr == _T('\0') ) break;
+                if( *pstr == _T('\"') ) bQuote = !bQuote;
+                else if( !bQuote ) { pstrEnd = pstr + 1; break; }
+                pstr++;
+            }
+        }
+
+        if( pstrEnd == NULL ) {
+            if( bEof ) {
+                if( iPos < cchData ) bRes = _Failed(_T("Unexpected end of file"), pstrText);
+                else if( aNames.GetSize() > 1 ) bRes = _Failed(_T("Unexpected end of file"));
+                break;
+            }
+            // 单元不完整，把它移到缓冲区开头后续读一块
+            cchData -= iPos;
+            ::MoveMemory(pstrBuffer, pstrBuffer + iPos, cchData * sizeof(TCHAR));
+            iScan = (int)(pstr - pstrBuffer) - iPos;
+            if( iScan < 0 ) iScan = 0;
+            iPos = 0;
+            if( cchData + CMarkupStreamReader::CHUNK_SIZE > cchAlloc ) {
+                cchAlloc = cchData + CMarkupStreamReader::CHUNK_SIZE * 2;
+                pstrBuffer = static_cast<LPTSTR>(realloc(pstrBuffer, (cchAlloc + 1) * sizeof(TCHAR)));
+            }
+            int cchRead = pReader->Read(pstrBuffer + cchData);
+            if( cchRead == 0 ) bEof = true;
+            cchData += cchRead;
+            pstrBuffer[cchData] = _T('\0');
+            continue;
+        }
+
+        iPos = (int)(pstrEnd - pstrBuffer);
+        iScan = iPos;
+        bQuote = false;
+        if( *pstrText != _T('<') ) {
+            // 文本在解码时写入'\0'，先保存结束符
+            TCHAR chEnd = *pstrEnd;
+            LPTSTR pstrDest = pstrText;
+            LPTSTR pstrData = pstrText;
+            _ParseData(pstrData, pstrDest, _T('<'));
+            *pstrDest = _T('\0');
+            LPCTSTR pstrCheck = pstrText;
+            _SkipWhitespace(pstrCheck);
+            if( *pstrCheck != _T('\0') ) {
+                if( aNames.IsEmpty() ) {
+                    bRes = _Failed(_T("Expected start tag"), pstrCheck);
+                    break;
+                }
+                if( !pHandler->OnText(pstrText) ) break;
+            }
+            *pstrEnd = chEnd;
+        }
+        else if( pstrText[1] != _T('!') && pstrText[1] != _T('?') ) {
+            pstrEnd[-1] = _T('\0');
+            if( !_ParseStreamTag(pstrText, pHandler, aNames) ) {
+                bRes = (m_szErrorMsg[0] == _T('\0'));
+                break;
+            }
+        }
+        if( iPos >= cchData && bEof ) {
+            if( aNames.GetSize() > 1 ) bRes = _Failed(_T("Unexpected end of file"));
+            break;
+        }
+    }
+
+    for( int i = 0; i < aNames.GetSize(); i++ ) delete static_cast<CDuiString*>(aNames[i]);
+    free(pstrBuffer);
+    delete pReader;
+    return bRes;
+}
+
+// pstrText指向'<'，结尾的'>'已替换为'\0'；返回false时m_szErrorMsg为空表示回调要求停止
+bool CMarkup::_ParseStreamTag(LPTSTR pstrText, IMarkupHandler* pHandler, CStdPtrArray& aNames)
+{
+    pstrText++;
+    if( *pstrText == _T('/') ) {
+        pstrText++;
+        _SkipWhitespace(pstrText);
+        LPTSTR pstrName = pstrText;
+        _SkipIdentifier(pstrText);
+        LPTSTR pstrNameEnd = pstrText;
+        _SkipWhitespace(pstrText);
+        if( *pstrText != _T('\0') || aNames.IsEmpty() ) return _Failed(_T("Unmatched closing tag"), pstrName);
+        *pstrNameEnd = _T('\0');
+        CDuiString* pOpen = static_cast<CDuiString*>(aNames[aNames.GetSize() - 1]);
+        if( *pOpen != pstrName ) return _Failed(_T("Unmatched closing tag"), pstrName);
+        bool bContinue = pHandler->OnEndElement(pstrName);
+        delete pOpen;
+        aNames.Remove(aNames.GetSize() - 1);
+        return bContinue;
+    }
+
+    _SkipWhitespace(pstrText);
+    LPTSTR pstrName = pstrText;
+    _SkipIdentifier(pstrText);
+    LPTSTR pstrNameEnd = pstrText;
+    if( pstrName == pstrNameEnd ) return _Failed(_T("Error parsing element name"), pstrName);
+    // 先收集属性再回调，名字的结尾要等属性解析完才能写'\0'
+    CStdPtrArray aAttributes;
+    bool bClosed = false;
+    for( ; ; ) {
+        _SkipWhitespace(pstrText);
+        if( *pstrText == _T('\0') ) break;
+        if( *pstrText == _T('/') ) {
+            pstrText++;
+            _SkipWhitespace(pstrText);
+            if( *pstrText != _T('\0') ) return _Failed(_T("Expected start-tag closing"), pstrText);
+            bClosed = true;
+            break;
+        }
+        LPTSTR pstrAttrName = pstrText;
+        _SkipIdentifier(pstrText);
+        LPTSTR pstrAttrNameEnd = pstrText;
+        _SkipWhitespace(pstrText);
+        if( pstrAttrName == pstrAttrNameEnd || *pstrText != _T('=') ) return _Failed(_T("Error while parsing attributes"), pstrText);
+        pstrText++;
+        _SkipWhitespace(pstrText);
+        if( *pstrText++ != _T('\"') ) return _Failed(_T("Expected attribute value"), pstrText);
+        LPTSTR pstrValue = pstrText;
+        LPTSTR pstrDest = pstrText;
+        _ParseData(pstrText, pstrDest, _T('\"'));
+        if( *pstrText == _T('\0') ) return _Failed(_T("Error while parsing attribute string"), pstrText);
+        pstrText++;
+        *pstrDest = _T('\0');
+        *pstrAttrNameEnd = _T('\0');
+        aAttributes.Add(pstrAttrName);
+        aAttributes.Add(pstrValue);
+    }
+    *pstrNameEnd = _T('\0');
+
+    if( !pHandler->OnStartElement(pstrName) ) return false;
+    for( int i = 0; i + 1 < aAttributes.GetSize(); i += 2 ) {
+        if( !pHandler->OnAttribute(static_cast<LPCTSTR>(aAttributes[i]), static_cast<LPCTSTR>(aAttributes[i + 1])) ) return false;
+    }
+    if( bClosed ) return pHandler->OnEndElement(pstrName);
+    aNames.Add(new CDuiString(pstrName));
+    return true;
+}
+
 void CMarkup::Release()
 {
-    if( m_pstrXML != NULL ) free(m_pstrXML);
-    if( m_pElements != NULL ) free(m_pElements);
+    if( m_hBinaryMap != NULL ) {
+        if( m_pBinary != NULL ) ::UnmapViewOfFile(m_pBinary);
+        ::CloseHandle(m_hBinaryMap);
+    }
+    else if( m_pBinary != NULL ) {
+        free(m_pBinary);
+    }
+    else {
+        if( m_pstrXML != NULL ) free(m_pstrXML);
+        if( m_pstrUtf8 != NULL ) free(m_pstrUtf8);
+        if( m_pstrUtf8Wide != NULL ) ::VirtualFree(m_pstrUtf8Wide, 0, MEM_RELEASE);
+        if( m_pUtf8WidePages != NULL ) free(m_pUtf8WidePages);
+        if( m_pElements != NULL ) free(m_pElements);
+        if( m_pAttributeIndex != NULL ) free(m_pAttributeIndex);
+        if( m_pAttributes != NULL ) free(m_pAttributes);
+    }
+    if( m_pAttributeHash != NULL ) free(m_pAttributeHash);
     m_pstrXML = NULL;
+    m_pstrUtf8 = NULL;
+    m_pstrUtf8Wide = NULL;
+    m_pUtf8WidePages = NULL;
     m_pElements = NULL;
     m_nElements = 0;
+    m_pAttributeIndex = NULL;
+    m_pAttributes = NULL;
+    m_nAttributes = 0;
+    m_pAttributeHash = NULL;
+    m_nAttributeHashMask = 0;
+    m_pBinary = NULL;
+    m_hBinaryMap = NULL;
+}
+
+static ULONG _InternString(LPCTSTR pstr, CStdStringPtrMap& mapStrings, std::vector<TCHAR>& aStrings)
+{
+    LPVOID pData = mapStrings.Find(pstr, false);
+    if( pData != NULL ) return (ULONG)((UINT_PTR)pData - 1);
+    ULONG iPos = (ULONG)aStrings.size();
+    aStrings.insert(aStrings.end(), pstr, pstr + _tcslen(pstr) + 1);
+    mapStrings.Insert(pstr, (LPVOID)(UINT_PTR)(iPos + 1));
+    return iPos;
+}
+
+bool CMarkup::SaveToBinary(LPCTSTR pstrFilename)
+{
+    if( !IsValid() ) return _Failed(_T("No document loaded"));
+
+    CStdStringPtrMap mapStrings(m_nElements + 83);
+    std::vector<TCHAR> aStrings;
+    std::vector<XMLELEMENT> aElements(m_pElements, m_pElements + m_nElements);
+    std::vector<ULONG> aIndex;
+    std::vector<XMLATTRIBUTE> aAttributes;
+    aIndex.reserve(m_nElements + 1);
+    aAttributes.reserve(m_nAttributes);
+
+    // 0号元素保留，偏移0为空串
+    _InternString(_T(""), mapStrings, aStrings);
+    ::ZeroMemory(&aElements[0], sizeof(XMLELEMENT));
+    aIndex.push_back(0);
+    for( ULONG i = 1; i < m_nElements; i++ ) {
+        aIndex.push_back((ULONG)aAttributes.size());
+        aElements[i].iStart = _InternString(_GetString(m_pElements[i].iStart), mapStrings, aStrings);
+        aElements[i].iData = _InternString(_GetString(m_pElements[i].iData), mapStrings, aStrings);
+        for( ULONG j = m_pAttributeIndex[i]; j < m_pAttributeIndex[i + 1]; j++ ) {
+            XMLATTRIBUTE attr = m_pAttributes[j];
+            attr.iName = _InternString(_GetString(m_pAttributes[j].iName), mapStrings, aStrings);
+            attr.iValue = _InternString(_GetString(m_pAttributes[j].iValue), mapStrings, aStrings);
+            aAttributes.push_back(attr);
+        }
+    }
+    aIndex.push_back((ULONG)aAttributes.size());
+
+    XMLBINARYHEADER header = { 0 };
+    header.dwMagic = XMLBINARY_MAGIC;
+    header.wVersion = XMLBINARY_VERSION;
+    header.cbChar = sizeof(TCHAR);
+    header.nElements = m_nElements;
+    header.nAttributes = (DWORD)aAttributes.size();
+    header.cchStrings = (DWORD)aStrings.size();
+
+    HANDLE hFile = ::CreateFile(pstrFilename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if( hFile == INVALID_HANDLE_VALUE ) return _Failed(_T("Error creating file"));
+    DWORD dwWritten = 0;
+    bool bRes = ::WriteFile(hFile, &header, sizeof(header), &dwWritten, NULL)
+        && ::WriteFile(hFile, &aElements[0], (DWORD)(aElements.size() * sizeof(XMLELEMENT)), &dwWritten, NULL)
+        && ::WriteFile(hFile, &aIndex[0], (DWORD)(aIndex.size() * sizeof(ULONG)), &dwWritten, NULL)
+        && (aAttributes.empty() || ::WriteFile(hFile, &aAttributes[0], (DWORD)(aAttributes.size() * sizeof(XMLATTRIBUTE)), &dwWritten, NULL))
+        && ::WriteFile(hFile, &aStrings[0], (DWORD)(aStrings.size() * sizeof(TCHAR)), &dwWritten, NULL);
+    ::CloseHandle(hFile);
+    if( !bRes ) return _Failed(_T("Error writing file"));
+    return true;
 }
 
+bool CMarkup::_IsBinary(const BYTE* pByte, DWORD dwSize)
+{
+    return pByte != NULL && dwSize >= sizeof(XMLBINARYHEADER) && reinterpret_cast<const XMLBINARYHEADER*>(pByte)->dwMagic == XMLBINARY_MAGIC;
+}
+
+bool CMarkup::_LoadBinary(LPBYTE pByte, DWORD dwSize)
+{
+    const XMLBINARYHEADER* pHeader = reinterpret_cast<const XMLBINARYHEADER*>(pByte);
+    if( pHeader->wVersion != XMLBINARY_VERSION ) return _Failed(_T("Unsupported binary skin version"));
+    if( pHeader->cbChar != sizeof(TCHAR) ) return _Failed(_T("Binary skin character size mismatch"));
+    if( pHeader->nElements < 2 || pHeader->cchStrings == 0 ) return _Failed(_T("Binary skin is empty"));
+    ULONGLONG cbNeed = sizeof(XMLBINARYHEADER)
+        + (ULONGLONG)pHeader->nElements * sizeof(XMLELEMENT)
+        + ((ULONGLONG)pHeader->nElements + 1) * sizeof(ULONG)
+        + (ULONGLONG)pHeader->nAttributes * sizeof(XMLATTRIBUTE)
+        + (ULONGLONG)pHeader->cchStrings * sizeof(TCHAR);
+    if( cbNeed > dwSize ) return _Failed(_T("Binary skin is truncated"));
+
+    LPBYTE pData = pByte + sizeof(XMLBINARYHEADER);
+    m_pElements = reinterpret_cast<XMLELEMENT*>(pData);
+    pData += pHeader->nElements * sizeof(XMLELEMENT);
+    m_pAttributeIndex = reinterpret_cast<ULONG*>(pData);
+    pData += (pHeader->nElements + 1) * sizeof(ULONG);
+    m_pAttributes = reinterpret_cast<XMLATTRIBUTE*>(pData);
+    pData += pHeader->nAttributes * sizeof(XMLATTRIBUTE);
+    m_pstrXML = reinterpret_cast<LPTSTR>(pData);
+    if( !_ValidateBinary(pHeader) ) return false;
+    m_nElements = pHeader->nElements;
+    m_nReservedElements = m_nElements;
+    m_nAttributes = pHeader->nAttributes;
+    _BuildAttributeHash();
+    return true;
+}
+
+// 编译过的皮肤可能来自损坏或被截断的文件，所有下标都要在范围内才能直接使用
+// 元素按文档顺序编号：父元素在前，子元素和下一个兄弟在后，这样沿任何链接遍历都不会成环
+bool CMarkup::_ValidateBinary(const XMLBINARYHEADER* pHeader)
+{
+    ULONG nElements = pHeader->nElements;
+    ULONG nAttributes = pHeader->nAttributes;
+    ULONG cchStrings = pHeader->cchStrings;
+    if( m_pstrXML[cchStrings - 1] != _T('\0') ) return _Failed(_T("Binary skin string pool is corrupt"));
+    if( m_pAttributeIndex[0] != 0 || m_pAttributeIndex[nElements] != nAttributes ) return _Failed(_T("Binary skin attribute table is corrupt"));
+    for( ULONG i = 1; i < nElements; i++ ) {
+        const XMLELEMENT& el = m_pElements[i];
+        if( el.iStart >= cchStrings || el.iData >= cchStrings ) return _Failed(_T("Binary skin element is corrupt"));
+        if( el.iParent >= i || (el.iChild != 0 && (el.iChild <= i || el.iChild >= nElements))
+            || (el.iNext != 0 && (el.iNext <= i || el.iNext >= nElements)) ) return _Failed(_T("Binary skin element is corrupt"));
+        if( m_pAttributeIndex[i] < m_pAttributeIndex[i - 1] || m_pAttributeIndex[i] > m_pAttributeIndex[i + 1] ) {
+            return _Failed(_T("Binary skin attribute table is corrupt"));
+        }
+    }
+    for( ULONG i = 0; i < nAttributes; i++ ) {
+        if( m_pAttributes[i].iName >= cchStrings || m_pAttributes[i].iValue >= cchStrings ) return _Failed(_T("Binary skin attribute is corrupt"));
+    }
+    return true;
+}
+
+#ifdef _UNICODE
+bool CMarkup::_LoadUtf8(LPBYTE pByte, DWORD dwSize)
+{
+    // 接管pByte(malloc分配，至少dwSize + 1字节)，直接在其中解析
+    m_pstrUtf8 = reinterpret_cast<LPSTR>(pByte);
+    m_pstrUtf8[dwSize] = '\0';
+    if( dwSize >= 3 && pByte[0] == 0xEF && pByte[1] == 0xBB && pByte[2] == 0xBF ) ::FillMemory(pByte, 3, ' ');
+    // 影子缓冲区只保留地址空间，_GetString转换字符串前才提交它所在的页（系统提交时清零），
+    // 只有访问过的字符串所在的页才占用内存
+    m_pstrUtf8Wide = static_cast<LPWSTR>(::VirtualAlloc(NULL, (dwSize + 1) * sizeof(WCHAR), MEM_RESERVE, PAGE_READWRITE));
+    m_pUtf8WidePages = static_cast<LPBYTE>(calloc(((dwSize + 1) * sizeof(WCHAR) + UTF8_WIDE_PAGE - 1) / UTF8_WIDE_PAGE, 1));
+    if( m_pstrUtf8Wide == NULL || m_pUtf8WidePages == NULL ) {
+        Release();
+        return _Failed(_T("Out of memory"));
+    }
+    bool bRes = _Parse();
+    if( !bRes ) Release();
+    return bRes;
+}
+
+bool CMarkup::_CommitUtf8Wide(ULONG iPos, ULONG cch) const
+{
+    // 提交影子缓冲区中第iPos个字符起的cch个字符及结尾'\0'所在的页，已提交的页重复提交不会清零
+    ULONG iFirst = iPos * sizeof(WCHAR) / UTF8_WIDE_PAGE;
+    ULONG iLast = (iPos + cch) * sizeof(WCHAR) / UTF8_WIDE_PAGE;
+    while( iFirst <= iLast && m_pUtf8WidePages[iFirst] != 0 ) iFirst++;
+    if( iFirst > iLast ) return true;
+    LPBYTE pPage = reinterpret_cast<LPBYTE>(m_pstrUtf8Wide) + iFirst * UTF8_WIDE_PAGE;
+    if( ::VirtualAlloc(pPage, (iLast - iFirst + 1) * UTF8_WIDE_PAGE, MEM_COMMIT, PAGE_READWRITE) == NULL ) return false;
+    ::FillMemory(m_pUtf8WidePages + iFirst, iLast - iFirst + 1, 1);
+    return true;
+}
+#endif // _UNICODE
+
 void CMarkup::GetLastErrorMessage(LPTSTR pstrMessage, SIZE_T cchMax) const
 {
     _tcsncpy(pstrMessage, m_szErrorMsg, cchMax);
@@ -420,37 +1282,75 @@ void CMarkup::GetLastErrorLocation(LPTSTR pstrSource, SIZE_T cchMax) const
 
 CMarkupNode CMarkup::GetRoot()
 {
-    if( m_nElements == 0 ) return CMarkupNode();
+    // 0号元素保留，空文档或只有注释的文档没有根元素
+    if( m_nElements < 2 ) return CMarkupNode();
     return CMarkupNode(this, 1);
 }
 
+LPCTSTR CMarkup::_GetString(ULONG iPos) const
+{
+#ifdef _UNICODE
+    if( m_pstrUtf8 != NULL ) {
+        // 解析后每个字符串都以'\0'结尾且互不重叠，宽字符数不超过字节数，
+        // 所以译文放在影子缓冲区的相同偏移处不会覆盖其它字符串；所在页已提交且首字符非0即已转换
+        if( m_pstrUtf8[iPos] == '\0' ) return _T("");
+        LPWSTR pstrWide = m_pstrUtf8Wide + iPos;
+        if( m_pUtf8WidePages[iPos * sizeof(WCHAR) / UTF8_WIDE_PAGE] == 0 || *pstrWide == L'\0' ) {
+            int cchUtf8 = (int)strlen(m_pstrUtf8 + iPos);
+            if( !_CommitUtf8Wide(iPos, cchUtf8) ) return _T("");
+            int cchWide = ::MultiByteToWideChar(CP_UTF8, 0, m_pstrUtf8 + iPos, cchUtf8, pstrWide, cchUtf8);
+            pstrWide[cchWide] = L'\0';
+        }
+        return pstrWide;
+    }
+#endif
+    return m_pstrXML + iPos;
+}
+
 bool CMarkup::_Parse()
 {
     _ReserveElement(); // Reserve index 0 for errors
     ::ZeroMemory(m_szErrorMsg, sizeof(m_szErrorMsg));
     ::ZeroMemory(m_szErrorXML, sizeof(m_szErrorXML));
-    LPTSTR pstrXML = m_pstrXML;
-    return _Parse(pstrXML, 0);
+#ifdef _UNICODE
+    if( m_pstrUtf8 != NULL ) {
+        LPSTR pstrUtf8 = m_pstrUtf8;
+        if( !_Parse(pstrUtf8, m_pstrUtf8, 0) ) return false;
+    }
+    else
+#endif
+    {
+        LPTSTR pstrXML = m_pstrXML;
+        if( !_Parse(pstrXML, m_pstrXML, 0) ) return false;
+    }
+    m_pAttributeIndex[m_nElements] = m_nAttributes;
+    _BuildAttributeHash();
+    return true;
 }
 
-bool CMarkup::_Parse(LPTSTR& pstrText, ULONG iParent)
+template<typename T>
+bool CMarkup::_Parse(T*& pstrText, const T* pstrBase, ULONG iParent)
 {
     _SkipWhitespace(pstrText);
     ULONG iPrevious = 0;
     for( ; ; ) 
     {
-        if( *pstrText == _T('\0') && iParent <= 1 ) return true;
+        if( *pstrText == '\0' && iParent <= 1 ) return true;
         _SkipWhitespace(pstrText);
-        if( *pstrText != _T('<') ) return _Failed(_T("Expected start tag"), pstrText);
-        if( pstrText[1] == _T('/') ) return true;
-        *pstrText++ = _T('\0');
+        if( *pstrText != '<' ) return _Failed(_T("Expected start tag"), pstrText);
+        if( pstrText[1] == '/' ) return true;
+        *pstrText++ = '\0';
         _SkipWhitespace(pstrText);
         // Skip comment or processing directive
-        if( *pstrText == _T('!') || *pstrText == _T('?') ) {
-            TCHAR ch = *pstrText;
-            if( *pstrText == _T('!') ) ch = _T('-');
-            while( *pstrText != _T('\0') && !(*pstrText == ch && *(pstrText + 1) == _T('>')) ) pstrText = ::CharNext(pstrText);
-            if( *pstrText != _T('\0') ) pstrText += 2;
+        if( *pstrText == '!' || *pstrText == '?' ) {
+            T ch = *pstrText;
+            if( *pstrText == '!' ) ch = '-';
+            for( ; ; ) {
+                pstrText = _ScanUntil(pstrText, ch, ch, ch);
+                if( *pstrText == '\0' || *(pstrText + 1) == '>' ) break;
+                pstrText += _CharLength(pstrText);
+            }
+            if( *pstrText != '\0' ) pstrText += 2;
             _SkipWhitespace(pstrText);
             continue;
         }
@@ -458,54 +1358,54 @@ bool CMarkup::_Parse(LPTSTR& pstrText, ULONG iParent)
         // Fill out element structure
         XMLELEMENT* pEl = _ReserveElement();
         ULONG iPos = pEl - m_pElements;
-        pEl->iStart = pstrText - m_pstrXML;
+        pEl->iStart = pstrText - pstrBase;
         pEl->iParent = iParent;
         pEl->iNext = pEl->iChild = 0;
         if( iPrevious != 0 ) m_pElements[iPrevious].iNext = iPos;
         else if( iParent > 0 ) m_pElements[iParent].iChild = iPos;
         iPrevious = iPos;
         // Parse name
-        LPCTSTR pstrName = pstrText;
+        const T* pstrName = pstrText;
         _SkipIdentifier(pstrText);
-        LPTSTR pstrNameEnd = pstrText;
-        if( *pstrText == _T('\0') ) return _Failed(_T("Error parsing element name"), pstrText);
+        T* pstrNameEnd = pstrText;
+        if( *pstrText == '\0' ) return _Failed(_T("Error parsing element name"), pstrText);
         // Parse attributes
-        if( !_ParseAttributes(pstrText) ) return false;
+        if( !_ParseAttributes(pstrText, pstrBase) ) return false;
         _SkipWhitespace(pstrText);
-        if( pstrText[0] == _T('/') && pstrText[1] == _T('>') )
+        if( pstrText[0] == '/' && pstrText[1] == '>' )
         {
-            pEl->iData = pstrText - m_pstrXML;
-            *pstrText = _T('\0');
+            pEl->iData = pstrText - pstrBase;
+            *pstrText = '\0';
             pstrText += 2;
         }
         else
         {
-            if( *pstrText != _T('>') ) return _Failed(_T("Expected start-tag closing"), pstrText);
+            if( *pstrText != '>' ) return _Failed(_T("Expected start-tag closing"), pstrText);
             // Parse node data
-            pEl->iData = ++pstrText - m_pstrXML;
-            LPTSTR pstrDest = pstrText;
-            if( !_ParseData(pstrText, pstrDest, _T('<')) ) return false;
+            pEl->iData = ++pstrText - pstrBase;
+            T* pstrDest = pstrText;
+            if( !_ParseData(pstrText, pstrDest, '<') ) return false;
             // Determine type of next element
-            if( *pstrText == _T('\0') && iParent <= 1 ) return true;
-            if( *pstrText != _T('<') ) return _Failed(_T("Expected end-tag start"), pstrText);
-            if( pstrText[0] == _T('<') && pstrText[1] != _T('/') ) 
+            if( *pstrText == '\0' && iParent <= 1 ) return true;
+            if( *pstrText != '<' ) return _Failed(_T("Expected end-tag start"), pstrText);
+            if( pstrText[0] == '<' && pstrText[1] != '/' ) 
             {
-                if( !_Parse(pstrText, iPos) ) return false;
+                if( !_Parse(pstrText, pstrBase, iPos) ) return false;
             }
-            if( pstrText[0] == _T('<') && pstrText[1] == _T('/') ) 
+            if( pstrText[0] == '<' && pstrText[1] == '/' ) 
             {
-                *pstrDest = _T('\0');
-                *pstrText = _T('\0');
+                *pstrDest = '\0';
+                *pstrText = '\0';
                 pstrText += 2;
                 _SkipWhitespace(pstrText);
                 SIZE_T cchName = pstrNameEnd - pstrName;
-                if( _tcsncmp(pstrText, pstrName, cchName) != 0 ) return _Failed(_T("Unmatched closing tag"), pstrText);
+                if( _CompareName(pstrText, pstrName, cchName) != 0 ) return _Failed(_T("Unmatched closing tag"), pstrText);
                 pstrText += cchName;
                 _SkipWhitespace(pstrText);
-                if( *pstrText++ != _T('>') ) return _Failed(_T("Unmatched closing tag"), pstrText);
+                if( *pstrText++ != '>' ) return _Failed(_T("Unmatched closing tag"), pstrText);
             }
         }
-        *pstrNameEnd = _T('\0');
+        *pstrNameEnd = '\0';
         _SkipWhitespace(pstrText);
     }
 }
@@ -516,113 +1416,198 @@ CMarkup::XMLELEMENT* CMarkup::_ReserveElement()
     if( m_nElements >= m_nReservedElements ) {
         m_nReservedElements += (m_nReservedElements / 2) + 500;
         m_pElements = static_cast<XMLELEMENT*>(realloc(m_pElements, m_nReservedElements * sizeof(XMLELEMENT)));
+        m_pAttributeIndex = static_cast<ULONG*>(realloc(m_pAttributeIndex, (m_nReservedElements + 1) * sizeof(ULONG)));
     }
+    // 元素按文档顺序编号，属性也按顺序追加，元素的属性区间为 [m_pAttributeIndex[i], m_pAttributeIndex[i + 1])
+    m_pAttributeIndex[m_nElements] = m_nAttributes;
     return &m_pElements[m_nElements++];
 }
 
-void CMarkup::_SkipWhitespace(LPCTSTR& pstr) const
+CMarkup::XMLATTRIBUTE* CMarkup::_ReserveAttribute()
 {
-    while( *pstr > _T('\0') && *pstr <= _T(' ') ) pstr = ::CharNext(pstr);
+    if( m_nAttributes == 0 ) m_nReservedAttributes = 0;
+    if( m_nAttributes >= m_nReservedAttributes ) {
+        m_nReservedAttributes += (m_nReservedAttributes / 2) + 1000;
+        m_pAttributes = static_cast<XMLATTRIBUTE*>(realloc(m_pAttributes, m_nReservedAttributes * sizeof(XMLATTRIBUTE)));
+    }
+    return &m_pAttributes[m_nAttributes++];
 }
 
-void CMarkup::_SkipWhitespace(LPTSTR& pstr) const
+ULONG CMarkup::_HashName(LPCTSTR pstrName)
 {
-    while( *pstr > _T('\0') && *pstr <= _T(' ') ) pstr = ::CharNext(pstr);
+    // 与_tcsicmp一致，不区分大小写
+    ULONG nHash = 2166136261UL;
+    for( ; *pstrName != _T('\0'); pstrName++ ) {
+        TCHAR ch = *pstrName;
+        if( ch >= _T('A') && ch <= _T('Z') ) ch += _T('a') - _T('A');
+#ifdef _UNICODE
+        else if( ch >= 0x80 ) ch = (TCHAR)towlower(ch);
+#endif
+        nHash = (nHash ^ (ULONG)ch) * 16777619UL;
+    }
+    return nHash;
 }
 
-void CMarkup::_SkipIdentifier(LPCTSTR& pstr) const
+#ifdef _UNICODE
+ULONG CMarkup::_HashName(LPCSTR pstrName)
 {
-    // 属性只能用英文，所以这样处理没有问题
-    while( *pstr != _T('\0') && (*pstr == _T('_') || *pstr == _T(':') || _istalnum(*pstr)) ) pstr = ::CharNext(pstr);
+    // 必须与宽字符名字的哈希相同，含非ASCII字符时先转换
+    ULONG nHash = 2166136261UL;
+    for( LPCSTR pstr = pstrName; *pstr != '\0'; pstr++ ) {
+        char ch = *pstr;
+        if( (BYTE)ch >= 0x80 ) {
+            int cchWide = ::MultiByteToWideChar(CP_UTF8, 0, pstrName, -1, NULL, 0);
+            LPWSTR pstrWide = static_cast<LPWSTR>(malloc(cchWide * sizeof(WCHAR)));
+            ::MultiByteToWideChar(CP_UTF8, 0, pstrName, -1, pstrWide, cchWide);
+            nHash = _HashName(pstrWide);
+            free(pstrWide);
+            return nHash;
+        }
+        if( ch >= 'A' && ch <= 'Z' ) ch += 'a' - 'A';
+        nHash = (nHash ^ (ULONG)ch) * 16777619UL;
+    }
+    return nHash;
 }
+#endif // _UNICODE
 
-void CMarkup::_SkipIdentifier(LPTSTR& pstr) const
+void CMarkup::_BuildAttributeHash()
 {
-    // 属性只能用英文，所以这样处理没有问题
-    while( *pstr != _T('\0') && (*pstr == _T('_') || *pstr == _T(':') || _istalnum(*pstr)) ) pstr = ::CharNext(pstr);
+    // 开放寻址，装载因子不超过1/2
+    ULONG nSize = 16;
+    while( nSize < m_nAttributes * 2 ) nSize <<= 1;
+    m_pAttributeHash = static_cast<ULONG*>(calloc(nSize, sizeof(ULONG)));
+    m_nAttributeHashMask = nSize - 1;
+    for( ULONG iPos = 1; iPos < m_nElements; iPos++ ) {
+        for( ULONG i = m_pAttributeIndex[iPos]; i < m_pAttributeIndex[iPos + 1]; i++ ) {
+            ULONG iSlot = (m_pAttributes[i].nHash + iPos * 0x9E3779B1UL) & m_nAttributeHashMask;
+            while( m_pAttributeHash[iSlot] != 0 ) iSlot = (iSlot + 1) & m_nAttributeHashMask;
+            m_pAttributeHash[iSlot] = i + 1;
+        }
+    }
+}
+
+const CMarkup::XMLATTRIBUTE* CMarkup::_FindAttribute(ULONG iPos, LPCTSTR pstrName) const
+{
+    ULONG iFirst = m_pAttributeIndex[iPos];
+    ULONG iLast = m_pAttributeIndex[iPos + 1];
+    if( iFirst == iLast || m_pAttributeHash == NULL ) return NULL;
+    // 同名属性按插入顺序探测，返回第一个
+    ULONG nHash = _HashName(pstrName);
+    ULONG iSlot = (nHash + iPos * 0x9E3779B1UL) & m_nAttributeHashMask;
+    for( ; m_pAttributeHash[iSlot] != 0; iSlot = (iSlot + 1) & m_nAttributeHashMask ) {
+        ULONG i = m_pAttributeHash[iSlot] - 1;
+        if( i < iFirst || i >= iLast || m_pAttributes[i].nHash != nHash ) continue;
+        if( _tcsicmp(_GetString(m_pAttributes[i].iName), pstrName) == 0 ) return &m_pAttributes[i];
+    }
+    return NULL;
+}
+
+template<typename T>
+void CMarkup::_SkipWhitespace(T*& pstr) const
+{
+    pstr = const_cast<T*>(_SkipSpaceRun(pstr));
+}
+
+template<typename T>
+void CMarkup::_SkipIdentifier(T*& pstr) const
+{
+    while( _IsNameChar(*pstr) ) pstr += _CharLength(pstr);
 }
 
-bool CMarkup::_ParseAttributes(LPTSTR& pstrText)
+template<typename T>
+bool CMarkup::_ParseAttributes(T*& pstrText, const T* pstrBase)
 {   
 	// 无属性
-	LPTSTR pstrIdentifier = pstrText;
-	if( *pstrIdentifier == _T('/') && *++pstrIdentifier == _T('>') ) return true;
-    if( *pstrText == _T('>') ) return true;
-    *pstrText++ = _T('\0');
+	T* pstrIdentifier = pstrText;
+	if( *pstrIdentifier == '/' && *++pstrIdentifier == '>' ) return true;
+    if( *pstrText == '>' ) return true;
+    *pstrText++ = '\0';
     _SkipWhitespace(pstrText);
-    while( *pstrText != _T('\0') && *pstrText != _T('>') && *pstrText != _T('/') ) {
+    while( *pstrText != '\0' && *pstrText != '>' && *pstrText != '/' ) {
+        T* pstrName = pstrText;
         _SkipIdentifier(pstrText);
-        LPTSTR pstrIdentifierEnd = pstrText;
+        T* pstrIdentifierEnd = pstrText;
         _SkipWhitespace(pstrText);
-        if( *pstrText != _T('=') ) return _Failed(_T("Error while parsing attributes"), pstrText);
-        *pstrText++ = _T(' ');
-        *pstrIdentifierEnd = _T('\0');
+        if( *pstrText != '=' ) return _Failed(_T("Error while parsing attributes"), pstrText);
+        *pstrText++ = ' ';
+        *pstrIdentifierEnd = '\0';
         _SkipWhitespace(pstrText);
-        if( *pstrText++ != _T('\"') ) return _Failed(_T("Expected attribute value"), pstrText);
-        LPTSTR pstrDest = pstrText;
-        if( !_ParseData(pstrText, pstrDest, _T('\"')) ) return false;
-        if( *pstrText == _T('\0') ) return _Failed(_T("Error while parsing attribute string"), pstrText);
-        *pstrDest = _T('\0');
-        if( pstrText != pstrDest ) *pstrText = _T(' ');
+        if( *pstrText++ != '\"' ) return _Failed(_T("Expected attribute value"), pstrText);
+        XMLATTRIBUTE* pAttr = _ReserveAttribute();
+        pAttr->iName = pstrName - pstrBase;
+        pAttr->iValue = pstrText - pstrBase;
+        pAttr->nHash = _HashName(pstrName);
+        T* pstrDest = pstrText;
+        if( !_ParseData(pstrText, pstrDest, '\"') ) return false;
+        if( *pstrText == '\0' ) return _Failed(_T("Error while parsing attribute string"), pstrText);
+        *pstrDest = '\0';
+        if( pstrText != pstrDest ) *pstrText = ' ';
         pstrText++;
         _SkipWhitespace(pstrText);
     }
     return true;
 }
 
-bool CMarkup::_ParseData(LPTSTR& pstrText, LPTSTR& pstrDest, char cEnd)
+template<typename T>
+bool CMarkup::_ParseData(T*& pstrText, T*& pstrDest, char cEnd)
 {
-    while( *pstrText != _T('\0') && *pstrText != cEnd ) {
-		if( *pstrText == _T('&') ) {
-			while( *pstrText == _T('&') ) {
+    // 不需要转义和折叠空白的连续字符整段移动
+    T chSpace = m_bPreserveWhitespace ? '&' : ' ';
+    while( *pstrText != '\0' && *pstrText != cEnd ) {
+        T* pstrRun = _ScanUntil(pstrText, (T)cEnd, (T)'&', chSpace);
+        if( pstrRun != pstrText ) {
+            if( pstrDest != pstrText ) ::MoveMemory(pstrDest, pstrText, (pstrRun - pstrText) * sizeof(T));
+            pstrDest += pstrRun - pstrText;
+            pstrText = pstrRun;
+            continue;
+        }
+		if( *pstrText == '&' ) {
+			while( *pstrText == '&' ) {
 				_ParseMetaChar(++pstrText, pstrDest);
 			}
 			if (*pstrText == cEnd)
 				break;
 		}
 
-        if( *pstrText == _T(' ') ) {
+        if( *pstrText == ' ' ) {
             *pstrDest++ = *pstrText++;
             if( !m_bPreserveWhitespace ) _SkipWhitespace(pstrText);
         }
         else {
-            LPTSTR pstrTemp = ::CharNext(pstrText);
+            T* pstrTemp = pstrText + _CharLength(pstrText);
             while( pstrText < pstrTemp) {
                 *pstrDest++ = *pstrText++;
             }
         }
     }
-    // Make sure that MapAttributes() works correctly when it parses
-    // over a value that has been transformed.
-    LPTSTR pstrFill = pstrDest + 1;
-    while( pstrFill < pstrText ) *pstrFill++ = _T(' ');
     return true;
 }
 
-void CMarkup::_ParseMetaChar(LPTSTR& pstrText, LPTSTR& pstrDest)
+template<typename T>
+void CMarkup::_ParseMetaChar(T*& pstrText, T*& pstrDest)
 {
-    if( pstrText[0] == _T('a') && pstrText[1] == _T('m') && pstrText[2] == _T('p') && pstrText[3] == _T(';') ) {
-        *pstrDest++ = _T('&');
+    if( pstrText[0] == 'a' && pstrText[1] == 'm' && pstrText[2] == 'p' && pstrText[3] == ';' ) {
+        *pstrDest++ = '&';
         pstrText += 4;
     }
-    else if( pstrText[0] == _T('l') && pstrText[1] == _T('t') && pstrText[2] == _T(';') ) {
-        *pstrDest++ = _T('<');
+    else if( pstrText[0] == 'l' && pstrText[1] == 't' && pstrText[2] == ';' ) {
+        *pstrDest++ = '<';
         pstrText += 3;
     }
-    else if( pstrText[0] == _T('g') && pstrText[1] == _T('t') && pstrText[2] == _T(';') ) {
-        *pstrDest++ = _T('>');
+    else if( pstrText[0] == 'g' && pstrText[1] == 't' && pstrText[2] == ';' ) {
+        *pstrDest++ = '>';
         pstrText += 3;
     }
-    else if( pstrText[0] == _T('q') && pstrText[1] == _T('u') && pstrText[2] == _T('o') && pstrText[3] == _T('t') && pstrText[4] == _T(';') ) {
-        *pstrDest++ = _T('\"');
+    else if( pstrText[0] == 'q' && pstrText[1] == 'u' && pstrText[2] == 'o' && pstrText[3] == 't' && pstrText[4] == ';' ) {
+        *pstrDest++ = '\"';
         pstrText += 5;
     }
-    else if( pstrText[0] == _T('a') && pstrText[1] == _T('p') && pstrText[2] == _T('o') && pstrText[3] == _T('s') && pstrText[4] == _T(';') ) {
-        *pstrDest++ = _T('\'');
+    else if( pstrText[0] == 'a' && pstrText[1] == 'p' && pstrText[2] == 'o' && pstrText[3] == 's' && pstrText[4] == ';' ) {
+        *pstrDest++ = '\'';
         pstrText += 5;
     }
     else {
-        *pstrDest++ = _T('&');
+        *pstrDest++ = '&';
     }
 }
 
@@ -636,4 +1621,13 @@ bool CMarkup::_Failed(LPCTSTR pstrError, LPCTSTR pstrLocation)
     return false; // Always return 'false'
 }
 
+#ifdef _UNICODE
+bool CMarkup::_Failed(LPCTSTR pstrError, LPCSTR pstrLocation)
+{
+    WCHAR szLocation[lengthof(m_szErrorXML)] = { 0 };
+    ::MultiByteToWideChar(CP_UTF8, 0, pstrLocation, (int)strnlen(pstrLocation, lengthof(szLocation) - 1), szLocation, lengthof(szLocation) - 1);
+    return _Failed(pstrError, szLocation);
+}
+#endif // _UNICODE
+
 } // namespace DuiLib
@@ -12,9 +12,31 @@ namespace DuiLib {
 		XMLFILE_ENCODING_ASNI = 2,
 	};
 
+	// Highest instruction set used to scan delimiters and whitespace; never above what the CPU supports
+	enum
+	{
+		MARKUP_SIMD_NONE = 0,
+		MARKUP_SIMD_SSE2 = 1,
+		MARKUP_SIMD_AVX2 = 2,
+	};
+
+	// Compiled (binary) skin signature "DUIB"
+	#define XMLBINARY_MAGIC		0x42495544
+	#define XMLBINARY_VERSION	2
+
 	class CMarkup;
 	class CMarkupNode;
 
+	// Event sink for CMarkup::ParseStream. Strings are only valid during the call.
+	// Return false from any callback to stop parsing.
+	class UILIB_API IMarkupHandler
+	{
+	public:
+		virtual bool OnStartElement(LPCTSTR pstrName) = 0;
+		virtual bool OnAttribute(LPCTSTR pstrName, LPCTSTR pstrValue) = 0;
+		virtual bool OnText(LPCTSTR pstrText) = 0;
+		virtual bool OnEndElement(LPCTSTR pstrName) = 0;
+	};
 
 	class UILIB_API CMarkup
 	{
@@ -28,8 +50,17 @@ namespace DuiLib {
 		bool LoadFromFile(LPCTSTR pstrFilename, int encoding = XMLFILE_ENCODING_UTF8);
 		void Release();
 		bool IsValid() const;
+		bool IsBinary() const;
+
+		// Forward-only parse in fixed-size chunks; memory is bounded by the largest single tag
+		bool ParseStream(LPCTSTR pstrFilename, IMarkupHandler* pHandler, int encoding = XMLFILE_ENCODING_UTF8);
+
+		// Writes the loaded document as a compiled skin that LoadFromFile/LoadFromMem accept without parsing
+		bool SaveToBinary(LPCTSTR pstrFilename);
 
 		void SetPreserveWhitespace(bool bPreserve = true);
+		// Applies to every CMarkup; defaults to MARKUP_SIMD_AVX2. Lets tests compare against the scalar scanner
+		static void SetSimdLevel(int iLevel);
 		void GetLastErrorMessage(LPTSTR pstrMessage, SIZE_T cchMax) const;
 		void GetLastErrorLocation(LPTSTR pstrSource, SIZE_T cchMax) const;
 
@@ -45,26 +76,75 @@ namespace DuiLib {
 			ULONG iData;
 		} XMLELEMENT;
 
+		typedef struct tagXMLATTRIBUTE
+		{
+			ULONG iName;
+			ULONG iValue;
+			ULONG nHash;
+		} XMLATTRIBUTE;
+
+		// Compiled skin layout: header, XMLELEMENT[nElements], ULONG[nElements + 1] first attribute
+		// of each element, XMLATTRIBUTE[nAttributes], TCHAR[cchStrings] interned string pool
+		typedef struct tagXMLBINARYHEADER
+		{
+			DWORD dwMagic;
+			WORD wVersion;
+			WORD cbChar;
+			DWORD nElements;
+			DWORD nAttributes;
+			DWORD cchStrings;
+		} XMLBINARYHEADER;
+
+		// Commit granularity of m_pstrUtf8Wide, the page size on every Windows platform
+		enum { UTF8_WIDE_PAGE = 4096 };
+
 		LPTSTR m_pstrXML;
+		// UTF-8 text parsed in place; strings are decoded on first access into
+		// m_pstrUtf8Wide at the same offset (Unicode builds only). The shadow buffer
+		// is only reserved; m_pUtf8WidePages marks the pages committed so far
+		LPSTR m_pstrUtf8;
+		LPWSTR m_pstrUtf8Wide;
+		LPBYTE m_pUtf8WidePages;
 		XMLELEMENT* m_pElements;
 		ULONG m_nElements;
 		ULONG m_nReservedElements;
+		ULONG* m_pAttributeIndex;
+		XMLATTRIBUTE* m_pAttributes;
+		ULONG m_nAttributes;
+		ULONG m_nReservedAttributes;
+		ULONG* m_pAttributeHash;
+		ULONG m_nAttributeHashMask;
+		LPBYTE m_pBinary;
+		HANDLE m_hBinaryMap;
 		TCHAR m_szErrorMsg[100];
 		TCHAR m_szErrorXML[50];
 		bool m_bPreserveWhitespace;
 
 	private:
 		bool _Parse();
-		bool _Parse(LPTSTR& pstrText, ULONG iParent);
+		template<typename T> bool _Parse(T*& pstrText, const T* pstrBase, ULONG iParent);
+		LPCTSTR _GetString(ULONG iPos) const;
 		XMLELEMENT* _ReserveElement();
-		inline void _SkipWhitespace(LPTSTR& pstr) const;
-		inline void _SkipWhitespace(LPCTSTR& pstr) const;
-		inline void _SkipIdentifier(LPTSTR& pstr) const;
-		inline void _SkipIdentifier(LPCTSTR& pstr) const;
-		bool _ParseData(LPTSTR& pstrText, LPTSTR& pstrData, char cEnd);
-		void _ParseMetaChar(LPTSTR& pstrText, LPTSTR& pstrDest);
-		bool _ParseAttributes(LPTSTR& pstrText);
+		XMLATTRIBUTE* _ReserveAttribute();
+		void _BuildAttributeHash();
+		const XMLATTRIBUTE* _FindAttribute(ULONG iPos, LPCTSTR pstrName) const;
+		static ULONG _HashName(LPCTSTR pstrName);
+		template<typename T> void _SkipWhitespace(T*& pstr) const;
+		template<typename T> void _SkipIdentifier(T*& pstr) const;
+		template<typename T> bool _ParseData(T*& pstrText, T*& pstrData, char cEnd);
+		template<typename T> void _ParseMetaChar(T*& pstrText, T*& pstrDest);
+		template<typename T> bool _ParseAttributes(T*& pstrText, const T* pstrBase);
 		bool _Failed(LPCTSTR pstrError, LPCTSTR pstrLocation = NULL);
+#ifdef _UNICODE
+		bool _LoadUtf8(LPBYTE pByte, DWORD dwSize);
+		bool _CommitUtf8Wide(ULONG iPos, ULONG cch) const;
+		static ULONG _HashName(LPCSTR pstrName);
+		bool _Failed(LPCTSTR pstrError, LPCSTR pstrLocation);
+#endif
+		bool _ParseStreamTag(LPTSTR pstrText, IMarkupHandler* pHandler, CStdPtrArray& aNames);
+		static bool _IsBinary(const BYTE* pByte, DWORD dwSize);
+		bool _LoadBinary(LPBYTE pByte, DWORD dwSize);
+		bool _ValidateBinary(const XMLBINARYHEADER* pHeader);
 	};
 
 
@@ -98,19 +178,7 @@ namespace DuiLib {
 		bool GetAttributeValue(LPCTSTR pstrName, LPTSTR pstrValue, SIZE_T cchMax);
 
 	private:
-		void _MapAttributes();
-
-		enum { MAX_XML_ATTRIBUTES = 64 };
-
-		typedef struct
-		{
-			ULONG iName;
-			ULONG iValue;
-		} XMLATTRIBUTE;
-
 		int m_iPos;
-		int m_nAttributes;
-		XMLATTRIBUTE m_aAttributes[MAX_XML_ATTRIBUTES];
 		CMarkup* m_pOwner;
 	};
 
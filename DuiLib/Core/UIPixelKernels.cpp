@@ -0,0 +1,451 @@
+﻿#include "UIPixelKernels.h"
+
+#ifdef UILIB_X86_SIMD
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#if !defined(_MSC_VER) || _MSC_VER >= 1700
+#define UIPIXEL_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace DuiLib {
+
+	static int s_iSimdLimit = PIXEL_SIMD_AVX2;
+
+#ifdef UILIB_X86_SIMD
+	static int GetCpuSimdLevel()
+	{
+		int iLevel = PIXEL_SIMD_NONE;
+#ifdef _MSC_VER
+		int info[4] = { 0 };
+		__cpuid(info, 0);
+		int nIds = info[0];
+		__cpuid(info, 1);
+		if( (info[3] & (1 << 26)) != 0 ) iLevel = PIXEL_SIMD_SSE2;
+		if( iLevel == PIXEL_SIMD_SSE2 && (info[2] & (1 << 9)) != 0 ) iLevel = PIXEL_SIMD_SSSE3;
+#ifdef UIPIXEL_AVX2
+		bool bOSXSave = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		if( iLevel == PIXEL_SIMD_SSSE3 && nIds >= 7 && bOSXSave && bAVX && (_xgetbv(0) & 6) == 6 ) {
+			__cpuidex(info, 7, 0);
+			if( (info[1] & (1 << 5)) != 0 ) iLevel = PIXEL_SIMD_AVX2;
+		}
+#endif
+#else
+		unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+		if( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ) return PIXEL_SIMD_NONE;
+		if( (edx & (1 << 26)) != 0 ) iLevel = PIXEL_SIMD_SSE2;
+		if( iLevel == PIXEL_SIMD_SSE2 && (ecx & (1 << 9)) != 0 ) iLevel = PIXEL_SIMD_SSSE3;
+		bool bOSXSave = (ecx & (1 << 27)) != 0;
+		bool bAVX = (ecx & (1 << 28)) != 0;
+		if( iLevel == PIXEL_SIMD_SSSE3 && bOSXSave && bAVX ) {
+			unsigned int xcr0 = 0, xcr0High = 0;
+			__asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+			if( (xcr0 & 6) == 6 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 5)) != 0 ) iLevel = PIXEL_SIMD_AVX2;
+		}
+#endif
+		return iLevel;
+	}
+#endif
+
+	int CPixelKernels::GetSimdLevel()
+	{
+#ifdef UILIB_X86_SIMD
+		static int s_iLevel = -1;
+		if( s_iLevel < 0 ) s_iLevel = GetCpuSimdLevel();
+		return s_iLevel < s_iSimdLimit ? s_iLevel : s_iSimdLimit;
+#else
+		return PIXEL_SIMD_NONE;
+#endif
+	}
+
+	void CPixelKernels::SetSimdLevel(int iLevel)
+	{
+		s_iSimdLimit = iLevel;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	// ConvertImageBits：c*a/255按(x + 1 + (x >> 8)) >> 8计算，x不超过255*255时与整数除法结果一致
+	// 各SIMD版本处理整组像素，返回处理到的位置，剩下的由标量循环完成
+
+#ifdef UILIB_X86_SIMD
+	UILIB_TARGET("sse2") static inline __m128i Div255Epi16(__m128i v)
+	{
+		return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_set1_epi16(1)), _mm_srli_epi16(v, 8)), 8);
+	}
+
+	UILIB_TARGET("sse2") static int ConvertImageBitsSSE2(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask, bool& bAlphaChannel)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaLane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+		const __m128i colorBits = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i maskColor = _mm_set1_epi32((int)mask);
+		__m128i alphaAll = _mm_set1_epi32(-1);
+		__m128i maskHit = zero;
+		int i = 0;
+		for( ; i + 4 <= nPixels; i += 4 ) {
+			__m128i src = _mm_loadu_si128((const __m128i*)(pSrc + i * 4));
+			__m128i lo = _mm_unpacklo_epi8(src, zero);
+			__m128i hi = _mm_unpackhi_epi8(src, zero);
+			// RGBA -> BGRA
+			lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+			hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+			// 颜色乘以alpha，alpha自身乘以255保持不变
+			__m128i alo = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), alphaLane);
+			__m128i ahi = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), alphaLane);
+			lo = Div255Epi16(_mm_mullo_epi16(lo, alo));
+			hi = Div255Epi16(_mm_mullo_epi16(hi, ahi));
+			__m128i dst = _mm_packus_epi16(lo, hi);
+
+			__m128i hit = _mm_cmpeq_epi32(dst, maskColor);
+			dst = _mm_andnot_si128(hit, dst);
+			maskHit = _mm_or_si128(maskHit, hit);
+			alphaAll = _mm_and_si128(alphaAll, _mm_or_si128(src, colorBits));
+			_mm_storeu_si128((__m128i*)(pDest + i * 4), dst);
+		}
+		if( _mm_movemask_epi8(maskHit) != 0 || _mm_movemask_epi8(_mm_cmpeq_epi32(alphaAll, _mm_set1_epi32(-1))) != 0xFFFF ) {
+			bAlphaChannel = true;
+		}
+		return i;
+	}
+
+	// 交换和取alpha都用一条pshufb，代替SSE2的四次16位shuffle
+	UILIB_TARGET("ssse3") static int ConvertImageBitsSSSE3(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask, bool& bAlphaChannel)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i swizzle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m128i alphaLo = _mm_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+		const __m128i alphaHi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+		const __m128i alphaLane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+		const __m128i colorBits = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i maskColor = _mm_set1_epi32((int)mask);
+		__m128i alphaAll = _mm_set1_epi32(-1);
+		__m128i maskHit = zero;
+		int i = 0;
+		for( ; i + 4 <= nPixels; i += 4 ) {
+			__m128i src = _mm_loadu_si128((const __m128i*)(pSrc + i * 4));
+			__m128i bgra = _mm_shuffle_epi8(src, swizzle);
+			__m128i lo = _mm_unpacklo_epi8(bgra, zero);
+			__m128i hi = _mm_unpackhi_epi8(bgra, zero);
+			__m128i alo = _mm_or_si128(_mm_shuffle_epi8(src, alphaLo), alphaLane);
+			__m128i ahi = _mm_or_si128(_mm_shuffle_epi8(src, alphaHi), alphaLane);
+			lo = Div255Epi16(_mm_mullo_epi16(lo, alo));
+			hi = Div255Epi16(_mm_mullo_epi16(hi, ahi));
+			__m128i dst = _mm_packus_epi16(lo, hi);
+
+			__m128i hit = _mm_cmpeq_epi32(dst, maskColor);
+			dst = _mm_andnot_si128(hit, dst);
+			maskHit = _mm_or_si128(maskHit, hit);
+			alphaAll = _mm_and_si128(alphaAll, _mm_or_si128(src, colorBits));
+			_mm_storeu_si128((__m128i*)(pDest + i * 4), dst);
+		}
+		if( _mm_movemask_epi8(maskHit) != 0 || _mm_movemask_epi8(_mm_cmpeq_epi32(alphaAll, _mm_set1_epi32(-1))) != 0xFFFF ) {
+			bAlphaChannel = true;
+		}
+		return i;
+	}
+
+#ifdef UIPIXEL_AVX2
+	// 同SSSE3版本，一次8个像素；shuffle、unpack和pack都在128位内进行，像素顺序不变
+	UILIB_TARGET("avx2") static int ConvertImageBitsAVX2(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask, bool& bAlphaChannel)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi16(1);
+		const __m256i swizzle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m256i alphaLo = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1,
+			3, -1, 3, -1, 3, -1, -1, -1, 7, -1, 7, -1, 7, -1, -1, -1);
+		const __m256i alphaHi = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1,
+			11, -1, 11, -1, 11, -1, -1, -1, 15, -1, 15, -1, 15, -1, -1, -1);
+		const __m256i alphaLane = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+		const __m256i colorBits = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i maskColor = _mm256_set1_epi32((int)mask);
+		__m256i alphaAll = _mm256_set1_epi32(-1);
+		__m256i maskHit = zero;
+		int i = 0;
+		for( ; i + 8 <= nPixels; i += 8 ) {
+			__m256i src = _mm256_loadu_si256((const __m256i*)(pSrc + i * 4));
+			__m256i bgra = _mm256_shuffle_epi8(src, swizzle);
+			__m256i lo = _mm256_unpacklo_epi8(bgra, zero);
+			__m256i hi = _mm256_unpackhi_epi8(bgra, zero);
+			__m256i alo = _mm256_or_si256(_mm256_shuffle_epi8(src, alphaLo), alphaLane);
+			__m256i ahi = _mm256_or_si256(_mm256_shuffle_epi8(src, alphaHi), alphaLane);
+			lo = _mm256_mullo_epi16(lo, alo);
+			hi = _mm256_mullo_epi16(hi, ahi);
+			lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+			hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+			__m256i dst = _mm256_packus_epi16(lo, hi);
+
+			__m256i hit = _mm256_cmpeq_epi32(dst, maskColor);
+			dst = _mm256_andnot_si256(hit, dst);
+			maskHit = _mm256_or_si256(maskHit, hit);
+			alphaAll = _mm256_and_si256(alphaAll, _mm256_or_si256(src, colorBits));
+			_mm256_storeu_si256((__m256i*)(pDest + i * 4), dst);
+		}
+		if( _mm256_movemask_epi8(maskHit) != 0 || _mm256_movemask_epi8(_mm256_cmpeq_epi32(alphaAll, _mm256_set1_epi32(-1))) != -1 ) {
+			bAlphaChannel = true;
+		}
+		return i;
+	}
+#endif
+#endif
+
+	bool CPixelKernels::ConvertImageBits(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask)
+	{
+		bool bAlphaChannel = false;
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		switch( GetSimdLevel() ) {
+#ifdef UIPIXEL_AVX2
+		case PIXEL_SIMD_AVX2: i = ConvertImageBitsAVX2(pSrc, pDest, nPixels, mask, bAlphaChannel); break;
+#endif
+		case PIXEL_SIMD_SSSE3: i = ConvertImageBitsSSSE3(pSrc, pDest, nPixels, mask, bAlphaChannel); break;
+		case PIXEL_SIMD_SSE2: i = ConvertImageBitsSSE2(pSrc, pDest, nPixels, mask, bAlphaChannel); break;
+		default: break;
+		}
+#endif
+		// 先读出整个像素再写，pSrc与pDest可以是同一块内存
+		for( ; i < nPixels; i++ )
+		{
+			BYTE r = pSrc[i*4], g = pSrc[i*4 + 1], b = pSrc[i*4 + 2], a = pSrc[i*4 + 3];
+			pDest[i*4 + 3] = a;
+			if( a < 255 )
+			{
+				pDest[i*4] = (BYTE)(DWORD(b)*a/255);
+				pDest[i*4 + 1] = (BYTE)(DWORD(g)*a/255);
+				pDest[i*4 + 2] = (BYTE)(DWORD(r)*a/255);
+				bAlphaChannel = true;
+			}
+			else
+			{
+				pDest[i*4] = b;
+				pDest[i*4 + 1] = g;
+				pDest[i*4 + 2] = r;
+			}
+
+			// 按字节组合，目标地址不必4字节对齐
+			DWORD dwPixel = (DWORD)pDest[i*4] | ((DWORD)pDest[i*4 + 1] << 8) | ((DWORD)pDest[i*4 + 2] << 16) | ((DWORD)a << 24);
+			if( dwPixel == mask ) {
+				pDest[i*4] = (BYTE)0;
+				pDest[i*4 + 1] = (BYTE)0;
+				pDest[i*4 + 2] = (BYTE)0;
+				pDest[i*4 + 3] = (BYTE)0;
+				bAlphaChannel = true;
+			}
+		}
+		return bAlphaChannel;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	// CRasterizer的行内处理：SIMD版本处理整组像素，返回处理到的位置，剩下的由标量循环完成
+
+	static inline DWORD Div255(DWORD x)
+	{
+		return (x + 1 + (x >> 8)) >> 8;
+	}
+
+	// 每个通道乘以dwFade/255
+	static inline DWORD FadePixel(DWORD dwSrc, DWORD dwFade)
+	{
+		DWORD dwResult = 0;
+		for( int i = 0; i < 32; i += 8 ) {
+			dwResult |= Div255(((dwSrc >> i) & 0xFF) * dwFade) << i;
+		}
+		return dwResult;
+	}
+
+	// dwSrc为预乘颜色：dst = src + dst * (255 - srcA) / 255，每个通道饱和到255
+	static inline DWORD BlendPixel(DWORD dwDest, DWORD dwSrc)
+	{
+		DWORD dwInv = 255 - (dwSrc >> 24);
+		DWORD dwResult = 0;
+		for( int i = 0; i < 32; i += 8 ) {
+			DWORD c = Div255(((dwDest >> i) & 0xFF) * dwInv) + ((dwSrc >> i) & 0xFF);
+			if( c > 255 ) c = 255;
+			dwResult |= c << i;
+		}
+		return dwResult;
+	}
+
+#ifdef UILIB_X86_SIMD
+	UILIB_TARGET("sse2") static inline __m128i Fade4(__m128i s, __m128i fade)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i lo = Div255Epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), fade));
+		__m128i hi = Div255Epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), fade));
+		return _mm_packus_epi16(lo, hi);
+	}
+
+	// 同BlendPixel，一次4个像素
+	UILIB_TARGET("sse2") static inline __m128i Blend4(__m128i d, __m128i s)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i c255 = _mm_set1_epi16(255);
+		__m128i slo = _mm_unpacklo_epi8(s, zero);
+		__m128i shi = _mm_unpackhi_epi8(s, zero);
+		__m128i ilo = _mm_sub_epi16(c255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+		__m128i ihi = _mm_sub_epi16(c255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+		__m128i dlo = Div255Epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ilo));
+		__m128i dhi = Div255Epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ihi));
+		return _mm_packus_epi16(_mm_add_epi16(dlo, slo), _mm_add_epi16(dhi, shi));
+	}
+
+	UILIB_TARGET("sse2") static int FillSpanSSE2(DWORD* pDest, int n, DWORD dwColor)
+	{
+		const __m128i c = _mm_set1_epi32((int)dwColor);
+		int i = 0;
+		if( (dwColor >> 24) == 255 ) {
+			for( ; i + 4 <= n; i += 4 ) _mm_storeu_si128((__m128i*)(pDest + i), c);
+			return i;
+		}
+		for( ; i + 4 <= n; i += 4 ) {
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDest + i));
+			_mm_storeu_si128((__m128i*)(pDest + i), Blend4(d, c));
+		}
+		return i;
+	}
+
+	UILIB_TARGET("sse2") static int BlendSpanSSE2(DWORD* pDest, const DWORD* pSrc, int n, DWORD dwFade)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i fade = _mm_set1_epi16((short)dwFade);
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 ) {
+			__m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+			if( dwFade < 255 ) s = Fade4(s, fade);
+			// 4个像素全不透明时直接覆盖，全为0时跳过
+			if( _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask)) == 0xFFFF ) {
+				_mm_storeu_si128((__m128i*)(pDest + i), s);
+				continue;
+			}
+			if( _mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF ) continue;
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDest + i));
+			_mm_storeu_si128((__m128i*)(pDest + i), Blend4(d, s));
+		}
+		return i;
+	}
+
+	UILIB_TARGET("sse2") static int RepairAlphaSpanSSE2(DWORD* pDest, int n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 ) {
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDest + i));
+			__m128i noAlpha = _mm_cmpeq_epi32(_mm_and_si128(d, alphaMask), zero);
+			__m128i noColor = _mm_cmpeq_epi32(_mm_and_si128(d, colorMask), zero);
+			__m128i fix = _mm_andnot_si128(noColor, noAlpha);
+			if( _mm_movemask_epi8(fix) == 0 ) continue;
+			_mm_storeu_si128((__m128i*)(pDest + i), _mm_or_si128(d, _mm_and_si128(fix, alphaMask)));
+		}
+		return i;
+	}
+
+	UILIB_TARGET("sse2") static int ForceOpaqueSpanSSE2(DWORD* pDest, int n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 ) {
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDest + i));
+			__m128i fix = _mm_andnot_si128(_mm_cmpeq_epi32(d, zero), alphaMask);
+			_mm_storeu_si128((__m128i*)(pDest + i), _mm_or_si128(d, fix));
+		}
+		return i;
+	}
+
+	UILIB_TARGET("sse2") static int MultiplyAlphaSpanSSE2(DWORD* pDest, const DWORD* pMask, int n)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		int i = 0;
+		for( ; i + 4 <= n; i += 4 ) {
+			__m128i d = _mm_loadu_si128((const __m128i*)(pDest + i));
+			__m128i m = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pMask + i)), alphaMask);
+			__m128i mlo = _mm_unpacklo_epi8(m, zero);
+			__m128i mhi = _mm_unpackhi_epi8(m, zero);
+			mlo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(mlo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			mhi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(mhi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i lo = Div255Epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), mlo));
+			__m128i hi = Div255Epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), mhi));
+			__m128i r = _mm_and_si128(_mm_packus_epi16(lo, hi), colorMask);
+			_mm_storeu_si128((__m128i*)(pDest + i), _mm_or_si128(r, m));
+		}
+		return i;
+	}
+#endif
+
+	void CPixelKernels::FillSpan(DWORD* pDest, int n, DWORD dwColor)
+	{
+		if( dwColor == 0 ) return;
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		if( GetSimdLevel() >= PIXEL_SIMD_SSE2 ) i = FillSpanSSE2(pDest, n, dwColor);
+#endif
+		if( (dwColor >> 24) == 255 ) {
+			for( ; i < n; i++ ) pDest[i] = dwColor;
+			return;
+		}
+		for( ; i < n; i++ ) pDest[i] = BlendPixel(pDest[i], dwColor);
+	}
+
+	void CPixelKernels::BlendSpan(DWORD* pDest, const DWORD* pSrc, int n, DWORD dwFade)
+	{
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		if( GetSimdLevel() >= PIXEL_SIMD_SSE2 ) i = BlendSpanSSE2(pDest, pSrc, n, dwFade);
+#endif
+		for( ; i < n; i++ ) {
+			DWORD s = pSrc[i];
+			if( dwFade < 255 ) s = FadePixel(s, dwFade);
+			pDest[i] = BlendPixel(pDest[i], s);
+		}
+	}
+
+	void CPixelKernels::RepairAlphaSpan(DWORD* pDest, int n)
+	{
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		if( GetSimdLevel() >= PIXEL_SIMD_SSE2 ) i = RepairAlphaSpanSSE2(pDest, n);
+#endif
+		for( ; i < n; i++ ) {
+			if( (pDest[i] & 0xFF000000) == 0 && (pDest[i] & 0x00FFFFFF) != 0 ) pDest[i] |= 0xFF000000;
+		}
+	}
+
+	void CPixelKernels::ForceOpaqueSpan(DWORD* pDest, int n)
+	{
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		if( GetSimdLevel() >= PIXEL_SIMD_SSE2 ) i = ForceOpaqueSpanSSE2(pDest, n);
+#endif
+		for( ; i < n; i++ ) {
+			if( pDest[i] != 0 ) pDest[i] |= 0xFF000000;
+		}
+	}
+
+	void CPixelKernels::MultiplyAlphaSpan(DWORD* pDest, const DWORD* pMask, int n)
+	{
+		int i = 0;
+#ifdef UILIB_X86_SIMD
+		if( GetSimdLevel() >= PIXEL_SIMD_SSE2 ) i = MultiplyAlphaSpanSSE2(pDest, pMask, n);
+#endif
+		for( ; i < n; i++ ) {
+			DWORD a = pMask[i] >> 24;
+			DWORD d = pDest[i];
+			pDest[i] = (a << 24) | (Div255(((d >> 16) & 0xFF) * a) << 16) | (Div255(((d >> 8) & 0xFF) * a) << 8) | Div255((d & 0xFF) * a);
+		}
+	}
+
+} // namespace DuiLib
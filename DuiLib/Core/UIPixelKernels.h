@@ -0,0 +1,38 @@
+﻿#ifndef __UIPIXELKERNELS_H__
+#define __UIPIXELKERNELS_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// 解码和合成用的逐像素处理，按CPU选择SSE2/SSSE3/AVX2实现，各级别的结果与标量实现逐字节一致
+	class UILIB_API CPixelKernels
+	{
+	public:
+		// 当前使用的指令集，见PIXEL_SIMD_*
+		static int GetSimdLevel();
+		// 设置可用指令集的上限，默认PIXEL_SIMD_AVX2；测试和基准用来与标量实现比较
+		static void SetSimdLevel(int iLevel);
+
+		// stb_image输出的RGBA转换为GDI使用的预乘alpha BGRA，并把等于mask的像素置为全透明
+		// 返回是否含有透明像素；pSrc与pDest可以是同一块内存
+		static bool ConvertImageBits(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask);
+
+		// 以下为CRasterizer使用的行内处理，像素都是预乘alpha的BGRA，地址只要求4字节对齐
+		// 用预乘颜色覆盖混合n个像素，不透明时直接填充
+		static void FillSpan(DWORD* pDest, int n, DWORD dwColor);
+		// 源像素乘以dwFade/255后覆盖混合到目标：dst = src + dst * (255 - srcA) / 255
+		static void BlendSpan(DWORD* pDest, const DWORD* pSrc, int n, DWORD dwFade);
+		// 颜色不为0而alpha为0的像素改为不透明
+		static void RepairAlphaSpan(DWORD* pDest, int n);
+		// 不为0的像素改为不透明
+		static void ForceOpaqueSpan(DWORD* pDest, int n);
+		// 颜色乘以遮罩的alpha/255，alpha取遮罩的alpha
+		static void MultiplyAlphaSpan(DWORD* pDest, const DWORD* pMask, int n);
+	};
+
+} // namespace DuiLib
+
+#endif // __UIPIXELKERNELS_H__
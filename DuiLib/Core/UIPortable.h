@@ -0,0 +1,82 @@
+﻿#ifndef __UIPORTABLE_H__
+#define __UIPORTABLE_H__
+
+#pragma once
+
+// 不依赖窗口的模块（像素转换、光栅化、GIF解码、脏区域、图集分配、图片文件头）只包含这个头文件，不使用StdAfx.h，
+// 在Windows以外也能编译，Tests目录下的测试在Linux上构建它们
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t BYTE;
+typedef BYTE* LPBYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int64_t LONGLONG;
+typedef unsigned int UINT;
+typedef int BOOL;
+
+typedef struct tagRECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+} RECT, *LPRECT;
+
+typedef struct tagPOINT
+{
+	LONG x;
+	LONG y;
+} POINT, *LPPOINT;
+
+typedef struct tagSIZE
+{
+	LONG cx;
+	LONG cy;
+} SIZE, *LPSIZE;
+#endif
+
+// 与UIlib.h的定义一致
+#ifndef UILIB_API
+#ifdef UILIB_STATIC
+#define UILIB_API
+#elif defined(UILIB_EXPORTS) && defined(_MSC_VER)
+#define UILIB_API __declspec(dllexport)
+#elif defined(_MSC_VER)
+#define UILIB_API __declspec(dllimport)
+#else
+#define UILIB_API
+#endif
+#endif
+
+// x86和x64上编译SSE2/SSSE3/AVX2路径，运行时按cpuid选择
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define UILIB_X86_SIMD
+#ifdef _MSC_VER
+#define UILIB_TARGET(isa)
+#else
+// GCC要求用到SSSE3/AVX2指令的函数声明目标指令集
+#define UILIB_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace DuiLib {
+
+	// 像素处理可用的最高指令集，CPU支持的级别与SetSimdLevel设置的上限取较小值
+	enum
+	{
+		PIXEL_SIMD_NONE = 0,
+		PIXEL_SIMD_SSE2 = 1,
+		PIXEL_SIMD_SSSE3 = 2,
+		PIXEL_SIMD_AVX2 = 3,
+	};
+
+} // namespace DuiLib
+
+#endif // __UIPORTABLE_H__
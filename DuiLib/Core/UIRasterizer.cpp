@@ -0,0 +1,452 @@
+﻿#include "UIRasterizer.h"
+#include "UIPixelKernels.h"
+#include <math.h>
+#include <string.h>
+
+namespace DuiLib {
+
+	// c*a/255按(x + 1 + (x >> 8)) >> 8计算，x不超过255*255时与整数除法结果一致
+	static inline DWORD Div255(DWORD x)
+	{
+		return (x + 1 + (x >> 8)) >> 8;
+	}
+
+	static inline DWORD PremultiplyColor(DWORD dwColor)
+	{
+		DWORD a = dwColor >> 24;
+		if( a == 255 ) return dwColor;
+		return (a << 24) | (Div255(((dwColor >> 16) & 0xFF) * a) << 16) | (Div255(((dwColor >> 8) & 0xFF) * a) << 8) | Div255((dwColor & 0xFF) * a);
+	}
+
+	// 两种颜色之间第i/n处的颜色，alpha固定为dwAlpha，返回预乘结果
+	static DWORD LerpColor(DWORD dwFirst, DWORD dwSecond, int i, int n, DWORD dwAlpha)
+	{
+		DWORD dwColor = dwAlpha << 24;
+		for( int s = 0; s < 24; s += 8 ) {
+			DWORD c = (((dwFirst >> s) & 0xFF) * (n - i) + ((dwSecond >> s) & 0xFF) * i) / n;
+			dwColor |= c << s;
+		}
+		return PremultiplyColor(dwColor);
+	}
+
+	// rc中第y行落在圆角矩形内的范围[x0, x1)，按像素中心判断
+	static void RoundRectSpan(const RECT& rc, int nRadiusX, int nRadiusY, int y, int& x0, int& x1)
+	{
+		x0 = rc.left;
+		x1 = rc.right;
+		double dy = 0;
+		if( y < rc.top + nRadiusY ) dy = rc.top + nRadiusY - (y + 0.5);
+		else if( y >= rc.bottom - nRadiusY ) dy = (y + 0.5) - (rc.bottom - nRadiusY);
+		if( dy <= 0 ) return;
+		double t = 1.0 - dy * dy / ((double)nRadiusY * nRadiusY);
+		int nInset = t <= 0 ? nRadiusX : (int)(nRadiusX - nRadiusX * sqrt(t) + 0.5);
+		x0 += nInset;
+		x1 -= nInset;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	CRasterizer::CRasterizer() :
+		m_pBits(NULL),
+		m_nWidth(0),
+		m_nHeight(0),
+		m_nStride(0),
+		m_pRowBuffer(NULL),
+		m_nRowBuffer(0),
+		m_pIndexBuffer(NULL),
+		m_nIndexBuffer(0)
+	{
+		m_rcClip.left = m_rcClip.top = m_rcClip.right = m_rcClip.bottom = 0;
+	}
+
+	CRasterizer::~CRasterizer()
+	{
+		if( m_pRowBuffer ) delete[] m_pRowBuffer;
+		if( m_pIndexBuffer ) delete[] m_pIndexBuffer;
+	}
+
+	void CRasterizer::Attach(LPBYTE pBits, int nWidth, int nHeight, int nStride)
+	{
+		m_pBits = pBits;
+		m_nWidth = pBits ? nWidth : 0;
+		m_nHeight = pBits ? nHeight : 0;
+		m_nStride = nStride;
+		ResetClip();
+	}
+
+	LPBYTE CRasterizer::GetBits() const
+	{
+		return m_pBits;
+	}
+
+	int CRasterizer::GetWidth() const
+	{
+		return m_nWidth;
+	}
+
+	int CRasterizer::GetHeight() const
+	{
+		return m_nHeight;
+	}
+
+	int CRasterizer::GetStride() const
+	{
+		return m_nStride;
+	}
+
+	void CRasterizer::SetClip(const RECT& rcClip)
+	{
+		m_rcClip.left = rcClip.left > 0 ? rcClip.left : 0;
+		m_rcClip.top = rcClip.top > 0 ? rcClip.top : 0;
+		m_rcClip.right = rcClip.right < m_nWidth ? rcClip.right : m_nWidth;
+		m_rcClip.bottom = rcClip.bottom < m_nHeight ? rcClip.bottom : m_nHeight;
+		if( m_rcClip.right < m_rcClip.left ) m_rcClip.right = m_rcClip.left;
+		if( m_rcClip.bottom < m_rcClip.top ) m_rcClip.bottom = m_rcClip.top;
+	}
+
+	void CRasterizer::ResetClip()
+	{
+		m_rcClip.left = m_rcClip.top = 0;
+		m_rcClip.right = m_nWidth;
+		m_rcClip.bottom = m_nHeight;
+	}
+
+	const RECT& CRasterizer::GetClip() const
+	{
+		return m_rcClip;
+	}
+
+	DWORD* CRasterizer::_GetRow(int y) const
+	{
+		return (DWORD*)(m_pBits + (ptrdiff_t)y * m_nStride);
+	}
+
+	bool CRasterizer::_ClipRect(const RECT& rc, RECT& rcClipped) const
+	{
+		rcClipped.left = rc.left > m_rcClip.left ? rc.left : m_rcClip.left;
+		rcClipped.top = rc.top > m_rcClip.top ? rc.top : m_rcClip.top;
+		rcClipped.right = rc.right < m_rcClip.right ? rc.right : m_rcClip.right;
+		rcClipped.bottom = rc.bottom < m_rcClip.bottom ? rc.bottom : m_rcClip.bottom;
+		return rcClipped.left < rcClipped.right && rcClipped.top < rcClipped.bottom;
+	}
+
+	void CRasterizer::_FillSpan(int y, int x0, int x1, DWORD dwPremultiplied)
+	{
+		if( y < m_rcClip.top || y >= m_rcClip.bottom ) return;
+		if( x0 < m_rcClip.left ) x0 = m_rcClip.left;
+		if( x1 > m_rcClip.right ) x1 = m_rcClip.right;
+		if( x0 < x1 ) CPixelKernels::FillSpan(_GetRow(y) + x0, x1 - x0, dwPremultiplied);
+	}
+
+	DWORD* CRasterizer::_GetRowBuffer(int nPixels)
+	{
+		if( nPixels > m_nRowBuffer ) {
+			if( m_pRowBuffer ) delete[] m_pRowBuffer;
+			m_pRowBuffer = new DWORD[nPixels];
+			m_nRowBuffer = nPixels;
+		}
+		return m_pRowBuffer;
+	}
+
+	int* CRasterizer::_GetIndexBuffer(int nPixels)
+	{
+		if( nPixels > m_nIndexBuffer ) {
+			if( m_pIndexBuffer ) delete[] m_pIndexBuffer;
+			m_pIndexBuffer = new int[nPixels];
+			m_nIndexBuffer = nPixels;
+		}
+		return m_pIndexBuffer;
+	}
+
+	void CRasterizer::FillRect(const RECT& rc, DWORD dwColor)
+	{
+		DWORD c = PremultiplyColor(dwColor);
+		RECT rcClipped;
+		if( c == 0 || !_ClipRect(rc, rcClipped) ) return;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			CPixelKernels::FillSpan(_GetRow(y) + rcClipped.left, rcClipped.right - rcClipped.left, c);
+		}
+	}
+
+	void CRasterizer::FillGradient(const RECT& rc, DWORD dwFirst, DWORD dwSecond, bool bVertical)
+	{
+		DWORD dwAlpha = ((dwFirst >> 24) + (dwSecond >> 24)) >> 1;
+		RECT rcClipped;
+		if( dwAlpha == 0 || !_ClipRect(rc, rcClipped) ) return;
+
+		if( bVertical ) {
+			int n = rc.bottom - rc.top;
+			for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+				DWORD c = LerpColor(dwFirst, dwSecond, y - rc.top, n, dwAlpha);
+				CPixelKernels::FillSpan(_GetRow(y) + rcClipped.left, rcClipped.right - rcClipped.left, c);
+			}
+		}
+		else {
+			// 每列颜色相同，先生成一行再逐行混合
+			int n = rc.right - rc.left;
+			int cx = rcClipped.right - rcClipped.left;
+			DWORD* pRow = _GetRowBuffer(cx);
+			for( int x = 0; x < cx; x++ ) {
+				pRow[x] = LerpColor(dwFirst, dwSecond, rcClipped.left + x - rc.left, n, dwAlpha);
+			}
+			for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+				if( dwAlpha == 255 ) ::memcpy(_GetRow(y) + rcClipped.left, pRow, cx * sizeof(DWORD));
+				else CPixelKernels::BlendSpan(_GetRow(y) + rcClipped.left, pRow, cx, 255);
+			}
+		}
+	}
+
+	void CRasterizer::FrameRect(const RECT& rc, int nSize, DWORD dwColor)
+	{
+		if( nSize <= 0 ) return;
+		// 边框宽度超过一半时整个矩形都是边框，分四块填充保证每个像素只混合一次
+		if( nSize * 2 >= rc.right - rc.left || nSize * 2 >= rc.bottom - rc.top ) {
+			FillRect(rc, dwColor);
+			return;
+		}
+		RECT rcTop = { rc.left, rc.top, rc.right, rc.top + nSize };
+		RECT rcBottom = { rc.left, rc.bottom - nSize, rc.right, rc.bottom };
+		RECT rcLeft = { rc.left, rc.top + nSize, rc.left + nSize, rc.bottom - nSize };
+		RECT rcRight = { rc.right - nSize, rc.top + nSize, rc.right, rc.bottom - nSize };
+		FillRect(rcTop, dwColor);
+		FillRect(rcBottom, dwColor);
+		FillRect(rcLeft, dwColor);
+		FillRect(rcRight, dwColor);
+	}
+
+	void CRasterizer::FrameRoundRect(const RECT& rc, int nRadiusX, int nRadiusY, int nSize, DWORD dwColor)
+	{
+		if( nRadiusX > (rc.right - rc.left) / 2 ) nRadiusX = (rc.right - rc.left) / 2;
+		if( nRadiusY > (rc.bottom - rc.top) / 2 ) nRadiusY = (rc.bottom - rc.top) / 2;
+		if( nRadiusX <= 0 || nRadiusY <= 0 ) {
+			FrameRect(rc, nSize, dwColor);
+			return;
+		}
+		DWORD c = PremultiplyColor(dwColor);
+		RECT rcClipped;
+		if( nSize <= 0 || c == 0 || !_ClipRect(rc, rcClipped) ) return;
+
+		// 外轮廓减去向内缩进nSize的圆角矩形
+		RECT rcInner = { rc.left + nSize, rc.top + nSize, rc.right - nSize, rc.bottom - nSize };
+		int nInnerX = nRadiusX - nSize;
+		int nInnerY = nRadiusY - nSize;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			int x0 = 0, x1 = 0;
+			RoundRectSpan(rc, nRadiusX, nRadiusY, y, x0, x1);
+			if( y >= rcInner.top && y < rcInner.bottom && rcInner.left < rcInner.right ) {
+				int i0 = rcInner.left, i1 = rcInner.right;
+				if( nInnerX > 0 && nInnerY > 0 ) RoundRectSpan(rcInner, nInnerX, nInnerY, y, i0, i1);
+				if( i0 > x1 ) i0 = x1;
+				if( i1 < x0 ) i1 = x0;
+				_FillSpan(y, x0, i0, c);
+				_FillSpan(y, i1 > i0 ? i1 : i0, x1, c);
+			}
+			else {
+				_FillSpan(y, x0, x1, c);
+			}
+		}
+	}
+
+	void CRasterizer::DrawLine(int x0, int y0, int x1, int y1, int nSize, DWORD dwColor)
+	{
+		if( nSize <= 0 ) nSize = 1;
+		int nHalf = nSize / 2;
+		if( y0 == y1 || x0 == x1 ) {
+			// 水平和竖直线直接填充矩形
+			RECT rc = { 0 };
+			if( y0 == y1 ) {
+				rc.left = x0 < x1 ? x0 : x1 + 1;
+				rc.right = x0 < x1 ? x1 : x0 + 1;
+				rc.top = y0 - nHalf;
+				rc.bottom = rc.top + nSize;
+			}
+			else {
+				rc.top = y0 < y1 ? y0 : y1 + 1;
+				rc.bottom = y0 < y1 ? y1 : y0 + 1;
+				rc.left = x0 - nHalf;
+				rc.right = rc.left + nSize;
+			}
+			FillRect(rc, dwColor);
+			return;
+		}
+
+		// Bresenham，每一步盖一个nSize见方的点；点之间有重叠，半透明颜色会重复混合
+		DWORD c = PremultiplyColor(dwColor);
+		if( c == 0 ) return;
+		int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+		int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+		int sx = x0 < x1 ? 1 : -1;
+		int sy = y0 < y1 ? 1 : -1;
+		int err = dx + dy;
+		while( x0 != x1 || y0 != y1 ) {
+			for( int y = y0 - nHalf; y < y0 - nHalf + nSize; y++ ) _FillSpan(y, x0 - nHalf, x0 - nHalf + nSize, c);
+			int e2 = err * 2;
+			if( e2 >= dy ) {
+				err += dy;
+				x0 += sx;
+			}
+			if( e2 <= dx ) {
+				err += dx;
+				y0 += sy;
+			}
+		}
+	}
+
+	void CRasterizer::Blit(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, bool bBlend, BYTE uFade)
+	{
+		Tile(rcDest, pSrc, nSrcStride, rcSrc, bBlend, uFade, false, false);
+	}
+
+	void CRasterizer::Tile(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, bool bBlend, BYTE uFade, bool bTileX, bool bTileY)
+	{
+		int cxDest = rcDest.right - rcDest.left;
+		int cyDest = rcDest.bottom - rcDest.top;
+		int cxSrc = rcSrc.right - rcSrc.left;
+		int cySrc = rcSrc.bottom - rcSrc.top;
+		if( pSrc == NULL || cxDest <= 0 || cyDest <= 0 || cxSrc <= 0 || cySrc <= 0 ) return;
+		if( bBlend && uFade == 0 ) return;
+		RECT rc;
+		if( !_ClipRect(rcDest, rc) ) return;
+
+		// 每一列对应的源像素：平铺时取模，否则按像素中心拉伸；与源一一对应时直接使用源的行
+		int cx = rc.right - rc.left;
+		bool bDirectX = !bTileX && cxDest == cxSrc;
+		int* pIndex = NULL;
+		DWORD* pRow = NULL;
+		if( !bDirectX ) {
+			pIndex = _GetIndexBuffer(cx);
+			pRow = _GetRowBuffer(cx);
+			for( int x = 0; x < cx; x++ ) {
+				int dx = rc.left + x - rcDest.left;
+				pIndex[x] = rcSrc.left + (bTileX ? dx % cxSrc : (int)(((LONGLONG)dx * 2 + 1) * cxSrc / (cxDest * 2)));
+			}
+		}
+
+		int nRowSrc = -1;
+		for( int y = rc.top; y < rc.bottom; y++ ) {
+			int dy = y - rcDest.top;
+			int sy = rcSrc.top;
+			if( bTileY ) sy += dy % cySrc;
+			else if( cyDest == cySrc ) sy += dy;
+			else sy += (int)(((LONGLONG)dy * 2 + 1) * cySrc / (cyDest * 2));
+			const DWORD* pSrcRow = (const DWORD*)(pSrc + (ptrdiff_t)sy * nSrcStride);
+
+			const DWORD* s = NULL;
+			if( bDirectX ) {
+				s = pSrcRow + rcSrc.left + rc.left - rcDest.left;
+			}
+			else {
+				// 纵向拉伸时相邻几行常取同一源行，复用已经取好的像素
+				if( sy != nRowSrc ) {
+					for( int x = 0; x < cx; x++ ) pRow[x] = pSrcRow[pIndex[x]];
+					nRowSrc = sy;
+				}
+				s = pRow;
+			}
+			DWORD* d = _GetRow(y) + rc.left;
+			if( bBlend ) CPixelKernels::BlendSpan(d, s, cx, uFade);
+			else ::memcpy(d, s, cx * sizeof(DWORD));
+		}
+	}
+
+	void CRasterizer::DrawNinePatch(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, const RECT& rcCorners, \
+		bool bBlend, BYTE uFade, bool bHole, bool bTileX, bool bTileY)
+	{
+		const RECT& rc = rcDest;
+		const RECT& rcC = rcCorners;
+		// middle
+		if( !bHole ) {
+			RECT rcD = { rc.left + rcC.left, rc.top + rcC.top, rc.right - rcC.right, rc.bottom - rcC.bottom };
+			RECT rcS = { rcSrc.left + rcC.left, rcSrc.top + rcC.top, rcSrc.right - rcC.right, rcSrc.bottom - rcC.bottom };
+			Tile(rcD, pSrc, nSrcStride, rcS, bBlend, uFade, bTileX, bTileY);
+		}
+		// left-top
+		if( rcC.left > 0 && rcC.top > 0 ) {
+			RECT rcD = { rc.left, rc.top, rc.left + rcC.left, rc.top + rcC.top };
+			RECT rcS = { rcSrc.left, rcSrc.top, rcSrc.left + rcC.left, rcSrc.top + rcC.top };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// top
+		if( rcC.top > 0 ) {
+			RECT rcD = { rc.left + rcC.left, rc.top, rc.right - rcC.right, rc.top + rcC.top };
+			RECT rcS = { rcSrc.left + rcC.left, rcSrc.top, rcSrc.right - rcC.right, rcSrc.top + rcC.top };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// right-top
+		if( rcC.right > 0 && rcC.top > 0 ) {
+			RECT rcD = { rc.right - rcC.right, rc.top, rc.right, rc.top + rcC.top };
+			RECT rcS = { rcSrc.right - rcC.right, rcSrc.top, rcSrc.right, rcSrc.top + rcC.top };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// left
+		if( rcC.left > 0 ) {
+			RECT rcD = { rc.left, rc.top + rcC.top, rc.left + rcC.left, rc.bottom - rcC.bottom };
+			RECT rcS = { rcSrc.left, rcSrc.top + rcC.top, rcSrc.left + rcC.left, rcSrc.bottom - rcC.bottom };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// right
+		if( rcC.right > 0 ) {
+			RECT rcD = { rc.right - rcC.right, rc.top + rcC.top, rc.right, rc.bottom - rcC.bottom };
+			RECT rcS = { rcSrc.right - rcC.right, rcSrc.top + rcC.top, rcSrc.right, rcSrc.bottom - rcC.bottom };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// left-bottom
+		if( rcC.left > 0 && rcC.bottom > 0 ) {
+			RECT rcD = { rc.left, rc.bottom - rcC.bottom, rc.left + rcC.left, rc.bottom };
+			RECT rcS = { rcSrc.left, rcSrc.bottom - rcC.bottom, rcSrc.left + rcC.left, rcSrc.bottom };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// bottom
+		if( rcC.bottom > 0 ) {
+			RECT rcD = { rc.left + rcC.left, rc.bottom - rcC.bottom, rc.right - rcC.right, rc.bottom };
+			RECT rcS = { rcSrc.left + rcC.left, rcSrc.bottom - rcC.bottom, rcSrc.right - rcC.right, rcSrc.bottom };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+		// right-bottom
+		if( rcC.right > 0 && rcC.bottom > 0 ) {
+			RECT rcD = { rc.right - rcC.right, rc.bottom - rcC.bottom, rc.right, rc.bottom };
+			RECT rcS = { rcSrc.right - rcC.right, rcSrc.bottom - rcC.bottom, rcSrc.right, rcSrc.bottom };
+			Blit(rcD, pSrc, nSrcStride, rcS, bBlend, uFade);
+		}
+	}
+
+	void CRasterizer::Clear(const RECT& rc)
+	{
+		RECT rcClipped;
+		if( !_ClipRect(rc, rcClipped) ) return;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			memset(_GetRow(y) + rcClipped.left, 0, (rcClipped.right - rcClipped.left) * sizeof(DWORD));
+		}
+	}
+
+	void CRasterizer::RepairAlpha(const RECT& rc)
+	{
+		RECT rcClipped;
+		if( !_ClipRect(rc, rcClipped) ) return;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			CPixelKernels::RepairAlphaSpan(_GetRow(y) + rcClipped.left, rcClipped.right - rcClipped.left);
+		}
+	}
+
+	void CRasterizer::ForceOpaque(const RECT& rc)
+	{
+		RECT rcClipped;
+		if( !_ClipRect(rc, rcClipped) ) return;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			CPixelKernels::ForceOpaqueSpan(_GetRow(y) + rcClipped.left, rcClipped.right - rcClipped.left);
+		}
+	}
+
+	void CRasterizer::MultiplyAlpha(const RECT& rc, const BYTE* pMask, int nMaskStride)
+	{
+		RECT rcClipped;
+		if( pMask == NULL || !_ClipRect(rc, rcClipped) ) return;
+		for( int y = rcClipped.top; y < rcClipped.bottom; y++ ) {
+			const DWORD* pMaskRow = (const DWORD*)(pMask + (ptrdiff_t)y * nMaskStride);
+			CPixelKernels::MultiplyAlphaSpan(_GetRow(y) + rcClipped.left, pMaskRow + rcClipped.left, rcClipped.right - rcClipped.left);
+		}
+	}
+
+} // namespace DuiLib
@@ -0,0 +1,83 @@
+﻿#ifndef __UIRASTERIZER_H__
+#define __UIRASTERIZER_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// 软件光栅化：在预乘alpha的BGRA内存上绘制填充、渐变、边框、线条、位图和九宫格
+	// 只使用BYTE/DWORD/RECT等基本类型和C运行库，不调用Win32 API，可以脱离窗口在任意平台上运行
+	// 颜色参数为DuiLib使用的未预乘ARGB，按源覆盖（source-over）混合；逐行的混合由CPixelKernels完成，各指令集的结果逐像素一致
+	class UILIB_API CRasterizer
+	{
+	public:
+		CRasterizer();
+		~CRasterizer();
+
+		// pBits指向最上面一行，nStride为下一行相对上一行的字节偏移；自下而上的DIB传入最后一行的地址和负的行宽
+		void Attach(LPBYTE pBits, int nWidth, int nHeight, int nStride);
+		LPBYTE GetBits() const;
+		int GetWidth() const;
+		int GetHeight() const;
+		int GetStride() const;
+
+		// 所有绘制都裁剪到该矩形和缓冲区范围内
+		void SetClip(const RECT& rcClip);
+		void ResetClip();
+		const RECT& GetClip() const;
+
+		void FillRect(const RECT& rc, DWORD dwColor);
+		// 颜色从rc的左（上）边线性过渡到右（下）边，alpha取两端的平均值，与CRenderEngine::DrawGradient一致
+		void FillGradient(const RECT& rc, DWORD dwFirst, DWORD dwSecond, bool bVertical);
+		// 边框画在rc以内，宽度为nSize
+		void FrameRect(const RECT& rc, int nSize, DWORD dwColor);
+		void FrameRoundRect(const RECT& rc, int nRadiusX, int nRadiusY, int nSize, DWORD dwColor);
+		// 与GDI的LineTo一样不画终点，宽度为nSize的方形笔
+		void DrawLine(int x0, int y0, int x1, int y1, int nSize, DWORD dwColor);
+
+		// 源为预乘alpha的BGRA，pSrc指向第0行；尺寸不同时按像素中心取最近点拉伸
+		// bBlend为false时直接复制（包括alpha），否则源乘以uFade/255后覆盖混合
+		void Blit(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, bool bBlend, BYTE uFade = 255);
+		// 平铺绘制，每块与源同样大小，最后一块截断
+		void Tile(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, bool bBlend, BYTE uFade, bool bTileX, bool bTileY);
+		// 九宫格：rcCorners为四边不拉伸的宽度，bHole为true时不画中间部分，规则同CRenderEngine::DrawImage
+		void DrawNinePatch(const RECT& rcDest, const BYTE* pSrc, int nSrcStride, const RECT& rcSrc, const RECT& rcCorners, \
+			bool bBlend, BYTE uFade, bool bHole = false, bool bTileX = false, bool bTileY = false);
+
+		// 以下为分层窗口合成用的逐像素处理，都只处理rc与裁剪区域相交的部分
+		// 清为全透明
+		void Clear(const RECT& rc);
+		// GDI绘制的像素alpha为0：颜色不为0而alpha为0的像素改为不透明
+		void RepairAlpha(const RECT& rc);
+		// 不为0的像素都改为不透明
+		void ForceOpaque(const RECT& rc);
+		// 颜色乘以遮罩像素的alpha/255（截断），alpha取遮罩的alpha；pMask与缓冲区坐标一致，指向第0行
+		void MultiplyAlpha(const RECT& rc, const BYTE* pMask, int nMaskStride);
+
+	private:
+		CRasterizer(const CRasterizer&);
+		CRasterizer& operator=(const CRasterizer&);
+
+		DWORD* _GetRow(int y) const;
+		bool _ClipRect(const RECT& rc, RECT& rcClipped) const;
+		void _FillSpan(int y, int x0, int x1, DWORD dwPremultiplied);
+		DWORD* _GetRowBuffer(int nPixels);
+		int* _GetIndexBuffer(int nPixels);
+
+	private:
+		LPBYTE m_pBits;
+		int m_nWidth;
+		int m_nHeight;
+		int m_nStride;
+		RECT m_rcClip;
+		DWORD* m_pRowBuffer;
+		int m_nRowBuffer;
+		int* m_pIndexBuffer;
+		int m_nIndexBuffer;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIRASTERIZER_H__
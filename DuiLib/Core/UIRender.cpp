@@ -18,7 +18,19 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////
 namespace DuiLib {
-	static int g_iFontID = MAX_FONT_ID;
+	static volatile LONG g_iFontID = MAX_FONT_ID;
+
+	// DrawHtmlText中标签临时组合的字体：已有同样的字体时直接使用，否则用新的id加入，
+	// 不替换其它调用（包括其它分块线程）正在使用的字体；查找和加入一起加锁，同样的字体只加入一次
+	static TFontInfo* GetHtmlFontInfo(CPaintManagerUI* pManager, LPCTSTR pStrFontName, int nSize, bool bBold, bool bUnderline, bool bItalic, bool bStrikeout)
+	{
+		pManager->LockPaintResource();
+		HFONT hFont = pManager->GetFont(pStrFontName, nSize, bBold, bUnderline, bItalic, bStrikeout);
+		if( hFont == NULL ) hFont = pManager->AddFont(::InterlockedIncrement(&g_iFontID), pStrFontName, nSize, bBold, bUnderline, bItalic, bStrikeout);
+		TFontInfo* pFontInfo = pManager->GetFontInfo(hFont);
+		pManager->UnlockPaintResource();
+		return pFontInfo;
+	}
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	//
@@ -34,12 +46,22 @@ namespace DuiLib {
 		::DeleteObject(hRgn);
 	}
 
+	// 裁剪区域使用设备坐标，DC设置了窗口原点（例如绘制到容器的缓存层）时需要换算
+	static RECT ClipRectToDevice(HDC hDC, const RECT& rc)
+	{
+		RECT rcDevice = rc;
+		::LPtoDP(hDC, (LPPOINT)&rcDevice, 2);
+		return rcDevice;
+	}
+
 	void CRenderClip::GenerateClip(HDC hDC, RECT rc, CRenderClip& clip)
 	{
 		RECT rcClip = { 0 };
 		::GetClipBox(hDC, &rcClip);
+		rcClip = ClipRectToDevice(hDC, rcClip);
 		clip.hOldRgn = ::CreateRectRgnIndirect(&rcClip);
-		clip.hRgn = ::CreateRectRgnIndirect(&rc);
+		RECT rcDevice = ClipRectToDevice(hDC, rc);
+		clip.hRgn = ::CreateRectRgnIndirect(&rcDevice);
 		::ExtSelectClipRgn(hDC, clip.hRgn, RGN_AND);
 		clip.hDC = hDC;
 		clip.rcItem = rc;
@@ -49,8 +71,11 @@ namespace DuiLib {
 	{
 		RECT rcClip = { 0 };
 		::GetClipBox(hDC, &rcClip);
+		rcClip = ClipRectToDevice(hDC, rcClip);
 		clip.hOldRgn = ::CreateRectRgnIndirect(&rcClip);
-		clip.hRgn = ::CreateRectRgnIndirect(&rc);
+		RECT rcDevice = ClipRectToDevice(hDC, rc);
+		clip.hRgn = ::CreateRectRgnIndirect(&rcDevice);
+		rcItem = ClipRectToDevice(hDC, rcItem);
 		HRGN hRgnItem = ::CreateRoundRectRgn(rcItem.left, rcItem.top, rcItem.right + 1, rcItem.bottom + 1, width, height);
 		::CombineRgn(clip.hRgn, clip.hRgn, hRgnItem, RGN_AND);
 		::ExtSelectClipRgn(hDC, clip.hRgn, RGN_AND);
@@ -116,6 +141,59 @@ namespace DuiLib {
 		*ARGB |= RGB( (BYTE)(R<0?0:(R>255?255:R)), (BYTE)(G<0?0:(G>255?255:G)), (BYTE)(B<0?0:(B>255?255:B)) );
 	}
 
+	// 皮肤图片的颜色种类有限，按颜色缓存调整结果，相同颜色只做一次浮点转换
+	#define HSL_CACHE_BITS 12
+	// 每个线程至少处理的像素数，小图不值得分块
+	#define HSL_TASK_PIXELS (256 * 256)
+
+	static void AdjustImageBits(const DWORD* pSrc, DWORD* pDest, int nPixels, short H, short S, short L)
+	{
+		DWORD aKey[1 << HSL_CACHE_BITS];
+		DWORD aValue[1 << HSL_CACHE_BITS];
+		// 缓存键只用低24位，0xFFFFFFFF表示空
+		::FillMemory(aKey, sizeof(aKey), 0xFF);
+
+		float fH, fS, fL;
+		float S1 = S / 100.0f;
+		float L1 = L / 100.0f;
+		for( int i = 0; i < nPixels; i++ ) {
+			DWORD dwColor = pSrc[i] & 0x00FFFFFF;
+			DWORD iSlot = (dwColor * 2654435761U) >> (32 - HSL_CACHE_BITS);
+			if( aKey[iSlot] != dwColor ) {
+				RGBtoHSL(dwColor, &fH, &fS, &fL);
+				fH += (H - 180);
+				fH = fH > 0 ? fH : fH + 360; 
+				fS *= S1;
+				fL *= L1;
+				DWORD dwValue = 0;
+				HSLtoRGB(&dwValue, fH, fS, fL);
+				aKey[iSlot] = dwColor;
+				aValue[iSlot] = dwValue;
+			}
+			pDest[i] = (pDest[i] & 0xFF000000) | aValue[iSlot];
+		}
+	}
+
+	typedef struct tagHSLTASK
+	{
+		const DWORD* pSrc;
+		DWORD* pDest;
+		int nPixels;
+		short H;
+		short S;
+		short L;
+		volatile LONG* pnPending;
+		HANDLE hDone;
+	} HSLTASK;
+
+	static DWORD WINAPI AdjustImageBitsTask(LPVOID pParam)
+	{
+		HSLTASK* pTask = static_cast<HSLTASK*>(pParam);
+		AdjustImageBits(pTask->pSrc, pTask->pDest, pTask->nPixels, pTask->H, pTask->S, pTask->L);
+		if( ::InterlockedDecrement(pTask->pnPending) == 0 ) ::SetEvent(pTask->hDone);
+		return 0;
+	}
+
 	static COLORREF PixelAlpha(COLORREF clrSrc, double src_darken, COLORREF clrDest, double dest_darken)
 	{
 		return RGB (GetRValue (clrSrc) * src_darken + GetRValue (clrDest) * dest_darken, 
@@ -288,8 +366,21 @@ namespace DuiLib {
 			return false;
 		}
 		const TImageInfo* data = NULL;
-		data = pManager->GetImageEx((LPCTSTR)sImageName, sImageResType.IsEmpty() ? NULL : (LPCTSTR)sImageResType, dwMask, false, bGdiplus, instance);
-		if( !data ) return false;
+		data = pManager->GetImageAsync((LPCTSTR)sImageName, sImageResType.IsEmpty() ? NULL : (LPCTSTR)sImageResType, dwMask, false, bGdiplus, rcItem, instance);
+		if( !data ) {
+			// 图片还在后台加载，占位图整张拉伸到目标区域
+			data = pManager->GetImagePlaceholderInfo();
+			if( !data ) return false;
+			::SetRect(&rcBmpPart, 0, 0, data->nX, data->nY);
+			::SetRectEmpty(&rcCorner);
+			bGdiplus = false;
+			bHole = bTiledX = bTiledY = false;
+		}
+		else {
+			// DPI图片变体按皮肤坐标的nScale%制作，source和corner同样换算
+			CRenderEngine::ScaleImageRect(rcBmpPart, data->nScale);
+			CRenderEngine::ScaleImageRect(rcCorner, data->nScale);
+		}
 
 		if( rcBmpPart.left == 0 && rcBmpPart.right == 0 && rcBmpPart.top == 0 && rcBmpPart.bottom == 0 ) {
 			rcBmpPart.right = data->nX;
@@ -297,13 +388,17 @@ namespace DuiLib {
 		}
 		if (rcBmpPart.right > data->nX) rcBmpPart.right = data->nX;
 		if (rcBmpPart.bottom > data->nY) rcBmpPart.bottom = data->nY;
+		if (data->pAtlas) ::OffsetRect(&rcBmpPart, data->nAtlasX, data->nAtlasY);
 
 		RECT rcTemp;
 		if( !::IntersectRect(&rcTemp, &rcItem, &rc) ) return true;
 		if( !::IntersectRect(&rcTemp, &rcItem, &rcPaint) ) return true;
 
 		if(bGdiplus) {
+			// GDI+的图片对象不能同时在多个线程绘制
+			pManager->LockPaintResource();
 			CRenderEngine::GdiplusDrawImage(hDC, data->pImage, rcItem, rcPaint, rcBmpPart, pManager->IsLayered() ? true : data->bAlpha, uFade, uRotate);
+			pManager->UnlockPaintResource();
 		}
 		else {
 			CRenderEngine::DrawImage(hDC, data->hBitmap, rcItem, rcPaint, rcBmpPart, rcCorner, pManager->IsLayered() ? true : data->bAlpha, uFade, bHole, bTiledX, bTiledY);
@@ -456,124 +551,157 @@ namespace DuiLib {
 	}
 #endif//USE_XIMAGE_EFFECT
 
-	TImageInfo* CRenderEngine::LoadImage(STRINGorID bitmap, LPCTSTR type, DWORD mask, HINSTANCE instance)
+	// 解压资源zip中的文件到VirtualAlloc申请的页面，由UnmapImageData释放
+	static LPBYTE UnzipImageData(LPCTSTR pstrName, DWORD& dwSize)
 	{
-		LPBYTE pData = NULL;
-		DWORD dwSize = 0;
-		do 
+		dwSize = 0;
+		CDuiString sFile = CPaintManagerUI::GetResourcePath();
+		sFile += CPaintManagerUI::GetResourceZip();
+		CDuiString sFilePwd = CPaintManagerUI::GetResourceZipPwd();
+		HZIP hz = NULL;
+		if( CPaintManagerUI::IsCachedResourceZip() ) hz = (HZIP)CPaintManagerUI::GetResourceZipHandle();
+		else
 		{
-			if( type == NULL ) {
-				CDuiString sFile = CPaintManagerUI::GetResourcePath();
-				if( CPaintManagerUI::GetResourceZip().IsEmpty() ) {
-					sFile += bitmap.m_lpstr;
-					HANDLE hFile = ::CreateFile(sFile.GetData(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, \
-						FILE_ATTRIBUTE_NORMAL, NULL);
-					if( hFile == INVALID_HANDLE_VALUE ) break;
-					dwSize = ::GetFileSize(hFile, NULL);
-					if( dwSize == 0 ) break;
-
-					DWORD dwRead = 0;
-					pData = new BYTE[ dwSize ];
-					::ReadFile( hFile, pData, dwSize, &dwRead, NULL );
-					::CloseHandle( hFile );
-
-					if( dwRead != dwSize ) {
-						delete[] pData;
-						pData = NULL;
-						break;
-					}
-				}
-				else {
-					sFile += CPaintManagerUI::GetResourceZip();
-					CDuiString sFilePwd = CPaintManagerUI::GetResourceZipPwd();
-					HZIP hz = NULL;
-					if( CPaintManagerUI::IsCachedResourceZip() ) hz = (HZIP)CPaintManagerUI::GetResourceZipHandle();
-					else
-					{
 #ifdef UNICODE
-						char* pwd = w2a((wchar_t*)sFilePwd.GetData());
-						hz = OpenZip(sFile.GetData(), pwd);
-						if(pwd) delete[] pwd;
+			char* pwd = w2a((wchar_t*)sFilePwd.GetData());
+			hz = OpenZip(sFile.GetData(), pwd);
+			if(pwd) delete[] pwd;
 #else
-						hz = OpenZip(sFile.GetData(), sFilePwd.GetData());
+			hz = OpenZip(sFile.GetData(), sFilePwd.GetData());
 #endif
-					}
-					if( hz == NULL ) break;
-					ZIPENTRY ze; 
-					int i = 0; 
-					CDuiString key = bitmap.m_lpstr;
-					key.Replace(_T("\\"), _T("/"));
-					if( FindZipItem(hz, key, true, &i, &ze) != 0 ) break;
-					dwSize = ze.unc_size;
-					if( dwSize == 0 ) break;
-					pData = new BYTE[ dwSize ];
-					int res = UnzipItem(hz, i, pData, dwSize);
-					if( res != 0x00000000 && res != 0x00000600) {
-						delete[] pData;
-						pData = NULL;
-						if( !CPaintManagerUI::IsCachedResourceZip() ) CloseZip(hz);
-						break;
-					}
-					if( !CPaintManagerUI::IsCachedResourceZip() ) CloseZip(hz);
-				}
+		}
+		if( hz == NULL ) return NULL;
+		LPBYTE pData = NULL;
+		ZIPENTRY ze;
+		int i = 0;
+		CDuiString key = pstrName;
+		key.Replace(_T("\\"), _T("/"));
+		if( FindZipItem(hz, key, true, &i, &ze) == 0 && ze.unc_size > 0 ) {
+			dwSize = ze.unc_size;
+			pData = (LPBYTE)::VirtualAlloc(NULL, dwSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+			int res = pData ? UnzipItem(hz, i, pData, dwSize) : -1;
+			if( res != 0x00000000 && res != 0x00000600) {
+				if( pData ) ::VirtualFree(pData, 0, MEM_RELEASE);
+				pData = NULL;
+				dwSize = 0;
 			}
-			else {
-				HINSTANCE dllinstance = NULL;
-				if (instance) {
-					dllinstance = instance;
-				}
-				else {
-					dllinstance = CPaintManagerUI::GetResourceDll();
-				}
-				HRSRC hResource = ::FindResource(dllinstance, bitmap.m_lpstr, type);
-				if( hResource == NULL ) break;
-				HGLOBAL hGlobal = ::LoadResource(dllinstance, hResource);
-				if( hGlobal == NULL ) {
-					FreeResource(hResource);
-					break;
-				}
+		}
+		if( !CPaintManagerUI::IsCachedResourceZip() ) CloseZip(hz);
+		return pData;
+	}
+
+	// 只读映射整个文件，空文件或打开失败返回NULL
+	static const BYTE* MapImageFile(LPCTSTR pstrFile, DWORD& dwSize)
+	{
+		dwSize = 0;
+		HANDLE hFile = ::CreateFile(pstrFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, \
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if( hFile == INVALID_HANDLE_VALUE ) return NULL;
+		DWORD dwFileSize = ::GetFileSize(hFile, NULL);
+		HANDLE hMap = NULL;
+		if( dwFileSize != INVALID_FILE_SIZE && dwFileSize > 0 ) {
+			hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		::CloseHandle(hFile);
+		if( hMap == NULL ) return NULL;
+		const BYTE* pView = (const BYTE*)::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+		::CloseHandle(hMap);
+		if( pView != NULL ) dwSize = dwFileSize;
+		return pView;
+	}
 
+	const BYTE* CRenderEngine::MapImageData(STRINGorID bitmap, LPCTSTR type, HINSTANCE instance, DWORD& dwSize)
+	{
+		const BYTE* pData = NULL;
+		dwSize = 0;
+		if( type == NULL ) {
+			if( CPaintManagerUI::GetResourceZip().IsEmpty() ) {
+				CDuiString sFile = CPaintManagerUI::GetResourcePath();
+				sFile += bitmap.m_lpstr;
+				pData = MapImageFile(sFile.GetData(), dwSize);
+			}
+			else {
+				pData = UnzipImageData(bitmap.m_lpstr, dwSize);
+			}
+		}
+		else {
+			// 资源数据在模块映像中，直接使用不复制
+			HINSTANCE dllinstance = instance ? instance : CPaintManagerUI::GetResourceDll();
+			HRSRC hResource = ::FindResource(dllinstance, bitmap.m_lpstr, type);
+			HGLOBAL hGlobal = hResource ? ::LoadResource(dllinstance, hResource) : NULL;
+			if( hGlobal != NULL ) {
 				dwSize = ::SizeofResource(dllinstance, hResource);
-				if( dwSize == 0 ) break;
-				pData = new BYTE[ dwSize ];
-				::CopyMemory(pData, (LPBYTE)::LockResource(hGlobal), dwSize);
-				::FreeResource(hGlobal);
+				pData = dwSize > 0 ? (const BYTE*)::LockResource(hGlobal) : NULL;
 			}
-		} while (0);
+		}
+		//读不到图片, 则直接去读取bitmap.m_lpstr指向的路径
+		if( pData == NULL ) pData = MapImageFile(bitmap.m_lpstr, dwSize);
+		if( pData == NULL ) dwSize = 0;
+		return pData;
+	}
 
-		while (!pData)
-		{
-			//读不到图片, 则直接去读取bitmap.m_lpstr指向的路径
-			HANDLE hFile = ::CreateFile(bitmap.m_lpstr, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, \
-				FILE_ATTRIBUTE_NORMAL, NULL);
-			if( hFile == INVALID_HANDLE_VALUE ) break;
-			dwSize = ::GetFileSize(hFile, NULL);
-			if( dwSize == 0 ) break;
+	void CRenderEngine::UnmapImageData(const BYTE* pData)
+	{
+		if( pData == NULL ) return;
+		MEMORY_BASIC_INFORMATION mbi;
+		if( ::VirtualQuery(pData, &mbi, sizeof(mbi)) == 0 ) return;
+		// 模块映像中的资源数据不需要释放
+		if( mbi.Type == MEM_MAPPED ) ::UnmapViewOfFile(pData);
+		else if( mbi.Type == MEM_PRIVATE && mbi.AllocationBase == pData ) ::VirtualFree((LPVOID)pData, 0, MEM_RELEASE);
+	}
 
-			DWORD dwRead = 0;
-			pData = new BYTE[ dwSize ];
-			::ReadFile( hFile, pData, dwSize, &dwRead, NULL );
-			::CloseHandle( hFile );
+	// 读取文件开头的dwSize字节，返回实际读到的长度
+	static DWORD ReadImageHead(LPCTSTR pstrFile, LPBYTE pData, DWORD dwSize)
+	{
+		HANDLE hFile = ::CreateFile(pstrFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, \
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if( hFile == INVALID_HANDLE_VALUE ) return 0;
+		DWORD dwRead = 0;
+		if( !::ReadFile(hFile, pData, dwSize, &dwRead, NULL) ) dwRead = 0;
+		::CloseHandle(hFile);
+		return dwRead;
+	}
 
-			if( dwRead != dwSize ) {
-				delete[] pData;
-				pData = NULL;
+	// JPEG的EXIF等元数据段可能较大，文件头中找不到尺寸时再读取完整数据
+	#define IMAGEPROBE_HEAD		(64 * 1024)
+
+	bool CRenderEngine::ProbeImage(STRINGorID bitmap, LPCTSTR type, HINSTANCE instance, int& x, int& y, bool& bAlpha)
+	{
+		x = y = 0;
+		bAlpha = false;
+		if( type == NULL && CPaintManagerUI::GetResourceZip().IsEmpty() ) {
+			LPBYTE pHead = new BYTE[IMAGEPROBE_HEAD];
+			CDuiString sFile = CPaintManagerUI::GetResourcePath();
+			sFile += bitmap.m_lpstr;
+			DWORD dwRead = ReadImageHead(sFile.GetData(), pHead, IMAGEPROBE_HEAD);
+			if( dwRead == 0 ) dwRead = ReadImageHead(bitmap.m_lpstr, pHead, IMAGEPROBE_HEAD);
+			bool bRet = CImageProbe::Probe(pHead, dwRead, x, y, bAlpha);
+			delete[] pHead;
+			if( bRet || dwRead < IMAGEPROBE_HEAD ) return bRet;
+		}
+		else if( type != NULL ) {
+			// 资源直接在模块映像中解析，不复制
+			HINSTANCE dllinstance = instance ? instance : CPaintManagerUI::GetResourceDll();
+			HRSRC hResource = ::FindResource(dllinstance, bitmap.m_lpstr, type);
+			HGLOBAL hGlobal = hResource ? ::LoadResource(dllinstance, hResource) : NULL;
+			if( hGlobal != NULL ) {
+				bool bRet = CImageProbe::Probe((const BYTE*)::LockResource(hGlobal), ::SizeofResource(dllinstance, hResource), x, y, bAlpha);
+				::FreeResource(hGlobal);
+				return bRet;
 			}
-			break;
-		}
-		if (!pData)
-		{
-			return NULL;
 		}
 
-		LPBYTE pImage = NULL;
-		int x,y,n;
-		pImage = stbi_load_from_memory(pData, dwSize, &x, &y, &n, 4);
-		delete[] pData;
-		if( !pImage ) {
-			return NULL;
-		}
+		// 资源zip中的文件需要整体解压
+		DWORD dwSize = 0;
+		const BYTE* pData = MapImageData(bitmap, type, instance, dwSize);
+		if( pData == NULL ) return false;
+		bool bRet = CImageProbe::Probe(pData, dwSize, x, y, bAlpha);
+		UnmapImageData(pData);
+		return bRet;
+	}
 
+	static HBITMAP CreateImageDIB(int x, int y, LPBYTE* ppBits)
+	{
 		BITMAPINFO bmi;
 		::ZeroMemory(&bmi, sizeof(BITMAPINFO));
 		bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
@@ -583,49 +711,349 @@ namespace DuiLib {
 		bmi.bmiHeader.biBitCount = 32;
 		bmi.bmiHeader.biCompression = BI_RGB;
 		bmi.bmiHeader.biSizeImage = x * y * 4;
+		return ::CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, (void**)ppBits, NULL, 0);
+	}
+
+	bool CRenderEngine::DecodeImageTo(const BYTE* pData, DWORD dwSize, LPBYTE pDest, int nStride, int nX, int nY, DWORD mask, bool& bAlpha)
+	{
+		bAlpha = false;
+		if( pData == NULL || dwSize == 0 || pDest == NULL || nX <= 0 || nY <= 0 || nStride < nX * 4 ) return false;
+
+		// stb先把整幅图解码为它自己分配的RGBA缓冲区，再转换写入目标，行之间没有间隙时整块转换；
+		// 解码期间的峰值内存为stb的缓冲区加目标位图
+		int x = 0, y = 0, n = 0;
+		LPBYTE pImage = stbi_load_from_memory(pData, dwSize, &x, &y, &n, 4);
+		if( pImage == NULL ) return false;
+
+		bool bRet = (x == nX && y == nY);
+		if( bRet ) {
+			if( nStride == nX * 4 ) {
+				bAlpha = CPixelKernels::ConvertImageBits(pImage, pDest, nX * nY, mask);
+			}
+			else {
+				for( int i = 0; i < nY; i++ ) {
+					if( CPixelKernels::ConvertImageBits(pImage + i * nX * 4, pDest + i * nStride, nX, mask) ) bAlpha = true;
+				}
+			}
+		}
+		stbi_image_free(pImage);
+		return bRet;
+	}
+
+	TImageInfo* CRenderEngine::DecodeImageInfo(const BYTE* pData, DWORD dwSize, DWORD mask)
+	{
+		if( pData == NULL || dwSize == 0 ) return NULL;
+		int x = 0, y = 0, n = 0;
+		if( !stbi_info_from_memory(pData, dwSize, &x, &y, &n) || x <= 0 || y <= 0 ) return NULL;
 
-		bool bAlphaChannel = false;
 		LPBYTE pDest = NULL;
-		HBITMAP hBitmap = ::CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, (void**)&pDest, NULL, 0);
-		if( !hBitmap ) {
+		HBITMAP hBitmap = CreateImageDIB(x, y, &pDest);
+		if( !hBitmap ) return NULL;
+		bool bAlphaChannel = false;
+		if( !DecodeImageTo(pData, dwSize, pDest, x * 4, x, y, mask, bAlphaChannel) ) {
+			::DeleteObject(hBitmap);
 			return NULL;
 		}
 
-		for( int i = 0; i < x * y; i++ ) 
-		{
-			pDest[i*4 + 3] = pImage[i*4 + 3];
-			if( pDest[i*4 + 3] < 255 )
-			{
-				pDest[i*4] = (BYTE)(DWORD(pImage[i*4 + 2])*pImage[i*4 + 3]/255);
-				pDest[i*4 + 1] = (BYTE)(DWORD(pImage[i*4 + 1])*pImage[i*4 + 3]/255);
-				pDest[i*4 + 2] = (BYTE)(DWORD(pImage[i*4])*pImage[i*4 + 3]/255); 
-				bAlphaChannel = true;
+		TImageInfo* data = new TImageInfo;
+		data->pBits = pDest;
+		data->pSrcBits = NULL;
+		data->hBitmap = hBitmap;
+		data->nX = x;
+		data->nY = y;
+		data->bAlpha = bAlphaChannel;
+		return data;
+	}
+
+	// 可分离的三角滤波：放大时为双线性插值，缩小时滤波宽度随比例放大，相当于按面积平均
+	// 每个目标像素对应pFirst开始的pCount个源像素，权重为14位定点数且和为1 << 14
+	static int* ComputeResampleWeights(int nSrc, int nDest, int* pFirst, int* pCount, int& nMaxCount)
+	{
+		double dScale = (double)nDest / nSrc;
+		double dSupport = dScale < 1.0 ? 1.0 / dScale : 1.0;
+		nMaxCount = (int)dSupport * 2 + 3;
+		int* pWeights = new int[nDest * nMaxCount];
+		double* pTemp = new double[nMaxCount];
+		for( int i = 0; i < nDest; i++ ) {
+			double dCenter = (i + 0.5) / dScale;
+			int iFirst = (int)(dCenter - dSupport);
+			int iLast = (int)(dCenter + dSupport) + 1;
+			if( iFirst < 0 ) iFirst = 0;
+			if( iLast > nSrc ) iLast = nSrc;
+			if( iLast - iFirst > nMaxCount ) iLast = iFirst + nMaxCount;
+
+			double dTotal = 0.0;
+			for( int j = iFirst; j < iLast; j++ ) {
+				double dDist = (j + 0.5 - dCenter) / dSupport;
+				if( dDist < 0 ) dDist = -dDist;
+				pTemp[j - iFirst] = dDist < 1.0 ? 1.0 - dDist : 0.0;
+				dTotal += pTemp[j - iFirst];
 			}
-			else
-			{
-				pDest[i*4] = pImage[i*4 + 2];
-				pDest[i*4 + 1] = pImage[i*4 + 1];
-				pDest[i*4 + 2] = pImage[i*4]; 
+
+			int* pRow = pWeights + i * nMaxCount;
+			int nTotal = 0;
+			int iMax = 0;
+			for( int k = 0; k < iLast - iFirst; k++ ) {
+				pRow[k] = dTotal > 0.0 ? (int)(pTemp[k] / dTotal * (1 << 14) + 0.5) : 0;
+				nTotal += pRow[k];
+				if( pRow[k] > pRow[iMax] ) iMax = k;
 			}
+			// 舍入误差补到最大的权重上，保证不透明区域缩放后仍不透明
+			pRow[iMax] += (1 << 14) - nTotal;
+			pFirst[i] = iFirst;
+			pCount[i] = iLast - iFirst;
+		}
+		delete[] pTemp;
+		return pWeights;
+	}
 
-			if( *(DWORD*)(&pDest[i*4]) == mask ) {
-				pDest[i*4] = (BYTE)0;
-				pDest[i*4 + 1] = (BYTE)0;
-				pDest[i*4 + 2] = (BYTE)0; 
-				pDest[i*4 + 3] = (BYTE)0;
-				bAlphaChannel = true;
+	// 预乘alpha的BGRA位图先水平后垂直缩放
+	static void ResampleImageBits(const BYTE* pSrc, int nSrcX, int nSrcY, BYTE* pDest, int nDestX, int nDestY)
+	{
+		int nMaxX = 0, nMaxY = 0;
+		int* pFirstX = new int[nDestX];
+		int* pCountX = new int[nDestX];
+		int* pWeightsX = ComputeResampleWeights(nSrcX, nDestX, pFirstX, pCountX, nMaxX);
+		int* pFirstY = new int[nDestY];
+		int* pCountY = new int[nDestY];
+		int* pWeightsY = ComputeResampleWeights(nSrcY, nDestY, pFirstY, pCountY, nMaxY);
+		BYTE* pTemp = new BYTE[nDestX * nSrcY * 4];
+
+		for( int y = 0; y < nSrcY; y++ ) {
+			const BYTE* pLine = pSrc + y * nSrcX * 4;
+			BYTE* pOut = pTemp + y * nDestX * 4;
+			for( int x = 0; x < nDestX; x++ ) {
+				const int* pWeight = pWeightsX + x * nMaxX;
+				const BYTE* pPixel = pLine + pFirstX[x] * 4;
+				int b = 0, g = 0, r = 0, a = 0;
+				for( int k = 0; k < pCountX[x]; k++, pPixel += 4 ) {
+					b += pPixel[0] * pWeight[k];
+					g += pPixel[1] * pWeight[k];
+					r += pPixel[2] * pWeight[k];
+					a += pPixel[3] * pWeight[k];
+				}
+				pOut[x * 4] = (BYTE)((b + (1 << 13)) >> 14);
+				pOut[x * 4 + 1] = (BYTE)((g + (1 << 13)) >> 14);
+				pOut[x * 4 + 2] = (BYTE)((r + (1 << 13)) >> 14);
+				pOut[x * 4 + 3] = (BYTE)((a + (1 << 13)) >> 14);
 			}
 		}
 
-		stbi_image_free(pImage);
+		for( int y = 0; y < nDestY; y++ ) {
+			const int* pWeight = pWeightsY + y * nMaxY;
+			BYTE* pOut = pDest + y * nDestX * 4;
+			for( int x = 0; x < nDestX; x++ ) {
+				const BYTE* pPixel = pTemp + (pFirstY[y] * nDestX + x) * 4;
+				int b = 0, g = 0, r = 0, a = 0;
+				for( int k = 0; k < pCountY[y]; k++, pPixel += nDestX * 4 ) {
+					b += pPixel[0] * pWeight[k];
+					g += pPixel[1] * pWeight[k];
+					r += pPixel[2] * pWeight[k];
+					a += pPixel[3] * pWeight[k];
+				}
+				a = (a + (1 << 13)) >> 14;
+				b = (b + (1 << 13)) >> 14;
+				g = (g + (1 << 13)) >> 14;
+				r = (r + (1 << 13)) >> 14;
+				// 预乘颜色不能超过alpha
+				pOut[x * 4] = (BYTE)(b > a ? a : b);
+				pOut[x * 4 + 1] = (BYTE)(g > a ? a : g);
+				pOut[x * 4 + 2] = (BYTE)(r > a ? a : r);
+				pOut[x * 4 + 3] = (BYTE)a;
+			}
+		}
+
+		delete[] pTemp;
+		delete[] pWeightsY;
+		delete[] pCountY;
+		delete[] pFirstY;
+		delete[] pWeightsX;
+		delete[] pCountX;
+		delete[] pFirstX;
+	}
+
+	int CRenderEngine::GetImageScale(LPCTSTR bitmap)
+	{
+		LPCTSTR pstrAt = bitmap != NULL ? _tcsrchr(bitmap, _T('@')) : NULL;
+		if( pstrAt == NULL || !_istdigit(pstrAt[1]) ) return 100;
+		LPTSTR pstr = NULL;
+		int nScale = _tcstol(pstrAt + 1, &pstr, 10);
+		if( *pstr != _T('.') || nScale <= 0 ) return 100;
+		return nScale;
+	}
+
+	void CRenderEngine::ScaleImageRect(RECT& rc, int nScale)
+	{
+		if( nScale == 100 || nScale <= 0 ) return;
+		rc.left = MulDiv(rc.left, nScale, 100);
+		rc.top = MulDiv(rc.top, nScale, 100);
+		rc.right = MulDiv(rc.right, nScale, 100);
+		rc.bottom = MulDiv(rc.bottom, nScale, 100);
+	}
+
+	TImageInfo* CRenderEngine::CreateScaledImage(const TImageInfo* pImageInfo, int nScale)
+	{
+		if( pImageInfo == NULL || pImageInfo->pBits == NULL || nScale <= 0 ) return NULL;
+
+		int x = MulDiv(pImageInfo->nX, nScale, 100);
+		int y = MulDiv(pImageInfo->nY, nScale, 100);
+		if( x <= 0 ) x = 1;
+		if( y <= 0 ) y = 1;
+		LPBYTE pDest = NULL;
+		HBITMAP hBitmap = CreateImageDIB(x, y, &pDest);
+		if( !hBitmap ) return NULL;
+		ResampleImageBits(pImageInfo->pBits, pImageInfo->nX, pImageInfo->nY, pDest, x, y);
 
 		TImageInfo* data = new TImageInfo;
-		data->pBits = NULL;
+		data->pBits = pDest;
 		data->pSrcBits = NULL;
 		data->hBitmap = hBitmap;
 		data->nX = x;
 		data->nY = y;
-		data->bAlpha = bAlphaChannel;
+		data->bAlpha = pImageInfo->bAlpha;
+		data->nScale = nScale;
+		return data;
+	}
+
+	TImageInfo* CRenderEngine::ApplyImageScale(TImageInfo* pImageInfo, int nScale, bool bOriginal)
+	{
+		if( pImageInfo == NULL ) return NULL;
+		if( !bOriginal ) {
+			pImageInfo->nScale = nScale;
+			return pImageInfo;
+		}
+		// GDI+图片仍在绘制时缩放
+		if( nScale == 100 || pImageInfo->pImage != NULL ) return pImageInfo;
+		TImageInfo* pScaled = CreateScaledImage(pImageInfo, nScale);
+		if( pScaled == NULL ) return pImageInfo;
+		FreeImage(pImageInfo);
+		return pScaled;
+	}
+
+	// 解码缓存文件：文件头后紧跟nX*nY个预乘alpha的BGRA像素，即DecodeImageInfo生成的位图内容
+	#define IMAGECACHE_MAGIC	0x43495544	// "DUIC"
+	#define IMAGECACHE_VERSION	1
+
+	typedef struct tagIMAGECACHEHEADER
+	{
+		DWORD dwMagic;
+		WORD wVersion;
+		WORD wAlpha;
+		DWORD dwMask;
+		LONG nX;
+		LONG nY;
+		DWORD dwReserved;
+		ULONGLONG ullHash;
+	} IMAGECACHEHEADER;
+
+	static CDuiString GetImageCacheFile(ULONGLONG ullHash, DWORD mask)
+	{
+		CDuiString sFile;
+		sFile.Format(_T("%s%08X%08X_%08X.bgra"), CPaintManagerUI::GetDecodedImageCachePath().GetData(), (DWORD)(ullHash >> 32), (DWORD)ullHash, mask);
+		return sFile;
+	}
+
+	ULONGLONG CRenderEngine::HashImageData(const BYTE* pData, DWORD dwSize)
+	{
+		// FNV-1a 64位
+		ULONGLONG ullHash = 14695981039346656037ULL;
+		for( DWORD i = 0; i < dwSize; i++ ) {
+			ullHash ^= pData[i];
+			ullHash *= 1099511628211ULL;
+		}
+		return ullHash;
+	}
+
+	TImageInfo* CRenderEngine::LoadCachedImage(ULONGLONG ullHash, DWORD mask)
+	{
+		if( CPaintManagerUI::GetDecodedImageCachePath().IsEmpty() ) return NULL;
+
+		CDuiString sFile = GetImageCacheFile(ullHash, mask);
+		HANDLE hFile = ::CreateFile(sFile.GetData(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if( hFile == INVALID_HANDLE_VALUE ) return NULL;
+		DWORD dwFileSize = ::GetFileSize(hFile, NULL);
+		HANDLE hMap = NULL;
+		if( dwFileSize != INVALID_FILE_SIZE && dwFileSize > sizeof(IMAGECACHEHEADER) ) {
+			hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		::CloseHandle(hFile);
+		if( hMap == NULL ) return NULL;
+		const BYTE* pView = (const BYTE*)::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+		::CloseHandle(hMap);
+		if( pView == NULL ) return NULL;
+
+		// 文件不完整或不匹配时返回NULL，由调用方重新解码并覆盖
+		TImageInfo* data = NULL;
+		const IMAGECACHEHEADER* pHeader = (const IMAGECACHEHEADER*)pView;
+		if( pHeader->dwMagic == IMAGECACHE_MAGIC && pHeader->wVersion == IMAGECACHE_VERSION
+			&& pHeader->ullHash == ullHash && pHeader->dwMask == mask && pHeader->nX > 0 && pHeader->nY > 0
+			&& (ULONGLONG)pHeader->nX * pHeader->nY * 4 == dwFileSize - sizeof(IMAGECACHEHEADER) ) {
+			LPBYTE pDest = NULL;
+			HBITMAP hBitmap = CreateImageDIB(pHeader->nX, pHeader->nY, &pDest);
+			if( hBitmap ) {
+				::CopyMemory(pDest, pView + sizeof(IMAGECACHEHEADER), pHeader->nX * pHeader->nY * 4);
+				data = new TImageInfo;
+				data->pBits = pDest;
+				data->pSrcBits = NULL;
+				data->hBitmap = hBitmap;
+				data->nX = pHeader->nX;
+				data->nY = pHeader->nY;
+				data->bAlpha = pHeader->wAlpha != 0;
+			}
+		}
+		::UnmapViewOfFile(pView);
+		return data;
+	}
+
+	void CRenderEngine::SaveCachedImage(ULONGLONG ullHash, DWORD mask, const TImageInfo* pImageInfo)
+	{
+		const CDuiString& sPath = CPaintManagerUI::GetDecodedImageCachePath();
+		if( sPath.IsEmpty() || pImageInfo == NULL || pImageInfo->pBits == NULL ) return;
+
+		::CreateDirectory(sPath.GetData(), NULL);
+		CDuiString sFile = GetImageCacheFile(ullHash, mask);
+		// 先写临时文件再改名，多个线程同时写入或中途退出都不会留下不完整的缓存
+		CDuiString sTemp;
+		sTemp.Format(_T("%s.%u.tmp"), sFile.GetData(), ::GetCurrentThreadId());
+		HANDLE hFile = ::CreateFile(sTemp.GetData(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if( hFile == INVALID_HANDLE_VALUE ) return;
+
+		IMAGECACHEHEADER header;
+		::ZeroMemory(&header, sizeof(IMAGECACHEHEADER));
+		header.dwMagic = IMAGECACHE_MAGIC;
+		header.wVersion = IMAGECACHE_VERSION;
+		header.wAlpha = pImageInfo->bAlpha ? 1 : 0;
+		header.dwMask = mask;
+		header.nX = pImageInfo->nX;
+		header.nY = pImageInfo->nY;
+		header.ullHash = ullHash;
+		DWORD dwBits = pImageInfo->nX * pImageInfo->nY * 4;
+		DWORD dwWritten = 0;
+		bool bWritten = ::WriteFile(hFile, &header, sizeof(IMAGECACHEHEADER), &dwWritten, NULL) && dwWritten == sizeof(IMAGECACHEHEADER);
+		if( bWritten ) bWritten = ::WriteFile(hFile, pImageInfo->pBits, dwBits, &dwWritten, NULL) && dwWritten == dwBits;
+		::CloseHandle(hFile);
+		if( !bWritten || !::MoveFileEx(sTemp.GetData(), sFile.GetData(), MOVEFILE_REPLACE_EXISTING) ) ::DeleteFile(sTemp.GetData());
+	}
+
+	TImageInfo* CRenderEngine::LoadImage(STRINGorID bitmap, LPCTSTR type, DWORD mask, HINSTANCE instance)
+	{
+		// 文件只读映射、资源直接引用，不复制压缩数据
+		DWORD dwSize = 0;
+		const BYTE* pData = MapImageData(bitmap, type, instance, dwSize);
+		if( !pData ) return NULL;
+
+		// 磁盘缓存命中时不必解码
+		bool bDiskCache = !CPaintManagerUI::GetDecodedImageCachePath().IsEmpty();
+		ULONGLONG ullHash = bDiskCache ? HashImageData(pData, dwSize) : 0;
+		TImageInfo* data = bDiskCache ? LoadCachedImage(ullHash, mask) : NULL;
+		if( data ) {
+			UnmapImageData(pData);
+			return data;
+		}
+
+		data = DecodeImageInfo(pData, dwSize, mask);
+		UnmapImageData(pData);
+		if( bDiskCache && data ) SaveCachedImage(ullHash, mask, data);
 		return data;
 	}
 
@@ -638,14 +1066,16 @@ namespace DuiLib {
 		}
 		pImageInfo->pImage = NULL;
 
-		if (pImageInfo->hBitmap) {
+		// 图集中的图片不单独拥有位图
+		if (pImageInfo->pAtlas) {
+			CImageAtlas::Release(pImageInfo);
+		}
+		else if (pImageInfo->hBitmap) {
 			::DeleteObject(pImageInfo->hBitmap);
 		}
 		pImageInfo->hBitmap = NULL;
 
-		if (pImageInfo->pBits) {
-			delete[] pImageInfo->pBits;
-		}
+		// pBits指向DIB位图内存，随hBitmap一起释放
 		pImageInfo->pBits = NULL;
 
 		if (pImageInfo->pSrcBits) {
@@ -676,6 +1106,43 @@ namespace DuiLib {
 		return LoadImage(STRINGorID(nID), type, mask, instance);
 	}
 
+	// 源与目标大小相同时用BitBlt，HALFTONE模式下StretchBlt即使不缩放也要走拉伸流程
+	static BOOL StretchImageBlt(HDC hDC, int x, int y, int cx, int cy, HDC hSrcDC, int xSrc, int ySrc, int cxSrc, int cySrc, DWORD dwRop)
+	{
+		if( cx == cxSrc && cy == cySrc ) return ::BitBlt(hDC, x, y, cx, cy, hSrcDC, xSrc, ySrc, dwRop);
+		return ::StretchBlt(hDC, x, y, cx, cy, hSrcDC, xSrc, ySrc, cxSrc, cySrc, dwRop);
+	}
+
+	// 绑定的渲染后端，每个线程各自登记
+	#define RENDERTARGET_MAX	8
+	static __declspec(thread) IRenderTarget* g_aRenderTargets[RENDERTARGET_MAX];
+	static __declspec(thread) int g_nRenderTargets = 0;
+
+	bool CRenderEngine::BindRenderTarget(IRenderTarget* pTarget)
+	{
+		if( pTarget == NULL || g_nRenderTargets >= RENDERTARGET_MAX ) return false;
+		g_aRenderTargets[g_nRenderTargets++] = pTarget;
+		return true;
+	}
+
+	void CRenderEngine::UnbindRenderTarget(IRenderTarget* pTarget)
+	{
+		for( int i = 0; i < g_nRenderTargets; i++ ) {
+			if( g_aRenderTargets[i] != pTarget ) continue;
+			for( int j = i + 1; j < g_nRenderTargets; j++ ) g_aRenderTargets[j - 1] = g_aRenderTargets[j];
+			g_aRenderTargets[--g_nRenderTargets] = NULL;
+			return;
+		}
+	}
+
+	IRenderTarget* CRenderEngine::GetRenderTarget(HDC hDC)
+	{
+		for( int i = g_nRenderTargets - 1; i >= 0; i-- ) {
+			if( g_aRenderTargets[i]->GetDC() == hDC ) return g_aRenderTargets[i];
+		}
+		return NULL;
+	}
+
 	void CRenderEngine::DrawImage(HDC hDC, HBITMAP hBitmap, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, const RECT& rcCorners, bool bAlpha, UINT uFade, bool hole, bool xtiled, bool ytiled)
 	{
 		ASSERT(::GetObjectType(hDC)==OBJ_DC || ::GetObjectType(hDC)==OBJ_MEMDC);
@@ -686,6 +1153,9 @@ namespace DuiLib {
 		if( lpAlphaBlend == NULL ) lpAlphaBlend = AlphaBitBlt;
 		if( hBitmap == NULL ) return;
 
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawImage(hBitmap, rc, rcPaint, rcBmpPart, rcCorners, bAlpha, uFade, hole, xtiled, ytiled) ) return;
+
 		HDC hCloneDC = ::CreateCompatibleDC(hDC);
 		HBITMAP hOldBitmap = (HBITMAP) ::SelectObject(hCloneDC, hBitmap);
 		::SetStretchBltMode(hDC, HALFTONE);
@@ -924,7 +1394,7 @@ namespace DuiLib {
 						if( !xtiled && !ytiled ) {
 							rcDest.right -= rcDest.left;
 							rcDest.bottom -= rcDest.top;
-							::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+							StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 								rcBmpPart.left + rcCorners.left, rcBmpPart.top + rcCorners.top, \
 								rcBmpPart.right - rcBmpPart.left - rcCorners.left - rcCorners.right, \
 								rcBmpPart.bottom - rcBmpPart.top - rcCorners.top - rcCorners.bottom, SRCCOPY);
@@ -967,7 +1437,7 @@ namespace DuiLib {
 									lDrawWidth -= lDestRight - rcDest.right;
 									lDestRight = rcDest.right;
 								}
-								::StretchBlt(hDC, lDestLeft, rcDest.top, lDestRight - lDestLeft, rcDest.bottom, 
+								StretchImageBlt(hDC, lDestLeft, rcDest.top, lDestRight - lDestLeft, rcDest.bottom, 
 									hCloneDC, rcBmpPart.left + rcCorners.left, rcBmpPart.top + rcCorners.top, \
 									lDrawWidth, rcBmpPart.bottom - rcBmpPart.top - rcCorners.top - rcCorners.bottom, SRCCOPY);
 							}
@@ -983,7 +1453,7 @@ namespace DuiLib {
 									lDrawHeight -= lDestBottom - rcDest.bottom;
 									lDestBottom = rcDest.bottom;
 								}
-								::StretchBlt(hDC, rcDest.left, rcDest.top + lHeight * i, rcDest.right, lDestBottom - lDestTop, 
+								StretchImageBlt(hDC, rcDest.left, rcDest.top + lHeight * i, rcDest.right, lDestBottom - lDestTop, 
 									hCloneDC, rcBmpPart.left + rcCorners.left, rcBmpPart.top + rcCorners.top, \
 									rcBmpPart.right - rcBmpPart.left - rcCorners.left - rcCorners.right, lDrawHeight, SRCCOPY);                    
 							}
@@ -1002,7 +1472,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.left, rcBmpPart.top, rcCorners.left, rcCorners.top, SRCCOPY);
 					}
 				}
@@ -1017,7 +1487,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.left + rcCorners.left, rcBmpPart.top, rcBmpPart.right - rcBmpPart.left - \
 							rcCorners.left - rcCorners.right, rcCorners.top, SRCCOPY);
 					}
@@ -1033,7 +1503,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.right - rcCorners.right, rcBmpPart.top, rcCorners.right, rcCorners.top, SRCCOPY);
 					}
 				}
@@ -1048,7 +1518,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.left, rcBmpPart.top + rcCorners.top, rcCorners.left, rcBmpPart.bottom - \
 							rcBmpPart.top - rcCorners.top - rcCorners.bottom, SRCCOPY);
 					}
@@ -1064,7 +1534,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.right - rcCorners.right, rcBmpPart.top + rcCorners.top, rcCorners.right, \
 							rcBmpPart.bottom - rcBmpPart.top - rcCorners.top - rcCorners.bottom, SRCCOPY);
 					}
@@ -1080,7 +1550,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.left, rcBmpPart.bottom - rcCorners.bottom, rcCorners.left, rcCorners.bottom, SRCCOPY);
 					}
 				}
@@ -1095,7 +1565,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.left + rcCorners.left, rcBmpPart.bottom - rcCorners.bottom, \
 							rcBmpPart.right - rcBmpPart.left - rcCorners.left - rcCorners.right, rcCorners.bottom, SRCCOPY);
 					}
@@ -1111,7 +1581,7 @@ namespace DuiLib {
 					if( ::IntersectRect(&rcTemp, &rcPaint, &rcDest) ) {
 						rcDest.right -= rcDest.left;
 						rcDest.bottom -= rcDest.top;
-						::StretchBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
+						StretchImageBlt(hDC, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, hCloneDC, \
 							rcBmpPart.right - rcCorners.right, rcBmpPart.bottom - rcCorners.bottom, rcCorners.right, \
 							rcCorners.bottom, SRCCOPY);
 					}
@@ -1273,6 +1743,7 @@ namespace DuiLib {
 		// GDI
 		bool bAlphaChannel = false;
 		HBITMAP hBitmap = NULL;
+		LPBYTE pBits = NULL;
 		int x,y,n;
 		LPBYTE pImage = stbi_load_from_memory(pData, dwSize, &x, &y, &n, 4);
 		if(pImage != NULL) {
@@ -1289,31 +1760,8 @@ namespace DuiLib {
 			LPBYTE pDest = NULL;
 			hBitmap = ::CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, (void**)&pDest, NULL, 0);
 			if(hBitmap != NULL) {
-				for( int i = 0; i < x * y; i++ ) 
-				{
-					pDest[i*4 + 3] = pImage[i*4 + 3];
-					if( pDest[i*4 + 3] < 255 )
-					{
-						pDest[i*4] = (BYTE)(DWORD(pImage[i*4 + 2])*pImage[i*4 + 3]/255);
-						pDest[i*4 + 1] = (BYTE)(DWORD(pImage[i*4 + 1])*pImage[i*4 + 3]/255);
-						pDest[i*4 + 2] = (BYTE)(DWORD(pImage[i*4])*pImage[i*4 + 3]/255); 
-						bAlphaChannel = true;
-					}
-					else
-					{
-						pDest[i*4] = pImage[i*4 + 2];
-						pDest[i*4 + 1] = pImage[i*4 + 1];
-						pDest[i*4 + 2] = pImage[i*4]; 
-					}
-
-					if( *(DWORD*)(&pDest[i*4]) == mask ) {
-						pDest[i*4] = (BYTE)0;
-						pDest[i*4 + 1] = (BYTE)0;
-						pDest[i*4 + 2] = (BYTE)0; 
-						pDest[i*4 + 3] = (BYTE)0;
-						bAlphaChannel = true;
-					}
-				}
+				bAlphaChannel = CPixelKernels::ConvertImageBits(pImage, pDest, x * y, mask);
+				pBits = pDest;
 				stbi_image_free(pImage);
 			}
 		}
@@ -1342,7 +1790,7 @@ namespace DuiLib {
 		}
 
 		TImageInfo* data = new TImageInfo;
-		data->pBits = NULL;
+		data->pBits = pBits;
 		data->pSrcBits = NULL;
 		data->pImage = pGdiplusImage;
 		data->hBitmap = hBitmap;
@@ -1556,6 +2004,9 @@ namespace DuiLib {
 	{
 		if( color <= 0x00FFFFFF ) return;
 
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawColor(rc, color) ) return;
+
 		Gdiplus::Graphics graphics( hDC );
 		Gdiplus::SolidBrush brush(Gdiplus::Color((LOBYTE((color)>>24)), GetBValue(color), GetGValue(color), GetRValue(color)));
 		graphics.FillRectangle(&brush, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
@@ -1571,6 +2022,10 @@ namespace DuiLib {
 
 		BYTE bAlpha = (BYTE)(((dwFirst >> 24) + (dwSecond >> 24)) >> 1);
 		if( bAlpha == 0 ) return;
+
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawGradient(rc, dwFirst, dwSecond, bVertical, nSteps) ) return;
+
 		int cx = rc.right - rc.left;
 		int cy = rc.bottom - rc.top;
 		RECT rcPaint = rc;
@@ -1647,6 +2102,9 @@ namespace DuiLib {
 	{
 		ASSERT(::GetObjectType(hDC)==OBJ_DC || ::GetObjectType(hDC)==OBJ_MEMDC);
 
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawLine(rc, nSize, dwPenColor, nStyle) ) return;
+
 		LOGPEN lg;
 		lg.lopnColor = RGB(GetBValue(dwPenColor), GetGValue(dwPenColor), GetRValue(dwPenColor));
 		lg.lopnStyle = nStyle;
@@ -1662,6 +2120,9 @@ namespace DuiLib {
 
 	void CRenderEngine::DrawRect(HDC hDC, const RECT& rc, int nSize, DWORD dwPenColor,int nStyle /*= PS_SOLID*/)
 	{
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawRect(rc, nSize, dwPenColor, nStyle) ) return;
+
 #ifdef USE_GDI_RENDER
 		ASSERT(::GetObjectType(hDC) == OBJ_DC || ::GetObjectType(hDC) == OBJ_MEMDC);
 		HPEN hPen = ::CreatePen(nStyle | PS_INSIDEFRAME, nSize, RGB(GetBValue(dwPenColor), GetGValue(dwPenColor), GetRValue(dwPenColor)));
@@ -1683,6 +2144,9 @@ namespace DuiLib {
 
 	void CRenderEngine::DrawRoundRect(HDC hDC, const RECT& rc, int nSize, int width, int height, DWORD dwPenColor, int nStyle /*= PS_SOLID*/)
 	{
+		IRenderTarget* pTarget = GetRenderTarget(hDC);
+		if( pTarget != NULL && pTarget->DrawRoundRect(rc, nSize, width, height, dwPenColor, nStyle) ) return;
+
 #ifdef USE_GDI_RENDER
 		ASSERT(::GetObjectType(hDC)==OBJ_DC || ::GetObjectType(hDC)==OBJ_MEMDC);
 		HPEN hPen = ::CreatePen(nStyle, nSize, RGB(GetBValue(dwPenColor), GetGValue(dwPenColor), GetRValue(dwPenColor)));
@@ -1774,8 +2238,10 @@ namespace DuiLib {
 
 		RECT rcClip = { 0 };
 		::GetClipBox(hDC, &rcClip);
+		rcClip = ClipRectToDevice(hDC, rcClip);
 		HRGN hOldRgn = ::CreateRectRgnIndirect(&rcClip);
-		HRGN hRgn = ::CreateRectRgnIndirect(&rc);
+		RECT rcDevice = ClipRectToDevice(hDC, rc);
+		HRGN hRgn = ::CreateRectRgnIndirect(&rcDevice);
 		if( bDraw ) ::ExtSelectClipRgn(hDC, hRgn, RGN_AND);
 
 		TFontInfo* pDefFontInfo = pManager->GetFontInfo(iFont);
@@ -1914,9 +2380,7 @@ namespace DuiLib {
 							TFontInfo* pFontInfo = pDefFontInfo;
 							if( aFontArray.GetSize() > 0 ) pFontInfo = (TFontInfo*)aFontArray.GetAt(aFontArray.GetSize() - 1);
 							if( pFontInfo->bUnderline == false ) {
-								HFONT hFont = pManager->GetFont(pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								if( hFont == NULL ) hFont = pManager->AddFont(g_iFontID, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								pFontInfo = pManager->GetFontInfo(hFont);
+								pFontInfo = GetHtmlFontInfo(pManager, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
 								aFontArray.Add(pFontInfo);
 								pTm = &pFontInfo->tm;
 								::SelectObject(hDC, pFontInfo->hFont);
@@ -1932,9 +2396,7 @@ namespace DuiLib {
 							TFontInfo* pFontInfo = pDefFontInfo;
 							if( aFontArray.GetSize() > 0 ) pFontInfo = (TFontInfo*)aFontArray.GetAt(aFontArray.GetSize() - 1);
 							if( pFontInfo->bBold == false ) {
-								HFONT hFont = pManager->GetFont(pFontInfo->sFontName, pFontInfo->iSize, true, pFontInfo->bUnderline, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								if( hFont == NULL ) hFont = pManager->AddFont(g_iFontID, pFontInfo->sFontName, pFontInfo->iSize, true, pFontInfo->bUnderline, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								pFontInfo = pManager->GetFontInfo(hFont);
+								pFontInfo = GetHtmlFontInfo(pManager, pFontInfo->sFontName, pFontInfo->iSize, true, pFontInfo->bUnderline, pFontInfo->bItalic, pFontInfo->bStrikeout);
 								aFontArray.Add(pFontInfo);
 								pTm = &pFontInfo->tm;
 								::SelectObject(hDC, pFontInfo->hFont);
@@ -1994,9 +2456,7 @@ namespace DuiLib {
 								if( sFontAttr.Find(_T("underline")) >= 0 ) bUnderline = true;
 								if( sFontAttr.Find(_T("italic")) >= 0 ) bItalic = true;
 								if( sFontAttr.Find(_T("strikeout")) >= 0 ) bStrikeout = true;
-								HFONT hFont = pManager->GetFont(sFontName, iFontSize, bBold, bUnderline, bItalic, bStrikeout);
-								if( hFont == NULL ) hFont = pManager->AddFont(g_iFontID, sFontName, iFontSize, bBold, bUnderline, bItalic, bStrikeout);
-								TFontInfo* pFontInfo = pManager->GetFontInfo(hFont);
+								TFontInfo* pFontInfo = GetHtmlFontInfo(pManager, sFontName, iFontSize, bBold, bUnderline, bItalic, bStrikeout);
 								aFontArray.Add(pFontInfo);
 								pTm = &pFontInfo->tm;
 								::SelectObject(hDC, pFontInfo->hFont);
@@ -2025,9 +2485,7 @@ namespace DuiLib {
 								TFontInfo* pFontInfo = pDefFontInfo;
 								if( aFontArray.GetSize() > 0 ) pFontInfo = (TFontInfo*)aFontArray.GetAt(aFontArray.GetSize() - 1);
 								if( pFontInfo->bItalic == false ) {
-									HFONT hFont = pManager->GetFont(pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, pFontInfo->bUnderline, pFontInfo->bStrikeout, true);
-									if( hFont == NULL ) hFont = pManager->AddFont(g_iFontID, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, pFontInfo->bUnderline, pFontInfo->bStrikeout, true);
-									pFontInfo = pManager->GetFontInfo(hFont);
+									pFontInfo = GetHtmlFontInfo(pManager, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, pFontInfo->bUnderline, pFontInfo->bStrikeout, true);
 									aFontArray.Add(pFontInfo);
 									pTm = &pFontInfo->tm;
 									::SelectObject(hDC, pFontInfo->hFont);
@@ -2158,9 +2616,7 @@ namespace DuiLib {
 							TFontInfo* pFontInfo = pDefFontInfo;
 							if( aFontArray.GetSize() > 0 ) pFontInfo = (TFontInfo*)aFontArray.GetAt(aFontArray.GetSize() - 1);
 							if( pFontInfo->bUnderline == false ) {
-								HFONT hFont = pManager->GetFont(pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								if( hFont == NULL ) hFont = pManager->AddFont(g_iFontID, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
-								pFontInfo = pManager->GetFontInfo(hFont);
+								pFontInfo = GetHtmlFontInfo(pManager, pFontInfo->sFontName, pFontInfo->iSize, pFontInfo->bBold, true, pFontInfo->bItalic, pFontInfo->bStrikeout);
 								aFontArray.Add(pFontInfo);
 								pTm = &pFontInfo->tm;
 								::SelectObject(hDC, pFontInfo->hFont);
@@ -2598,17 +3054,42 @@ namespace DuiLib {
 			return;
 		}
 
-		float fH, fS, fL;
-		float S1 = S / 100.0f;
-		float L1 = L / 100.0f;
-		for( int i = 0; i < imageInfo->nX * imageInfo->nY; i++ ) {
-			RGBtoHSL(*(DWORD*)(imageInfo->pSrcBits + i*4), &fH, &fS, &fL);
-			fH += (H - 180);
-			fH = fH > 0 ? fH : fH + 360; 
-			fS *= S1;
-			fL *= L1;
-			HSLtoRGB((DWORD*)(imageInfo->pBits + i*4), fH, fS, fL);
+		// 直接改写DIB内存前先完成未执行的GDI操作
+		::GdiFlush();
+
+		int nPixels = imageInfo->nX * imageInfo->nY;
+		SYSTEM_INFO si;
+		::GetSystemInfo(&si);
+		int nTasks = min((int)si.dwNumberOfProcessors, nPixels / HSL_TASK_PIXELS);
+		HANDLE hDone = nTasks > 1 ? ::CreateEvent(NULL, TRUE, FALSE, NULL) : NULL;
+		if( hDone == NULL ) {
+			AdjustImageBits((const DWORD*)imageInfo->pSrcBits, (DWORD*)imageInfo->pBits, nPixels, H, S, L);
+			return;
 		}
+
+		// 大图按行分块交给线程池，当前线程处理第一块
+		volatile LONG nPending = nTasks - 1;
+		HSLTASK* pTasks = new HSLTASK[nTasks];
+		int nRows = (imageInfo->nY + nTasks - 1) / nTasks;
+		for( int i = 0; i < nTasks; i++ ) {
+			int iTop = min(i * nRows, imageInfo->nY);
+			int iBottom = min(iTop + nRows, imageInfo->nY);
+			pTasks[i].pSrc = (const DWORD*)imageInfo->pSrcBits + iTop * imageInfo->nX;
+			pTasks[i].pDest = (DWORD*)imageInfo->pBits + iTop * imageInfo->nX;
+			pTasks[i].nPixels = (iBottom - iTop) * imageInfo->nX;
+			pTasks[i].H = H;
+			pTasks[i].S = S;
+			pTasks[i].L = L;
+			pTasks[i].pnPending = &nPending;
+			pTasks[i].hDone = hDone;
+		}
+		for( int i = 1; i < nTasks; i++ ) {
+			if( !::QueueUserWorkItem(AdjustImageBitsTask, &pTasks[i], WT_EXECUTEDEFAULT) ) AdjustImageBitsTask(&pTasks[i]);
+		}
+		AdjustImageBits(pTasks[0].pSrc, pTasks[0].pDest, pTasks[0].nPixels, H, S, L);
+		::WaitForSingleObject(hDone, INFINITE);
+		::CloseHandle(hDone);
+		delete[] pTasks;
 	}
 
 } // namespace DuiLib
@@ -26,6 +26,24 @@ namespace DuiLib {
 		static void UseOldClipEnd(HDC hDC, CRenderClip& clip);
 	};
 
+	/////////////////////////////////////////////////////////////////////////////////////
+	//
+	// 渲染后端：绑定到HDC后，CRenderEngine在该HDC上的图元绘制先交给它，返回false时仍用GDI/GDI+绘制
+	// 没有绑定时就是默认的GDI后端；文字总是由GDI/GDI+绘制
+	class IRenderTarget
+	{
+	public:
+		virtual ~IRenderTarget() {}
+		virtual HDC GetDC() const = 0;
+		virtual bool DrawColor(const RECT& rc, DWORD color) = 0;
+		virtual bool DrawGradient(const RECT& rc, DWORD dwFirst, DWORD dwSecond, bool bVertical, int nSteps) = 0;
+		virtual bool DrawLine(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle) = 0;
+		virtual bool DrawRect(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle) = 0;
+		virtual bool DrawRoundRect(const RECT& rc, int nSize, int width, int height, DWORD dwPenColor, int nStyle) = 0;
+		virtual bool DrawImage(HBITMAP hBitmap, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, const RECT& rcCorners, \
+			bool bAlpha, UINT uFade, bool hole, bool xtiled, bool ytiled) = 0;
+	};
+
 	/////////////////////////////////////////////////////////////////////////////////////
 	//
 
@@ -40,11 +58,37 @@ namespace DuiLib {
 		static void FreeImage(TImageInfo* pImageInfo, bool bDelete = true);
 		static TImageInfo* LoadImage(LPCTSTR pStrImage, LPCTSTR type = NULL, DWORD mask = 0, HINSTANCE instance = NULL);
 		static TImageInfo* LoadImage(UINT nID, LPCTSTR type = NULL, DWORD mask = 0, HINSTANCE instance = NULL);
+		// 不复制的读取：磁盘文件只读映射，资源直接引用模块中的数据，zip中的文件解压到独立页面；用UnmapImageData释放
+		static const BYTE* MapImageData(STRINGorID bitmap, LPCTSTR type, HINSTANCE instance, DWORD& dwSize);
+		static void UnmapImageData(const BYTE* pData);
+		// stb先解码到它自己的RGBA缓冲区，再转换为预乘alpha的BGRA写入pDest（每行nStride字节），
+		// 峰值内存为stb的缓冲区加pDest；nX/nY须与图片尺寸一致；可在工作线程调用
+		static bool DecodeImageTo(const BYTE* pData, DWORD dwSize, LPBYTE pDest, int nStride, int nX, int nY, DWORD mask, bool& bAlpha);
+		// 按文件头尺寸创建DIB，用DecodeImageTo把stb解码出的RGBA转换一次写入DIB，峰值内存为stb的缓冲区加DIB
+		static TImageInfo* DecodeImageInfo(const BYTE* pData, DWORD dwSize, DWORD mask);
+		// 用CImageProbe解析文件头取得尺寸和是否可能带透明，不解码像素；无法识别的格式返回false
+		static bool ProbeImage(STRINGorID bitmap, LPCTSTR type, HINSTANCE instance, int& x, int& y, bool& bAlpha);
+		// 解码缓存：以源数据内容哈希和mask为键，在CPaintManagerUI::GetDecodedImageCachePath()下保存转换后的位图
+		static ULONGLONG HashImageData(const BYTE* pData, DWORD dwSize);
+		static TImageInfo* LoadCachedImage(ULONGLONG ullHash, DWORD mask);
+		static void SaveCachedImage(ULONGLONG ullHash, DWORD mask, const TImageInfo* pImageInfo);
+		// DPI图片变体：name@150.png返回150，没有比例后缀返回100
+		static int GetImageScale(LPCTSTR bitmap);
+		static TImageInfo* CreateScaledImage(const TImageInfo* pImageInfo, int nScale);
+		// bOriginal为true表示变体文件不存在、加载的是原图，此时缩放一次并释放原图，返回实际使用的图片
+		static TImageInfo* ApplyImageScale(TImageInfo* pImageInfo, int nScale, bool bOriginal);
+		// 绘制字符串中的source、corner使用皮肤坐标，换算为按nScale%制作的位图（TImageInfo::nScale）中的像素
+		static void ScaleImageRect(RECT& rc, int nScale);
 
 		static void DrawImage(HDC hDC, HBITMAP hBitmap, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, const RECT& rcCorners, bool bAlpha, UINT uFade = 255, bool hole = false, bool xtiled = false, bool ytiled = false);
 		static bool DrawImageInfo(HDC hDC, CPaintManagerUI* pManager, const RECT& rcItem, const RECT& rcPaint, const TDrawInfo* pDrawInfo, HINSTANCE instance = NULL);
 		static bool DrawImageString(HDC hDC, CPaintManagerUI* pManager, const RECT& rcItem, const RECT& rcPaint, LPCTSTR pStrImage, LPCTSTR pStrModify = NULL, HINSTANCE instance = NULL);
 
+		// 渲染后端按线程登记，同一线程最多同时绑定8个；绘制时按HDC查找，后绑定的优先
+		static bool BindRenderTarget(IRenderTarget* pTarget);
+		static void UnbindRenderTarget(IRenderTarget* pTarget);
+		static IRenderTarget* GetRenderTarget(HDC hDC);
+
 		// Gdiplus绘制
 		static TImageInfo* GdiplusLoadImage(STRINGorID bitmap, LPCTSTR type = NULL, DWORD mask = 0, HINSTANCE instance = NULL);
 		static void GdiplusDrawImage(HDC hDC, Gdiplus::Image* image, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, bool bAlpha, UINT uFade = 255, UINT uRotate = 0);
@@ -0,0 +1,225 @@
+﻿#include "StdAfx.h"
+#include "UIRenderTarget.h"
+
+namespace DuiLib {
+
+	// 取得32位DIB最上面一行的地址和行偏移，自下而上的位图行偏移为负
+	static bool GetDIBSurface(HBITMAP hBitmap, LPBYTE& pBits, int& nWidth, int& nHeight, int& nStride)
+	{
+		DIBSECTION ds;
+		if( hBitmap == NULL || ::GetObject(hBitmap, sizeof(DIBSECTION), &ds) != sizeof(DIBSECTION) ) return false;
+		if( ds.dsBm.bmBitsPixel != 32 || ds.dsBm.bmBits == NULL || ds.dsBmih.biCompression != BI_RGB ) return false;
+		nWidth = ds.dsBm.bmWidth;
+		nHeight = ds.dsBm.bmHeight;
+		nStride = ds.dsBm.bmWidthBytes;
+		pBits = (LPBYTE)ds.dsBm.bmBits;
+		if( ds.dsBmih.biHeight > 0 ) {
+			pBits += (ptrdiff_t)(nHeight - 1) * nStride;
+			nStride = -nStride;
+		}
+		return true;
+	}
+
+	CSoftRenderTarget::CSoftRenderTarget(HDC hDC) :
+		m_hDC(hDC),
+		m_bBound(false),
+		m_hClipRgn(NULL),
+		m_pRgnData(NULL),
+		m_dwRgnData(0),
+		m_pClipRects(NULL),
+		m_nClipRects(0),
+		m_bGdiFallback(true),
+		m_bSkipped(false)
+	{
+		::ZeroMemory(&m_rcFull, sizeof(RECT));
+		m_ptOrigin.x = m_ptOrigin.y = 0;
+
+		LPBYTE pBits = NULL;
+		int cx = 0, cy = 0, nStride = 0;
+		if( hDC != NULL && GetDIBSurface((HBITMAP)::GetCurrentObject(hDC, OBJ_BITMAP), pBits, cx, cy, nStride) ) {
+			m_Rasterizer.Attach(pBits, cx, cy, nStride);
+			m_rcFull.right = cx;
+			m_rcFull.bottom = cy;
+			m_hClipRgn = ::CreateRectRgn(0, 0, 0, 0);
+			if( m_hClipRgn != NULL ) m_bBound = CRenderEngine::BindRenderTarget(this);
+		}
+	}
+
+	CSoftRenderTarget::~CSoftRenderTarget()
+	{
+		if( m_bBound ) CRenderEngine::UnbindRenderTarget(this);
+		if( m_hClipRgn != NULL ) ::DeleteObject(m_hClipRgn);
+		if( m_pRgnData ) delete[] m_pRgnData;
+	}
+
+	bool CSoftRenderTarget::IsValid() const
+	{
+		return m_bBound;
+	}
+
+	CRasterizer& CSoftRenderTarget::GetRasterizer()
+	{
+		return m_Rasterizer;
+	}
+
+	HDC CSoftRenderTarget::GetDC() const
+	{
+		return m_hDC;
+	}
+
+	void CSoftRenderTarget::SetGdiFallback(bool bFallback)
+	{
+		m_bGdiFallback = bFallback;
+	}
+
+	bool CSoftRenderTarget::HasSkippedDraw() const
+	{
+		return m_bSkipped;
+	}
+
+	// 不支持的绘制：通常返回false交给GDI；不允许回到GDI时记录下来，返回true跳过这次绘制
+	bool CSoftRenderTarget::_Unsupported()
+	{
+		if( m_bGdiFallback ) return false;
+		m_bSkipped = true;
+		return true;
+	}
+
+	// 读取DC当前的原点和裁剪区域，返回裁剪矩形的个数；DC有坐标变换时返回-1，交给GDI绘制
+	int CSoftRenderTarget::_BeginDraw()
+	{
+		if( ::GetMapMode(m_hDC) != MM_TEXT || ::GetGraphicsMode(m_hDC) == GM_ADVANCED ) return -1;
+		// GDI的绘制是批量提交的，直接写位图内存之前先让它完成
+		::GdiFlush();
+
+		POINT pt = { 0, 0 };
+		::LPtoDP(m_hDC, &pt, 1);
+		m_ptOrigin = pt;
+
+		m_pClipRects = &m_rcFull;
+		m_nClipRects = 1;
+		if( ::GetClipRgn(m_hDC, m_hClipRgn) == 1 ) {
+			DWORD dwSize = ::GetRegionData(m_hClipRgn, 0, NULL);
+			if( dwSize == 0 ) return -1;
+			if( dwSize > m_dwRgnData ) {
+				if( m_pRgnData ) delete[] m_pRgnData;
+				m_pRgnData = new BYTE[dwSize];
+				m_dwRgnData = dwSize;
+			}
+			LPRGNDATA pRgnData = (LPRGNDATA)m_pRgnData;
+			if( ::GetRegionData(m_hClipRgn, dwSize, pRgnData) == 0 ) return -1;
+			m_pClipRects = (const RECT*)pRgnData->Buffer;
+			m_nClipRects = pRgnData->rdh.nCount;
+		}
+		return m_nClipRects;
+	}
+
+	void CSoftRenderTarget::_SetClip(int iClip, const RECT* prcLimit)
+	{
+		RECT rcClip = m_pClipRects[iClip];
+		if( prcLimit != NULL ) {
+			if( rcClip.left < prcLimit->left ) rcClip.left = prcLimit->left;
+			if( rcClip.top < prcLimit->top ) rcClip.top = prcLimit->top;
+			if( rcClip.right > prcLimit->right ) rcClip.right = prcLimit->right;
+			if( rcClip.bottom > prcLimit->bottom ) rcClip.bottom = prcLimit->bottom;
+		}
+		m_Rasterizer.SetClip(rcClip);
+	}
+
+	RECT CSoftRenderTarget::_ToDevice(const RECT& rc) const
+	{
+		RECT rcDevice = rc;
+		::OffsetRect(&rcDevice, m_ptOrigin.x, m_ptOrigin.y);
+		return rcDevice;
+	}
+
+	bool CSoftRenderTarget::DrawColor(const RECT& rc, DWORD color)
+	{
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		RECT rcDest = _ToDevice(rc);
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i);
+			m_Rasterizer.FillRect(rcDest, color);
+		}
+		return true;
+	}
+
+	bool CSoftRenderTarget::DrawGradient(const RECT& rc, DWORD dwFirst, DWORD dwSecond, bool bVertical, int nSteps)
+	{
+		// 与GradientFill一样连续过渡，不按nSteps分级
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		RECT rcDest = _ToDevice(rc);
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i);
+			m_Rasterizer.FillGradient(rcDest, dwFirst, dwSecond, bVertical);
+		}
+		return true;
+	}
+
+	bool CSoftRenderTarget::DrawLine(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle)
+	{
+		if( nStyle != PS_SOLID ) return _Unsupported();
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		// GDI画笔不支持透明度
+		RECT rcDest = _ToDevice(rc);
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i);
+			m_Rasterizer.DrawLine(rcDest.left, rcDest.top, rcDest.right, rcDest.bottom, nSize, dwPenColor | 0xFF000000);
+		}
+		return true;
+	}
+
+	bool CSoftRenderTarget::DrawRect(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle)
+	{
+		if( nStyle != PS_SOLID ) return _Unsupported();
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		RECT rcDest = _ToDevice(rc);
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i);
+			m_Rasterizer.FrameRect(rcDest, nSize, dwPenColor);
+		}
+		return true;
+	}
+
+	bool CSoftRenderTarget::DrawRoundRect(const RECT& rc, int nSize, int width, int height, DWORD dwPenColor, int nStyle)
+	{
+		if( nStyle != PS_SOLID ) return _Unsupported();
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		RECT rcDest = _ToDevice(rc);
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i);
+			m_Rasterizer.FrameRoundRect(rcDest, width / 2, height / 2, nSize, dwPenColor);
+		}
+		return true;
+	}
+
+	bool CSoftRenderTarget::DrawImage(HBITMAP hBitmap, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, const RECT& rcCorners, \
+		bool bAlpha, UINT uFade, bool hole, bool xtiled, bool ytiled)
+	{
+		LPBYTE pSrc = NULL;
+		int cx = 0, cy = 0, nStride = 0;
+		if( !GetDIBSurface(hBitmap, pSrc, cx, cy, nStride) ) return _Unsupported();
+		// 源区域或九宫格超出位图时GDI会自行裁剪，这里不直接读取
+		if( rcBmpPart.left < 0 || rcBmpPart.top < 0 || rcBmpPart.right > cx || rcBmpPart.bottom > cy ) return _Unsupported();
+		if( rcCorners.left < 0 || rcCorners.top < 0 || rcCorners.right < 0 || rcCorners.bottom < 0 ) return _Unsupported();
+		if( rcCorners.left + rcCorners.right > rcBmpPart.right - rcBmpPart.left ) return _Unsupported();
+		if( rcCorners.top + rcCorners.bottom > rcBmpPart.bottom - rcBmpPart.top ) return _Unsupported();
+
+		int nClips = _BeginDraw();
+		if( nClips < 0 ) return _Unsupported();
+		RECT rcDest = _ToDevice(rc);
+		RECT rcLimit = _ToDevice(rcPaint);
+		bool bBlend = bAlpha || uFade < 255;
+		for( int i = 0; i < nClips; i++ ) {
+			_SetClip(i, &rcLimit);
+			m_Rasterizer.DrawNinePatch(rcDest, pSrc, nStride, rcBmpPart, rcCorners, bBlend, (BYTE)uFade, hole, xtiled, ytiled);
+		}
+		return true;
+	}
+
+} // namespace DuiLib
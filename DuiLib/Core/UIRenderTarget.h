@@ -0,0 +1,62 @@
+﻿#ifndef __UIRENDERTARGET_H__
+#define __UIRENDERTARGET_H__
+
+#pragma once
+
+namespace DuiLib {
+
+	// 软件渲染后端：hDC须已选入32位DIB（例如CRenderEngine::CreateARGB32Bitmap创建的位图），
+	// 构造时绑定到hDC，之后CRenderEngine在该DC上的图元绘制由CRasterizer直接写入位图内存，析构时解除绑定
+	// 遵守DC的裁剪区域和窗口原点；不支持的情况（虚线、非DIB位图等）返回false，由CRenderEngine继续用GDI绘制
+	// 不需要窗口，也可以用来离屏绘制控件：
+	//     CSoftRenderTarget target(hMemDC);
+	//     pControl->Paint(hMemDC, rcPaint, NULL);
+	class UILIB_API CSoftRenderTarget : public IRenderTarget
+	{
+	public:
+		explicit CSoftRenderTarget(HDC hDC);
+		virtual ~CSoftRenderTarget();
+
+		bool IsValid() const;
+		CRasterizer& GetRasterizer();
+		// 默认不支持的绘制交给GDI；分块并行绘制时设为false，不支持的绘制直接跳过并由HasSkippedDraw()报告，
+		// 调用者改为在窗口线程重画（同一位图不能同时选入多个线程的DC）
+		void SetGdiFallback(bool bFallback);
+		bool HasSkippedDraw() const;
+
+		virtual HDC GetDC() const;
+		virtual bool DrawColor(const RECT& rc, DWORD color);
+		virtual bool DrawGradient(const RECT& rc, DWORD dwFirst, DWORD dwSecond, bool bVertical, int nSteps);
+		virtual bool DrawLine(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle);
+		virtual bool DrawRect(const RECT& rc, int nSize, DWORD dwPenColor, int nStyle);
+		virtual bool DrawRoundRect(const RECT& rc, int nSize, int width, int height, DWORD dwPenColor, int nStyle);
+		virtual bool DrawImage(HBITMAP hBitmap, const RECT& rc, const RECT& rcPaint, const RECT& rcBmpPart, const RECT& rcCorners, \
+			bool bAlpha, UINT uFade, bool hole, bool xtiled, bool ytiled);
+
+	private:
+		CSoftRenderTarget(const CSoftRenderTarget&);
+		CSoftRenderTarget& operator=(const CSoftRenderTarget&);
+
+		int _BeginDraw();
+		void _SetClip(int iClip, const RECT* prcLimit = NULL);
+		RECT _ToDevice(const RECT& rc) const;
+		bool _Unsupported();
+
+	private:
+		HDC m_hDC;
+		bool m_bBound;
+		CRasterizer m_Rasterizer;
+		HRGN m_hClipRgn;
+		LPBYTE m_pRgnData;
+		DWORD m_dwRgnData;
+		const RECT* m_pClipRects;
+		int m_nClipRects;
+		RECT m_rcFull;
+		POINT m_ptOrigin;
+		bool m_bGdiFallback;
+		bool m_bSkipped;
+	};
+
+} // namespace DuiLib
+
+#endif // __UIRENDERTARGET_H__
@@ -159,6 +159,95 @@ namespace DuiLib {
 		}
 	}
 
+	// 语言文件可能很大，按流式解析，只保留根节点下<Text>节点的id和value
+	// 解析成功前条目只暂存在m_mapStaged中，失败时不改动已加载的文本
+	class CLanguageTextHandler : public IMarkupHandler
+	{
+	public:
+		CLanguageTextHandler() : m_nDepth(0), m_nTextDepth(0), m_bId(false), m_bValue(false)
+		{
+		}
+
+		~CLanguageTextHandler()
+		{
+			for( int i = 0; i < m_mapStaged.GetSize(); i++ ) {
+				if( LPCTSTR key = m_mapStaged.GetAt(i) ) delete static_cast<CDuiString*>(m_mapStaged.Find(key));
+			}
+		}
+
+		virtual bool OnStartElement(LPCTSTR pstrName)
+		{
+			m_nDepth++;
+			// <Text>的子节点不影响<Text>自身的状态
+			if( m_nTextDepth == 0 && m_nDepth == 2 && _tcsicmp(pstrName, _T("Text")) == 0 ) {
+				m_nTextDepth = m_nDepth;
+				m_bId = m_bValue = false;
+			}
+			return true;
+		}
+
+		virtual bool OnAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+		{
+			if( m_nTextDepth == 0 || m_nDepth != m_nTextDepth ) return true;
+			if( _tcsicmp(pstrName, _T("id")) == 0 ) {
+				m_sId = pstrValue;
+				m_bId = true;
+			}
+			else if( _tcsicmp(pstrName, _T("value")) == 0 ) {
+				m_sValue = pstrValue;
+				m_bValue = true;
+			}
+			return true;
+		}
+
+		virtual bool OnText(LPCTSTR pstrText)
+		{
+			return true;
+		}
+
+		virtual bool OnEndElement(LPCTSTR pstrName)
+		{
+			if( m_nTextDepth != 0 && m_nDepth == m_nTextDepth ) {
+				if( m_bId && m_bValue ) {
+					CDuiString *lpstrFind = static_cast<CDuiString *>(m_mapStaged.Find(m_sId));
+					if( lpstrFind != NULL ) lpstrFind->Assign(m_sValue);
+					else m_mapStaged.Insert(m_sId, (LPVOID)new CDuiString(m_sValue));
+				}
+				m_nTextDepth = 0;
+			}
+			m_nDepth--;
+			return true;
+		}
+
+		// 把暂存的条目并入mapText
+		void Commit(CStdStringPtrMap& mapText)
+		{
+			for( int i = 0; i < m_mapStaged.GetSize(); i++ ) {
+				LPCTSTR key = m_mapStaged.GetAt(i);
+				if( key == NULL ) continue;
+				CDuiString* pValue = static_cast<CDuiString*>(m_mapStaged.Find(key));
+				CDuiString *lpstrFind = static_cast<CDuiString *>(mapText.Find(key));
+				if( lpstrFind != NULL ) {
+					lpstrFind->Assign(*pValue);
+					delete pValue;
+				}
+				else {
+					mapText.Insert(key, (LPVOID)pValue);
+				}
+			}
+			m_mapStaged.RemoveAll();
+		}
+
+	private:
+		CStdStringPtrMap m_mapStaged;
+		int m_nDepth;
+		int m_nTextDepth;
+		bool m_bId;
+		bool m_bValue;
+		CDuiString m_sId;
+		CDuiString m_sValue;
+	};
+
 	BOOL CResourceManager::LoadLanguage(LPCTSTR pstrXml)
 	{
 		CMarkup xml;
@@ -166,7 +255,10 @@ namespace DuiLib {
 			if( !xml.Load(pstrXml) ) return FALSE;
 		}
 		else {
-			if( !xml.LoadFromFile(pstrXml) ) return FALSE;
+			CLanguageTextHandler handler;
+			if( !xml.ParseStream(pstrXml, &handler) ) return FALSE;
+			handler.Commit(m_mTextResourceHashMap);
+			return TRUE;
 		}
 		CMarkupNode Root = xml.GetRoot();
 		if( !Root.IsValid() ) return FALSE;
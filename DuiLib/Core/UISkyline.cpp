@@ -0,0 +1,87 @@
+﻿#include "UISkyline.h"
+#include <string.h>
+#include <assert.h>
+
+namespace DuiLib {
+
+	CSkylinePacker::CSkylinePacker() :
+		m_nSkyline(0),
+		m_cx(0),
+		m_cy(0)
+	{
+	}
+
+	void CSkylinePacker::Reset(int cx, int cy)
+	{
+		assert(cx > 0 && cx <= SKYLINE_MAX_WIDTH && cy > 0);
+		m_aSkyline[0].x = 0;
+		m_aSkyline[0].y = 0;
+		m_aSkyline[0].cx = cx;
+		m_nSkyline = 1;
+		m_cx = cx;
+		m_cy = cy;
+	}
+
+	bool CSkylinePacker::Allocate(int cx, int cy, POINT& pt)
+	{
+		if( cx <= 0 || cy <= 0 ) return false;
+		// 选择放下后顶边最低的位置，相同时选较窄的一段，减少浪费
+		int iBest = -1;
+		int nBestBottom = m_cy + 1;
+		int nBestWidth = m_cx + 1;
+		int nBestY = 0;
+		for( int i = 0; i < m_nSkyline; i++ ) {
+			if( m_aSkyline[i].x + cx > m_cx ) break;
+			int y = 0;
+			int nRemain = cx;
+			for( int j = i; nRemain > 0; j++ ) {
+				if( m_aSkyline[j].y > y ) y = m_aSkyline[j].y;
+				nRemain -= m_aSkyline[j].cx;
+			}
+			if( y + cy > m_cy ) continue;
+			if( y + cy < nBestBottom || (y + cy == nBestBottom && m_aSkyline[i].cx < nBestWidth) ) {
+				iBest = i;
+				nBestBottom = y + cy;
+				nBestWidth = m_aSkyline[i].cx;
+				nBestY = y;
+			}
+		}
+		if( iBest < 0 ) return false;
+
+		pt.x = m_aSkyline[iBest].x;
+		pt.y = nBestY;
+
+		memmove(&m_aSkyline[iBest + 1], &m_aSkyline[iBest], (m_nSkyline - iBest) * sizeof(SKYLINE));
+		m_nSkyline++;
+		m_aSkyline[iBest].x = pt.x;
+		m_aSkyline[iBest].y = nBestBottom;
+		m_aSkyline[iBest].cx = cx;
+
+		// 新区域覆盖的后续段截短或删除
+		while( iBest + 1 < m_nSkyline ) {
+			SKYLINE& prev = m_aSkyline[iBest];
+			SKYLINE& next = m_aSkyline[iBest + 1];
+			int nOverlap = prev.x + prev.cx - next.x;
+			if( nOverlap <= 0 ) break;
+			if( nOverlap < next.cx ) {
+				next.x += nOverlap;
+				next.cx -= nOverlap;
+				break;
+			}
+			memmove(&m_aSkyline[iBest + 1], &m_aSkyline[iBest + 2], (m_nSkyline - iBest - 2) * sizeof(SKYLINE));
+			m_nSkyline--;
+		}
+
+		// 合并高度相同的相邻段
+		for( int i = 0; i + 1 < m_nSkyline; ) {
+			if( m_aSkyline[i].y == m_aSkyline[i + 1].y ) {
+				m_aSkyline[i].cx += m_aSkyline[i + 1].cx;
+				memmove(&m_aSkyline[i + 1], &m_aSkyline[i + 2], (m_nSkyline - i - 2) * sizeof(SKYLINE));
+				m_nSkyline--;
+			}
+			else i++;
+		}
+		return true;
+	}
+
+} // namespace DuiLib
@@ -0,0 +1,45 @@
+﻿#ifndef __UISKYLINE_H__
+#define __UISKYLINE_H__
+
+#pragma once
+
+#include "UIPortable.h"
+
+namespace DuiLib {
+
+	// 用skyline算法在一页中分配矩形区域，供图集使用；分配的区域不单独释放，Reset清空整页
+	// 每次选择放下后顶边最低的位置，相同时选较窄的一段
+	// 只使用POINT和C运行库，不依赖窗口
+	class UILIB_API CSkylinePacker
+	{
+	public:
+		enum
+		{
+			SKYLINE_MAX_WIDTH = 1024,
+		};
+
+		CSkylinePacker();
+
+		// 清空为cx×cy的空页，cx不超过SKYLINE_MAX_WIDTH
+		void Reset(int cx, int cy);
+		// 分配cx×cy的区域，左上角写入pt；放不下时返回false，页不变
+		bool Allocate(int cx, int cy, POINT& pt);
+
+	private:
+		typedef struct tagSKYLINE
+		{
+			int x;
+			int y;
+			int cx;
+		} SKYLINE;
+
+		// 每段至少1像素宽，插入新段后、截短后续段之前最多比页宽多一段
+		SKYLINE m_aSkyline[SKYLINE_MAX_WIDTH + 1];
+		int m_nSkyline;
+		int m_cx;
+		int m_cy;
+	};
+
+} // namespace DuiLib
+
+#endif // __UISKYLINE_H__
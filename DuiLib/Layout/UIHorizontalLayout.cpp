@@ -234,11 +234,26 @@ namespace DuiLib
 		return m_bImmMode;
 	}
 
-	void CHorizontalLayoutUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	bool CHorizontalLayoutUI::CanCopyAttributes() const
 	{
-		if( _tcsicmp(pstrName, _T("sepwidth")) == 0 ) SetSepWidth(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("sepimm")) == 0 ) SetSepImmMode(_tcsicmp(pstrValue, _T("true")) == 0);
-		else CContainerUI::SetAttribute(pstrName, pstrValue);
+		return typeid(*this) == typeid(CHorizontalLayoutUI) && m_pVerticalScrollBar == NULL && m_pHorizontalScrollBar == NULL;
+	}
+
+	void CHorizontalLayoutUI::CopyAttributes(const CControlUI* pSource)
+	{
+		CContainerUI::CopyAttributes(pSource);
+		const CHorizontalLayoutUI* pLayout = static_cast<const CHorizontalLayoutUI*>(pSource);
+		m_iSepWidth = pLayout->m_iSepWidth;
+		m_bImmMode = pLayout->m_bImmMode;
+	}
+
+	void CHorizontalLayoutUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_SEPWIDTH: SetSepWidth(_ttoi(pstrValue)); break;
+		case DUI_ATTR_SEPIMM: SetSepImmMode(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		default: CContainerUI::SetAttribute(iId, pstrName, pstrValue); break;
+		}
 	}
 
 	void CHorizontalLayoutUI::DoEvent(TEventUI& event)
@@ -233,11 +233,26 @@ namespace DuiLib
 		return m_bImmMode;
 	}
 
-	void CVerticalLayoutUI::SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	bool CVerticalLayoutUI::CanCopyAttributes() const
 	{
-		if( _tcsicmp(pstrName, _T("sepheight")) == 0 ) SetSepHeight(_ttoi(pstrValue));
-		else if( _tcsicmp(pstrName, _T("sepimm")) == 0 ) SetSepImmMode(_tcsicmp(pstrValue, _T("true")) == 0);
-		else CContainerUI::SetAttribute(pstrName, pstrValue);
+		return typeid(*this) == typeid(CVerticalLayoutUI) && m_pVerticalScrollBar == NULL && m_pHorizontalScrollBar == NULL;
+	}
+
+	void CVerticalLayoutUI::CopyAttributes(const CControlUI* pSource)
+	{
+		CContainerUI::CopyAttributes(pSource);
+		const CVerticalLayoutUI* pLayout = static_cast<const CVerticalLayoutUI*>(pSource);
+		m_iSepHeight = pLayout->m_iSepHeight;
+		m_bImmMode = pLayout->m_bImmMode;
+	}
+
+	void CVerticalLayoutUI::SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		switch( iId ) {
+		case DUI_ATTR_SEPHEIGHT: SetSepHeight(_ttoi(pstrValue)); break;
+		case DUI_ATTR_SEPIMM: SetSepImmMode(_tcsicmp(pstrValue, _T("true")) == 0); break;
+		default: CContainerUI::SetAttribute(iId, pstrName, pstrValue); break;
+		}
 	}
 
 	void CVerticalLayoutUI::DoEvent(TEventUI& event)
@@ -19,7 +19,10 @@ namespace DuiLib
 		int GetSepHeight() const;
 		void SetSepImmMode(bool bImmediately);
 		bool IsSepImmMode() const;
-		void SetAttribute(LPCTSTR pstrName, LPCTSTR pstrValue);
+		using CContainerUI::SetAttribute;
+		void SetAttribute(int iId, LPCTSTR pstrName, LPCTSTR pstrValue);
+		bool CanCopyAttributes() const;
+		void CopyAttributes(const CControlUI* pSource);
 		void DoEvent(TEventUI& event);
 
 		void SetPos(RECT rc, bool bNeedInvalidate = true);
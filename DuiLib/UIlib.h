@@ -44,6 +44,7 @@
 #include <malloc.h>
 #include <comdef.h>
 #include <gdiplus.h>
+#include <typeinfo>
 
 #include "Utils/Utils.h"
 #include "Utils/unzip.h"
@@ -57,7 +58,9 @@
 #include "Utils/DPI.h"
 
 #include "Core/UIDefine.h"
+#include "Core/UIAttributeId.h"
 #include "Core/UIResourceManager.h"
+#include "Core/UIDirtyRegion.h"
 #include "Core/UIManager.h"
 #include "Core/UIBase.h"
 #include "Core/ControlFactory.h"
@@ -66,6 +69,14 @@
 
 #include "Core/UIDlgBuilder.h"
 #include "Core/UIRender.h"
+#include "Core/UIImageDecoder.h"
+#include "Core/UIImageProbe.h"
+#include "Core/UISkyline.h"
+#include "Core/UIImageAtlas.h"
+#include "Core/UIGifDecoder.h"
+#include "Core/UIPixelKernels.h"
+#include "Core/UIRasterizer.h"
+#include "Core/UIRenderTarget.h"
 #include "Utils/WinImplBase.h"
 
 #include "Layout/UIVerticalLayout.h"
@@ -315,7 +315,10 @@ void CShadowUI::Update(HWND hParent)
 			RECT rcBmpPart = {0};
 			rcBmpPart.right = data->nX;
 			rcBmpPart.bottom = data->nY;
+			if (data->pAtlas) ::OffsetRect(&rcBmpPart, data->nAtlasX, data->nAtlasY);
+			// 阴影图可能是按DPI缩放过的变体，corner与DrawImage一样从皮肤坐标换算
 			RECT corner = m_rcShadowCorner;
+			CRenderEngine::ScaleImageRect(corner, data->nScale);
 			CRenderEngine::DrawImage(hMemDC, data->hBitmap, rcPaint, rcPaint, rcBmpPart, corner, data->bAlpha, 0xFF, true, false, false);
 		}
 	}
@@ -0,0 +1,77 @@
+﻿// CMarkup解析速度：分别用逐字符、SSE2和AVX2扫描解析同一组皮肤文件，输出MB/s
+// 用法：bench_markup [秒数] 皮肤文件...
+#include "StdAfx.h"
+#include "TestUtil.h"
+#include "MarkupTest.h"
+
+using namespace DuiLib;
+
+struct CorpusDoc
+{
+	std::string sUtf8;
+	std::vector<WCHAR> aWide;
+};
+
+// 反复解析全部文档直到超过dSeconds，返回每秒解析的输入字节数（MB）
+static double Measure(const std::vector<CorpusDoc>& aDocs, bool bUtf8, double dSeconds)
+{
+	double dBytes = 0;
+	CTestTimer timer;
+	do {
+		for( size_t i = 0; i < aDocs.size(); i++ ) {
+			CMarkup xml;
+			if( bUtf8 ) {
+				xml.LoadFromMem((BYTE*)aDocs[i].sUtf8.data(), (DWORD)aDocs[i].sUtf8.size());
+				dBytes += aDocs[i].sUtf8.size();
+			}
+			else {
+				xml.Load(&aDocs[i].aWide[0]);
+				dBytes += aDocs[i].aWide.size() * sizeof(WCHAR);
+			}
+		}
+	} while( timer.Elapsed() < dSeconds );
+	return dBytes / timer.Elapsed() / (1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[])
+{
+	int iArg = 1;
+	double dSeconds = 1.0;
+	if( iArg < argc && atof(argv[iArg]) > 0 ) dSeconds = atof(argv[iArg++]);
+	std::vector<CorpusDoc> aDocs;
+	for( ; iArg < argc; iArg++ ) {
+		CorpusDoc doc;
+		if( !ReadCorpusFile(argv[iArg], doc.sUtf8) ) continue;
+		doc.aWide = Utf8ToWide(doc.sUtf8);
+		aDocs.push_back(doc);
+	}
+	// 没有皮肤文件时用随机文档
+	if( aDocs.empty() ) {
+		CTestRandom random;
+		for( int i = 0; i < 50; i++ ) {
+			CorpusDoc doc;
+			doc.sUtf8 = MakeRandomDocument(random, 200);
+			doc.aWide = Utf8ToWide(doc.sUtf8);
+			aDocs.push_back(doc);
+		}
+	}
+
+	// 各指令集轮流测几遍取最好的一次，减少机器负载波动的影响
+	static const char* s_aLevels[] = { "scalar", "SSE2", "AVX2" };
+	double aBest[3][2] = { { 0 } };
+	for( int iRound = 0; iRound < 5; iRound++ ) {
+		for( int iLevel = MARKUP_SIMD_NONE; iLevel <= MARKUP_SIMD_AVX2; iLevel++ ) {
+			CMarkup::SetSimdLevel(iLevel);
+			for( int iUtf8 = 0; iUtf8 < 2; iUtf8++ ) {
+				double dSpeed = Measure(aDocs, iUtf8 != 0, dSeconds / 5);
+				if( dSpeed > aBest[iLevel][iUtf8] ) aBest[iLevel][iUtf8] = dSpeed;
+			}
+		}
+	}
+	printf("%-8s %12s %12s\n", "scan", "UTF-16 MB/s", "UTF-8 MB/s");
+	for( int iLevel = MARKUP_SIMD_NONE; iLevel <= MARKUP_SIMD_AVX2; iLevel++ ) {
+		printf("%-8s %12.1f %12.1f\n", s_aLevels[iLevel], aBest[iLevel][0], aBest[iLevel][1]);
+	}
+	CMarkup::SetSimdLevel(MARKUP_SIMD_AVX2);
+	return 0;
+}
@@ -0,0 +1,37 @@
+﻿// CPixelKernels速度：各指令集分别处理一张3840x2160的图片，输出每帧毫秒数
+// 用法：bench_pixel_kernels [秒数]
+#include "TestUtil.h"
+#include "Core/UIPixelKernels.h"
+#include <vector>
+
+using namespace DuiLib;
+
+int main(int argc, char* argv[])
+{
+	double dSeconds = argc > 1 && atof(argv[1]) > 0 ? atof(argv[1]) : 1.0;
+	const int nPixels = 3840 * 2160;
+	CTestRandom random;
+	std::vector<BYTE> aSrc(nPixels * 4), aDest(nPixels * 4);
+	// 大部分像素不透明，边缘半透明，和常见的背景图片类似
+	for( int i = 0; i < nPixels; i++ ) {
+		DWORD dwPixel = random.Next();
+		if( random.Next(8) != 0 ) dwPixel |= 0xFF000000;
+		for( int j = 0; j < 4; j++ ) aSrc[i*4 + j] = (BYTE)(dwPixel >> (j * 8));
+	}
+
+	static const char* s_aLevels[] = { "scalar", "SSE2", "SSSE3", "AVX2" };
+	printf("%-8s %12s\n", "kernel", "ms/frame");
+	for( int iLevel = PIXEL_SIMD_NONE; iLevel <= PIXEL_SIMD_AVX2; iLevel++ ) {
+		CPixelKernels::SetSimdLevel(iLevel);
+		if( CPixelKernels::GetSimdLevel() != iLevel ) continue;
+		int nFrames = 0;
+		CTestTimer timer;
+		do {
+			CPixelKernels::ConvertImageBits(&aSrc[0], &aDest[0], nPixels, 0xFF00FF00);
+			nFrames++;
+		} while( timer.Elapsed() < dSeconds / 4 );
+		printf("%-8s %12.2f\n", s_aLevels[iLevel], timer.Elapsed() * 1000 / nFrames);
+	}
+	CPixelKernels::SetSimdLevel(PIXEL_SIMD_AVX2);
+	return 0;
+}
@@ -0,0 +1,145 @@
+﻿#ifndef __MARKUPTEST_H__
+#define __MARKUPTEST_H__
+
+#pragma once
+
+#include "TestUtil.h"
+#include <string>
+#include <vector>
+
+// CMarkup测试和基准共用：读取皮肤文件，生成随机文档，比较两次解析的结果
+
+inline bool ReadCorpusFile(const char* pstrFile, std::string& sData)
+{
+	FILE* pFile = fopen(pstrFile, "rb");
+	if( pFile == NULL ) return false;
+	char szBuffer[4096];
+	size_t cb = 0;
+	while( (cb = fread(szBuffer, 1, sizeof(szBuffer), pFile)) > 0 ) sData.append(szBuffer, cb);
+	fclose(pFile);
+	return true;
+}
+
+// 去掉BOM后转换为以'\0'结尾的UTF-16
+inline std::vector<WCHAR> Utf8ToWide(const std::string& sUtf8)
+{
+	const char* pstr = sUtf8.data();
+	int cb = (int)sUtf8.size();
+	if( cb >= 3 && (BYTE)pstr[0] == 0xEF && (BYTE)pstr[1] == 0xBB && (BYTE)pstr[2] == 0xBF ) {
+		pstr += 3;
+		cb -= 3;
+	}
+	std::vector<WCHAR> aWide(cb + 1, L'\0');
+	int cch = cb > 0 ? ::MultiByteToWideChar(CP_UTF8, 0, pstr, cb, &aWide[0], cb) : 0;
+	aWide.resize(cch + 1);
+	aWide[cch] = L'\0';
+	return aWide;
+}
+
+// 0~70个空白，长度跨过SSE2和AVX2的块大小
+inline std::string MakeSpaceRun(CTestRandom& random)
+{
+	static const char s_aSpaces[] = { ' ', ' ', ' ', '\t', '\r', '\n' };
+	int n = random.Next(4) == 0 ? random.Next(71) : random.Next(3);
+	std::string s;
+	for( int i = 0; i < n; i++ ) s += s_aSpaces[random.Next(sizeof(s_aSpaces))];
+	return s;
+}
+
+inline std::string MakeRandomText(CTestRandom& random, bool bAttribute)
+{
+	static const char* s_aPieces[] = {
+		"abc", "Hello", "0,0,0,0", "#FF00FF00", "&amp;", "&lt;", "&gt;", "&quot;", "&apos;", "& ", "&unknown;",
+		"\xE4\xB8\xAD\xE6\x96\x87", "\xCC\x81", "e\xCC\x81", "file='a.png' source='0,0,16,16'", "-", ">", "/",
+	};
+	std::string s;
+	int n = random.Next(8);
+	for( int i = 0; i < n; i++ ) {
+		s += MakeSpaceRun(random);
+		s += s_aPieces[random.Next(sizeof(s_aPieces) / sizeof(s_aPieces[0]))];
+		// 组合字符紧跟在空白之后，CharNext会把它和空白算作一个字符
+		if( random.Next(6) == 0 ) s += " \xCC\x81";
+	}
+	if( !bAttribute && random.Next(3) == 0 ) s += "<!-- comment - with -- dashes -->";
+	return s + MakeSpaceRun(random);
+}
+
+inline void MakeRandomElement(CTestRandom& random, std::string& s, int nDepth, int& nBudget)
+{
+	static const char* s_aNames[] = { "Window", "VerticalLayout", "HorizontalLayout", "Button", "Label", "Control", "Font", "Default" };
+	static const char* s_aAttributes[] = { "name", "text", "pos", "bkimage", "float", "width", "height", "textcolor", "padding" };
+	const char* pstrName = s_aNames[random.Next(sizeof(s_aNames) / sizeof(s_aNames[0]))];
+	nBudget--;
+	s += "<";
+	s += pstrName;
+	int nAttributes = random.Next(5);
+	for( int i = 0; i < nAttributes; i++ ) {
+		s += random.Next(2) ? " " : MakeSpaceRun(random) + " ";
+		s += s_aAttributes[random.Next(sizeof(s_aAttributes) / sizeof(s_aAttributes[0]))];
+		s += MakeSpaceRun(random) + "=" + MakeSpaceRun(random) + "\"";
+		std::string sValue = MakeRandomText(random, true);
+		// 属性值里不能有引号和'<'
+		for( size_t j = 0; j < sValue.size(); j++ ) {
+			if( sValue[j] == '\"' || sValue[j] == '<' ) sValue[j] = '_';
+		}
+		s += sValue + "\"";
+	}
+	s += MakeSpaceRun(random);
+	if( nDepth > 6 || nBudget <= 0 || random.Next(4) == 0 ) {
+		s += "/>";
+		return;
+	}
+	s += ">";
+	s += MakeRandomText(random, false);
+	int nChildren = random.Next(5);
+	for( int i = 0; i < nChildren && nBudget > 0; i++ ) {
+		MakeRandomElement(random, s, nDepth + 1, nBudget);
+		s += MakeSpaceRun(random);
+	}
+	s += "</";
+	s += pstrName;
+	s += MakeSpaceRun(random) + ">";
+}
+
+inline std::string MakeRandomDocument(CTestRandom& random, int nElements)
+{
+	std::string s;
+	if( random.Next(2) ) s += "<?xml version=\"1.0\" encoding=\"utf-8\"?>";
+	s += MakeSpaceRun(random);
+	MakeRandomElement(random, s, 0, nElements);
+	return s + MakeSpaceRun(random);
+}
+
+inline bool SameText(LPCTSTR pstr1, LPCTSTR pstr2)
+{
+	if( pstr1 == NULL || pstr2 == NULL ) return pstr1 == pstr2;
+	size_t cch = _tcslen(pstr1);
+	return cch == _tcslen(pstr2) && _tcsncmp(pstr1, pstr2, cch) == 0;
+}
+
+// 按文档顺序逐个比较元素的名字、内容、属性和树结构，返回比较过的元素数
+inline int CompareTree(DuiLib::CMarkupNode node1, DuiLib::CMarkupNode node2)
+{
+	int nElements = 0;
+	for( ; node1.IsValid() || node2.IsValid(); node1 = node1.GetSibling(), node2 = node2.GetSibling() ) {
+		TEST_CHECK(node1.IsValid() && node2.IsValid());
+		if( !node1.IsValid() || !node2.IsValid() ) break;
+		nElements++;
+		TEST_CHECK(SameText(node1.GetName(), node2.GetName()));
+		TEST_CHECK(SameText(node1.GetValue(), node2.GetValue()));
+		int nAttributes = node1.GetAttributeCount();
+		TEST_CHECK(nAttributes == node2.GetAttributeCount());
+		if( nAttributes != node2.GetAttributeCount() ) continue;
+		for( int i = 0; i < nAttributes; i++ ) {
+			TEST_CHECK(SameText(node1.GetAttributeName(i), node2.GetAttributeName(i)));
+			TEST_CHECK(SameText(node1.GetAttributeValue(i), node2.GetAttributeValue(i)));
+			// 按名字查找走属性哈希表
+			TEST_CHECK(SameText(node1.GetAttributeValue(node1.GetAttributeName(i)), node2.GetAttributeValue(node2.GetAttributeName(i))));
+		}
+		TEST_CHECK(node1.HasChildren() == node2.HasChildren());
+		nElements += CompareTree(node1.GetChild(), node2.GetChild());
+	}
+	return nElements;
+}
+
+#endif // __MARKUPTEST_H__
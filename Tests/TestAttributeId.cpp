@@ -0,0 +1,91 @@
+﻿// CAttributeId和CAttributeList：每个属性名在任意大小写下都查到自己的编号，其它名字查不到；
+// 属性表的拆分规则与ApplyAttributeList一致
+#include "StdAfx.h"
+#include "TestUtil.h"
+#include "MarkupTest.h"
+
+using namespace DuiLib;
+
+static CDuiString ChangeCase(LPCTSTR pstrName, CTestRandom& random)
+{
+	CDuiString sName;
+	for( ; *pstrName != _T('\0'); pstrName++ ) {
+		TCHAR sz[2] = { *pstrName, _T('\0') };
+		if( random.Next(2) ) sz[0] = (TCHAR)towupper((wint_t)sz[0]);
+		sName += sz;
+	}
+	return sName;
+}
+
+static void CheckNames()
+{
+	CTestRandom random;
+	TEST_CHECK(CAttributeId::Find(NULL) == DUI_ATTR_UNKNOWN);
+	TEST_CHECK(CAttributeId::Find(_T("")) == DUI_ATTR_UNKNOWN);
+	TEST_CHECK(CAttributeId::GetName(DUI_ATTR_UNKNOWN) == NULL);
+	TEST_CHECK(CAttributeId::GetName(DUI_ATTR_COUNT) == NULL);
+	for( int i = DUI_ATTR_UNKNOWN + 1; i < DUI_ATTR_COUNT; i++ ) {
+		LPCTSTR pstrName = CAttributeId::GetName(i);
+		TEST_CHECK(pstrName != NULL);
+		if( pstrName == NULL ) continue;
+		TEST_CHECK(CAttributeId::Find(pstrName) == i);
+		// 复制出来的名字同样能查到，不依赖指针
+		CDuiString sCopy = pstrName;
+		TEST_CHECK(CAttributeId::Find(sCopy) == i);
+		for( int j = 0; j < 4; j++ ) TEST_CHECK(CAttributeId::Find(ChangeCase(pstrName, random)) == i);
+
+		// 加一个字符、去掉最后一个字符或改一个字符后，只能查到表中真有的名字
+		CDuiString sLonger = sCopy;
+		sLonger += _T("x");
+		int iLonger = CAttributeId::Find(sLonger);
+		TEST_CHECK(iLonger == DUI_ATTR_UNKNOWN || _tcsicmp(CAttributeId::GetName(iLonger), sLonger) == 0);
+		std::vector<TCHAR> aName(pstrName, pstrName + _tcslen(pstrName) + 1);
+		aName[aName.size() - 2] = _T('\0');
+		int iShorter = CAttributeId::Find(&aName[0]);
+		TEST_CHECK(iShorter == DUI_ATTR_UNKNOWN || _tcsicmp(CAttributeId::GetName(iShorter), &aName[0]) == 0);
+		aName.assign(pstrName, pstrName + _tcslen(pstrName) + 1);
+		aName[random.Next((int)aName.size() - 1)] = _T('#');
+		TEST_CHECK(CAttributeId::Find(&aName[0]) == DUI_ATTR_UNKNOWN);
+	}
+	TEST_CHECK(CAttributeId::Find(_T("group")) == DUI_ATTR_UNKNOWN);
+	TEST_CHECK(CAttributeId::Find(_T("\x4E2D\x6587")) == DUI_ATTR_UNKNOWN);
+}
+
+static void CheckList()
+{
+	CAttributeList list(_T("name=\"btn\" Text=\"a,b\",width=\"10\"\r\n\tfoo=\"&quot;\""));
+	TEST_CHECK(SameText(list.GetData(), _T("name=\"btn\" Text=\"a,b\",width=\"10\"\r\n\tfoo=\"&quot;\"")));
+	TEST_CHECK(list.GetCount() == 4);
+	TEST_CHECK(list.GetId(0) == DUI_ATTR_NAME && SameText(list.GetName(0), _T("name")) && SameText(list.GetValue(0), _T("btn")));
+	// 名字保持原来的写法
+	TEST_CHECK(list.GetId(1) == DUI_ATTR_TEXT && SameText(list.GetName(1), _T("Text")) && SameText(list.GetValue(1), _T("a,b")));
+	TEST_CHECK(list.GetId(2) == DUI_ATTR_WIDTH && SameText(list.GetValue(2), _T("10")));
+	// &quot;在拆分前就换成引号，和原来一样会提前结束值
+	TEST_CHECK(list.GetId(3) == DUI_ATTR_UNKNOWN && SameText(list.GetName(3), _T("foo")) && SameText(list.GetValue(3), _T("")));
+	TEST_CHECK(list.GetId(4) == DUI_ATTR_UNKNOWN && list.GetName(4) == NULL && list.GetValue(-1) == NULL);
+
+	// 出错时保留出错之前的属性
+	CAttributeList listBroken(_T("pos=\"0,0,1,1\" float=\"true\" width"));
+	TEST_CHECK(listBroken.GetCount() == 2);
+	CAttributeList listUnquoted(_T("pos=\"0,0,1,1\";height=\"1\""));
+	TEST_CHECK(listUnquoted.GetCount() == 1);
+	CAttributeList listEmpty(_T("  \t "));
+	TEST_CHECK(listEmpty.GetCount() == 0);
+	CAttributeList listNull((LPCTSTR)NULL);
+	TEST_CHECK(listNull.GetCount() == 0);
+
+	CMarkup xml(_T("<Button name=\"ok\" bkcolor=\"#FF000000\" custom=\"1\"/>"));
+	CMarkupNode node = xml.GetRoot();
+	CAttributeList listNode(node);
+	TEST_CHECK(listNode.GetCount() == 3);
+	TEST_CHECK(listNode.GetId(1) == DUI_ATTR_BKCOLOR && SameText(listNode.GetValue(1), _T("#FF000000")));
+	TEST_CHECK(listNode.GetId(2) == DUI_ATTR_UNKNOWN && SameText(listNode.GetName(2), _T("custom")));
+}
+
+int main()
+{
+	CheckNames();
+	CheckList();
+	printf("%d attribute names checked\n", DUI_ATTR_COUNT - 1);
+	return TestExitCode();
+}
@@ -0,0 +1,181 @@
+﻿// CDirtyRegion：矩形数不超过上限且互不相交，覆盖所有加入的像素，外接矩形与加入的矩形一致，裁剪后仍覆盖裁剪范围内的像素
+#include "TestUtil.h"
+#include "Core/UIDirtyRegion.h"
+#include <string.h>
+#include <vector>
+
+using namespace DuiLib;
+
+// 坐标都是CELL的倍数，按格子检查覆盖
+static const int CELL = 8;
+static const int GRID = 64;
+
+static RECT MakeRect(int left, int top, int right, int bottom)
+{
+	RECT rc = { left, top, right, bottom };
+	return rc;
+}
+
+static bool IsEqualRect(const RECT& rc1, const RECT& rc2)
+{
+	return rc1.left == rc2.left && rc1.top == rc2.top && rc1.right == rc2.right && rc1.bottom == rc2.bottom;
+}
+
+static bool IsRectEmpty(const RECT& rc)
+{
+	return rc.left >= rc.right || rc.top >= rc.bottom;
+}
+
+static bool RectsIntersect(const RECT& rc1, const RECT& rc2)
+{
+	return rc1.left < rc2.right && rc2.left < rc1.right && rc1.top < rc2.bottom && rc2.top < rc1.bottom;
+}
+
+// 脏区域的格子覆盖图，并检查矩形的基本性质
+static std::vector<bool> CheckRegion(const CDirtyRegion& region)
+{
+	std::vector<bool> aCovered(GRID * GRID, false);
+	TEST_CHECK(region.GetCount() >= 0 && region.GetCount() <= CDirtyRegion::DIRTY_RECT_MAX);
+	TEST_CHECK(region.IsEmpty() == (region.GetCount() == 0));
+	DWORD dwArea = 0;
+	for( int i = 0; i < region.GetCount(); i++ ) {
+		const RECT& rc = region.GetAt(i);
+		TEST_CHECK(!IsRectEmpty(rc));
+		for( int j = i + 1; j < region.GetCount(); j++ ) TEST_CHECK(!RectsIntersect(rc, region.GetAt(j)));
+		dwArea += (DWORD)((rc.right - rc.left) * (rc.bottom - rc.top));
+		for( int y = rc.top / CELL; y < rc.bottom / CELL; y++ ) {
+			for( int x = rc.left / CELL; x < rc.right / CELL; x++ ) aCovered[y * GRID + x] = true;
+		}
+	}
+	TEST_CHECK(region.GetArea() == dwArea);
+	return aCovered;
+}
+
+static RECT RandomRect(CTestRandom& random)
+{
+	int left = random.Next(GRID), top = random.Next(GRID);
+	// 大多是小矩形，像控件的局部刷新
+	int cx = random.Next(4) == 0 ? random.Next(GRID - left + 1) : random.Next(6);
+	int cy = random.Next(4) == 0 ? random.Next(GRID - top + 1) : random.Next(6);
+	if( left + cx > GRID ) cx = GRID - left;
+	if( top + cy > GRID ) cy = GRID - top;
+	return MakeRect(left * CELL, top * CELL, (left + cx) * CELL, (top + cy) * CELL);
+}
+
+static void CheckRandom()
+{
+	CTestRandom random(0x68E31DA4u);
+	for( int iRun = 0; iRun < 3000; iRun++ ) {
+		CDirtyRegion region;
+		std::vector<bool> aAdded(GRID * GRID, false);
+		RECT rcBounds = { 0 };
+		int nRects = 1 + random.Next(30);
+		for( int i = 0; i < nRects; i++ ) {
+			RECT rc = RandomRect(random);
+			region.Add(rc);
+			if( IsRectEmpty(rc) ) continue;
+			for( int y = rc.top / CELL; y < rc.bottom / CELL; y++ ) {
+				for( int x = rc.left / CELL; x < rc.right / CELL; x++ ) aAdded[y * GRID + x] = true;
+			}
+			if( IsRectEmpty(rcBounds) ) rcBounds = rc;
+			else {
+				if( rc.left < rcBounds.left ) rcBounds.left = rc.left;
+				if( rc.top < rcBounds.top ) rcBounds.top = rc.top;
+				if( rc.right > rcBounds.right ) rcBounds.right = rc.right;
+				if( rc.bottom > rcBounds.bottom ) rcBounds.bottom = rc.bottom;
+			}
+		}
+		std::vector<bool> aCovered = CheckRegion(region);
+		bool bCovered = true;
+		for( int i = 0; i < GRID * GRID; i++ ) {
+			if( aAdded[i] && !aCovered[i] ) bCovered = false;
+		}
+		TEST_CHECK(bCovered);
+		// 合并只会把矩形换成它们的外接矩形，不会超出加入的范围
+		RECT rcResult = region.GetBounds();
+		TEST_CHECK(IsEqualRect(rcResult, IsRectEmpty(rcBounds) ? MakeRect(0, 0, 0, 0) : rcBounds));
+
+		// 加入另一个区域与逐个加入它的矩形结果相同
+		CDirtyRegion merged, single;
+		merged.Add(region);
+		for( int i = 0; i < region.GetCount(); i++ ) single.Add(region.GetAt(i));
+		TEST_CHECK(merged.GetCount() == single.GetCount() && merged.GetArea() == single.GetArea());
+
+		// 裁剪后仍互不相交，只留下裁剪范围内的部分，并覆盖其中加入过的格子
+		RECT rcClip = RandomRect(random);
+		region.Clip(rcClip);
+		aCovered = CheckRegion(region);
+		bool bClipped = true;
+		for( int i = 0; i < region.GetCount(); i++ ) {
+			const RECT& rc = region.GetAt(i);
+			if( rc.left < rcClip.left || rc.top < rcClip.top || rc.right > rcClip.right || rc.bottom > rcClip.bottom ) bClipped = false;
+		}
+		TEST_CHECK(bClipped);
+		bCovered = true;
+		for( int y = rcClip.top / CELL; y < rcClip.bottom / CELL; y++ ) {
+			for( int x = rcClip.left / CELL; x < rcClip.right / CELL; x++ ) {
+				if( aAdded[y * GRID + x] && !aCovered[y * GRID + x] ) bCovered = false;
+			}
+		}
+		TEST_CHECK(bCovered);
+	}
+}
+
+// 合并规则的几个具体例子
+static void CheckMergeRules()
+{
+	CDirtyRegion region;
+	// 空矩形不加入
+	region.Add(MakeRect(10, 10, 10, 20));
+	region.Add(MakeRect(10, 20, 30, 20));
+	TEST_CHECK(region.IsEmpty());
+
+	// 相距很远的两个矩形分开保存，被包含的矩形不改变区域
+	region.Add(MakeRect(0, 0, 100, 100));
+	region.Add(MakeRect(1000, 1000, 1100, 1100));
+	region.Add(MakeRect(10, 10, 20, 20));
+	TEST_CHECK(region.GetCount() == 2 && region.GetArea() == 20000);
+
+	// 相交的矩形必须合并
+	region.Empty();
+	region.Add(MakeRect(0, 0, 100, 100));
+	region.Add(MakeRect(50, 50, 150, 150));
+	TEST_CHECK(region.GetCount() == 1 && IsEqualRect(region.GetAt(0), MakeRect(0, 0, 150, 150)));
+
+	// 不相交但合并多出的面积不超过DIRTY_MERGE_AREA时合并
+	region.Empty();
+	region.Add(MakeRect(0, 0, 64, 64));
+	region.Add(MakeRect(0, 128, 64, 192));
+	TEST_CHECK(region.GetCount() == 1 && IsEqualRect(region.GetAt(0), MakeRect(0, 0, 64, 192)));
+	region.Empty();
+	region.Add(MakeRect(0, 0, 64, 64));
+	region.Add(MakeRect(0, 129, 64, 193));
+	TEST_CHECK(region.GetCount() == 2);
+
+	// 合并后变大的矩形与其它矩形相交时继续合并
+	region.Empty();
+	region.Add(MakeRect(0, 0, 10, 10));
+	region.Add(MakeRect(500, 0, 510, 10));
+	region.Add(MakeRect(0, 0, 505, 5));
+	TEST_CHECK(region.GetCount() == 1 && IsEqualRect(region.GetAt(0), MakeRect(0, 0, 510, 10)));
+
+	// 已满且已有矩形两两合并都更费时：新矩形并入多出面积最小的一个
+	region.Empty();
+	for( int i = 0; i < CDirtyRegion::DIRTY_RECT_MAX; i++ ) region.Add(MakeRect(i * 1000, 0, i * 1000 + 100, 100));
+	TEST_CHECK(region.GetCount() == CDirtyRegion::DIRTY_RECT_MAX);
+	region.Add(MakeRect(7000, 200, 7100, 300));
+	TEST_CHECK(region.GetCount() == CDirtyRegion::DIRTY_RECT_MAX && region.GetArea() == 8 * 10000 + 10000 + 10000);
+
+	// 裁剪掉不相交的矩形
+	region.Clip(MakeRect(0, 0, 2100, 50));
+	TEST_CHECK(region.GetCount() == 3 && region.GetArea() == 3 * 5000);
+	region.Clip(MakeRect(5000, 0, 6000, 100));
+	TEST_CHECK(region.IsEmpty() && IsEqualRect(region.GetBounds(), MakeRect(0, 0, 0, 0)));
+}
+
+int main()
+{
+	CheckMergeRules();
+	CheckRandom();
+	return TestExitCode();
+}
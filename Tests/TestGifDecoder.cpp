@@ -0,0 +1,356 @@
+﻿// CGifDecoder：随机生成的动画在顺序播放、跳帧和往回取帧时都与逐帧完整合成的参考结果一致，
+// 覆盖四种处置方式、超出画布的子区域、隔行扫描、局部调色板和帧缓存；截断的文件不能越界访问
+#include "TestUtil.h"
+#include "Core/UIGifDecoder.h"
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace DuiLib;
+
+struct TestFrame
+{
+	int x, y, cx, cy;
+	int nDisposal;
+	int nTransparent;
+	bool bInterlaced;
+	bool bLocalPalette;
+	// 为false时只写字面码，为true时按标准LZW压缩，码长一直增长到12位
+	bool bCompress;
+	UINT uDelay;
+	DWORD aPalette[16];
+	std::vector<BYTE> aIndices;
+};
+
+struct TestAnimation
+{
+	int nWidth, nHeight;
+	DWORD aPalette[16];
+	std::vector<TestFrame> aFrames;
+};
+
+static void AppendWord(std::string& s, int n)
+{
+	s += (char)(n & 0xFF);
+	s += (char)((n >> 8) & 0xFF);
+}
+
+static void AppendPalette(std::string& s, const DWORD* pPalette)
+{
+	for( int i = 0; i < 16; i++ ) {
+		s += (char)((pPalette[i] >> 16) & 0xFF);
+		s += (char)((pPalette[i] >> 8) & 0xFF);
+		s += (char)(pPalette[i] & 0xFF);
+	}
+}
+
+class CCodeWriter
+{
+public:
+	CCodeWriter() : m_dwBits(0), m_nBits(0) {}
+
+	void Write(int nCode, int nCodeSize)
+	{
+		m_dwBits |= (DWORD)nCode << m_nBits;
+		m_nBits += nCodeSize;
+		while( m_nBits >= 8 ) {
+			m_sData += (char)(m_dwBits & 0xFF);
+			m_dwBits >>= 8;
+			m_nBits -= 8;
+		}
+	}
+
+	std::string Finish()
+	{
+		if( m_nBits > 0 ) m_sData += (char)(m_dwBits & 0xFF);
+		return m_sData;
+	}
+
+private:
+	std::string m_sData;
+	DWORD m_dwBits;
+	int m_nBits;
+};
+
+// 4位索引，清除码16，结束码17
+static std::string EncodeLiterals(const std::vector<BYTE>& aIndices)
+{
+	// 每14个码字前插入清除码，编码表不会增长到6位
+	CCodeWriter writer;
+	writer.Write(16, 5);
+	for( size_t i = 0; i < aIndices.size(); i++ ) {
+		if( i > 0 && i % 14 == 0 ) writer.Write(16, 5);
+		writer.Write(aIndices[i], 5);
+	}
+	writer.Write(17, 5);
+	return writer.Finish();
+}
+
+static std::string EncodeLzw(const std::vector<BYTE>& aIndices)
+{
+	CCodeWriter writer;
+	std::map<int, int> mapCodes;
+	int nNext = 18;
+	int nCodeSize = 5;
+	writer.Write(16, nCodeSize);
+	int nPrefix = aIndices[0];
+	for( size_t i = 1; i < aIndices.size(); i++ ) {
+		int nKey = nPrefix * 16 + aIndices[i];
+		std::map<int, int>::const_iterator it = mapCodes.find(nKey);
+		if( it != mapCodes.end() ) {
+			nPrefix = it->second;
+			continue;
+		}
+		writer.Write(nPrefix, nCodeSize);
+		if( nNext < 4096 ) {
+			mapCodes[nKey] = nNext++;
+			// 解码器晚一个码字建表，码长在下一个码字前增长
+			if( nNext > (1 << nCodeSize) && nCodeSize < 12 ) nCodeSize++;
+		}
+		else {
+			writer.Write(16, nCodeSize);
+			mapCodes.clear();
+			nNext = 18;
+			nCodeSize = 5;
+		}
+		nPrefix = aIndices[i];
+	}
+	writer.Write(nPrefix, nCodeSize);
+	writer.Write(17, nCodeSize);
+	return writer.Finish();
+}
+
+static void AppendImageData(std::string& s, const std::vector<BYTE>& aIndices, bool bCompress)
+{
+	std::string sData = bCompress ? EncodeLzw(aIndices) : EncodeLiterals(aIndices);
+
+	s += (char)4;
+	for( size_t i = 0; i < sData.size(); i += 255 ) {
+		size_t cb = sData.size() - i < 255 ? sData.size() - i : 255;
+		s += (char)cb;
+		s += sData.substr(i, cb);
+	}
+	s += (char)0;
+}
+
+// 隔行扫描时按四遍的行顺序写出
+static std::vector<BYTE> OrderRows(const TestFrame& frame)
+{
+	if( !frame.bInterlaced ) return frame.aIndices;
+	static const int aPassStart[] = { 0, 4, 2, 1 };
+	static const int aPassStep[] = { 8, 8, 4, 2 };
+	std::vector<BYTE> aOrdered;
+	for( int iPass = 0; iPass < 4; iPass++ ) {
+		for( int y = aPassStart[iPass]; y < frame.cy; y += aPassStep[iPass] ) {
+			aOrdered.insert(aOrdered.end(), frame.aIndices.begin() + y * frame.cx, frame.aIndices.begin() + (y + 1) * frame.cx);
+		}
+	}
+	return aOrdered;
+}
+
+static std::string EncodeGif(const TestAnimation& anim)
+{
+	std::string s = "GIF89a";
+	AppendWord(s, anim.nWidth);
+	AppendWord(s, anim.nHeight);
+	s += (char)0x83;
+	s += (char)0;
+	s += (char)0;
+	AppendPalette(s, anim.aPalette);
+	// 不认识的扩展块要被跳过
+	s += "\x21\xFF\x0BNETSCAPE2.0\x03\x01";
+	s += std::string(2, '\0');
+	s += (char)0;
+	for( size_t i = 0; i < anim.aFrames.size(); i++ ) {
+		const TestFrame& frame = anim.aFrames[i];
+		s += "\x21\xF9\x04";
+		s += (char)((frame.nDisposal << 2) | (frame.nTransparent >= 0 ? 1 : 0));
+		AppendWord(s, frame.uDelay / 10);
+		s += (char)(frame.nTransparent >= 0 ? frame.nTransparent : 0);
+		s += (char)0;
+		s += (char)0x2C;
+		AppendWord(s, frame.x);
+		AppendWord(s, frame.y);
+		AppendWord(s, frame.cx);
+		AppendWord(s, frame.cy);
+		s += (char)((frame.bLocalPalette ? 0x83 : 0) | (frame.bInterlaced ? 0x40 : 0));
+		if( frame.bLocalPalette ) AppendPalette(s, frame.aPalette);
+		AppendImageData(s, OrderRows(frame), frame.bCompress);
+	}
+	s += (char)0x3B;
+	return s;
+}
+
+static void RandomPalette(CTestRandom& random, DWORD* pPalette)
+{
+	for( int i = 0; i < 16; i++ ) pPalette[i] = 0xFF000000 | (random.Next() & 0x00FFFFFF);
+}
+
+static TestAnimation RandomAnimation(CTestRandom& random, int nFrames)
+{
+	TestAnimation anim;
+	// 偶尔生成大图，让LZW码长增长到12位并清除编码表
+	int nMaxSize = random.Next(20) == 0 ? 200 : 40;
+	anim.nWidth = 1 + random.Next(nMaxSize);
+	anim.nHeight = 1 + random.Next(nMaxSize);
+	RandomPalette(random, anim.aPalette);
+	for( int i = 0; i < nFrames; i++ ) {
+		TestFrame frame;
+		// 子区域可以超出画布，偶尔完全在画布以外
+		frame.x = random.Next(anim.nWidth + 4);
+		frame.y = random.Next(anim.nHeight + 4);
+		if( random.Next(4) == 0 ) frame.x = frame.y = 0;
+		frame.cx = 1 + random.Next(anim.nWidth);
+		frame.cy = 1 + random.Next(anim.nHeight);
+		frame.nDisposal = random.Next(4);
+		frame.nTransparent = random.Next(3) == 0 ? -1 : random.Next(16);
+		frame.bInterlaced = random.Next(3) == 0;
+		frame.bLocalPalette = random.Next(3) == 0;
+		frame.bCompress = random.Next(3) != 0;
+		frame.uDelay = random.Next(100) * 10;
+		RandomPalette(random, frame.aPalette);
+		// 透明像素成块出现，让处置后的区域露出下面的内容
+		// 重复的游程让LZW出现刚建表就使用的码字
+		int nColors = 1 + random.Next(16);
+		while( (int)frame.aIndices.size() < frame.cx * frame.cy ) {
+			BYTE cIndex = (BYTE)(random.Next(4) == 0 && frame.nTransparent >= 0 ? frame.nTransparent : random.Next(nColors));
+			int nRun = random.Next(4) == 0 ? 1 + random.Next(30) : 1;
+			for( int j = 0; j < nRun && (int)frame.aIndices.size() < frame.cx * frame.cy; j++ ) frame.aIndices.push_back(cIndex);
+		}
+		anim.aFrames.push_back(frame);
+	}
+	return anim;
+}
+
+// 从第一帧开始逐帧完整合成到第iFrame帧
+static std::vector<DWORD> ComposeFrame(const TestAnimation& anim, int iFrame)
+{
+	int nPixels = anim.nWidth * anim.nHeight;
+	std::vector<DWORD> aCanvas(nPixels, 0), aRestore(nPixels, 0);
+	for( int i = 0; i <= iFrame; i++ ) {
+		if( i > 0 ) {
+			const TestFrame& prev = anim.aFrames[i - 1];
+			for( int y = prev.y; y < prev.y + prev.cy && y < anim.nHeight; y++ ) {
+				for( int x = prev.x; x < prev.x + prev.cx && x < anim.nWidth; x++ ) {
+					if( prev.nDisposal == 2 ) aCanvas[y * anim.nWidth + x] = 0;
+					else if( prev.nDisposal == 3 ) aCanvas[y * anim.nWidth + x] = aRestore[y * anim.nWidth + x];
+				}
+			}
+		}
+		const TestFrame& frame = anim.aFrames[i];
+		if( frame.nDisposal == 3 ) aRestore = aCanvas;
+		const DWORD* pPalette = frame.bLocalPalette ? frame.aPalette : anim.aPalette;
+		for( int y = 0; y < frame.cy; y++ ) {
+			for( int x = 0; x < frame.cx; x++ ) {
+				int xCanvas = frame.x + x, yCanvas = frame.y + y;
+				BYTE cIndex = frame.aIndices[y * frame.cx + x];
+				if( cIndex == frame.nTransparent || xCanvas >= anim.nWidth || yCanvas >= anim.nHeight ) continue;
+				aCanvas[yCanvas * anim.nWidth + xCanvas] = pPalette[cIndex];
+			}
+		}
+	}
+	return aCanvas;
+}
+
+// 按aOrder取帧，每帧与参考结果比较；顺序取下一帧时，脏区域以外必须与上一次返回的帧相同
+static void CheckPlayback(CGifDecoder& decoder, const TestAnimation& anim, const std::vector<int>& aOrder)
+{
+	int nPixels = anim.nWidth * anim.nHeight;
+	std::vector<DWORD> aLast;
+	int iLast = -1;
+	for( size_t i = 0; i < aOrder.size(); i++ ) {
+		int iFrame = aOrder[i];
+		RECT rcDirty = { -1, -1, -1, -1 };
+		const BYTE* pBits = decoder.GetFrame(iFrame, &rcDirty);
+		TEST_CHECK(pBits != NULL);
+		if( pBits == NULL ) return;
+		std::vector<DWORD> aFrame(nPixels);
+		memcpy(&aFrame[0], pBits, nPixels * sizeof(DWORD));
+		TEST_CHECK(aFrame == ComposeFrame(anim, iFrame));
+
+		if( iLast >= 0 && iFrame == iLast ) {
+			TEST_CHECK(rcDirty.left >= rcDirty.right || rcDirty.top >= rcDirty.bottom);
+		}
+		else if( iLast >= 0 && iFrame == iLast + 1 ) {
+			TEST_CHECK(rcDirty.left >= 0 && rcDirty.top >= 0 && rcDirty.right <= anim.nWidth && rcDirty.bottom <= anim.nHeight);
+			for( int y = 0; y < anim.nHeight; y++ ) {
+				for( int x = 0; x < anim.nWidth; x++ ) {
+					if( x >= rcDirty.left && x < rcDirty.right && y >= rcDirty.top && y < rcDirty.bottom ) continue;
+					TEST_CHECK(aFrame[y * anim.nWidth + x] == aLast[y * anim.nWidth + x]);
+				}
+			}
+		}
+		else {
+			TEST_CHECK(rcDirty.left == 0 && rcDirty.top == 0 && rcDirty.right == anim.nWidth && rcDirty.bottom == anim.nHeight);
+		}
+		aLast = aFrame;
+		iLast = iFrame;
+	}
+}
+
+static void CheckAnimation(const TestAnimation& anim, CTestRandom& random)
+{
+	std::string sData = EncodeGif(anim);
+	int nFrames = (int)anim.aFrames.size();
+	std::vector<int> aOrder;
+	for( int iLoop = 0; iLoop < 2; iLoop++ ) {
+		for( int i = 0; i < nFrames; i++ ) aOrder.push_back(i);
+	}
+	for( int i = 0; i < 10; i++ ) aOrder.push_back(random.Next(nFrames));
+
+	static const int aCacheFrames[] = { 0, CGifDecoder::GIF_CACHE_FRAMES, 100 };
+	for( int iCache = 0; iCache < 3; iCache++ ) {
+		CGifDecoder decoder;
+		TEST_CHECK(decoder.Open((const BYTE*)sData.data(), (DWORD)sData.size()));
+		TEST_CHECK(decoder.GetWidth() == anim.nWidth && decoder.GetHeight() == anim.nHeight);
+		TEST_CHECK(decoder.GetFrameCount() == nFrames);
+		for( int i = 0; i < nFrames; i++ ) TEST_CHECK(decoder.GetFrameDelay(i) == anim.aFrames[i].uDelay);
+		TEST_CHECK(decoder.GetFrameDelay(nFrames) == 0 && decoder.GetFrame(nFrames) == NULL && decoder.GetFrame(-1) == NULL);
+		decoder.SetCacheFrames(aCacheFrames[iCache]);
+		CheckPlayback(decoder, anim, aOrder);
+
+		// 帧数不超过缓存帧数时每帧有自己的缓冲区，第二遍播放返回第一遍的结果；否则所有帧共用一块画布
+		std::vector<const BYTE*> aBits;
+		for( int i = 0; i < nFrames; i++ ) aBits.push_back(decoder.GetFrame(i));
+		bool bCached = nFrames > 1 && nFrames <= aCacheFrames[iCache];
+		for( int i = 0; i < nFrames; i++ ) {
+			TEST_CHECK(decoder.GetFrame(i) == aBits[i]);
+			if( i > 0 ) TEST_CHECK((aBits[i] != aBits[0]) == bCached);
+		}
+	}
+}
+
+// 每个长度截断后Open可以失败，成功时取每一帧都不能越界
+static void CheckTruncated(const TestAnimation& anim)
+{
+	std::string sData = EncodeGif(anim);
+	for( size_t cb = 0; cb < sData.size(); cb++ ) {
+		std::vector<BYTE> aData(sData.begin(), sData.begin() + cb);
+		CGifDecoder decoder;
+		if( !decoder.Open(aData.empty() ? NULL : &aData[0], (DWORD)cb) ) continue;
+		for( int i = 0; i < decoder.GetFrameCount(); i++ ) TEST_CHECK(decoder.GetFrame(i) != NULL);
+	}
+}
+
+int main()
+{
+	CTestRandom random;
+	TEST_CHECK(!CGifDecoder().Open((const BYTE*)"GIF88a\x01\x00\x01\x00\x00\x00\x00", 13));
+
+	// 各种处置方式单独覆盖一遍，再加随机组合
+	for( int iDisposal = 0; iDisposal < 4; iDisposal++ ) {
+		TestAnimation anim = RandomAnimation(random, 6);
+		for( size_t i = 0; i < anim.aFrames.size(); i++ ) anim.aFrames[i].nDisposal = iDisposal;
+		CheckAnimation(anim, random);
+	}
+	int nAnimations = 0;
+	for( int i = 0; i < 300; i++ ) {
+		CheckAnimation(RandomAnimation(random, 1 + random.Next(14)), random);
+		nAnimations++;
+	}
+	for( int i = 0; i < 5; i++ ) CheckTruncated(RandomAnimation(random, 1 + random.Next(4)));
+
+	printf("%d animations checked\n", nAnimations + 4);
+	return TestExitCode();
+}
@@ -0,0 +1,290 @@
+﻿// CImageProbe：PNG/GIF/JPEG/BMP文件头的尺寸和透明标记；截断的数据不越界读取，也不返回错误的尺寸
+#include "TestUtil.h"
+#include "Core/UIImageProbe.h"
+#include <string.h>
+#include <vector>
+
+using namespace DuiLib;
+
+typedef std::vector<BYTE> CBytes;
+
+static void Append(CBytes& data, const char* pstr, size_t cb)
+{
+	data.insert(data.end(), (const BYTE*)pstr, (const BYTE*)pstr + cb);
+}
+
+static void AppendBE16(CBytes& data, DWORD n) { data.push_back((BYTE)(n >> 8)); data.push_back((BYTE)n); }
+static void AppendBE32(CBytes& data, DWORD n) { AppendBE16(data, n >> 16); AppendBE16(data, n & 0xFFFF); }
+static void AppendLE16(CBytes& data, DWORD n) { data.push_back((BYTE)n); data.push_back((BYTE)(n >> 8)); }
+static void AppendLE32(CBytes& data, DWORD n) { AppendLE16(data, n & 0xFFFF); AppendLE16(data, n >> 16); }
+
+// PNG数据块：长度、类型、数据和不检查的CRC
+static void AppendPngChunk(CBytes& data, const char* pstrType, const CBytes& payload)
+{
+	AppendBE32(data, (DWORD)payload.size());
+	Append(data, pstrType, 4);
+	data.insert(data.end(), payload.begin(), payload.end());
+	AppendBE32(data, 0);
+}
+
+static CBytes MakePng(int x, int y, BYTE cColorType, const char* pstrChunks)
+{
+	CBytes data;
+	Append(data, "\x89PNG\r\n\x1a\n", 8);
+	CBytes ihdr;
+	AppendBE32(ihdr, x);
+	AppendBE32(ihdr, y);
+	ihdr.push_back(8);
+	ihdr.push_back(cColorType);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	AppendPngChunk(data, "IHDR", ihdr);
+	// pstrChunks中每4个字符是一个数据块的类型，数据为空或随意的几个字节
+	for( ; *pstrChunks != '\0'; pstrChunks += 4 ) {
+		CBytes payload(strncmp(pstrChunks, "PLTE", 4) == 0 ? 12 : 3, 0x55);
+		AppendPngChunk(data, pstrChunks, payload);
+	}
+	return data;
+}
+
+// GIF：逻辑屏幕描述符，可选的全局颜色表，pstrExtensions中'C'为注释扩展，'T'/'O'为带/不带透明标记的图形控制扩展
+static CBytes MakeGif(const char* pstrVersion, int x, int y, int nColorBits, const char* pstrExtensions)
+{
+	CBytes data;
+	Append(data, pstrVersion, 6);
+	AppendLE16(data, x);
+	AppendLE16(data, y);
+	data.push_back(nColorBits > 0 ? (BYTE)(0x80 | (nColorBits - 1)) : 0);
+	data.push_back(0);
+	data.push_back(0);
+	if( nColorBits > 0 ) data.insert(data.end(), 3 << nColorBits, 0x33);
+	for( ; *pstrExtensions != '\0'; pstrExtensions++ ) {
+		data.push_back(0x21);
+		if( *pstrExtensions == 'C' ) {
+			data.push_back(0xFE);
+			// 两个子块，内容中带0x21、0xF9，跳过时不能误认为扩展
+			data.push_back(5);
+			Append(data, "\x21\xF9\x04\x01\x00", 5);
+			data.push_back(2);
+			Append(data, "ok", 2);
+			data.push_back(0);
+		}
+		else {
+			data.push_back(0xF9);
+			data.push_back(4);
+			data.push_back(*pstrExtensions == 'T' ? 0x09 : 0x08);
+			AppendLE16(data, 10);
+			data.push_back(0);
+			data.push_back(0);
+		}
+	}
+	// 图像描述符
+	data.push_back(0x2C);
+	data.insert(data.end(), 9, 0);
+	data.push_back(2);
+	return data;
+}
+
+static void AppendJpegSegment(CBytes& data, BYTE cMarker, DWORD cbPayload)
+{
+	data.push_back(0xFF);
+	data.push_back(cMarker);
+	AppendBE16(data, cbPayload + 2);
+	data.insert(data.end(), cbPayload, 0xA5);
+}
+
+static void AppendJpegFrame(CBytes& data, BYTE cMarker, int x, int y)
+{
+	data.push_back(0xFF);
+	data.push_back(cMarker);
+	AppendBE16(data, 17);
+	data.push_back(8);
+	AppendBE16(data, y);
+	AppendBE16(data, x);
+	data.push_back(3);
+	data.insert(data.end(), 9, 0x11);
+}
+
+// 常见的JPEG开头：JFIF、大的EXIF、量化表、哈夫曼表（0xC4不是帧头），然后是帧头和扫描
+static CBytes MakeJpeg(BYTE cFrame, int x, int y, DWORD cbExif)
+{
+	CBytes data;
+	data.push_back(0xFF);
+	data.push_back(0xD8);
+	AppendJpegSegment(data, 0xE0, 14);
+	if( cbExif > 0 ) AppendJpegSegment(data, 0xE1, cbExif);
+	AppendJpegSegment(data, 0xDB, 65);
+	AppendJpegSegment(data, 0xC4, 28);
+	// 段之间允许多余的0xFF填充
+	data.push_back(0xFF);
+	data.push_back(0xFF);
+	AppendJpegFrame(data, cFrame, x, y);
+	AppendJpegSegment(data, 0xDA, 10);
+	data.insert(data.end(), 32, 0x7E);
+	data.push_back(0xFF);
+	data.push_back(0xD9);
+	return data;
+}
+
+static CBytes MakeBmp(DWORD dwHeaderSize, int x, int y, int nBitCount)
+{
+	CBytes data;
+	Append(data, "BM", 2);
+	AppendLE32(data, 0);
+	AppendLE32(data, 0);
+	AppendLE32(data, 14 + dwHeaderSize);
+	AppendLE32(data, dwHeaderSize);
+	if( dwHeaderSize == 12 ) {
+		AppendLE16(data, x);
+		AppendLE16(data, y);
+		AppendLE16(data, 1);
+		AppendLE16(data, nBitCount);
+	}
+	else {
+		AppendLE32(data, x);
+		AppendLE32(data, (DWORD)y);
+		AppendLE16(data, 1);
+		AppendLE16(data, nBitCount);
+		data.insert(data.end(), dwHeaderSize - 16, 0);
+	}
+	data.insert(data.end(), 16, 0x44);
+	return data;
+}
+
+// 每个长度的前缀都复制到恰好大小的缓冲区中解析（越界读取由AddressSanitizer发现），
+// 成功时尺寸必须与完整数据相同；完整数据的结果与期望一致
+static void CheckFixture(const char* pstrName, const CBytes& data, bool bValid, int xExpected, int yExpected, bool bAlphaExpected)
+{
+	int x = -1, y = -1;
+	bool bAlpha = true;
+	bool bRet = CImageProbe::Probe(&data[0], (DWORD)data.size(), x, y, bAlpha);
+	bool bMatch = bRet == bValid && (bValid ? x == xExpected && y == yExpected && bAlpha == bAlphaExpected : x == 0 && y == 0 && !bAlpha);
+	if( !bMatch ) fprintf(stderr, "%s: got %d %dx%d alpha %d\n", pstrName, (int)bRet, x, y, (int)bAlpha);
+	TEST_CHECK(bMatch);
+
+	bool bPrefixes = true;
+	for( size_t cb = 0; cb < data.size(); cb++ ) {
+		BYTE* pPrefix = new BYTE[cb > 0 ? cb : 1];
+		memcpy(pPrefix, &data[0], cb);
+		bool bPrefix = CImageProbe::Probe(pPrefix, (DWORD)cb, x, y, bAlpha);
+		delete[] pPrefix;
+		if( bPrefix ? !bValid || x != xExpected || y != yExpected : x != 0 || y != 0 || bAlpha ) {
+			if( bPrefixes ) fprintf(stderr, "%s: prefix of %d bytes gave %d %dx%d\n", pstrName, (int)cb, (int)bPrefix, x, y);
+			bPrefixes = false;
+		}
+	}
+	TEST_CHECK(bPrefixes);
+}
+
+static void CheckPng()
+{
+	CheckFixture("png rgba", MakePng(300, 200, 6, "IDAT"), true, 300, 200, true);
+	CheckFixture("png gray alpha", MakePng(7, 9, 4, "IDAT"), true, 7, 9, true);
+	CheckFixture("png rgb", MakePng(640, 480, 2, "gAMAIDAT"), true, 640, 480, false);
+	// tRNS在IDAT之前才算透明
+	CheckFixture("png palette trns", MakePng(16, 16, 3, "PLTEtRNSIDAT"), true, 16, 16, true);
+	CheckFixture("png palette", MakePng(16, 16, 3, "PLTEIDATtRNS"), true, 16, 16, false);
+	CheckFixture("png zero width", MakePng(0, 16, 6, "IDAT"), false, 0, 0, false);
+	CheckFixture("png negative", MakePng(0x80000000, 16, 6, "IDAT"), false, 0, 0, false);
+
+	// 数据块的长度超出数据时停止查找，之后的tRNS不再识别
+	CBytes data = MakePng(32, 32, 2, "gAMAtRNSIDAT");
+	data[33] = 0xFF;
+	data[34] = 0xFF;
+	CheckFixture("png bad length", data, true, 32, 32, false);
+	// IHDR必须是第一个数据块
+	data = MakePng(32, 32, 2, "IDAT");
+	memcpy(&data[12], "IHDX", 4);
+	CheckFixture("png no ihdr", data, false, 0, 0, false);
+}
+
+static void CheckGif()
+{
+	CheckFixture("gif87a", MakeGif("GIF87a", 100, 50, 8, ""), true, 100, 50, false);
+	CheckFixture("gif89a transparent", MakeGif("GIF89a", 33, 44, 2, "T"), true, 33, 44, true);
+	CheckFixture("gif89a opaque", MakeGif("GIF89a", 33, 44, 2, "O"), true, 33, 44, false);
+	// 注释扩展按子块跳过，之后的图形控制扩展仍然识别
+	CheckFixture("gif comment", MakeGif("GIF89a", 320, 240, 0, "CT"), true, 320, 240, true);
+	CheckFixture("gif comments", MakeGif("GIF89a", 320, 240, 4, "CCO"), true, 320, 240, false);
+	CheckFixture("gif empty", MakeGif("GIF89a", 0, 240, 4, "T"), false, 0, 0, false);
+	CheckFixture("gif88a", MakeGif("GIF88a", 10, 10, 4, "T"), false, 0, 0, false);
+}
+
+static void CheckJpeg()
+{
+	CheckFixture("jpeg baseline", MakeJpeg(0xC0, 1920, 1080, 0), true, 1920, 1080, false);
+	CheckFixture("jpeg progressive", MakeJpeg(0xC2, 17, 3, 0), true, 17, 3, false);
+	// APPn在帧头之前，EXIF大于64K读取的文件头时由调用方读取完整文件
+	CheckFixture("jpeg exif", MakeJpeg(0xC0, 4000, 3000, 6000), true, 4000, 3000, false);
+	CheckFixture("jpeg big exif", MakeJpeg(0xC1, 800, 600, 65000), true, 800, 600, false);
+
+	// 扫描或结束标记出现在帧头之前、段不以0xFF开头时失败
+	CBytes data;
+	data.push_back(0xFF);
+	data.push_back(0xD8);
+	AppendJpegSegment(data, 0xE0, 14);
+	AppendJpegSegment(data, 0xDA, 10);
+	AppendJpegFrame(data, 0xC0, 10, 10);
+	CheckFixture("jpeg sos first", data, false, 0, 0, false);
+	data.resize(2);
+	AppendJpegSegment(data, 0xE0, 14);
+	data.push_back(0x00);
+	AppendJpegFrame(data, 0xC0, 10, 10);
+	CheckFixture("jpeg garbage", data, false, 0, 0, false);
+	// 没有长度字段的RSTn在帧头之前
+	data.resize(2);
+	AppendJpegSegment(data, 0xE0, 14);
+	data.push_back(0xFF);
+	data.push_back(0xD0);
+	AppendJpegFrame(data, 0xC0, 64, 48);
+	CheckFixture("jpeg rst", data, true, 64, 48, false);
+	CheckFixture("jpeg zero height", MakeJpeg(0xC0, 64, 0, 0), false, 0, 0, false);
+}
+
+static void CheckBmp()
+{
+	CheckFixture("bmp core", MakeBmp(12, 80, 60, 24), true, 80, 60, false);
+	CheckFixture("bmp core 32", MakeBmp(12, 80, 60, 32), true, 80, 60, true);
+	CheckFixture("bmp info", MakeBmp(40, 123, 45, 24), true, 123, 45, false);
+	// 高度为负表示自上而下
+	CheckFixture("bmp top down", MakeBmp(40, 123, -45, 32), true, 123, 45, true);
+	CheckFixture("bmp v5", MakeBmp(124, 256, 256, 32), true, 256, 256, true);
+	CheckFixture("bmp height min", MakeBmp(40, 10, (int)0x80000000, 32), false, 0, 0, false);
+	CheckFixture("bmp unknown header", MakeBmp(20, 10, 10, 32), false, 0, 0, false);
+}
+
+static void CheckOther()
+{
+	int x = -1, y = -1;
+	bool bAlpha = true;
+	TEST_CHECK(!CImageProbe::Probe(NULL, 100, x, y, bAlpha) && x == 0 && y == 0 && !bAlpha);
+	CBytes data(64, 0);
+	Append(data, "<svg", 4);
+	CheckFixture("unknown", data, false, 0, 0, false);
+	// 随机数据不能越界读取
+	CTestRandom random(0x2F6B9D13u);
+	for( int i = 0; i < 20000; i++ ) {
+		CBytes noise(26 + random.Next(200));
+		for( size_t j = 0; j < noise.size(); j++ ) noise[j] = (BYTE)random.Next();
+		static const char* s_aHeaders[] = { "\x89PNG\r\n\x1a\n\0\0\0\x0dIHDR", "GIF89a", "\xFF\xD8", "BM" };
+		const char* pstrHeader = s_aHeaders[i % 4];
+		size_t cbHeader = i % 4 == 0 ? 16 : strlen(pstrHeader);
+		memcpy(&noise[0], pstrHeader, cbHeader);
+		BYTE* pNoise = new BYTE[noise.size()];
+		memcpy(pNoise, &noise[0], noise.size());
+		if( CImageProbe::Probe(pNoise, (DWORD)noise.size(), x, y, bAlpha) ) TEST_CHECK(x > 0 && y > 0);
+		else TEST_CHECK(x == 0 && y == 0 && !bAlpha);
+		delete[] pNoise;
+	}
+}
+
+int main()
+{
+	CheckPng();
+	CheckGif();
+	CheckJpeg();
+	CheckBmp();
+	CheckOther();
+	return TestExitCode();
+}
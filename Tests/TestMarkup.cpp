@@ -0,0 +1,177 @@
+﻿// CMarkup：SIMD扫描与逐字符扫描解析出的元素表和属性表必须完全相同
+// 用法：test_markup 皮肤文件...（CMake把bin/skin下的xml都传进来）
+#include "StdAfx.h"
+#include "TestUtil.h"
+#include "MarkupTest.h"
+
+using namespace DuiLib;
+
+// 一份UTF-8文档在各种加载方式、空白处理和指令集下的解析结果都与逐字符扫描一致
+static int CheckDocument(const std::string& sUtf8)
+{
+	std::vector<WCHAR> aWide = Utf8ToWide(sUtf8);
+	int nElements = 0;
+	for( int iPreserve = 0; iPreserve < 2; iPreserve++ ) {
+		for( int iUtf8 = 0; iUtf8 < 2; iUtf8++ ) {
+			CMarkup xmlScalar;
+			CMarkup xmlSimd[2];
+			xmlScalar.SetPreserveWhitespace(iPreserve != 0);
+			CMarkup::SetSimdLevel(MARKUP_SIMD_NONE);
+			bool bScalar = iUtf8 ? xmlScalar.LoadFromMem((BYTE*)sUtf8.data(), (DWORD)sUtf8.size()) : xmlScalar.Load(&aWide[0]);
+			for( int iLevel = MARKUP_SIMD_SSE2; iLevel <= MARKUP_SIMD_AVX2; iLevel++ ) {
+				CMarkup& xml = xmlSimd[iLevel - MARKUP_SIMD_SSE2];
+				xml.SetPreserveWhitespace(iPreserve != 0);
+				CMarkup::SetSimdLevel(iLevel);
+				bool bSimd = iUtf8 ? xml.LoadFromMem((BYTE*)sUtf8.data(), (DWORD)sUtf8.size()) : xml.Load(&aWide[0]);
+				TEST_CHECK(bScalar == bSimd);
+				if( !bScalar || !bSimd ) {
+					TCHAR szError1[100] = { 0 }, szError2[100] = { 0 };
+					xmlScalar.GetLastErrorMessage(szError1, lengthof(szError1) - 1);
+					xml.GetLastErrorMessage(szError2, lengthof(szError2) - 1);
+					TEST_CHECK(SameText(szError1, szError2));
+					continue;
+				}
+				nElements += CompareTree(xmlScalar.GetRoot(), xml.GetRoot());
+			}
+		}
+	}
+	CMarkup::SetSimdLevel(MARKUP_SIMD_AVX2);
+	return nElements;
+}
+
+// 把流式解析的开始、属性、结束事件记成一个串，文本不参与比较
+class CRecordHandler : public IMarkupHandler
+{
+public:
+	virtual bool OnStartElement(LPCTSTR pstrName) { m_sEvents += _T("<"); m_sEvents += pstrName; return true; }
+	virtual bool OnAttribute(LPCTSTR pstrName, LPCTSTR pstrValue)
+	{
+		m_sEvents += _T(" "); m_sEvents += pstrName; m_sEvents += _T("="); m_sEvents += pstrValue;
+		return true;
+	}
+	virtual bool OnText(LPCTSTR pstrText) { return true; }
+	virtual bool OnEndElement(LPCTSTR pstrName) { m_sEvents += _T("/"); m_sEvents += pstrName; return true; }
+
+	CDuiString m_sEvents;
+};
+
+static void RecordTree(CMarkupNode node, CDuiString& sEvents)
+{
+	for( ; node.IsValid(); node = node.GetSibling() ) {
+		sEvents += _T("<"); sEvents += node.GetName();
+		for( int i = 0; i < node.GetAttributeCount(); i++ ) {
+			sEvents += _T(" "); sEvents += node.GetAttributeName(i); sEvents += _T("="); sEvents += node.GetAttributeValue(i);
+		}
+		RecordTree(node.GetChild(), sEvents);
+		sEvents += _T("/"); sEvents += node.GetName();
+	}
+}
+
+// 写入临时文件后流式解析，事件序列要与整篇解析的树一致；返回比较的字符数
+static int CheckStream(const std::string& sUtf8)
+{
+	static const char s_szFile[] = "markup_stream.xml";
+	FILE* pFile = fopen(s_szFile, "wb");
+	TEST_CHECK(pFile != NULL);
+	if( pFile == NULL ) return 0;
+	fwrite(sUtf8.data(), 1, sUtf8.size(), pFile);
+	fclose(pFile);
+
+	CMarkup xml;
+	bool bLoad = xml.LoadFromMem((BYTE*)sUtf8.data(), (DWORD)sUtf8.size());
+	CRecordHandler handler;
+	CMarkup xmlStream;
+	std::vector<WCHAR> aFile = Utf8ToWide(s_szFile);
+	bool bStream = xmlStream.ParseStream(&aFile[0], &handler);
+	remove(s_szFile);
+	TEST_CHECK(bLoad == bStream);
+	if( !bLoad || !bStream ) return 0;
+	CDuiString sEvents;
+	RecordTree(xml.GetRoot(), sEvents);
+	TEST_CHECK(sEvents == handler.m_sEvents);
+	return sEvents.GetLength();
+}
+
+// 跨过多个64K读取块的标签，引号内有'>'，流式解析要接着上次的扫描位置和引号状态继续
+static void CheckLargeTags(CTestRandom& random)
+{
+	for( int i = 0; i < 4; i++ ) {
+		std::string sValue;
+		int cchValue = 60000 + random.Next(200000);
+		while( (int)sValue.size() < cchValue ) {
+			sValue += MakeRandomText(random, true);
+			sValue += " a>b ";
+		}
+		std::string sDoc = "<Window caption=\"0,0,0,30\" text=\"" + sValue + "\"" + MakeSpaceRun(random) + " name=\"main\">";
+		sDoc += "<Label text=\"" + sValue.substr(0, random.Next((int)sValue.size())) + "\"/>";
+		sDoc += std::string(random.Next(70000), ' ') + "<!-- " + std::string(70000, '-') + " x -->";
+		sDoc += "</Window>";
+		TEST_CHECK(CheckStream(sDoc) > cchValue);
+	}
+	// 未闭合的引号和标签在文件末尾报错
+	TEST_CHECK(CheckStream("<Window text=\"" + std::string(200000, '>') + "/>") == 0);
+}
+
+// UTF-8文档的影子缓冲区只在访问字符串时按页提交：解析不提交，读一个字符串只提交它所在的页，释放后全部归还
+static void CheckShadowCommit()
+{
+	std::string sDoc = "<Window name=\"main\">";
+	std::string sText(1000, 'x');
+	for( int i = 0; i < 2000; i++ ) sDoc += "<Label text=\"" + sText + "\"/>";
+	sDoc += "</Window>";
+	SIZE_T cbBase = Win32StubCommittedBytes();
+	{
+		CMarkup xml;
+		TEST_CHECK(xml.LoadFromMem((BYTE*)sDoc.data(), (DWORD)sDoc.size()));
+		TEST_CHECK(Win32StubCommittedBytes() == cbBase);
+		CMarkupNode root = xml.GetRoot();
+		TEST_CHECK(SameText(root.GetName(), _T("Window")));
+		TEST_CHECK(SameText(root.GetAttributeValue(_T("name")), _T("main")));
+		TEST_CHECK(Win32StubCommittedBytes() - cbBase <= 2 * 4096);
+		int nLabels = 0;
+		for( CMarkupNode node = root.GetChild(); node.IsValid(); node = node.GetSibling() ) {
+			if( _tcslen(node.GetAttributeValue(_T("text"))) == sText.size() ) nLabels++;
+		}
+		TEST_CHECK(nLabels == 2000);
+		TEST_CHECK(Win32StubCommittedBytes() - cbBase <= (sDoc.size() + 1) * sizeof(WCHAR) + 4096);
+	}
+	TEST_CHECK(Win32StubCommittedBytes() == cbBase);
+}
+
+int main(int argc, char* argv[])
+{
+	int nElements = 0;
+	int nFiles = 0;
+	for( int i = 1; i < argc; i++ ) {
+		std::string sFile;
+		if( !ReadCorpusFile(argv[i], sFile) ) {
+			fprintf(stderr, "cannot read %s\n", argv[i]);
+			TEST_CHECK(false);
+			continue;
+		}
+		// 根元素前加不同数量的空白，让每个分隔符都落在16/32字节块的各个位置上
+		for( int nShift = 0; nShift < 32; nShift++ ) {
+			nElements += CheckDocument(std::string(nShift, ' ') + sFile);
+		}
+		nFiles++;
+	}
+
+	// 随机生成的文档覆盖长空白、转义、组合字符和注释
+	CTestRandom random;
+	for( int i = 0; i < 300; i++ ) {
+		nElements += CheckDocument(MakeRandomDocument(random, 40));
+	}
+	// 流式解析与整篇解析一致
+	for( int i = 0; i < 100; i++ ) CheckStream(MakeRandomDocument(random, 40));
+	CheckLargeTags(random);
+	CheckShadowCommit();
+	// 错误的文档要在同样的位置以同样的错误失败
+	CheckDocument("<Window><Label text=\"abc\"></Window>");
+	CheckDocument("<Window size=\"1,2\" caption=\"0,0,0,30\"   ");
+	CheckDocument("<Window>   text   <!-- never closed ");
+	CheckDocument("<Window a=\"&amp;&lt;&gt;&quot;&apos;&\"  b  =  \"x\"/>");
+
+	printf("%d files, %d elements compared\n", nFiles, nElements);
+	TEST_CHECK(nElements > 0);
+	return TestExitCode();
+}
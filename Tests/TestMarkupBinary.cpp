@@ -0,0 +1,99 @@
+﻿// 编译过的皮肤：SkinCompiler的输出与XML解析结果相同；截断或损坏的文件只能加载失败，不能越界访问
+// 用法：test_markup_binary 皮肤目录 编译输出目录 相对路径...
+#include "StdAfx.h"
+#include "TestUtil.h"
+#include "MarkupTest.h"
+
+using namespace DuiLib;
+
+static CDuiString ToTString(const std::string& s)
+{
+	std::vector<WCHAR> aWide = Utf8ToWide(s);
+	return CDuiString(&aWide[0]);
+}
+
+// 遍历整棵树并读取所有字符串，损坏的下标会在这里越界或死循环
+static int WalkTree(CMarkupNode node, int nDepth)
+{
+	int nElements = 0;
+	for( ; node.IsValid(); node = node.GetSibling() ) {
+		nElements++;
+		TEST_CHECK(nDepth < 10000);
+		if( nDepth >= 10000 ) break;
+		_tcslen(node.GetName());
+		_tcslen(node.GetValue());
+		for( int i = 0; i < node.GetAttributeCount(); i++ ) {
+			_tcslen(node.GetAttributeName(i));
+			_tcslen(node.GetAttributeValue(i));
+			node.HasAttribute(node.GetAttributeName(i));
+		}
+		nElements += WalkTree(node.GetChild(), nDepth + 1);
+	}
+	return nElements;
+}
+
+// 只要加载成功，文件里的每个下标都已经检查过
+static void CheckCorrupt(std::string sData)
+{
+	CMarkup xml;
+	if( xml.LoadFromMem((BYTE*)&sData[0], (DWORD)sData.size()) ) WalkTree(xml.GetRoot(), 0);
+}
+
+int main(int argc, char* argv[])
+{
+	if( argc < 3 ) {
+		fprintf(stderr, "usage: test_markup_binary skin_dir compiled_dir file...\n");
+		return EXIT_FAILURE;
+	}
+	std::string sSkinDir = std::string(argv[1]) + "/";
+	std::string sCompiledDir = std::string(argv[2]) + "/";
+	std::string sSample;
+	int nElements = 0;
+	for( int i = 3; i < argc; i++ ) {
+		CMarkup xmlText;
+		CMarkup xmlBinary;
+		TEST_CHECK(xmlText.LoadFromFile(ToTString(sSkinDir + argv[i])));
+		TEST_CHECK(xmlBinary.LoadFromFile(ToTString(sCompiledDir + argv[i])));
+		TEST_CHECK(!xmlText.IsBinary() && xmlBinary.IsBinary());
+		nElements += CompareTree(xmlText.GetRoot(), xmlBinary.GetRoot());
+
+		std::string sData;
+		TEST_CHECK(ReadCorpusFile((sCompiledDir + argv[i]).c_str(), sData));
+		CMarkup xmlMem;
+		TEST_CHECK(xmlMem.LoadFromMem((BYTE*)&sData[0], (DWORD)sData.size()));
+		TEST_CHECK(xmlMem.IsBinary());
+		CompareTree(xmlText.GetRoot(), xmlMem.GetRoot());
+		if( sSample.empty() || (sData.size() < sSample.size() && sData.size() > 2000) ) sSample = sData;
+	}
+	TEST_CHECK(nElements > 0);
+	TEST_CHECK(!sSample.empty());
+
+	// 在每个长度上截断
+	for( size_t cb = 0; cb < sSample.size(); cb++ ) {
+		CMarkup xml;
+		std::string sData = sSample.substr(0, cb);
+		TEST_CHECK(!xml.LoadFromMem((BYTE*)&sData[0], (DWORD)sData.size()) || !xml.IsBinary());
+	}
+	// 随机改写字节和4字节字段，字段值取小整数、边界附近的值和任意值
+	CTestRandom random;
+	for( int i = 0; i < 20000; i++ ) {
+		std::string sData = sSample;
+		int nChanges = 1 + random.Next(3);
+		for( int j = 0; j < nChanges; j++ ) {
+			size_t iPos = (size_t)random.Next((int)sData.size() - 4) & ~(size_t)3;
+			uint32_t nValue = 0;
+			switch( random.Next(4) ) {
+			case 0: nValue = (uint32_t)random.Next(64); break;
+			case 1: nValue = (uint32_t)random.Next(70000); break;
+			case 2: nValue = random.Next(); break;
+			default: nValue = 0xFFFFFFFF - (uint32_t)random.Next(4); break;
+			}
+			if( random.Next(3) == 0 ) sData[iPos + random.Next(4)] ^= (char)(1 << random.Next(8));
+			else memcpy(&sData[iPos], &nValue, sizeof(nValue));
+		}
+		CheckCorrupt(sData);
+	}
+
+	printf("%d files, %d elements compared\n", argc - 3, nElements);
+	return TestExitCode();
+}
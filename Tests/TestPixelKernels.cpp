@@ -0,0 +1,200 @@
+﻿// CPixelKernels：每个指令集的结果与按原来的逐像素除法计算的参考结果、以及标量实现的结果逐字节一致
+#include "TestUtil.h"
+#include "Core/UIPixelKernels.h"
+#include <string.h>
+#include <vector>
+
+using namespace DuiLib;
+
+// 改为内核之前CRenderEngine::LoadImage中的循环
+static bool ReferenceConvert(const BYTE* pSrc, BYTE* pDest, int nPixels, DWORD mask)
+{
+	bool bAlphaChannel = false;
+	for( int i = 0; i < nPixels; i++ ) {
+		BYTE r = pSrc[i*4], g = pSrc[i*4 + 1], b = pSrc[i*4 + 2], a = pSrc[i*4 + 3];
+		pDest[i*4 + 3] = a;
+		if( a < 255 ) {
+			pDest[i*4] = (BYTE)(DWORD(b)*a/255);
+			pDest[i*4 + 1] = (BYTE)(DWORD(g)*a/255);
+			pDest[i*4 + 2] = (BYTE)(DWORD(r)*a/255);
+			bAlphaChannel = true;
+		}
+		else {
+			pDest[i*4] = b;
+			pDest[i*4 + 1] = g;
+			pDest[i*4 + 2] = r;
+		}
+		DWORD dwPixel = (DWORD)pDest[i*4] | ((DWORD)pDest[i*4 + 1] << 8) | ((DWORD)pDest[i*4 + 2] << 16) | ((DWORD)pDest[i*4 + 3] << 24);
+		if( dwPixel == mask ) {
+			memset(pDest + i*4, 0, 4);
+			bAlphaChannel = true;
+		}
+	}
+	return bAlphaChannel;
+}
+
+// 随机图片：alpha分别取任意值、全不透明、只有0和255，颜色偶尔重复mask对应的值
+static std::vector<BYTE> MakeImage(CTestRandom& random, int nPixels, int iKind, DWORD maskRGBA)
+{
+	std::vector<BYTE> aPixels(nPixels * 4 + 1);
+	for( int i = 0; i < nPixels; i++ ) {
+		DWORD dwPixel = random.Next();
+		if( iKind == 1 ) dwPixel |= 0xFF000000;
+		else if( iKind == 2 ) dwPixel = random.Next(2) ? (dwPixel | 0xFF000000) : (dwPixel & 0x00FFFFFF);
+		if( random.Next(8) == 0 ) dwPixel = maskRGBA;
+		for( int j = 0; j < 4; j++ ) aPixels[i*4 + j] = (BYTE)(dwPixel >> (j * 8));
+	}
+	return aPixels;
+}
+
+static void CheckConvert(int iLevel)
+{
+	CTestRandom random(0x9E3779B9u + iLevel);
+	for( int iImage = 0; iImage < 3000; iImage++ ) {
+		int nPixels = random.Next(4) == 0 ? random.Next(8) : random.Next(700);
+		int iKind = random.Next(3);
+		// mask是BGRA顺序的不透明颜色，构造图片时按RGBA写出同一个颜色
+		DWORD mask = random.Next(3) == 0 ? 0 : (0xFF000000 | (random.Next() & 0x00FFFFFF));
+		DWORD maskRGBA = (mask & 0xFF00FF00) | ((mask >> 16) & 0xFF) | ((mask & 0xFF) << 16);
+		std::vector<BYTE> aSrc = MakeImage(random, nPixels, iKind, maskRGBA);
+		// 从奇数地址开始，覆盖不对齐的读写
+		int iOffset = random.Next(2);
+		std::vector<BYTE> aIn(aSrc.size() + 1);
+		memcpy(&aIn[iOffset], &aSrc[0], nPixels * 4);
+
+		std::vector<BYTE> aExpected(nPixels * 4 + 1), aActual(nPixels * 4 + 2, 0xCD);
+		bool bExpected = ReferenceConvert(&aSrc[0], &aExpected[0], nPixels, mask);
+		bool bActual = CPixelKernels::ConvertImageBits(&aIn[iOffset], &aActual[1], nPixels, mask);
+		TEST_CHECK(bExpected == bActual);
+		TEST_CHECK(memcmp(&aExpected[0], &aActual[1], nPixels * 4) == 0);
+		// 不写出范围以外
+		TEST_CHECK(aActual[0] == 0xCD && aActual[nPixels * 4 + 1] == 0xCD);
+
+		// 原地转换
+		bActual = CPixelKernels::ConvertImageBits(&aIn[iOffset], &aIn[iOffset], nPixels, mask);
+		TEST_CHECK(bExpected == bActual);
+		TEST_CHECK(memcmp(&aExpected[0], &aIn[iOffset], nPixels * 4) == 0);
+	}
+
+	// 每种颜色值与每种alpha的组合
+	std::vector<BYTE> aAll(256 * 256 * 4), aExpected(aAll.size()), aActual(aAll.size());
+	for( int a = 0; a < 256; a++ ) {
+		for( int c = 0; c < 256; c++ ) {
+			BYTE* p = &aAll[(a * 256 + c) * 4];
+			p[0] = (BYTE)c; p[1] = (BYTE)(255 - c); p[2] = (BYTE)(c ^ 0x5A); p[3] = (BYTE)a;
+		}
+	}
+	TEST_CHECK(ReferenceConvert(&aAll[0], &aExpected[0], 256 * 256, 0) == CPixelKernels::ConvertImageBits(&aAll[0], &aActual[0], 256 * 256, 0));
+	TEST_CHECK(aExpected == aActual);
+}
+
+// 行内处理的参考实现，按定义逐通道做整数除法
+static DWORD RefChannels(DWORD dwPixel, DWORD dwFactor)
+{
+	DWORD dwResult = 0;
+	for( int s = 0; s < 32; s += 8 ) dwResult |= (((dwPixel >> s) & 0xFF) * dwFactor / 255) << s;
+	return dwResult;
+}
+
+static DWORD RefBlend(DWORD dwDest, DWORD dwSrc)
+{
+	DWORD dwInv = 255 - (dwSrc >> 24);
+	DWORD dwResult = 0;
+	for( int s = 0; s < 32; s += 8 ) {
+		DWORD c = ((dwDest >> s) & 0xFF) * dwInv / 255 + ((dwSrc >> s) & 0xFF);
+		dwResult |= (c > 255 ? 255 : c) << s;
+	}
+	return dwResult;
+}
+
+enum { SPAN_FILL, SPAN_BLEND, SPAN_REPAIR_ALPHA, SPAN_FORCE_OPAQUE, SPAN_MULTIPLY_ALPHA, SPAN_KERNEL_COUNT };
+
+static void ReferenceSpan(int iKernel, DWORD* pDest, const DWORD* pSrc, int n, DWORD dwParam)
+{
+	for( int i = 0; i < n; i++ ) {
+		DWORD d = pDest[i];
+		switch( iKernel ) {
+		case SPAN_FILL: pDest[i] = RefBlend(d, dwParam); break;
+		case SPAN_BLEND: pDest[i] = RefBlend(d, RefChannels(pSrc[i], dwParam)); break;
+		case SPAN_REPAIR_ALPHA: if( (d >> 24) == 0 && d != 0 ) pDest[i] = d | 0xFF000000; break;
+		case SPAN_FORCE_OPAQUE: if( d != 0 ) pDest[i] = d | 0xFF000000; break;
+		default: pDest[i] = (pSrc[i] & 0xFF000000) | (RefChannels(d, pSrc[i] >> 24) & 0x00FFFFFF); break;
+		}
+	}
+}
+
+static void RunSpan(int iKernel, DWORD* pDest, const DWORD* pSrc, int n, DWORD dwParam)
+{
+	switch( iKernel ) {
+	case SPAN_FILL: CPixelKernels::FillSpan(pDest, n, dwParam); break;
+	case SPAN_BLEND: CPixelKernels::BlendSpan(pDest, pSrc, n, dwParam); break;
+	case SPAN_REPAIR_ALPHA: CPixelKernels::RepairAlphaSpan(pDest, n); break;
+	case SPAN_FORCE_OPAQUE: CPixelKernels::ForceOpaqueSpan(pDest, n); break;
+	default: CPixelKernels::MultiplyAlphaSpan(pDest, pSrc, n); break;
+	}
+}
+
+// 预乘像素，混入全透明、不透明和GDI画出的alpha为0的像素
+static DWORD RandomPixel(CTestRandom& random)
+{
+	DWORD dwPixel = random.Next();
+	switch( random.Next(5) ) {
+	case 0: return 0;
+	case 1: return dwPixel | 0xFF000000;
+	case 2: return dwPixel & 0x00FFFFFF;
+	default: return (dwPixel & 0xFF000000) | (RefChannels(dwPixel, dwPixel >> 24) & 0x00FFFFFF);
+	}
+}
+
+static void CheckSpans(int iLevel)
+{
+	CTestRandom random(0x85EBCA6Bu + iLevel);
+	for( int iSpan = 0; iSpan < 20000; iSpan++ ) {
+		int iKernel = random.Next(SPAN_KERNEL_COUNT);
+		// 奇数长度和不足一组的长度，从不是16字节对齐的位置开始
+		int n = random.Next(4) == 0 ? random.Next(9) : random.Next(80);
+		int iOffset = 1 + random.Next(4);
+		std::vector<DWORD> aDest(n + 8), aSrc(n + 8);
+		for( size_t i = 0; i < aDest.size(); i++ ) {
+			aDest[i] = RandomPixel(random);
+			aSrc[i] = RandomPixel(random);
+		}
+		DWORD dwParam = 0;
+		if( iKernel == SPAN_FILL ) dwParam = RandomPixel(random);
+		else if( iKernel == SPAN_BLEND ) dwParam = random.Next(2) ? 255 : (DWORD)random.Next(256);
+		// 一组4个像素的源全不透明或全透明时走直接覆盖和跳过的分支
+		if( iKernel == SPAN_BLEND && random.Next(3) == 0 ) {
+			DWORD dwFill = random.Next(2) ? 0 : (random.Next() | 0xFF000000);
+			for( size_t i = 0; i < aSrc.size(); i++ ) aSrc[i] = dwFill;
+		}
+
+		std::vector<DWORD> aExpected = aDest;
+		ReferenceSpan(iKernel, &aExpected[iOffset], &aSrc[iOffset], n, dwParam);
+		std::vector<DWORD> aScalar = aDest;
+		CPixelKernels::SetSimdLevel(PIXEL_SIMD_NONE);
+		RunSpan(iKernel, &aScalar[iOffset], &aSrc[iOffset], n, dwParam);
+		CPixelKernels::SetSimdLevel(iLevel);
+		std::vector<DWORD> aActual = aDest;
+		RunSpan(iKernel, &aActual[iOffset], &aSrc[iOffset], n, dwParam);
+		// 范围以外的像素也一起比较
+		TEST_CHECK(aScalar == aExpected);
+		TEST_CHECK(aActual == aScalar);
+	}
+}
+
+int main()
+{
+	static const char* s_aLevels[] = { "scalar", "SSE2", "SSSE3", "AVX2" };
+	for( int iLevel = PIXEL_SIMD_NONE; iLevel <= PIXEL_SIMD_AVX2; iLevel++ ) {
+		CPixelKernels::SetSimdLevel(iLevel);
+		if( CPixelKernels::GetSimdLevel() != iLevel ) {
+			printf("%s not supported, skipped\n", s_aLevels[iLevel]);
+			continue;
+		}
+		CheckConvert(iLevel);
+		CheckSpans(iLevel);
+		printf("%s checked\n", s_aLevels[iLevel]);
+	}
+	CPixelKernels::SetSimdLevel(PIXEL_SIMD_AVX2);
+	return TestExitCode();
+}
@@ -0,0 +1,425 @@
+﻿// CRasterizer：填充、渐变、位图复制/拉伸/平铺/混合、九宫格和分层窗口的逐像素处理在每个指令集下都与逐像素计算的参考结果一致，
+// 且不写出裁剪区域和给定的脏矩形
+#include "TestUtil.h"
+#include "Core/UIRasterizer.h"
+#include "Core/UIPixelKernels.h"
+#include <string.h>
+#include <vector>
+
+using namespace DuiLib;
+
+static const DWORD GUARD_PIXEL = 0xDEADBEEF;
+
+// 带行尾填充的BGRA图片，可以自上而下或自下而上存放；填充部分写入GUARD_PIXEL，用来发现越界写
+class CTestImage
+{
+public:
+	CTestImage(int nWidth, int nHeight, int nPad, bool bBottomUp) :
+		m_nWidth(nWidth), m_nHeight(nHeight), m_nRowPixels(nWidth + nPad), m_bBottomUp(bBottomUp),
+		m_aPixels(m_nRowPixels * (nHeight > 0 ? nHeight : 1), GUARD_PIXEL)
+	{
+	}
+
+	int GetWidth() const { return m_nWidth; }
+	int GetHeight() const { return m_nHeight; }
+	DWORD& At(int x, int y) { return m_aPixels[(m_bBottomUp ? m_nHeight - 1 - y : y) * m_nRowPixels + x]; }
+	LPBYTE GetBits() { return (LPBYTE)&At(0, 0); }
+	int GetStride() const { return (m_bBottomUp ? -m_nRowPixels : m_nRowPixels) * (int)sizeof(DWORD); }
+
+	bool GuardIntact() const
+	{
+		for( int y = 0; y < m_nHeight; y++ ) {
+			for( int x = m_nWidth; x < m_nRowPixels; x++ ) {
+				if( m_aPixels[y * m_nRowPixels + x] != GUARD_PIXEL ) return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	int m_nWidth;
+	int m_nHeight;
+	int m_nRowPixels;
+	bool m_bBottomUp;
+	std::vector<DWORD> m_aPixels;
+};
+
+// 参考实现：按定义逐通道做整数除法
+static DWORD RefPremultiply(DWORD dwColor)
+{
+	DWORD a = dwColor >> 24;
+	DWORD dwResult = a << 24;
+	for( int s = 0; s < 24; s += 8 ) dwResult |= (((dwColor >> s) & 0xFF) * a / 255) << s;
+	return dwResult;
+}
+
+static DWORD RefFade(DWORD dwSrc, DWORD dwFade)
+{
+	DWORD dwResult = 0;
+	for( int s = 0; s < 32; s += 8 ) dwResult |= (((dwSrc >> s) & 0xFF) * dwFade / 255) << s;
+	return dwResult;
+}
+
+static DWORD RefBlend(DWORD dwDest, DWORD dwSrc)
+{
+	DWORD dwInv = 255 - (dwSrc >> 24);
+	DWORD dwResult = 0;
+	for( int s = 0; s < 32; s += 8 ) {
+		DWORD c = ((dwDest >> s) & 0xFF) * dwInv / 255 + ((dwSrc >> s) & 0xFF);
+		dwResult |= (c > 255 ? 255 : c) << s;
+	}
+	return dwResult;
+}
+
+static DWORD RandomColor(CTestRandom& random)
+{
+	switch( random.Next(4) ) {
+	case 0: return random.Next() | 0xFF000000;
+	case 1: return random.Next() & 0x00FFFFFF;
+	default: return random.Next();
+	}
+}
+
+static DWORD RandomPremultiplied(CTestRandom& random)
+{
+	return RefPremultiply(RandomColor(random));
+}
+
+static RECT RandomRect(CTestRandom& random, int nWidth, int nHeight)
+{
+	RECT rc;
+	rc.left = random.Next(nWidth + 8) - 4;
+	rc.top = random.Next(nHeight + 8) - 4;
+	rc.right = rc.left + random.Next(nWidth + 4);
+	rc.bottom = rc.top + random.Next(nHeight + 4);
+	return rc;
+}
+
+static bool PtInRect(const RECT& rc, int x, int y)
+{
+	return x >= rc.left && x < rc.right && y >= rc.top && y < rc.bottom;
+}
+
+// 按像素中心取最近点，或平铺时取模
+static int MapCoord(int d, int nDest, int nSrc, bool bTile)
+{
+	return bTile ? d % nSrc : (int)(((long long)d * 2 + 1) * nSrc / ((long long)nDest * 2));
+}
+
+// 九宫格中一个方向上的位置：0为起始边，1为中间，2为结束边
+static int MapNinePatch(int d, int nDest, int nSrc, int nStart, int nEnd, bool bTile, int& s)
+{
+	if( d < nStart ) {
+		s = d;
+		return 0;
+	}
+	if( d >= nDest - nEnd ) {
+		s = nSrc - (nDest - d);
+		return 2;
+	}
+	s = nStart + MapCoord(d - nStart, nDest - nStart - nEnd, nSrc - nStart - nEnd, bTile);
+	return 1;
+}
+
+// 以同样的状态随机绘制一次，先用参考实现计算期望值，再与CRasterizer的结果比较
+class CRasterizerCheck
+{
+public:
+	CRasterizerCheck(CTestRandom& random) : m_random(random),
+		m_image(1 + random.Next(40), 1 + random.Next(30), random.Next(3), random.Next(2) != 0),
+		m_src(1 + random.Next(24), 1 + random.Next(24), random.Next(3), random.Next(2) != 0),
+		m_mask(m_image.GetWidth(), m_image.GetHeight(), random.Next(3), random.Next(2) != 0)
+	{
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) m_image.At(x, y) = RandomPremultiplied(random);
+		}
+		for( int y = 0; y < m_src.GetHeight(); y++ ) {
+			for( int x = 0; x < m_src.GetWidth(); x++ ) m_src.At(x, y) = RandomPremultiplied(random);
+		}
+		m_aExpected.resize(m_image.GetWidth() * m_image.GetHeight());
+		m_rasterizer.Attach(m_image.GetBits(), m_image.GetWidth(), m_image.GetHeight(), m_image.GetStride());
+		if( random.Next(2) ) {
+			m_rcClip = RandomRect(random, m_image.GetWidth(), m_image.GetHeight());
+			m_rasterizer.SetClip(m_rcClip);
+		}
+		else {
+			RECT rcAll = { 0, 0, m_image.GetWidth(), m_image.GetHeight() };
+			m_rcClip = rcAll;
+		}
+	}
+
+	void Run()
+	{
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) m_aExpected[y * m_image.GetWidth() + x] = m_image.At(x, y);
+		}
+		switch( m_random.Next(5) ) {
+		case 0: CheckFillRect(); break;
+		case 1: CheckFillGradient(); break;
+		case 2: CheckTile(); break;
+		case 3: CheckNinePatch(); break;
+		default: CheckLayeredPass(); break;
+		}
+		bool bMatch = true;
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( m_image.At(x, y) != m_aExpected[y * m_image.GetWidth() + x] ) bMatch = false;
+			}
+		}
+		TEST_CHECK(bMatch);
+		TEST_CHECK(m_image.GuardIntact());
+		TEST_CHECK(m_src.GuardIntact());
+		TEST_CHECK(m_mask.GuardIntact());
+	}
+
+private:
+	bool IsDrawn(int x, int y) const
+	{
+		return PtInRect(m_rcClip, x, y);
+	}
+
+	DWORD& Expected(int x, int y)
+	{
+		return m_aExpected[y * m_image.GetWidth() + x];
+	}
+
+	void CheckFillRect()
+	{
+		RECT rc = RandomRect(m_random, m_image.GetWidth(), m_image.GetHeight());
+		DWORD dwColor = RandomColor(m_random);
+		DWORD c = RefPremultiply(dwColor);
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( PtInRect(rc, x, y) && IsDrawn(x, y) ) Expected(x, y) = RefBlend(Expected(x, y), c);
+			}
+		}
+		m_rasterizer.FillRect(rc, dwColor);
+	}
+
+	void CheckFillGradient()
+	{
+		RECT rc = RandomRect(m_random, m_image.GetWidth(), m_image.GetHeight());
+		DWORD dwFirst = RandomColor(m_random), dwSecond = RandomColor(m_random);
+		bool bVertical = m_random.Next(2) != 0;
+		DWORD dwAlpha = ((dwFirst >> 24) + (dwSecond >> 24)) / 2;
+		int n = bVertical ? rc.bottom - rc.top : rc.right - rc.left;
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( !PtInRect(rc, x, y) || !IsDrawn(x, y) ) continue;
+				int i = bVertical ? y - rc.top : x - rc.left;
+				DWORD dwColor = dwAlpha << 24;
+				for( int s = 0; s < 24; s += 8 ) dwColor |= ((((dwFirst >> s) & 0xFF) * (n - i) + ((dwSecond >> s) & 0xFF) * i) / n) << s;
+				Expected(x, y) = RefBlend(Expected(x, y), RefPremultiply(dwColor));
+			}
+		}
+		m_rasterizer.FillGradient(rc, dwFirst, dwSecond, bVertical);
+	}
+
+	RECT RandomSrcRect()
+	{
+		RECT rc;
+		rc.left = m_random.Next(m_src.GetWidth());
+		rc.top = m_random.Next(m_src.GetHeight());
+		rc.right = rc.left + 1 + m_random.Next(m_src.GetWidth() - rc.left);
+		rc.bottom = rc.top + 1 + m_random.Next(m_src.GetHeight() - rc.top);
+		return rc;
+	}
+
+	void PutPixel(int x, int y, DWORD dwSrc, bool bBlend, BYTE uFade)
+	{
+		Expected(x, y) = bBlend ? RefBlend(Expected(x, y), RefFade(dwSrc, uFade)) : dwSrc;
+	}
+
+	void CheckTile()
+	{
+		RECT rcDest = RandomRect(m_random, m_image.GetWidth(), m_image.GetHeight());
+		RECT rcSrc = RandomSrcRect();
+		// 一半的情况与源同样大小，走直接取源行的路径
+		if( m_random.Next(2) ) {
+			rcDest.right = rcDest.left + rcSrc.right - rcSrc.left;
+			rcDest.bottom = rcDest.top + rcSrc.bottom - rcSrc.top;
+		}
+		bool bBlend = m_random.Next(3) != 0;
+		BYTE uFade = m_random.Next(2) ? 255 : (BYTE)m_random.Next(256);
+		bool bTileX = m_random.Next(3) == 0, bTileY = m_random.Next(3) == 0;
+		int cxDest = rcDest.right - rcDest.left, cyDest = rcDest.bottom - rcDest.top;
+		int cxSrc = rcSrc.right - rcSrc.left, cySrc = rcSrc.bottom - rcSrc.top;
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( !PtInRect(rcDest, x, y) || !IsDrawn(x, y) ) continue;
+				int sx = rcSrc.left + MapCoord(x - rcDest.left, cxDest, cxSrc, bTileX);
+				int sy = rcSrc.top + MapCoord(y - rcDest.top, cyDest, cySrc, bTileY);
+				PutPixel(x, y, m_src.At(sx, sy), bBlend, uFade);
+			}
+		}
+		if( !bTileX && !bTileY && m_random.Next(2) ) m_rasterizer.Blit(rcDest, m_src.GetBits(), m_src.GetStride(), rcSrc, bBlend, uFade);
+		else m_rasterizer.Tile(rcDest, m_src.GetBits(), m_src.GetStride(), rcSrc, bBlend, uFade, bTileX, bTileY);
+	}
+
+	void CheckNinePatch()
+	{
+		// 四边的宽度小于源和目标的一半，各部分不重叠，中间部分至少一个像素
+		if( m_src.GetWidth() < 3 || m_src.GetHeight() < 3 ) return;
+		RECT rcSrc = { 0, 0, m_src.GetWidth(), m_src.GetHeight() };
+		int cxSrc = rcSrc.right, cySrc = rcSrc.bottom;
+		RECT rcCorners;
+		rcCorners.left = m_random.Next((cxSrc - 1) / 2 + 1);
+		rcCorners.right = m_random.Next((cxSrc - 1) / 2 + 1);
+		rcCorners.top = m_random.Next((cySrc - 1) / 2 + 1);
+		rcCorners.bottom = m_random.Next((cySrc - 1) / 2 + 1);
+		RECT rcDest;
+		rcDest.left = m_random.Next(m_image.GetWidth() + 4) - 4;
+		rcDest.top = m_random.Next(m_image.GetHeight() + 4) - 4;
+		rcDest.right = rcDest.left + rcCorners.left + rcCorners.right + 1 + m_random.Next(m_image.GetWidth() + 4);
+		rcDest.bottom = rcDest.top + rcCorners.top + rcCorners.bottom + 1 + m_random.Next(m_image.GetHeight() + 4);
+		bool bBlend = m_random.Next(3) != 0;
+		BYTE uFade = m_random.Next(2) ? 255 : (BYTE)m_random.Next(256);
+		bool bHole = m_random.Next(3) == 0;
+		bool bTileX = m_random.Next(3) == 0, bTileY = m_random.Next(3) == 0;
+		int cxDest = rcDest.right - rcDest.left, cyDest = rcDest.bottom - rcDest.top;
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( !PtInRect(rcDest, x, y) || !IsDrawn(x, y) ) continue;
+				// 只有中间部分平铺，四边拉伸
+				int sx, sy;
+				int iZoneX = MapNinePatch(x - rcDest.left, cxDest, cxSrc, rcCorners.left, rcCorners.right, false, sx);
+				int iZoneY = MapNinePatch(y - rcDest.top, cyDest, cySrc, rcCorners.top, rcCorners.bottom, false, sy);
+				if( iZoneX == 1 && iZoneY == 1 ) {
+					if( bHole ) continue;
+					MapNinePatch(x - rcDest.left, cxDest, cxSrc, rcCorners.left, rcCorners.right, bTileX, sx);
+					MapNinePatch(y - rcDest.top, cyDest, cySrc, rcCorners.top, rcCorners.bottom, bTileY, sy);
+				}
+				PutPixel(x, y, m_src.At(sx, sy), bBlend, uFade);
+			}
+		}
+		m_rasterizer.DrawNinePatch(rcDest, m_src.GetBits(), m_src.GetStride(), rcSrc, rcCorners, bBlend, uFade, bHole, bTileX, bTileY);
+	}
+
+	// 分层窗口合成的处理只改变脏矩形与裁剪区域相交的部分
+	void CheckLayeredPass()
+	{
+		// GDI画出的像素alpha为0
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( m_random.Next(3) == 0 ) m_image.At(x, y) = Expected(x, y) = m_random.Next() & 0x00FFFFFF;
+				if( m_random.Next(5) == 0 ) m_image.At(x, y) = Expected(x, y) = 0;
+				m_mask.At(x, y) = RandomPremultiplied(m_random);
+			}
+		}
+		RECT rcDirty = RandomRect(m_random, m_image.GetWidth(), m_image.GetHeight());
+		int iPass = m_random.Next(4);
+		for( int y = 0; y < m_image.GetHeight(); y++ ) {
+			for( int x = 0; x < m_image.GetWidth(); x++ ) {
+				if( !PtInRect(rcDirty, x, y) || !IsDrawn(x, y) ) continue;
+				DWORD d = Expected(x, y);
+				switch( iPass ) {
+				case 0: Expected(x, y) = 0; break;
+				case 1: if( (d >> 24) == 0 && d != 0 ) Expected(x, y) = d | 0xFF000000; break;
+				case 2: if( d != 0 ) Expected(x, y) = d | 0xFF000000; break;
+				default: Expected(x, y) = (m_mask.At(x, y) & 0xFF000000) | (RefFade(d, m_mask.At(x, y) >> 24) & 0x00FFFFFF); break;
+				}
+			}
+		}
+		switch( iPass ) {
+		case 0: m_rasterizer.Clear(rcDirty); break;
+		case 1: m_rasterizer.RepairAlpha(rcDirty); break;
+		case 2: m_rasterizer.ForceOpaque(rcDirty); break;
+		default: m_rasterizer.MultiplyAlpha(rcDirty, m_mask.GetBits(), m_mask.GetStride()); break;
+		}
+	}
+
+private:
+	CTestRandom& m_random;
+	CTestImage m_image;
+	CTestImage m_src;
+	CTestImage m_mask;
+	std::vector<DWORD> m_aExpected;
+	CRasterizer m_rasterizer;
+	RECT m_rcClip;
+};
+
+// 几个手算的像素值，防止参考实现与被测实现犯同样的错误
+static void CheckKnownPixels()
+{
+	DWORD aPixels[4] = { 0xFF0000FF, 0xFF0000FF, 0x00000000, 0x80402010 };
+	CRasterizer rasterizer;
+	rasterizer.Attach((LPBYTE)aPixels, 4, 1, sizeof(aPixels));
+	// 半透明红色：预乘为0x80800000，覆盖在不透明蓝色上蓝色剩255*127/255=127
+	RECT rc = { 0, 0, 1, 1 };
+	rasterizer.FillRect(rc, 0x80FF0000);
+	TEST_CHECK(aPixels[0] == 0xFF80007F);
+	// 裁剪以外不变
+	RECT rcClip = { 2, 0, 4, 1 };
+	rasterizer.SetClip(rcClip);
+	RECT rcAll = { 0, 0, 4, 1 };
+	rasterizer.FillRect(rcAll, 0xFF00FF00);
+	TEST_CHECK(aPixels[1] == 0xFF0000FF && aPixels[2] == 0xFF00FF00 && aPixels[3] == 0xFF00FF00);
+	rasterizer.ResetClip();
+
+	// 直接复制包括alpha，混合时源先乘以fade
+	DWORD aSrc[2] = { 0x80402010, 0xFFFFFFFF };
+	RECT rcSrc = { 0, 0, 1, 1 };
+	rasterizer.Blit(rc, (const BYTE*)aSrc, sizeof(aSrc), rcSrc, false);
+	TEST_CHECK(aPixels[0] == 0x80402010);
+	aPixels[1] = 0;
+	RECT rcDest1 = { 1, 0, 2, 1 };
+	RECT rcSrc1 = { 1, 0, 2, 1 };
+	rasterizer.Blit(rcDest1, (const BYTE*)aSrc, sizeof(aSrc), rcSrc1, true, 128);
+	TEST_CHECK(aPixels[1] == 0x80808080);
+
+	// 两个像素拉伸到四个：每个源像素占两列
+	DWORD aRow[4] = { 0 };
+	rasterizer.Attach((LPBYTE)aRow, 4, 1, sizeof(aRow));
+	RECT rcStretch = { 0, 0, 4, 1 };
+	RECT rcSrc2 = { 0, 0, 2, 1 };
+	rasterizer.Blit(rcStretch, (const BYTE*)aSrc, sizeof(aSrc), rcSrc2, false);
+	TEST_CHECK(aRow[0] == aSrc[0] && aRow[1] == aSrc[0] && aRow[2] == aSrc[1] && aRow[3] == aSrc[1]);
+
+	// 黑到白的水平渐变，第i列为255*i/4
+	rasterizer.Clear(rcStretch);
+	rasterizer.FillGradient(rcStretch, 0xFF000000, 0xFFFFFFFF, false);
+	TEST_CHECK(aRow[0] == 0xFF000000 && aRow[1] == 0xFF3F3F3F && aRow[2] == 0xFF7F7F7F && aRow[3] == 0xFFBFBFBF);
+
+	// 3x3源画到5x5，角为1：四角不拉伸，中间3x3都取源的中心，bHole时中间不画
+	DWORD aNine[9], aCanvas[25];
+	for( int i = 0; i < 9; i++ ) aNine[i] = 0xFF000000 | i;
+	for( int i = 0; i < 25; i++ ) aCanvas[i] = 0xFFFFFFFF;
+	rasterizer.Attach((LPBYTE)aCanvas, 5, 5, 5 * sizeof(DWORD));
+	RECT rcNine = { 0, 0, 5, 5 };
+	RECT rcNineSrc = { 0, 0, 3, 3 };
+	RECT rcCorners = { 1, 1, 1, 1 };
+	rasterizer.DrawNinePatch(rcNine, (const BYTE*)aNine, 3 * sizeof(DWORD), rcNineSrc, rcCorners, true, 255, true);
+	static const int s_aExpected[25] = {
+		0, 1, 1, 1, 2,
+		3, -1, -1, -1, 5,
+		3, -1, -1, -1, 5,
+		3, -1, -1, -1, 5,
+		6, 7, 7, 7, 8,
+	};
+	for( int i = 0; i < 25; i++ ) {
+		TEST_CHECK(aCanvas[i] == (s_aExpected[i] < 0 ? 0xFFFFFFFF : (0xFF000000 | s_aExpected[i])));
+	}
+	rasterizer.DrawNinePatch(rcNine, (const BYTE*)aNine, 3 * sizeof(DWORD), rcNineSrc, rcCorners, true, 255, false);
+	TEST_CHECK(aCanvas[6] == 0xFF000004 && aCanvas[12] == 0xFF000004 && aCanvas[18] == 0xFF000004);
+}
+
+int main()
+{
+	static const char* s_aLevels[] = { "scalar", "SSE2", "SSSE3", "AVX2" };
+	for( int iLevel = PIXEL_SIMD_NONE; iLevel <= PIXEL_SIMD_AVX2; iLevel++ ) {
+		CPixelKernels::SetSimdLevel(iLevel);
+		if( CPixelKernels::GetSimdLevel() != iLevel ) {
+			printf("%s not supported, skipped\n", s_aLevels[iLevel]);
+			continue;
+		}
+		CheckKnownPixels();
+		CTestRandom random(0x2545F491u + iLevel);
+		for( int i = 0; i < 20000; i++ ) {
+			CRasterizerCheck check(random);
+			check.Run();
+		}
+		printf("%s checked\n", s_aLevels[iLevel]);
+	}
+	CPixelKernels::SetSimdLevel(PIXEL_SIMD_AVX2);
+	return TestExitCode();
+}
@@ -0,0 +1,118 @@
+﻿// CSkylinePacker：分配的区域都在页内且互不重叠，页放满或区域比页大时拒绝，拒绝后页不变
+#include "TestUtil.h"
+#include "Core/UISkyline.h"
+#include <vector>
+
+using namespace DuiLib;
+
+// 记录每个像素被哪次分配占用，检查区域在页内且不重叠
+class CPageCheck
+{
+public:
+	CPageCheck(int cx, int cy) : m_cx(cx), m_cy(cy), m_aOwner(cx * cy, 0), m_nAllocated(0)
+	{
+		m_packer.Reset(cx, cy);
+	}
+
+	bool Allocate(int cx, int cy)
+	{
+		POINT pt = { -1, -1 };
+		if( !m_packer.Allocate(cx, cy, pt) ) return false;
+		m_nAllocated++;
+		TEST_CHECK(pt.x >= 0 && pt.y >= 0 && pt.x + cx <= m_cx && pt.y + cy <= m_cy);
+		if( pt.x < 0 || pt.y < 0 || pt.x + cx > m_cx || pt.y + cy > m_cy ) return true;
+		bool bFree = true;
+		for( int y = pt.y; y < pt.y + cy; y++ ) {
+			for( int x = pt.x; x < pt.x + cx; x++ ) {
+				if( m_aOwner[y * m_cx + x] != 0 ) bFree = false;
+				m_aOwner[y * m_cx + x] = m_nAllocated;
+			}
+		}
+		TEST_CHECK(bFree);
+		m_ptLast = pt;
+		return true;
+	}
+
+	int GetAllocated() const { return m_nAllocated; }
+	POINT GetLast() const { return m_ptLast; }
+
+	int GetUsedArea() const
+	{
+		int nArea = 0;
+		for( size_t i = 0; i < m_aOwner.size(); i++ ) {
+			if( m_aOwner[i] != 0 ) nArea++;
+		}
+		return nArea;
+	}
+
+private:
+	CSkylinePacker m_packer;
+	int m_cx;
+	int m_cy;
+	std::vector<int> m_aOwner;
+	int m_nAllocated;
+	POINT m_ptLast;
+};
+
+// 随机大小的区域一直分配到连续多次失败，再检查超出页的请求被拒绝
+static void CheckRandom()
+{
+	CTestRandom random(0x5EB1A7C3u);
+	for( int iRun = 0; iRun < 300; iRun++ ) {
+		int cxPage = 1 + random.Next(iRun % 10 == 0 ? CSkylinePacker::SKYLINE_MAX_WIDTH : 160);
+		int cyPage = 1 + random.Next(160);
+		CPageCheck page(cxPage, cyPage);
+		int nMaxSide = 1 + random.Next(40);
+		int nArea = 0;
+		for( int nFailures = 0; nFailures < 50; ) {
+			int cx = 1 + random.Next(nMaxSide), cy = 1 + random.Next(nMaxSide);
+			if( page.Allocate(cx, cy) ) nArea += cx * cy;
+			else nFailures++;
+		}
+		TEST_CHECK(page.GetUsedArea() == nArea);
+		// 拒绝的请求不改变页，之后仍然能放下1×1的区域直到放满
+		while( page.Allocate(1, 1) ) nArea++;
+		TEST_CHECK(page.GetUsedArea() == nArea);
+		TEST_CHECK(!page.Allocate(cxPage + 1, 1));
+		TEST_CHECK(!page.Allocate(1, cyPage + 1));
+		TEST_CHECK(!page.Allocate(0, 1) && !page.Allocate(1, 0));
+	}
+}
+
+static void CheckCases()
+{
+	// 正好铺满的页：16块全部放下，第17块和1×1都放不下
+	CPageCheck full(64, 64);
+	for( int i = 0; i < 16; i++ ) TEST_CHECK(full.Allocate(16, 16));
+	TEST_CHECK(full.GetUsedArea() == 64 * 64);
+	TEST_CHECK(!full.Allocate(16, 16));
+	TEST_CHECK(!full.Allocate(1, 1));
+
+	// 放下后顶边最低的位置优先；跨过几段的区域截短后面的段，等高的段合并后整行可用
+	CPageCheck page(64, 64);
+	TEST_CHECK(page.Allocate(10, 5) && page.GetLast().x == 0 && page.GetLast().y == 0);
+	TEST_CHECK(page.Allocate(20, 3) && page.GetLast().x == 10 && page.GetLast().y == 0);
+	TEST_CHECK(page.Allocate(25, 2) && page.GetLast().x == 30 && page.GetLast().y == 0);
+	TEST_CHECK(page.Allocate(40, 2) && page.GetLast().x == 10 && page.GetLast().y == 3);
+	TEST_CHECK(page.Allocate(14, 3) && page.GetLast().x == 50 && page.GetLast().y == 2);
+	TEST_CHECK(page.Allocate(64, 1) && page.GetLast().x == 0 && page.GetLast().y == 5);
+	TEST_CHECK(page.Allocate(64, 58) && page.GetLast().x == 0 && page.GetLast().y == 6);
+	TEST_CHECK(!page.Allocate(1, 1));
+
+	// 最宽的页上高度交替的1像素列：每列一段，再插入一段时段数比页宽多一
+	int cxWide = CSkylinePacker::SKYLINE_MAX_WIDTH;
+	CPageCheck columns(cxWide, 8);
+	for( int x = 0; x < cxWide; x++ ) {
+		TEST_CHECK(columns.Allocate(1, x % 2 == 0 ? 2 : 1) && columns.GetLast().x == x && columns.GetLast().y == 0);
+	}
+	TEST_CHECK(columns.Allocate(1, 1) && columns.GetLast().x == 1 && columns.GetLast().y == 1);
+	TEST_CHECK(columns.Allocate(cxWide, 6) && columns.GetLast().x == 0 && columns.GetLast().y == 2);
+	TEST_CHECK(columns.GetUsedArea() == cxWide / 2 * 3 + 1 + cxWide * 6);
+}
+
+int main()
+{
+	CheckCases();
+	CheckRandom();
+	return TestExitCode();
+}
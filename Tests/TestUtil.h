@@ -0,0 +1,69 @@
+﻿#ifndef __TESTUTIL_H__
+#define __TESTUTIL_H__
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+
+// 最小的测试框架：TEST_CHECK失败时打印位置并继续，TestExitCode()在main结尾返回结果
+inline int& TestFailureCount()
+{
+	static int s_nFailures = 0;
+	return s_nFailures;
+}
+
+inline void TestFail(const char* pstrFile, int nLine, const char* pstrExpr)
+{
+	// 同一个检查在循环里失败时只打印前几次
+	if( ++TestFailureCount() <= 20 ) fprintf(stderr, "%s(%d): check failed: %s\n", pstrFile, nLine, pstrExpr);
+}
+
+inline int TestExitCode()
+{
+	if( TestFailureCount() != 0 ) fprintf(stderr, "%d check(s) failed\n", TestFailureCount());
+	else printf("all checks passed\n");
+	return TestFailureCount() != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#define TEST_CHECK(expr) do { if( !(expr) ) TestFail(__FILE__, __LINE__, #expr); } while( 0 )
+
+// 可复现的伪随机数（xorshift32），测试数据不依赖平台的rand()
+class CTestRandom
+{
+public:
+	explicit CTestRandom(uint32_t nSeed = 0x12345678) : m_nState(nSeed != 0 ? nSeed : 1) {}
+
+	uint32_t Next()
+	{
+		m_nState ^= m_nState << 13;
+		m_nState ^= m_nState >> 17;
+		m_nState ^= m_nState << 5;
+		return m_nState;
+	}
+
+	// [0, n)
+	int Next(int n) { return (int)(Next() % (uint32_t)n); }
+
+private:
+	uint32_t m_nState;
+};
+
+// 基准计时，返回秒
+class CTestTimer
+{
+public:
+	CTestTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+	double Elapsed() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // __TESTUTIL_H__
@@ -0,0 +1,184 @@
+﻿// 测试用的最小Win32替身：只提供UIMarkup.cpp和UIAttributeId.cpp用到的类型、API和DuiLib类，
+// 用-fshort-wchar编译，TCHAR与Windows Unicode版本一样是16位，可以在Linux上运行CMarkup
+#ifndef __WIN32STUB_STDAFX_H__
+#define __WIN32STUB_STDAFX_H__
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <wctype.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#if __SIZEOF_WCHAR_T__ != 2
+#error "Win32Stub needs -fshort-wchar"
+#endif
+
+#ifndef _UNICODE
+#define _UNICODE
+#endif
+#ifndef UNICODE
+#define UNICODE
+#endif
+
+#define UILIB_API
+#define _T(x) L##x
+#define lengthof(x) (sizeof(x)/sizeof(*x))
+// 与DuiLib的Release版本一样不检查
+#define ASSERT(expr) ((void)0)
+
+typedef wchar_t WCHAR;
+typedef WCHAR TCHAR;
+typedef WCHAR* LPWSTR;
+typedef const WCHAR* LPCWSTR;
+typedef TCHAR* LPTSTR;
+typedef const TCHAR* LPCTSTR;
+typedef char CHAR;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef uint8_t BYTE;
+typedef BYTE* LPBYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint32_t UINT;
+typedef uint32_t ULONG;
+typedef uint64_t ULONGLONG;
+typedef size_t SIZE_T;
+typedef uintptr_t UINT_PTR;
+typedef int BOOL;
+typedef void* LPVOID;
+typedef void* HANDLE;
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 1
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define FILE_BEGIN 0
+#define PAGE_READONLY 2
+#define PAGE_READWRITE 4
+#define FILE_MAP_READ 4
+#define MEM_COMMIT 0x1000
+#define MEM_RESERVE 0x2000
+#define MEM_RELEASE 0x8000
+#define CP_ACP 0
+#define CP_UTF8 65001
+
+#define CopyMemory(d, s, n) memcpy((d), (s), (n))
+#define MoveMemory(d, s, n) memmove((d), (s), (n))
+#define ZeroMemory(d, n) memset((d), 0, (n))
+#define FillMemory(d, n, c) memset((d), (c), (n))
+
+HANDLE CreateFile(LPCTSTR pstrName, DWORD dwAccess, DWORD dwShare, void* pSecurity, DWORD dwCreation, DWORD dwFlags, HANDLE hTemplate);
+DWORD GetFileSize(HANDLE hFile, DWORD* pHigh);
+BOOL ReadFile(HANDLE hFile, void* pBuffer, DWORD cbRead, DWORD* pcbRead, void* pOverlapped);
+BOOL WriteFile(HANDLE hFile, const void* pBuffer, DWORD cbWrite, DWORD* pcbWritten, void* pOverlapped);
+DWORD SetFilePointer(HANDLE hFile, long nDistance, long* pHigh, DWORD dwMethod);
+BOOL CloseHandle(HANDLE h);
+HANDLE CreateFileMapping(HANDLE hFile, void* pSecurity, DWORD dwProtect, DWORD dwHigh, DWORD dwLow, LPCTSTR pstrName);
+LPVOID MapViewOfFile(HANDLE hMap, DWORD dwAccess, DWORD dwHigh, DWORD dwLow, SIZE_T cbSize);
+BOOL UnmapViewOfFile(const void* pView);
+LPVOID VirtualAlloc(LPVOID pAddress, SIZE_T cbSize, DWORD dwType, DWORD dwProtect);
+BOOL VirtualFree(LPVOID pAddress, SIZE_T cbSize, DWORD dwType);
+// VirtualAlloc当前已提交的字节数，测试用
+SIZE_T Win32StubCommittedBytes();
+int MultiByteToWideChar(UINT uCodePage, DWORD dwFlags, LPCSTR pstr, int cb, LPWSTR pstrWide, int cchWide);
+int WideCharToMultiByte(UINT uCodePage, DWORD dwFlags, LPCWSTR pstrWide, int cchWide, LPSTR pstr, int cb, LPCSTR pDefault, BOOL* pUsedDefault);
+LPWSTR CharNext(LPCWSTR pstr);
+inline BOOL IsDBCSLeadByte(BYTE) { return 0; }
+
+size_t _tcslen(LPCTSTR pstr);
+LPTSTR _tcscpy(LPTSTR pstrDest, LPCTSTR pstrSrc);
+LPTSTR _tcsncpy(LPTSTR pstrDest, LPCTSTR pstrSrc, size_t cch);
+int _tcsncmp(LPCTSTR pstr1, LPCTSTR pstr2, size_t cch);
+int _tcsicmp(LPCTSTR pstr1, LPCTSTR pstr2);
+inline int _istalnum(TCHAR ch) { return iswalnum((wint_t)ch); }
+
+namespace DuiLib {
+
+	class CDuiString
+	{
+	public:
+		CDuiString() {}
+		CDuiString(LPCTSTR pstr) { if( pstr != NULL ) m_str.assign((const char16_t*)pstr, _tcslen(pstr)); }
+		CDuiString& operator+=(LPCTSTR pstr) { m_str.append((const char16_t*)pstr, _tcslen(pstr)); return *this; }
+		CDuiString& operator+=(const CDuiString& src) { m_str += src.m_str; return *this; }
+		bool operator==(LPCTSTR pstr) const { return m_str.compare(0, std::u16string::npos, (const char16_t*)pstr, _tcslen(pstr)) == 0; }
+		bool operator!=(LPCTSTR pstr) const { return !(*this == pstr); }
+		operator LPCTSTR() const { return GetData(); }
+		LPCTSTR GetData() const { return (LPCTSTR)m_str.c_str(); }
+		bool IsEmpty() const { return m_str.empty(); }
+		int GetLength() const { return (int)m_str.size(); }
+		int Replace(LPCTSTR pstrFrom, LPCTSTR pstrTo);
+		CDuiString& Trim();
+
+	private:
+		std::u16string m_str;
+	};
+
+	class CStdPtrArray
+	{
+	public:
+		bool IsEmpty() const { return m_aItems.empty(); }
+		bool Add(LPVOID pData) { m_aItems.push_back(pData); return true; }
+		bool Remove(int iIndex) { m_aItems.erase(m_aItems.begin() + iIndex); return true; }
+		int GetSize() const { return (int)m_aItems.size(); }
+		LPVOID GetAt(int iIndex) const { return m_aItems[iIndex]; }
+		LPVOID operator[](int iIndex) const { return m_aItems[iIndex]; }
+
+	private:
+		std::vector<LPVOID> m_aItems;
+	};
+
+	class CStdStringPtrMap
+	{
+	public:
+		CStdStringPtrMap(int nSize = 83) { (void)nSize; }
+		LPVOID Find(LPCTSTR key, bool optimize = true) const;
+		bool Insert(LPCTSTR key, LPVOID pData);
+
+	private:
+		std::map<std::u16string, LPVOID> m_map;
+	};
+
+	// 资源路径为空、不使用zip，文件名按原样打开
+	class CPaintManagerUI
+	{
+	public:
+		static const CDuiString& GetResourcePath();
+		static const CDuiString& GetResourceZip();
+		static const CDuiString& GetResourceZipPwd();
+		static bool IsCachedResourceZip() { return false; }
+		static HANDLE GetResourceZipHandle() { return NULL; }
+	};
+
+	inline char* w2a(wchar_t*) { return NULL; }
+
+} // namespace DuiLib
+
+typedef struct HZIP__* HZIP;
+typedef DWORD ZRESULT;
+#define ZR_OK 0x00000000
+#define ZR_MORE 0x00000600
+typedef struct
+{
+	int index;
+	DWORD unc_size;
+} ZIPENTRY;
+inline HZIP OpenZip(LPCTSTR, const char*) { return NULL; }
+inline ZRESULT FindZipItem(HZIP, LPCTSTR, bool, int*, ZIPENTRY*) { return 1; }
+inline ZRESULT UnzipItem(HZIP, int, void*, unsigned int) { return 1; }
+inline ZRESULT CloseZip(HZIP) { return ZR_OK; }
+
+#include "Core/UIMarkup.h"
+#include "Core/UIAttributeId.h"
+
+#endif // __WIN32STUB_STDAFX_H__
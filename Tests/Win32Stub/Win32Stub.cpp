@@ -0,0 +1,345 @@
+﻿#include "StdAfx.h"
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+	enum { STUB_FILE = 1, STUB_MAPPING = 2 };
+
+	struct StubHandle
+	{
+		int nKind;
+		FILE* pFile;
+		BYTE* pData;
+		DWORD cbData;
+	};
+
+	std::string ToUtf8(LPCWSTR pstr)
+	{
+		std::string s;
+		int cch = (int)_tcslen(pstr);
+		int cb = WideCharToMultiByte(CP_UTF8, 0, pstr, cch, NULL, 0, NULL, NULL);
+		s.resize(cb);
+		if( cb > 0 ) WideCharToMultiByte(CP_UTF8, 0, pstr, cch, &s[0], cb, NULL, NULL);
+		return s;
+	}
+
+	// VirtualAlloc保留的地址范围及其中已提交的页，未提交的页不可访问
+	struct StubRegion
+	{
+		SIZE_T cbSize;
+		std::vector<bool> aCommitted;
+	};
+
+	std::map<BYTE*, StubRegion> s_mapRegions;
+	SIZE_T s_cbCommitted = 0;
+
+	SIZE_T GetPageSize()
+	{
+		return (SIZE_T)sysconf(_SC_PAGESIZE);
+	}
+
+	bool IsCombining(WCHAR ch)
+	{
+		return (ch >= 0x0300 && ch <= 0x036F) || (ch >= 0x1AB0 && ch <= 0x1AFF) || (ch >= 0x1DC0 && ch <= 0x1DFF) ||
+			(ch >= 0x20D0 && ch <= 0x20FF) || (ch >= 0xFE20 && ch <= 0xFE2F);
+	}
+
+} // namespace
+
+HANDLE CreateFile(LPCTSTR pstrName, DWORD dwAccess, DWORD, void*, DWORD, DWORD, HANDLE)
+{
+	FILE* pFile = fopen(ToUtf8(pstrName).c_str(), (dwAccess & GENERIC_WRITE) ? "wb" : "rb");
+	if( pFile == NULL ) return INVALID_HANDLE_VALUE;
+	StubHandle* pHandle = new StubHandle();
+	pHandle->nKind = STUB_FILE;
+	pHandle->pFile = pFile;
+	return pHandle;
+}
+
+DWORD GetFileSize(HANDLE hFile, DWORD* pHigh)
+{
+	FILE* pFile = static_cast<StubHandle*>(hFile)->pFile;
+	long nPos = ftell(pFile);
+	fseek(pFile, 0, SEEK_END);
+	long nSize = ftell(pFile);
+	fseek(pFile, nPos, SEEK_SET);
+	if( pHigh != NULL ) *pHigh = 0;
+	return (DWORD)nSize;
+}
+
+BOOL ReadFile(HANDLE hFile, void* pBuffer, DWORD cbRead, DWORD* pcbRead, void*)
+{
+	*pcbRead = (DWORD)fread(pBuffer, 1, cbRead, static_cast<StubHandle*>(hFile)->pFile);
+	return 1;
+}
+
+BOOL WriteFile(HANDLE hFile, const void* pBuffer, DWORD cbWrite, DWORD* pcbWritten, void*)
+{
+	*pcbWritten = (DWORD)fwrite(pBuffer, 1, cbWrite, static_cast<StubHandle*>(hFile)->pFile);
+	return *pcbWritten == cbWrite;
+}
+
+DWORD SetFilePointer(HANDLE hFile, long nDistance, long*, DWORD)
+{
+	fseek(static_cast<StubHandle*>(hFile)->pFile, nDistance, SEEK_SET);
+	return (DWORD)nDistance;
+}
+
+BOOL CloseHandle(HANDLE h)
+{
+	StubHandle* pHandle = static_cast<StubHandle*>(h);
+	if( pHandle->nKind == STUB_FILE ) fclose(pHandle->pFile);
+	delete pHandle;
+	return 1;
+}
+
+// 映射在替身里就是把整个文件读进内存，视图在UnmapViewOfFile时释放
+HANDLE CreateFileMapping(HANDLE hFile, void*, DWORD, DWORD, DWORD, LPCTSTR)
+{
+	DWORD cbSize = GetFileSize(hFile, NULL);
+	StubHandle* pHandle = new StubHandle();
+	pHandle->nKind = STUB_MAPPING;
+	pHandle->pData = static_cast<BYTE*>(malloc(cbSize + 1));
+	pHandle->cbData = cbSize;
+	FILE* pFile = static_cast<StubHandle*>(hFile)->pFile;
+	fseek(pFile, 0, SEEK_SET);
+	if( fread(pHandle->pData, 1, cbSize, pFile) != cbSize ) {
+		free(pHandle->pData);
+		delete pHandle;
+		return NULL;
+	}
+	return pHandle;
+}
+
+LPVOID MapViewOfFile(HANDLE hMap, DWORD, DWORD, DWORD, SIZE_T)
+{
+	StubHandle* pHandle = static_cast<StubHandle*>(hMap);
+	BYTE* pData = pHandle->pData;
+	pHandle->pData = NULL;
+	return pData;
+}
+
+BOOL UnmapViewOfFile(const void* pView)
+{
+	free(const_cast<void*>(pView));
+	return 1;
+}
+
+LPVOID VirtualAlloc(LPVOID pAddress, SIZE_T cbSize, DWORD dwType, DWORD)
+{
+	SIZE_T cbPage = GetPageSize();
+	if( pAddress == NULL ) {
+		if( cbSize == 0 ) return NULL;
+		cbSize = (cbSize + cbPage - 1) / cbPage * cbPage;
+		void* pBase = mmap(NULL, cbSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if( pBase == MAP_FAILED ) return NULL;
+		StubRegion& region = s_mapRegions[static_cast<BYTE*>(pBase)];
+		region.cbSize = cbSize;
+		region.aCommitted.assign(cbSize / cbPage, false);
+		if( (dwType & MEM_COMMIT) != 0 && VirtualAlloc(pBase, cbSize, MEM_COMMIT, PAGE_READWRITE) == NULL ) return NULL;
+		return pBase;
+	}
+	// 提交已保留的范围，与Windows一样按页对齐，已提交的页内容不变
+	BYTE* pByte = static_cast<BYTE*>(pAddress);
+	std::map<BYTE*, StubRegion>::iterator it = s_mapRegions.upper_bound(pByte);
+	if( it == s_mapRegions.begin() ) return NULL;
+	--it;
+	SIZE_T iFirst = (SIZE_T)(pByte - it->first) / cbPage;
+	SIZE_T iLast = ((SIZE_T)(pByte - it->first) + cbSize - 1) / cbPage;
+	if( cbSize == 0 || iLast >= it->second.aCommitted.size() ) return NULL;
+	if( mprotect(it->first + iFirst * cbPage, (iLast - iFirst + 1) * cbPage, PROT_READ | PROT_WRITE) != 0 ) return NULL;
+	for( SIZE_T i = iFirst; i <= iLast; i++ ) {
+		if( !it->second.aCommitted[i] ) s_cbCommitted += cbPage;
+		it->second.aCommitted[i] = true;
+	}
+	return it->first + iFirst * cbPage;
+}
+
+BOOL VirtualFree(LPVOID pAddress, SIZE_T, DWORD)
+{
+	std::map<BYTE*, StubRegion>::iterator it = s_mapRegions.find(static_cast<BYTE*>(pAddress));
+	if( it == s_mapRegions.end() ) return 0;
+	for( size_t i = 0; i < it->second.aCommitted.size(); i++ ) {
+		if( it->second.aCommitted[i] ) s_cbCommitted -= GetPageSize();
+	}
+	munmap(pAddress, it->second.cbSize);
+	s_mapRegions.erase(it);
+	return 1;
+}
+
+SIZE_T Win32StubCommittedBytes()
+{
+	return s_cbCommitted;
+}
+
+// UTF-8按Windows的方式把非法字节替换为U+FFFD；其它代码页按Latin-1处理
+int MultiByteToWideChar(UINT uCodePage, DWORD, LPCSTR pstr, int cb, LPWSTR pstrWide, int cchWide)
+{
+	if( cb < 0 ) cb = (int)strlen(pstr) + 1;
+	const BYTE* p = reinterpret_cast<const BYTE*>(pstr);
+	const BYTE* pEnd = p + cb;
+	int cch = 0;
+	while( p < pEnd ) {
+		DWORD ch = *p++;
+		if( uCodePage == CP_UTF8 && ch >= 0x80 ) {
+			int nTrail = ch >= 0xF0 ? 3 : (ch >= 0xE0 ? 2 : (ch >= 0xC0 ? 1 : -1));
+			if( nTrail < 0 || ch >= 0xF8 || pEnd - p < nTrail ) ch = 0xFFFD;
+			else {
+				ch &= 0x3F >> nTrail;
+				for( int i = 0; i < nTrail; i++ ) {
+					if( (p[i] & 0xC0) != 0x80 ) { ch = 0xFFFD; nTrail = i; break; }
+					ch = (ch << 6) | (p[i] & 0x3F);
+				}
+				p += nTrail;
+			}
+		}
+		WCHAR aUnits[2];
+		int nUnits = 1;
+		if( ch >= 0x10000 ) {
+			ch -= 0x10000;
+			aUnits[0] = (WCHAR)(0xD800 + (ch >> 10));
+			aUnits[1] = (WCHAR)(0xDC00 + (ch & 0x3FF));
+			nUnits = 2;
+		}
+		else aUnits[0] = (WCHAR)ch;
+		for( int i = 0; i < nUnits; i++ ) {
+			if( cchWide > 0 ) {
+				if( cch >= cchWide ) return 0;
+				pstrWide[cch] = aUnits[i];
+			}
+			cch++;
+		}
+	}
+	return cch;
+}
+
+int WideCharToMultiByte(UINT uCodePage, DWORD, LPCWSTR pstrWide, int cchWide, LPSTR pstr, int cb, LPCSTR, BOOL*)
+{
+	if( cchWide < 0 ) cchWide = (int)_tcslen(pstrWide) + 1;
+	int cbOut = 0;
+	for( int i = 0; i < cchWide; i++ ) {
+		DWORD ch = (WORD)pstrWide[i];
+		if( ch >= 0xD800 && ch < 0xDC00 && i + 1 < cchWide ) {
+			ch = 0x10000 + ((ch - 0xD800) << 10) + ((WORD)pstrWide[++i] - 0xDC00);
+		}
+		BYTE aBytes[4];
+		int n = 0;
+		if( uCodePage != CP_UTF8 ) aBytes[n++] = ch < 0x100 ? (BYTE)ch : '?';
+		else if( ch < 0x80 ) aBytes[n++] = (BYTE)ch;
+		else if( ch < 0x800 ) { aBytes[n++] = (BYTE)(0xC0 | (ch >> 6)); aBytes[n++] = (BYTE)(0x80 | (ch & 0x3F)); }
+		else if( ch < 0x10000 ) {
+			aBytes[n++] = (BYTE)(0xE0 | (ch >> 12));
+			aBytes[n++] = (BYTE)(0x80 | ((ch >> 6) & 0x3F));
+			aBytes[n++] = (BYTE)(0x80 | (ch & 0x3F));
+		}
+		else {
+			aBytes[n++] = (BYTE)(0xF0 | (ch >> 18));
+			aBytes[n++] = (BYTE)(0x80 | ((ch >> 12) & 0x3F));
+			aBytes[n++] = (BYTE)(0x80 | ((ch >> 6) & 0x3F));
+			aBytes[n++] = (BYTE)(0x80 | (ch & 0x3F));
+		}
+		for( int j = 0; j < n; j++ ) {
+			if( cb > 0 ) {
+				if( cbOut >= cb ) return 0;
+				pstr[cbOut] = (char)aBytes[j];
+			}
+			cbOut++;
+		}
+	}
+	return cbOut;
+}
+
+// 与CharNextW一样把后面的组合字符算作同一个字符
+LPWSTR CharNext(LPCWSTR pstr)
+{
+	if( *pstr == L'\0' ) return const_cast<LPWSTR>(pstr);
+	++pstr;
+	while( IsCombining(*pstr) ) ++pstr;
+	return const_cast<LPWSTR>(pstr);
+}
+
+size_t _tcslen(LPCTSTR pstr)
+{
+	size_t n = 0;
+	while( pstr[n] != L'\0' ) n++;
+	return n;
+}
+
+LPTSTR _tcscpy(LPTSTR pstrDest, LPCTSTR pstrSrc)
+{
+	memcpy(pstrDest, pstrSrc, (_tcslen(pstrSrc) + 1) * sizeof(TCHAR));
+	return pstrDest;
+}
+
+LPTSTR _tcsncpy(LPTSTR pstrDest, LPCTSTR pstrSrc, size_t cch)
+{
+	size_t i = 0;
+	for( ; i < cch && pstrSrc[i] != L'\0'; i++ ) pstrDest[i] = pstrSrc[i];
+	for( ; i < cch; i++ ) pstrDest[i] = L'\0';
+	return pstrDest;
+}
+
+int _tcsncmp(LPCTSTR pstr1, LPCTSTR pstr2, size_t cch)
+{
+	for( size_t i = 0; i < cch; i++ ) {
+		if( pstr1[i] != pstr2[i] ) return (WORD)pstr1[i] < (WORD)pstr2[i] ? -1 : 1;
+		if( pstr1[i] == L'\0' ) break;
+	}
+	return 0;
+}
+
+int _tcsicmp(LPCTSTR pstr1, LPCTSTR pstr2)
+{
+	for( ; ; pstr1++, pstr2++ ) {
+		wint_t c1 = towlower((WORD)*pstr1);
+		wint_t c2 = towlower((WORD)*pstr2);
+		if( c1 != c2 ) return c1 < c2 ? -1 : 1;
+		if( c1 == 0 ) return 0;
+	}
+}
+
+namespace DuiLib {
+
+	int CDuiString::Replace(LPCTSTR pstrFrom, LPCTSTR pstrTo)
+	{
+		std::u16string sFrom((const char16_t*)pstrFrom, _tcslen(pstrFrom));
+		std::u16string sTo((const char16_t*)pstrTo, _tcslen(pstrTo));
+		int nCount = 0;
+		if( sFrom.empty() ) return 0;
+		for( size_t iPos = m_str.find(sFrom); iPos != std::u16string::npos; iPos = m_str.find(sFrom, iPos + sTo.size()) ) {
+			m_str.replace(iPos, sFrom.size(), sTo);
+			nCount++;
+		}
+		return nCount;
+	}
+
+	CDuiString& CDuiString::Trim()
+	{
+		size_t iFirst = 0;
+		size_t iLast = m_str.size();
+		while( iFirst < iLast && iswspace((wint_t)m_str[iFirst]) ) iFirst++;
+		while( iLast > iFirst && iswspace((wint_t)m_str[iLast - 1]) ) iLast--;
+		m_str = m_str.substr(iFirst, iLast - iFirst);
+		return *this;
+	}
+
+	LPVOID CStdStringPtrMap::Find(LPCTSTR key, bool) const
+	{
+		std::map<std::u16string, LPVOID>::const_iterator it = m_map.find(std::u16string((const char16_t*)key, _tcslen(key)));
+		return it != m_map.end() ? it->second : NULL;
+	}
+
+	bool CStdStringPtrMap::Insert(LPCTSTR key, LPVOID pData)
+	{
+		return m_map.insert(std::make_pair(std::u16string((const char16_t*)key, _tcslen(key)), pData)).second;
+	}
+
+	static const CDuiString s_sEmpty;
+
+	const CDuiString& CPaintManagerUI::GetResourcePath() { return s_sEmpty; }
+	const CDuiString& CPaintManagerUI::GetResourceZip() { return s_sEmpty; }
+	const CDuiString& CPaintManagerUI::GetResourceZipPwd() { return s_sEmpty; }
+
+} // namespace DuiLib
@@ -0,0 +1,56 @@
+﻿// 皮肤编译器：把XML皮肤解析一遍，写成CMarkup::LoadFromFile/LoadFromMem可以直接映射使用的二进制格式
+// 用法：SkinCompiler 输入.xml 输出文件 [utf8|unicode|ansi]
+// 输出文件可以沿用原来的文件名放回皮肤目录或zip中，加载时按文件头自动识别
+// 编译结果与TCHAR的宽度有关，本工具只按Unicode版本（16位TCHAR）编译，生成的文件供Unicode版本的程序使用
+#include "StdAfx.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace DuiLib;
+
+static void PrintError(const char* pstrWhat, CMarkup& xml)
+{
+	TCHAR szMessage[100] = { 0 };
+	TCHAR szLocation[50] = { 0 };
+	xml.GetLastErrorMessage(szMessage, lengthof(szMessage) - 1);
+	xml.GetLastErrorLocation(szLocation, lengthof(szLocation) - 1);
+	char szUtf8Message[400] = { 0 };
+	char szUtf8Location[200] = { 0 };
+	::WideCharToMultiByte(CP_UTF8, 0, szMessage, -1, szUtf8Message, sizeof(szUtf8Message) - 1, NULL, NULL);
+	::WideCharToMultiByte(CP_UTF8, 0, szLocation, -1, szUtf8Location, sizeof(szUtf8Location) - 1, NULL, NULL);
+	fprintf(stderr, "%s: %s %s\n", pstrWhat, szUtf8Message, szUtf8Location);
+}
+
+static CDuiString ToTString(const char* pstr)
+{
+	int cch = ::MultiByteToWideChar(CP_UTF8, 0, pstr, -1, NULL, 0);
+	std::vector<WCHAR> aWide(cch + 1, L'\0');
+	::MultiByteToWideChar(CP_UTF8, 0, pstr, -1, &aWide[0], cch);
+	return CDuiString(&aWide[0]);
+}
+
+int main(int argc, char* argv[])
+{
+	if( argc < 3 ) {
+		fprintf(stderr, "usage: SkinCompiler input.xml output [utf8|unicode|ansi]\n");
+		return 2;
+	}
+	int encoding = XMLFILE_ENCODING_UTF8;
+	if( argc > 3 && strcmp(argv[3], "unicode") == 0 ) encoding = XMLFILE_ENCODING_UNICODE;
+	else if( argc > 3 && strcmp(argv[3], "ansi") == 0 ) encoding = XMLFILE_ENCODING_ASNI;
+
+	CMarkup xml;
+	if( !xml.LoadFromFile(ToTString(argv[1]), encoding) ) {
+		PrintError(argv[1], xml);
+		return 1;
+	}
+	if( xml.IsBinary() ) {
+		fprintf(stderr, "%s: already compiled\n", argv[1]);
+		return 1;
+	}
+	if( !xml.SaveToBinary(ToTString(argv[2])) ) {
+		PrintError(argv[2], xml);
+		return 1;
+	}
+	return 0;
+}